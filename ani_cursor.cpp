@@ -0,0 +1,354 @@
+#if defined(_MSC_VER) && !defined(_CRT_SECURE_NO_WARNINGS)
+#define _CRT_SECURE_NO_WARNINGS
+#endif
+
+#include "ani_cursor.h"
+
+#include <cstdio>
+#include <cstring>
+
+#define ANI_FOURCC(a, b, c, d) ((uint32_t)(a) | ((uint32_t)(b) << 8) | ((uint32_t)(c) << 16) | ((uint32_t)(d) << 24))
+
+#define ANI_FLAG_ICON     0x1 // Frames are icon/cursor files rather than raw bitmaps
+#define ANI_FLAG_SEQUENCE 0x2 // A 'seq ' chunk is present
+
+// Little-endian reader that refuses to go out of bounds.
+struct AniReader
+{
+    const unsigned char* Data;
+    size_t Size;
+
+    bool Has(size_t offset, size_t count) const
+    {
+        return offset <= Size && count <= Size - offset;
+    }
+
+    uint16_t U16(size_t offset) const
+    {
+        return (uint16_t)(Data[offset] | (Data[offset + 1] << 8));
+    }
+
+    uint32_t U32(size_t offset) const
+    {
+        return (uint32_t)Data[offset] | ((uint32_t)Data[offset + 1] << 8) | ((uint32_t)Data[offset + 2] << 16) | ((uint32_t)Data[offset + 3] << 24);
+    }
+};
+
+// Decodes the first image of an .ico/.cur file into 'width' x 'height' RGBA8 pixels.
+static bool AniCursor_DecodeIcon(AniReader icon, int* width, int* height, int* hotspotX, int* hotspotY, std::vector<unsigned char>* rgba)
+{
+    // ICONDIR + first ICONDIRENTRY
+    if (!icon.Has(0, 6 + 16))
+    {
+        return false;
+    }
+
+    uint16_t type = icon.U16(2);
+    uint16_t count = icon.U16(4);
+    if ((type != 1 && type != 2) || count == 0)
+    {
+        return false;
+    }
+
+    // For cursors, the planes and bit count fields of the entry hold the hotspot instead.
+    *hotspotX = type == 2 ? icon.U16(6 + 4) : 0;
+    *hotspotY = type == 2 ? icon.U16(6 + 6) : 0;
+    uint32_t imageSize = icon.U32(6 + 8);
+    uint32_t imageOffset = icon.U32(6 + 12);
+    if (!icon.Has(imageOffset, imageSize) || imageSize < 40)
+    {
+        return false;
+    }
+
+    AniReader image = { icon.Data + imageOffset, imageSize };
+
+    // BITMAPINFOHEADER. The height covers both the color image and the AND mask.
+    uint32_t headerSize = image.U32(0);
+    int w = (int32_t)image.U32(4);
+    int h = (int32_t)image.U32(8) / 2;
+    uint16_t bitCount = image.U16(14);
+    uint32_t compression = image.U32(16);
+    uint32_t colorsUsed = image.U32(32);
+    if (headerSize < 40 || w <= 0 || h <= 0 || w > 1024 || h > 1024 || compression != 0 /* BI_RGB */)
+    {
+        return false;
+    }
+    if (bitCount != 1 && bitCount != 4 && bitCount != 8 && bitCount != 24 && bitCount != 32)
+    {
+        return false;
+    }
+
+    size_t paletteOffset = headerSize;
+    size_t paletteCount = bitCount <= 8 ? (colorsUsed ? colorsUsed : (size_t)1 << bitCount) : 0;
+    size_t colorOffset = paletteOffset + paletteCount * 4;
+    size_t colorStride = (((size_t)w * bitCount + 31) / 32) * 4;
+    size_t maskOffset = colorOffset + colorStride * h;
+    size_t maskStride = (((size_t)w + 31) / 32) * 4;
+    if (!image.Has(colorOffset, colorStride * h) || !image.Has(maskOffset, maskStride * h))
+    {
+        return false;
+    }
+
+    *width = w;
+    *height = h;
+    rgba->resize((size_t)w * h * 4);
+
+    bool hasAlpha = false;
+    for (int y = 0; y < h; y++)
+    {
+        // Bitmap rows are stored bottom-up
+        const unsigned char* colorRow = image.Data + colorOffset + colorStride * (h - 1 - y);
+        const unsigned char* maskRow = image.Data + maskOffset + maskStride * (h - 1 - y);
+        unsigned char* dst = &(*rgba)[(size_t)y * w * 4];
+
+        for (int x = 0; x < w; x++, dst += 4)
+        {
+            unsigned char r, g, b, a = 255;
+            if (bitCount <= 8)
+            {
+                int bitOffset = x * bitCount;
+                int index = (colorRow[bitOffset / 8] >> (8 - bitCount - bitOffset % 8)) & ((1 << bitCount) - 1);
+                if ((size_t)index >= paletteCount)
+                {
+                    return false;
+                }
+                const unsigned char* entry = image.Data + paletteOffset + index * 4;
+                b = entry[0];
+                g = entry[1];
+                r = entry[2];
+            }
+            else
+            {
+                const unsigned char* pixel = colorRow + x * (bitCount / 8);
+                b = pixel[0];
+                g = pixel[1];
+                r = pixel[2];
+                if (bitCount == 32)
+                {
+                    a = pixel[3];
+                    hasAlpha |= a != 0;
+                }
+            }
+
+            // A set AND mask bit means the screen shows through (or gets inverted by the color, which we can't do).
+            bool transparent = (maskRow[x / 8] >> (7 - x % 8)) & 1;
+
+            dst[0] = r;
+            dst[1] = g;
+            dst[2] = b;
+            dst[3] = transparent ? 0 : a;
+        }
+    }
+
+    // 32-bit icons without any alpha rely on the AND mask only.
+    if (bitCount == 32 && !hasAlpha)
+    {
+        for (int y = 0; y < h; y++)
+        {
+            const unsigned char* maskRow = image.Data + maskOffset + maskStride * (h - 1 - y);
+            unsigned char* dst = &(*rgba)[(size_t)y * w * 4];
+            for (int x = 0; x < w; x++)
+            {
+                dst[x * 4 + 3] = ((maskRow[x / 8] >> (7 - x % 8)) & 1) ? 0 : 255;
+            }
+        }
+    }
+
+    return true;
+}
+
+bool AniCursor_LoadFromMemory(AniCursor* cursor, const void* data, size_t size)
+{
+    AniReader file = { (const unsigned char*)data, size };
+    if (!file.Has(0, 12) || file.U32(0) != ANI_FOURCC('R', 'I', 'F', 'F') || file.U32(8) != ANI_FOURCC('A', 'C', 'O', 'N'))
+    {
+        return false;
+    }
+
+    uint32_t frameCount = 0;
+    uint32_t stepCount = 0;
+    uint32_t defaultRate = 0;
+    uint32_t flags = 0;
+    bool hasHeader = false;
+    std::vector<uint32_t> rates;
+    std::vector<uint32_t> sequence;
+    std::vector<AniReader> icons;
+
+    size_t end = 8 + (size_t)file.U32(4);
+    if (end > size)
+    {
+        end = size;
+    }
+
+    size_t offset = 12;
+    while (file.Has(offset, 8) && offset + 8 <= end)
+    {
+        uint32_t id = file.U32(offset);
+        uint32_t chunkSize = file.U32(offset + 4);
+        size_t chunkData = offset + 8;
+        if (!file.Has(chunkData, chunkSize))
+        {
+            return false;
+        }
+
+        if (id == ANI_FOURCC('a', 'n', 'i', 'h') && chunkSize >= 36)
+        {
+            frameCount = file.U32(chunkData + 4);
+            stepCount = file.U32(chunkData + 8);
+            defaultRate = file.U32(chunkData + 28);
+            flags = file.U32(chunkData + 32);
+            hasHeader = true;
+        }
+        else if (id == ANI_FOURCC('r', 'a', 't', 'e'))
+        {
+            for (uint32_t i = 0; i + 4 <= chunkSize; i += 4)
+            {
+                rates.push_back(file.U32(chunkData + i));
+            }
+        }
+        else if (id == ANI_FOURCC('s', 'e', 'q', ' '))
+        {
+            for (uint32_t i = 0; i + 4 <= chunkSize; i += 4)
+            {
+                sequence.push_back(file.U32(chunkData + i));
+            }
+        }
+        else if (id == ANI_FOURCC('L', 'I', 'S', 'T') && chunkSize >= 4 && file.U32(chunkData) == ANI_FOURCC('f', 'r', 'a', 'm'))
+        {
+            size_t listOffset = chunkData + 4;
+            size_t listEnd = chunkData + chunkSize;
+            while (listOffset + 8 <= listEnd)
+            {
+                uint32_t subId = file.U32(listOffset);
+                uint32_t subSize = file.U32(listOffset + 4);
+                if (!file.Has(listOffset + 8, subSize) || listOffset + 8 + subSize > listEnd)
+                {
+                    return false;
+                }
+                if (subId == ANI_FOURCC('i', 'c', 'o', 'n'))
+                {
+                    AniReader icon = { file.Data + listOffset + 8, subSize };
+                    icons.push_back(icon);
+                }
+                listOffset += 8 + subSize + (subSize & 1);
+            }
+        }
+
+        // Chunks are padded to an even size
+        offset = chunkData + chunkSize + (chunkSize & 1);
+    }
+
+    if (!hasHeader || !(flags & ANI_FLAG_ICON) || frameCount == 0 || icons.size() < frameCount)
+    {
+        return false;
+    }
+
+    if (stepCount == 0)
+    {
+        stepCount = frameCount;
+    }
+
+    // Every step needs a frame before Steps is sized from the header: its own, or an entry of the sequence
+    if (stepCount > ((flags & ANI_FLAG_SEQUENCE) ? sequence.size() : frameCount))
+    {
+        return false;
+    }
+
+    cursor->FrameCount = (int)frameCount;
+    cursor->Pixels.clear();
+    cursor->Steps.resize(stepCount);
+
+    for (uint32_t i = 0; i < frameCount; i++)
+    {
+        int width, height, hotspotX, hotspotY;
+        std::vector<unsigned char> rgba;
+        if (!AniCursor_DecodeIcon(icons[i], &width, &height, &hotspotX, &hotspotY, &rgba))
+        {
+            return false;
+        }
+
+        if (i == 0)
+        {
+            cursor->Width = width;
+            cursor->Height = height;
+            cursor->HotspotX = hotspotX;
+            cursor->HotspotY = hotspotY;
+        }
+        else if (width != cursor->Width || height != cursor->Height)
+        {
+            return false;
+        }
+
+        cursor->Pixels.insert(cursor->Pixels.end(), rgba.begin(), rgba.end());
+    }
+
+    for (uint32_t i = 0; i < stepCount; i++)
+    {
+        uint32_t frame = (flags & ANI_FLAG_SEQUENCE) ? sequence[i] : i;
+        if (frame >= frameCount)
+        {
+            return false;
+        }
+
+        cursor->Steps[i].Frame = frame;
+        cursor->Steps[i].DurationJiffies = i < rates.size() ? rates[i] : defaultRate;
+        if (cursor->Steps[i].DurationJiffies == 0)
+        {
+            cursor->Steps[i].DurationJiffies = 1;
+        }
+    }
+
+    return true;
+}
+
+bool AniCursor_Load(AniCursor* cursor, const char* path)
+{
+    FILE* f = fopen(path, "rb");
+    if (!f)
+    {
+        return false;
+    }
+
+    std::vector<unsigned char> data;
+    unsigned char buffer[4096];
+    size_t read;
+    while ((read = fread(buffer, 1, sizeof(buffer), f)) > 0)
+    {
+        data.insert(data.end(), buffer, buffer + read);
+    }
+    fclose(f);
+
+    return !data.empty() && AniCursor_LoadFromMemory(cursor, data.data(), data.size());
+}
+
+uint64_t AniCursor_CycleNs(const AniCursor& cursor)
+{
+    uint64_t jiffies = 0;
+    for (const AniCursorStep& step : cursor.Steps)
+    {
+        jiffies += step.DurationJiffies;
+    }
+    return jiffies * ANI_JIFFY_NS;
+}
+
+int AniCursor_FrameAtTime(const AniCursor& cursor, uint64_t timeNs)
+{
+    uint64_t cycle = AniCursor_CycleNs(cursor);
+    if (cycle == 0)
+    {
+        return 0;
+    }
+
+    uint64_t t = timeNs % cycle;
+    for (const AniCursorStep& step : cursor.Steps)
+    {
+        uint64_t duration = step.DurationJiffies * ANI_JIFFY_NS;
+        if (t < duration)
+        {
+            return (int)step.Frame;
+        }
+        t -= duration;
+    }
+
+    return (int)cursor.Steps.back().Frame;
+}
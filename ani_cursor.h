@@ -0,0 +1,47 @@
+#pragma once
+
+// Decoder for animated cursor (.ani) files, producing RGBA8 images of every frame.
+//
+// An .ani file is a RIFF 'ACON' file with:
+//   'anih'      header: number of frames and steps, default display rate, flags
+//   'rate'      (optional) display time of each step, in jiffies (1/60th of a second)
+//   'seq '      (optional) frame index of each step
+//   LIST 'fram' one 'icon' chunk per frame, each a complete .ico/.cur file
+//
+// Icon images are decoded from their BITMAPINFOHEADER (1/4/8/24/32 bits per pixel) and AND mask.
+// PNG-compressed icon images are not supported.
+// This doesn't use any OS API, so the results can be checked on any platform.
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#define ANI_JIFFY_NS (1000000000ull / 60)
+
+struct AniCursorStep
+{
+    uint32_t Frame;
+    uint32_t DurationJiffies;
+};
+
+struct AniCursor
+{
+    int Width;
+    int Height;
+    int HotspotX;
+    int HotspotY;
+    int FrameCount;
+    std::vector<AniCursorStep> Steps;
+    std::vector<unsigned char> Pixels; // FrameCount images of Width*Height RGBA8 pixels, rows top to bottom
+
+    const unsigned char* FramePixels(int frame) const { return &Pixels[(size_t)frame * Width * Height * 4]; }
+};
+
+bool AniCursor_LoadFromMemory(AniCursor* cursor, const void* data, size_t size);
+bool AniCursor_Load(AniCursor* cursor, const char* path);
+
+// Duration of one full cycle of the animation.
+uint64_t AniCursor_CycleNs(const AniCursor& cursor);
+
+// Frame to display 'timeNs' after the animation started. Loops forever.
+int AniCursor_FrameAtTime(const AniCursor& cursor, uint64_t timeNs);
@@ -0,0 +1,122 @@
+#if defined(_MSC_VER) && !defined(_CRT_SECURE_NO_WARNINGS)
+#define _CRT_SECURE_NO_WARNINGS
+#endif
+
+#include "self_test.h"
+
+#include "ani_cursor.h"
+
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+// The app's cursor, from the working directory like main.cpp loads it
+#define ANI_CURSOR_TEST_PATH "Ragnarok.ani"
+
+// Decoded frames of Ragnarok.ani: FNV-1a of their RGBA8 pixels, and how many are opaque
+static const uint64_t kAniCursorTestFrameHashes[] = {
+    0xa3807d415d108b8full, 0x2651e2273c81240dull, 0x92147d243167fffaull,
+    0xab2e622d1be63da8ull, 0xa46b7b5b18f4dcb4ull, 0xe5dea8cab307cd0aull,
+};
+static const int kAniCursorTestOpaquePixels[] = { 313, 250, 176, 77, 177, 249 };
+
+static uint64_t AniCursorTest_Hash(const unsigned char* data, size_t size)
+{
+    uint64_t hash = 14695981039346656037ull;
+    for (size_t i = 0; i < size; i++)
+        hash = (hash ^ data[i]) * 1099511628211ull;
+    return hash;
+}
+
+// Decodes Ragnarok.ani and checks its header, its steps and timing, and the pixels of every frame, then checks that
+// every truncated copy of the file is rejected, and so are copies whose anih claims more steps than there are frames.
+SelfTestResult AniCursorTest_RunRagnarok()
+{
+    SelfTestResult result = {};
+
+    AniCursor cursor;
+    if (!SELF_TEST_CHECK(result, AniCursor_Load(&cursor, ANI_CURSOR_TEST_PATH)))
+    {
+        return result;
+    }
+
+    SELF_TEST_CHECK(result, cursor.Width == 32 && cursor.Height == 32);
+    SELF_TEST_CHECK(result, cursor.HotspotX == 0 && cursor.HotspotY == 0);
+    SELF_TEST_CHECK(result, cursor.FrameCount == 6 && cursor.Pixels.size() == 6 * 32 * 32 * 4);
+
+    // The first frame is held for half a second, the others for a tenth each
+    bool stepsMatch = cursor.Steps.size() == 6;
+    for (size_t i = 0; stepsMatch && i < cursor.Steps.size(); i++)
+        stepsMatch = cursor.Steps[i].Frame == i && cursor.Steps[i].DurationJiffies == (i == 0 ? 30u : 6u);
+    SELF_TEST_CHECK(result, stepsMatch);
+    SELF_TEST_CHECK(result, AniCursor_CycleNs(cursor) == 60 * ANI_JIFFY_NS);
+    SELF_TEST_CHECK(result, AniCursor_FrameAtTime(cursor, 0) == 0);
+    SELF_TEST_CHECK(result, AniCursor_FrameAtTime(cursor, 30 * ANI_JIFFY_NS - 1) == 0);
+    SELF_TEST_CHECK(result, AniCursor_FrameAtTime(cursor, 30 * ANI_JIFFY_NS) == 1);
+    SELF_TEST_CHECK(result, AniCursor_FrameAtTime(cursor, 59 * ANI_JIFFY_NS) == 5);
+    SELF_TEST_CHECK(result, AniCursor_FrameAtTime(cursor, 60 * ANI_JIFFY_NS + 36 * ANI_JIFFY_NS) == 2);
+
+    for (int frame = 0; frame < cursor.FrameCount && frame < 6; frame++)
+    {
+        const unsigned char* pixels = cursor.FramePixels(frame);
+        int opaque = 0;
+        for (int i = 0; i < cursor.Width * cursor.Height; i++)
+            opaque += pixels[i * 4 + 3] == 255;
+        SELF_TEST_CHECK(result, opaque == kAniCursorTestOpaquePixels[frame]);
+        SELF_TEST_CHECK(result, AniCursorTest_Hash(pixels, (size_t)cursor.Width * cursor.Height * 4) == kAniCursorTestFrameHashes[frame]);
+    }
+
+    // Rows go top to bottom: the arrow's tip is at the top left, next to the hotspot
+    const unsigned char* first = cursor.FramePixels(0);
+    SELF_TEST_CHECK(result, first[3] == 0 && first[(1 * 32 + 1) * 4 + 3] == 255);
+
+    FILE* f = fopen(ANI_CURSOR_TEST_PATH, "rb");
+    std::vector<unsigned char> data;
+    if (f)
+    {
+        unsigned char buffer[4096];
+        size_t read;
+        while ((read = fread(buffer, 1, sizeof(buffer), f)) > 0)
+            data.insert(data.end(), buffer, buffer + read);
+        fclose(f);
+    }
+
+    uint32_t truncatedLoaded = 0;
+    for (size_t size = 0; size < data.size(); size++)
+    {
+        AniCursor truncated;
+        truncatedLoaded += AniCursor_LoadFromMemory(&truncated, data.data(), size);
+    }
+    SELF_TEST_CHECK(result, !data.empty() && truncatedLoaded == 0);
+
+    // Corrupt the step count and flags of the anih chunk, whose fields start 8 bytes after its id
+    size_t anih = 0;
+    while (anih + 44 <= data.size() && memcmp(&data[anih], "anih", 4) != 0)
+        anih++;
+    if (!SELF_TEST_CHECK(result, anih + 44 <= data.size()))
+    {
+        return result;
+    }
+
+    const uint32_t corruptSteps[] = { 7, 0xFFFFFFFF };
+    uint32_t corruptLoaded = 0;
+    for (size_t i = 0; i < sizeof(corruptSteps) / sizeof(corruptSteps[0]); i++)
+    {
+        std::vector<unsigned char> corrupt = data;
+        memcpy(&corrupt[anih + 8 + 8], &corruptSteps[i], 4);
+        AniCursor cursorCorrupt;
+        corruptLoaded += AniCursor_LoadFromMemory(&cursorCorrupt, corrupt.data(), corrupt.size());
+    }
+
+    // Without a seq chunk, a sequenced cursor has no frame for any step
+    std::vector<unsigned char> unsequenced = data;
+    uint32_t flags;
+    memcpy(&flags, &unsequenced[anih + 8 + 32], 4);
+    flags |= 0x2; // ANI_FLAG_SEQUENCE
+    memcpy(&unsequenced[anih + 8 + 32], &flags, 4);
+    AniCursor cursorUnsequenced;
+    corruptLoaded += AniCursor_LoadFromMemory(&cursorUnsequenced, unsequenced.data(), unsequenced.size());
+    SELF_TEST_CHECK(result, corruptLoaded == 0);
+
+    return result;
+}
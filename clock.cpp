@@ -0,0 +1,147 @@
+#include "clock.h"
+
+#ifdef _WIN32
+#include <Windows.h>
+#include <mmsystem.h>
+#pragma comment(lib, "winmm.lib")
+#define CLOCK_SPIN_PAUSE() YieldProcessor()
+#else
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define CLOCK_SPIN_PAUSE() _mm_pause()
+#elif defined(__aarch64__) || defined(__arm__)
+#define CLOCK_SPIN_PAUSE() __asm__ __volatile__("yield")
+#else
+#define CLOCK_SPIN_PAUSE() ((void)0)
+#endif
+#endif
+
+// Below this much time left, stop asking the OS to sleep and spin instead.
+// On Windows, at least two ticks of the timer resolution, since Sleep() can overshoot by a whole tick.
+#define CLOCK_SPIN_THRESHOLD_NS 2000000
+
+PlatformClock::PlatformClock()
+{
+#ifdef _WIN32
+    LARGE_INTEGER frequency;
+    QueryPerformanceFrequency(&frequency);
+    Frequency = frequency.QuadPart;
+
+    // Sleep() rounds up to the system timer tick, 15.6ms by default. Ask for the finest one for the app's lifetime.
+    TimerPeriodMs = 0;
+    TIMECAPS caps;
+    if (timeGetDevCaps(&caps, sizeof(caps)) == MMSYSERR_NOERROR)
+    {
+        UINT period = caps.wPeriodMin > 1 ? caps.wPeriodMin : 1;
+        if (timeBeginPeriod(period) == TIMERR_NOERROR)
+        {
+            TimerPeriodMs = period;
+        }
+    }
+
+    // Without it, the tick is whatever the system is currently using
+    uint64_t tickNs;
+    if (TimerPeriodMs)
+    {
+        tickNs = uint64_t(TimerPeriodMs) * 1000000;
+    }
+    else
+    {
+        DWORD adjustment, increment;
+        BOOL disabled;
+        tickNs = GetSystemTimeAdjustment(&adjustment, &increment, &disabled) ? uint64_t(increment) * 100 : 15625000;
+    }
+    SpinThresholdNs = 2 * tickNs > CLOCK_SPIN_THRESHOLD_NS ? 2 * tickNs : CLOCK_SPIN_THRESHOLD_NS;
+#else
+    Frequency = 1000000000;
+    SpinThresholdNs = CLOCK_SPIN_THRESHOLD_NS;
+#endif
+}
+
+PlatformClock::~PlatformClock()
+{
+#ifdef _WIN32
+    if (TimerPeriodMs)
+    {
+        timeEndPeriod(TimerPeriodMs);
+    }
+#endif
+}
+
+uint64_t PlatformClock::NowNs()
+{
+#ifdef _WIN32
+    LARGE_INTEGER counter;
+    QueryPerformanceCounter(&counter);
+    return uint64_t(counter.QuadPart / Frequency) * 1000000000 + uint64_t(counter.QuadPart % Frequency) * 1000000000 / Frequency;
+#else
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return uint64_t(ts.tv_sec) * 1000000000 + uint64_t(ts.tv_nsec);
+#endif
+}
+
+void PlatformClock::SleepUntilNs(uint64_t deadline)
+{
+    for (;;)
+    {
+        uint64_t now = NowNs();
+        if (now >= deadline)
+        {
+            return;
+        }
+
+        uint64_t remaining = deadline - now;
+        if (remaining > SpinThresholdNs)
+        {
+            uint64_t sleepNs = remaining - SpinThresholdNs;
+#ifdef _WIN32
+            Sleep(DWORD(sleepNs / 1000000));
+#else
+            timespec ts;
+            ts.tv_sec = time_t(sleepNs / 1000000000);
+            ts.tv_nsec = long(sleepNs % 1000000000);
+            nanosleep(&ts, NULL);
+#endif
+        }
+        else
+        {
+            CLOCK_SPIN_PAUSE();
+        }
+    }
+}
+
+VirtualClock::VirtualClock(uint64_t startNs)
+{
+    Now.store(startNs, std::memory_order_relaxed);
+}
+
+uint64_t VirtualClock::NowNs()
+{
+    return Now.load(std::memory_order_acquire);
+}
+
+void VirtualClock::SleepUntilNs(uint64_t deadline)
+{
+    uint64_t now = Now.load(std::memory_order_relaxed);
+    while (now < deadline && !Now.compare_exchange_weak(now, deadline, std::memory_order_acq_rel, std::memory_order_relaxed)) { }
+}
+
+void VirtualClock::AdvanceNs(uint64_t ns)
+{
+    Now.fetch_add(ns, std::memory_order_acq_rel);
+}
+
+static PlatformClock g_PlatformClock;
+static std::atomic<Clock*> g_Clock(&g_PlatformClock);
+
+Clock* GetClock()
+{
+    return g_Clock.load(std::memory_order_acquire);
+}
+
+void SetClock(Clock* clock)
+{
+    g_Clock.store(clock ? clock : &g_PlatformClock, std::memory_order_release);
+}
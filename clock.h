@@ -0,0 +1,60 @@
+#pragma once
+
+// Monotonic nanosecond clock used for frame pacing, animation, ImGui's DeltaTime and latency measurements.
+//
+// Code should read time through GetClock() rather than calling the OS directly, so a VirtualClock can be
+// swapped in to run the same code deterministically (eg. replaying input traces or testing pacing on a build machine).
+
+#include <atomic>
+#include <cstdint>
+
+class Clock
+{
+public:
+    virtual ~Clock() {}
+
+    // Nanoseconds since an arbitrary origin. Never goes backwards.
+    virtual uint64_t NowNs() = 0;
+
+    // Returns once NowNs() >= deadline.
+    virtual void SleepUntilNs(uint64_t deadline) = 0;
+};
+
+// QueryPerformanceCounter on Windows, CLOCK_MONOTONIC elsewhere.
+// SleepUntilNs sleeps coarsely with the OS scheduler then spins, since OS sleeps only have the timer resolution.
+// On Windows, the instance raises the system timer resolution with timeBeginPeriod for as long as it exists.
+class PlatformClock : public Clock
+{
+public:
+    PlatformClock();
+    ~PlatformClock();
+
+    uint64_t NowNs() override;
+    void SleepUntilNs(uint64_t deadline) override;
+
+private:
+    int64_t Frequency;
+    uint64_t SpinThresholdNs;   // Spin instead of sleeping when the deadline is closer than this
+#ifdef _WIN32
+    unsigned TimerPeriodMs;     // Passed to timeBeginPeriod, 0 if it failed
+#endif
+};
+
+// Time only moves when told to. Sleeping jumps straight to the deadline.
+class VirtualClock : public Clock
+{
+public:
+    explicit VirtualClock(uint64_t startNs = 0);
+
+    uint64_t NowNs() override;
+    void SleepUntilNs(uint64_t deadline) override;
+
+    void AdvanceNs(uint64_t ns);
+
+private:
+    std::atomic<uint64_t> Now;
+};
+
+// The clock used by the app. Defaults to a PlatformClock.
+Clock* GetClock();
+void SetClock(Clock* clock);
@@ -0,0 +1,159 @@
+#include "frame_scheduler.h"
+
+#include <algorithm>
+#include <cmath>
+
+// Swaps further than this fraction of a period from the predicted vblank are ignored for phase and period tracking,
+// since they are most likely not vsynced (eg. adaptive VSync tearing, or the window being moved).
+#define FRAME_SCHEDULER_MAX_VBLANK_ERROR 0.25
+
+void FrameDurationEstimator::Init(double ewmaAlpha, double percentile)
+{
+    EwmaNs = 0.0;
+    EwmaAlpha = ewmaAlpha;
+    Percentile = percentile;
+    SampleCount = 0;
+}
+
+void FrameDurationEstimator::AddSample(uint64_t ns)
+{
+    EwmaNs = SampleCount == 0 ? double(ns) : EwmaNs + EwmaAlpha * (double(ns) - EwmaNs);
+    Samples[SampleCount % FRAME_SCHEDULER_WINDOW] = ns;
+    SampleCount++;
+}
+
+uint64_t FrameDurationEstimator::PercentileNs() const
+{
+    uint32_t count = std::min<uint32_t>(SampleCount, FRAME_SCHEDULER_WINDOW);
+    if (count == 0)
+    {
+        return 0;
+    }
+
+    uint64_t sorted[FRAME_SCHEDULER_WINDOW];
+    std::copy(Samples, Samples + count, sorted);
+
+    uint32_t rank = (uint32_t)std::ceil(Percentile / 100.0 * count);
+    rank = std::max<uint32_t>(1, std::min(rank, count));
+    std::nth_element(sorted, sorted + rank - 1, sorted + count);
+    return sorted[rank - 1];
+}
+
+uint64_t FrameDurationEstimator::EstimateNs() const
+{
+    return std::max(PercentileNs(), (uint64_t)EwmaNs);
+}
+
+void FrameScheduler_DefaultConfig(FrameSchedulerConfig* config)
+{
+    config->NominalRefreshHz = 60.0;
+    config->SafetyMarginMs = 1.0;
+    config->EwmaAlpha = 0.1;
+    config->DurationPercentile = 95.0;
+}
+
+void FrameScheduler::Init(const FrameSchedulerConfig& config)
+{
+    Config = config;
+    Period = 1e9 / config.NominalRefreshHz;
+    LastVblank = 0.0;
+    SwapCount = 0;
+    CPUTime.Init(config.EwmaAlpha, config.DurationPercentile);
+    GPUTime.Init(config.EwmaAlpha, config.DurationPercentile);
+    WakeLateness.Init(config.EwmaAlpha, config.DurationPercentile);
+    IdleTime.Init(config.EwmaAlpha, config.DurationPercentile);
+}
+
+void FrameScheduler::OnSwapCompleted(uint64_t ns)
+{
+    double t = double(ns);
+
+    if (SwapCount == 0)
+    {
+        LastVblank = t;
+        SwapCount++;
+        return;
+    }
+
+    // How many vblanks went by since the last one we know of. Frames can miss vblanks, or use a swap interval > 1.
+    double elapsed = t - LastVblank;
+    double vblanks = std::floor(elapsed / Period + 0.5);
+    if (vblanks < 1.0)
+    {
+        return;
+    }
+
+    double predicted = LastVblank + vblanks * Period;
+    double error = t - predicted;
+    if (std::fabs(error) > FRAME_SCHEDULER_MAX_VBLANK_ERROR * Period)
+    {
+        // Not vsynced. Keep the phase but don't let it drift too far behind.
+        if (elapsed > 4.0 * Period)
+        {
+            LastVblank = predicted;
+        }
+        return;
+    }
+
+    // Spread the error between the phase and the period.
+    Period += Config.EwmaAlpha * error / vblanks;
+    LastVblank = predicted + Config.EwmaAlpha * error;
+    if (LastVblank > t)
+    {
+        LastVblank = t;
+    }
+    SwapCount++;
+}
+
+void FrameScheduler::OnCPUFrameTime(uint64_t ns)
+{
+    CPUTime.AddSample(ns);
+}
+
+void FrameScheduler::OnGPUFrameTime(uint64_t ns)
+{
+    GPUTime.AddSample(ns);
+}
+
+void FrameScheduler::OnFrameStarted(uint64_t requestedNs, uint64_t actualNs)
+{
+    WakeLateness.AddSample(actualNs > requestedNs ? actualNs - requestedNs : 0);
+}
+
+void FrameScheduler::OnFrameIdle(uint64_t ns)
+{
+    IdleTime.AddSample(ns);
+}
+
+uint64_t FrameScheduler::BudgetNs() const
+{
+    return CPUTime.EstimateNs() + GPUTime.EstimateNs() + (uint64_t)(Config.SafetyMarginMs * 1e6);
+}
+
+uint64_t FrameScheduler::NextFrameStart(uint64_t now, int swapInterval) const
+{
+    if (!HasVblankEstimate() || CPUTime.SampleCount == 0)
+    {
+        return now;
+    }
+
+    double budget = double(BudgetNs());
+    if (budget >= Period * std::max(swapInterval, 1))
+    {
+        // The frame can't fit: start right away and let it take as many vblanks as it needs.
+        return now;
+    }
+
+    double t = double(now);
+    double target = LastVblank + Period * std::max(swapInterval, 1);
+
+    // If the last known vblank is stale, find the first upcoming one.
+    if (target - budget < t)
+    {
+        double vblanksAhead = std::ceil((t + budget - LastVblank) / Period);
+        target = LastVblank + vblanksAhead * Period;
+    }
+
+    double start = target - budget;
+    return start > t ? (uint64_t)start : now;
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+// Decides when to start drawing a frame so that it is done just before the vblank it will be presented at.
+//
+// Rather than sleeping a fixed amount before drawing, the scheduler:
+// - estimates the vblank period and phase from the times at which swaps complete (with vsync, they complete at vblank),
+// - tracks how long the CPU takes to submit the frame and how long the GPU takes to render it,
+// - and returns the latest start time that still leaves room for both (plus a safety margin) before the target vblank.
+//
+// The scheduler never reads a clock itself: every method takes timestamps in nanoseconds, so it can be driven by
+// the real clock in the app or by synthetic timing traces in tests.
+
+#include <cstdint>
+
+#define FRAME_SCHEDULER_WINDOW 64
+
+// Tracks a duration with both an EWMA and a sliding window percentile, and estimates with the larger of the two.
+struct FrameDurationEstimator
+{
+    double EwmaNs;
+    double EwmaAlpha;
+    double Percentile;          // 0..100, of the last FRAME_SCHEDULER_WINDOW samples
+    uint64_t Samples[FRAME_SCHEDULER_WINDOW];
+    uint32_t SampleCount;
+
+    void Init(double ewmaAlpha, double percentile);
+    void AddSample(uint64_t ns);
+    uint64_t PercentileNs() const;
+    uint64_t EstimateNs() const;
+};
+
+struct FrameSchedulerConfig
+{
+    double NominalRefreshHz;    // Initial guess for the vblank period, eg. from the display mode
+    double SafetyMarginMs;      // Extra time left before the vblank to absorb outliers
+    double EwmaAlpha;           // Weight of new samples, for both the vblank and the duration estimators
+    double DurationPercentile;  // Percentile of recent CPU/GPU durations to plan for
+};
+
+void FrameScheduler_DefaultConfig(FrameSchedulerConfig* config);
+
+class FrameScheduler
+{
+public:
+    void Init(const FrameSchedulerConfig& config);
+
+    // Time at which a vsynced swap completed (eg. when SwapBuffers+glFinish returned).
+    void OnSwapCompleted(uint64_t ns);
+
+    // CPU time from the scheduled start of the frame until it was fully submitted.
+    void OnCPUFrameTime(uint64_t ns);
+
+    // GPU time spent rendering the frame.
+    void OnGPUFrameTime(uint64_t ns);
+
+    // What actually happened on the caller's clock, to check the schedule against real hardware. Not used for planning.
+    // The time the caller asked to wake up at (from NextFrameStart) and the time it did.
+    void OnFrameStarted(uint64_t requestedNs, uint64_t actualNs);
+    // Time from the end of the frame's GPU work to the vblank it was presented at.
+    void OnFrameIdle(uint64_t ns);
+
+    // Latest time at which to start the frame so it is done before a vblank at least 'swapInterval' vblanks after
+    // the last swap. Returns 'now' if there isn't enough information yet or the frame is already late.
+    uint64_t NextFrameStart(uint64_t now, int swapInterval) const;
+
+    bool HasVblankEstimate() const { return SwapCount >= 2; }
+    double PeriodNs() const { return Period; }
+    uint64_t LastVblankNs() const { return (uint64_t)LastVblank; }
+    uint64_t BudgetNs() const;
+
+    FrameDurationEstimator CPUTime;
+    FrameDurationEstimator GPUTime;
+    FrameDurationEstimator WakeLateness;    // Of the actual frame start after the requested one, 0 if on time
+    FrameDurationEstimator IdleTime;
+
+private:
+    FrameSchedulerConfig Config;
+    double Period;
+    double LastVblank;
+    uint64_t SwapCount;
+};
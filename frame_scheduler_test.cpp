@@ -0,0 +1,118 @@
+#include "self_test.h"
+
+#include "frame_scheduler.h"
+#include "clock.h"
+
+#include <cmath>
+
+// A 59.94 Hz display (the scheduler is told 60 Hz, like the display mode reports) whose vblank phase isn't known
+#define FRAME_SCHEDULER_TEST_PERIOD_NS 16683350.0
+#define FRAME_SCHEDULER_TEST_PHASE_NS 5123457.0
+#define FRAME_SCHEDULER_TEST_FRAMES 1200
+
+// The period estimate moves with the jitter of the swap times, so it's only expected within 0.1% of the real one
+#define FRAME_SCHEDULER_TEST_PERIOD_TOLERANCE_NS 20000.0
+
+// Deterministic jitter, so a failure reproduces
+struct FrameSchedulerTestRandom
+{
+    uint32_t State;
+
+    // Uniform in [-1, 1]
+    double Next()
+    {
+        State = State * 1664525u + 1013904223u;
+        return (double)(State >> 8) / (double)(1u << 23) - 1.0;
+    }
+};
+
+struct FrameSchedulerTestStats
+{
+    uint32_t Frames;
+    uint32_t MissedVblanks;     // Frames presented later than the vblank after the previous frame's
+    double   IdleNs;            // Time from the end of each frame to its vblank, which is latency added to the frame
+};
+
+// Runs frames of the given CPU and GPU times through the scheduler on a virtual clock. Each frame sleeps until the
+// start the scheduler asks for, is done CPU+GPU time later, and its swap completes at the first vblank after that
+// (but never two frames in one vblank), up to 50 us later. Every 50th swap returns late enough to look unsynced,
+// though not so late that the next frame can't make its vblank.
+static FrameSchedulerTestStats FrameSchedulerTest_Run(FrameScheduler& scheduler, VirtualClock& clock, FrameSchedulerTestRandom& random,
+    int frames, double cpuNs, double gpuNs, int64_t& lastVblankIndex)
+{
+    FrameSchedulerTestStats stats = {};
+    for (int i = 0; i < frames; i++)
+    {
+        uint64_t start = scheduler.NextFrameStart(clock.NowNs(), 1);
+        clock.SleepUntilNs(start);
+        scheduler.OnFrameStarted(start, clock.NowNs());
+
+        // Now and then the CPU side takes a lot longer, like a frame that loads something
+        double cpu = cpuNs + 300000.0 * random.Next() + (i % 97 == 0 ? 1500000.0 : 0.0);
+        double gpu = gpuNs + 500000.0 * random.Next();
+        double done = (double)clock.NowNs() + cpu + gpu;
+
+        int64_t vblankIndex = (int64_t)std::ceil((done - FRAME_SCHEDULER_TEST_PHASE_NS) / FRAME_SCHEDULER_TEST_PERIOD_NS);
+        if (vblankIndex <= lastVblankIndex)
+            vblankIndex = lastVblankIndex + 1;
+        if (lastVblankIndex >= 0 && vblankIndex > lastVblankIndex + 1)
+            stats.MissedVblanks++;
+        lastVblankIndex = vblankIndex;
+
+        double vblank = FRAME_SCHEDULER_TEST_PHASE_NS + vblankIndex * FRAME_SCHEDULER_TEST_PERIOD_NS;
+        double swapCompleted = vblank + 25000.0 + 25000.0 * random.Next() + (i % 50 == 49 ? 5000000.0 : 0.0);
+        double idle = vblank - done > 0.0 ? vblank - done : 0.0;
+        stats.IdleNs += idle;
+        scheduler.OnFrameIdle((uint64_t)idle);
+        stats.Frames++;
+
+        scheduler.OnCPUFrameTime((uint64_t)cpu);
+        scheduler.OnGPUFrameTime((uint64_t)gpu);
+        clock.SleepUntilNs((uint64_t)swapCompleted);
+        scheduler.OnSwapCompleted(clock.NowNs());
+    }
+    return stats;
+}
+
+// Drives the scheduler with a synthetic timing trace: it has to lock on to the real refresh rate, start frames late
+// enough that they finish close to their vblank, rarely miss one, and adapt when the GPU load goes up.
+SelfTestResult FrameSchedulerTest_RunSyntheticTrace()
+{
+    SelfTestResult result = {};
+
+    FrameSchedulerConfig config;
+    FrameScheduler_DefaultConfig(&config);
+    FrameScheduler scheduler;
+    scheduler.Init(config);
+
+    VirtualClock clock(1000000);
+    FrameSchedulerTestRandom random = { 12345 };
+    int64_t lastVblankIndex = -1;
+
+    // Warm up, then measure with the estimates settled
+    FrameSchedulerTest_Run(scheduler, clock, random, 200, 2000000.0, 4000000.0, lastVblankIndex);
+    SELF_TEST_CHECK(result, scheduler.HasVblankEstimate());
+    SELF_TEST_CHECK(result, std::fabs(scheduler.PeriodNs() - FRAME_SCHEDULER_TEST_PERIOD_NS) < FRAME_SCHEDULER_TEST_PERIOD_TOLERANCE_NS);
+
+    FrameSchedulerTestStats steady = FrameSchedulerTest_Run(scheduler, clock, random, FRAME_SCHEDULER_TEST_FRAMES,
+        2000000.0, 4000000.0, lastVblankIndex);
+    SELF_TEST_CHECK(result, std::fabs(scheduler.PeriodNs() - FRAME_SCHEDULER_TEST_PERIOD_NS) < FRAME_SCHEDULER_TEST_PERIOD_TOLERANCE_NS);
+    SELF_TEST_CHECK(result, steady.MissedVblanks <= steady.Frames / 50);
+
+    // Starting right after the previous swap would leave ~10 ms idle before every vblank
+    SELF_TEST_CHECK(result, steady.IdleNs / steady.Frames < 3000000.0);
+
+    // The virtual clock wakes up exactly on time. The app shows the same statistics measured on the platform clock.
+    SELF_TEST_CHECK(result, scheduler.WakeLateness.SampleCount > 0 && scheduler.WakeLateness.EstimateNs() == 0);
+    SELF_TEST_CHECK(result, scheduler.IdleTime.SampleCount > 0 && scheduler.IdleTime.EwmaNs < 3000000.0);
+
+    // The GPU load jumps: a few frames miss while the estimates catch up, then it's steady again
+    FrameSchedulerTestStats jump = FrameSchedulerTest_Run(scheduler, clock, random, 100, 2000000.0, 8000000.0, lastVblankIndex);
+    SELF_TEST_CHECK(result, jump.MissedVblanks <= 10);
+    FrameSchedulerTestStats heavy = FrameSchedulerTest_Run(scheduler, clock, random, FRAME_SCHEDULER_TEST_FRAMES,
+        2000000.0, 8000000.0, lastVblankIndex);
+    SELF_TEST_CHECK(result, heavy.MissedVblanks <= heavy.Frames / 50);
+    SELF_TEST_CHECK(result, heavy.IdleNs / heavy.Frames < 3000000.0);
+
+    return result;
+}
@@ -0,0 +1,903 @@
+#if defined(_MSC_VER) && !defined(_CRT_SECURE_NO_WARNINGS)
+#define _CRT_SECURE_NO_WARNINGS
+#endif
+
+#include "gl_recorder.h"
+
+#include <cstdio>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+struct GLRecorderFunction
+{
+    const char* Name;
+    bool IsDraw;
+    GLRecorderProc Emulation;
+};
+
+static GLRecorderFunction g_Functions[GL_RECORDER_MAX_FUNCTIONS];
+static uint32_t g_FunctionCount;
+
+static GLRecorderStats g_FrameStats;        // Of the current frame
+static GLRecorderStats g_LastFrameStats;
+static GLRecorderStats g_TotalStats;
+
+static bool g_Recording = true;
+static std::vector<uint8_t> g_Commands;
+
+// Emulated state, keyed by the enum that queries it and its index (eg. the texture unit of a texture binding).
+// Multi-valued state (viewport and scissor box) uses one index per value.
+static std::unordered_map<uint64_t, GLint> g_State;
+
+static GLuint g_NextName;
+static std::unordered_map<GLuint, std::vector<uint8_t>> g_BufferStorage;
+static std::map<std::pair<GLuint, std::string>, GLint> g_Locations;
+static std::unordered_map<GLuint, GLint> g_NextLocation;
+
+#define GL_RECORDER_PROGRAM_BINARY_MAGIC "GLRECBIN"
+
+struct GLRecorderProgram
+{
+    std::vector<GLuint> Shaders;
+    bool Linked;
+    std::string Binary;     // GL_RECORDER_PROGRAM_BINARY_MAGIC then the sources of the shaders
+};
+
+static GLenum g_ProgramBinaryFormat = GL_RECORDER_PROGRAM_BINARY_FORMAT;
+static std::unordered_map<GLuint, std::string> g_ShaderSources;
+static std::unordered_map<GLuint, GLRecorderProgram> g_Programs;
+
+static const GLenum kBufferBindings[][2] = {
+    { GL_ARRAY_BUFFER, GL_ARRAY_BUFFER_BINDING },
+    { GL_ATOMIC_COUNTER_BUFFER, GL_ATOMIC_COUNTER_BUFFER_BINDING },
+    { GL_COPY_READ_BUFFER, GL_COPY_READ_BUFFER_BINDING },
+    { GL_COPY_WRITE_BUFFER, GL_COPY_WRITE_BUFFER_BINDING },
+    { GL_DISPATCH_INDIRECT_BUFFER, GL_DISPATCH_INDIRECT_BUFFER_BINDING },
+    { GL_DRAW_INDIRECT_BUFFER, GL_DRAW_INDIRECT_BUFFER_BINDING },
+    { GL_ELEMENT_ARRAY_BUFFER, GL_ELEMENT_ARRAY_BUFFER_BINDING },
+    { GL_PIXEL_PACK_BUFFER, GL_PIXEL_PACK_BUFFER_BINDING },
+    { GL_PIXEL_UNPACK_BUFFER, GL_PIXEL_UNPACK_BUFFER_BINDING },
+    { GL_QUERY_BUFFER, GL_QUERY_BUFFER_BINDING },
+    { GL_SHADER_STORAGE_BUFFER, GL_SHADER_STORAGE_BUFFER_BINDING },
+    { GL_TRANSFORM_FEEDBACK_BUFFER, GL_TRANSFORM_FEEDBACK_BUFFER_BINDING },
+    { GL_UNIFORM_BUFFER, GL_UNIFORM_BUFFER_BINDING },
+};
+
+static const GLenum kTextureBindings[][2] = {
+    { GL_TEXTURE_1D, GL_TEXTURE_BINDING_1D },
+    { GL_TEXTURE_1D_ARRAY, GL_TEXTURE_BINDING_1D_ARRAY },
+    { GL_TEXTURE_2D, GL_TEXTURE_BINDING_2D },
+    { GL_TEXTURE_2D_ARRAY, GL_TEXTURE_BINDING_2D_ARRAY },
+    { GL_TEXTURE_2D_MULTISAMPLE, GL_TEXTURE_BINDING_2D_MULTISAMPLE },
+    { GL_TEXTURE_2D_MULTISAMPLE_ARRAY, GL_TEXTURE_BINDING_2D_MULTISAMPLE_ARRAY },
+    { GL_TEXTURE_3D, GL_TEXTURE_BINDING_3D },
+    { GL_TEXTURE_BUFFER, GL_TEXTURE_BINDING_BUFFER },
+    { GL_TEXTURE_CUBE_MAP, GL_TEXTURE_BINDING_CUBE_MAP },
+    { GL_TEXTURE_CUBE_MAP_ARRAY, GL_TEXTURE_BINDING_CUBE_MAP_ARRAY },
+    { GL_TEXTURE_RECTANGLE, GL_TEXTURE_BINDING_RECTANGLE },
+};
+
+static GLenum GLRecorder_FindBinding(const GLenum (*bindings)[2], size_t count, GLenum target)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        if (bindings[i][0] == target)
+            return bindings[i][1];
+    }
+    return 0;
+}
+
+static bool GLRecorder_IsBinding(const GLenum (*bindings)[2], size_t count, GLenum pname)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        if (bindings[i][1] == pname)
+            return true;
+    }
+    return false;
+}
+
+#define GL_RECORDER_COUNTOF(a) (sizeof(a) / sizeof(a[0]))
+#define GL_RECORDER_BUFFER_BINDING(target) GLRecorder_FindBinding(kBufferBindings, GL_RECORDER_COUNTOF(kBufferBindings), target)
+#define GL_RECORDER_TEXTURE_BINDING(target) GLRecorder_FindBinding(kTextureBindings, GL_RECORDER_COUNTOF(kTextureBindings), target)
+
+static void GLRecorder_Count(uint64_t GLRecorderStats::* stat, uint64_t amount)
+{
+    g_FrameStats.*stat += amount;
+    g_TotalStats.*stat += amount;
+}
+
+static uint64_t GLRecorder_StateKey(GLenum pname, GLuint index)
+{
+    return ((uint64_t)pname << 32) | index;
+}
+
+static GLint GLRecorder_GetState(GLenum pname, GLuint index)
+{
+    auto found = g_State.find(GLRecorder_StateKey(pname, index));
+    return found != g_State.end() ? found->second : 0;
+}
+
+// Returns true if the value changed.
+static bool GLRecorder_SetState(GLenum pname, GLuint index, GLint value)
+{
+    GLint& state = g_State[GLRecorder_StateKey(pname, index)];
+    bool changed = state != value;
+    state = value;
+    return changed;
+}
+
+static void GLRecorder_CountStateCall(bool changed)
+{
+    if (!changed)
+    {
+        GLRecorder_Count(&GLRecorderStats::RedundantStateCalls, 1);
+    }
+}
+
+// Index of the state that a query of pname returns
+static GLuint GLRecorder_StateIndex(GLenum pname)
+{
+    if (pname == GL_SAMPLER_BINDING || GLRecorder_IsBinding(kTextureBindings, GL_RECORDER_COUNTOF(kTextureBindings), pname))
+        return (GLuint)(GLRecorder_GetState(GL_ACTIVE_TEXTURE, 0) - GL_TEXTURE0);
+    if (pname == GL_ELEMENT_ARRAY_BUFFER_BINDING)
+        return (GLuint)GLRecorder_GetState(GL_VERTEX_ARRAY_BINDING, 0);
+    return 0;
+}
+
+// Sets all the bindings of pnames that name the deleted object back to 0.
+static void GLRecorder_UnbindDeleted(const GLenum (*bindings)[2], size_t count, GLuint name)
+{
+    for (auto& state : g_State)
+    {
+        if (state.second == (GLint)name && GLRecorder_IsBinding(bindings, count, (GLenum)(state.first >> 32)))
+            state.second = 0;
+    }
+}
+
+static GLuint GLRecorder_BoundBuffer(GLenum target)
+{
+    GLenum binding = GL_RECORDER_BUFFER_BINDING(target);
+    return binding ? (GLuint)GLRecorder_GetState(binding, GLRecorder_StateIndex(binding)) : 0;
+}
+
+static void GLRecorder_GenNames(GLsizei n, GLuint* names)
+{
+    for (GLsizei i = 0; i < n; i++)
+        names[i] = g_NextName++;
+}
+
+static void GLRecorder_AllocateBuffer(GLuint buffer, GLsizeiptr size, const void* data)
+{
+    std::vector<uint8_t>& storage = g_BufferStorage[buffer];
+    storage.assign((size_t)size, 0);
+    if (data)
+    {
+        memcpy(storage.data(), data, (size_t)size);
+        GLRecorder_Count(&GLRecorderStats::BytesUploaded, (uint64_t)size);
+    }
+}
+
+static void GLRecorder_WriteBuffer(GLuint buffer, GLintptr offset, GLsizeiptr size, const void* data)
+{
+    auto found = g_BufferStorage.find(buffer);
+    if (found != g_BufferStorage.end() && data && offset >= 0 && (size_t)(offset + size) <= found->second.size())
+    {
+        memcpy(found->second.data() + offset, data, (size_t)size);
+    }
+    GLRecorder_Count(&GLRecorderStats::BytesUploaded, (uint64_t)size);
+}
+
+static void* GLRecorder_MapBuffer(GLuint buffer, GLintptr offset, GLsizeiptr length, bool write)
+{
+    auto found = g_BufferStorage.find(buffer);
+    if (found == g_BufferStorage.end() || offset < 0 || (size_t)(offset + length) > found->second.size())
+    {
+        return NULL;
+    }
+
+    if (write)
+    {
+        GLRecorder_Count(&GLRecorderStats::BytesMapped, (uint64_t)length);
+    }
+    return found->second.data() + offset;
+}
+
+// Ignores the pixel store parameters, which the app leaves at their defaults.
+static uint64_t GLRecorder_PixelsSize(GLsizei width, GLsizei height, GLsizei depth, GLenum format, GLenum type)
+{
+    uint64_t components;
+    switch (format)
+    {
+    case GL_RED: case GL_RED_INTEGER: case GL_GREEN: case GL_BLUE: case GL_DEPTH_COMPONENT: case GL_STENCIL_INDEX: components = 1; break;
+    case GL_RG: case GL_RG_INTEGER: case GL_DEPTH_STENCIL: components = 2; break;
+    case GL_RGB: case GL_RGB_INTEGER: case GL_BGR: case GL_BGR_INTEGER: components = 3; break;
+    default: components = 4; break;
+    }
+
+    uint64_t pixelSize;
+    switch (type)
+    {
+    case GL_UNSIGNED_BYTE: case GL_BYTE: pixelSize = components; break;
+    case GL_UNSIGNED_SHORT: case GL_SHORT: case GL_HALF_FLOAT: pixelSize = components * 2; break;
+    case GL_UNSIGNED_INT: case GL_INT: case GL_FLOAT: pixelSize = components * 4; break;
+    case GL_UNSIGNED_BYTE_3_3_2: case GL_UNSIGNED_BYTE_2_3_3_REV: pixelSize = 1; break;
+    case GL_UNSIGNED_SHORT_5_6_5: case GL_UNSIGNED_SHORT_5_6_5_REV:
+    case GL_UNSIGNED_SHORT_4_4_4_4: case GL_UNSIGNED_SHORT_4_4_4_4_REV:
+    case GL_UNSIGNED_SHORT_5_5_5_1: case GL_UNSIGNED_SHORT_1_5_5_5_REV: pixelSize = 2; break;
+    case GL_FLOAT_32_UNSIGNED_INT_24_8_REV: pixelSize = 8; break;
+    default: pixelSize = 4; break;
+    }
+
+    return (uint64_t)width * height * depth * pixelSize;
+}
+
+static void GLRecorder_UploadPixels(GLsizei width, GLsizei height, GLsizei depth, GLenum format, GLenum type, const void* pixels)
+{
+    // With a pixel unpack buffer bound, pixels is an offset into it and nothing comes from client memory.
+    if (pixels && GLRecorder_BoundBuffer(GL_PIXEL_UNPACK_BUFFER) == 0)
+    {
+        GLRecorder_Count(&GLRecorderStats::BytesUploaded, GLRecorder_PixelsSize(width, height, depth, format, type));
+    }
+}
+
+static void GLRecorder_GetLocation(GLuint program, const GLchar* name, GLint* location)
+{
+    auto found = g_Locations.find(std::make_pair(program, std::string(name)));
+    if (found != g_Locations.end())
+    {
+        *location = found->second;
+        return;
+    }
+
+    *location = g_NextLocation[program]++;
+    g_Locations[std::make_pair(program, std::string(name))] = *location;
+}
+
+// Emulations, called by the stubs after recording the call
+
+static void GLAPIENTRY GLRecorder_glGenBuffers(GLsizei n, GLuint* buffers) { GLRecorder_GenNames(n, buffers); }
+static void GLAPIENTRY GLRecorder_glGenTextures(GLsizei n, GLuint* textures) { GLRecorder_GenNames(n, textures); }
+static void GLAPIENTRY GLRecorder_glGenVertexArrays(GLsizei n, GLuint* arrays) { GLRecorder_GenNames(n, arrays); }
+static void GLAPIENTRY GLRecorder_glGenSamplers(GLsizei count, GLuint* samplers) { GLRecorder_GenNames(count, samplers); }
+static void GLAPIENTRY GLRecorder_glGenQueries(GLsizei n, GLuint* ids) { GLRecorder_GenNames(n, ids); }
+static void GLAPIENTRY GLRecorder_glGenFramebuffers(GLsizei n, GLuint* framebuffers) { GLRecorder_GenNames(n, framebuffers); }
+static void GLAPIENTRY GLRecorder_glGenRenderbuffers(GLsizei n, GLuint* renderbuffers) { GLRecorder_GenNames(n, renderbuffers); }
+static void GLAPIENTRY GLRecorder_glCreateBuffers(GLsizei n, GLuint* buffers) { GLRecorder_GenNames(n, buffers); }
+static void GLAPIENTRY GLRecorder_glCreateTextures(GLenum, GLsizei n, GLuint* textures) { GLRecorder_GenNames(n, textures); }
+static void GLAPIENTRY GLRecorder_glCreateVertexArrays(GLsizei n, GLuint* arrays) { GLRecorder_GenNames(n, arrays); }
+static void GLAPIENTRY GLRecorder_glCreateSamplers(GLsizei n, GLuint* samplers) { GLRecorder_GenNames(n, samplers); }
+static void GLAPIENTRY GLRecorder_glCreateQueries(GLenum, GLsizei n, GLuint* ids) { GLRecorder_GenNames(n, ids); }
+static void GLAPIENTRY GLRecorder_glCreateFramebuffers(GLsizei n, GLuint* framebuffers) { GLRecorder_GenNames(n, framebuffers); }
+static GLuint GLAPIENTRY GLRecorder_glCreateShader(GLenum) { return g_NextName++; }
+static GLuint GLAPIENTRY GLRecorder_glCreateProgram() { return g_NextName++; }
+static GLuint GLAPIENTRY GLRecorder_glCreateShaderProgramv(GLenum, GLsizei, const GLchar* const*) { return g_NextName++; }
+
+static void GLAPIENTRY GLRecorder_glDeleteBuffers(GLsizei n, const GLuint* buffers)
+{
+    for (GLsizei i = 0; i < n; i++)
+    {
+        if (buffers[i] == 0)
+            continue;
+        g_BufferStorage.erase(buffers[i]);
+        GLRecorder_UnbindDeleted(kBufferBindings, GL_RECORDER_COUNTOF(kBufferBindings), buffers[i]);
+    }
+}
+
+static void GLAPIENTRY GLRecorder_glDeleteTextures(GLsizei n, const GLuint* textures)
+{
+    for (GLsizei i = 0; i < n; i++)
+    {
+        if (textures[i] != 0)
+            GLRecorder_UnbindDeleted(kTextureBindings, GL_RECORDER_COUNTOF(kTextureBindings), textures[i]);
+    }
+}
+
+static void GLAPIENTRY GLRecorder_glDeleteVertexArrays(GLsizei n, const GLuint* arrays)
+{
+    for (GLsizei i = 0; i < n; i++)
+    {
+        if (arrays[i] != 0 && GLRecorder_GetState(GL_VERTEX_ARRAY_BINDING, 0) == (GLint)arrays[i])
+            GLRecorder_SetState(GL_VERTEX_ARRAY_BINDING, 0, 0);
+    }
+}
+
+static void GLAPIENTRY GLRecorder_glBufferData(GLenum target, GLsizeiptr size, const void* data, GLenum)
+{
+    GLRecorder_AllocateBuffer(GLRecorder_BoundBuffer(target), size, data);
+}
+
+static void GLAPIENTRY GLRecorder_glBufferStorage(GLenum target, GLsizeiptr size, const void* data, GLbitfield)
+{
+    GLRecorder_AllocateBuffer(GLRecorder_BoundBuffer(target), size, data);
+}
+
+static void GLAPIENTRY GLRecorder_glNamedBufferData(GLuint buffer, GLsizeiptr size, const void* data, GLenum)
+{
+    GLRecorder_AllocateBuffer(buffer, size, data);
+}
+
+static void GLAPIENTRY GLRecorder_glNamedBufferStorage(GLuint buffer, GLsizeiptr size, const void* data, GLbitfield)
+{
+    GLRecorder_AllocateBuffer(buffer, size, data);
+}
+
+static void GLAPIENTRY GLRecorder_glBufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, const void* data)
+{
+    GLRecorder_WriteBuffer(GLRecorder_BoundBuffer(target), offset, size, data);
+}
+
+static void GLAPIENTRY GLRecorder_glNamedBufferSubData(GLuint buffer, GLintptr offset, GLsizeiptr size, const void* data)
+{
+    GLRecorder_WriteBuffer(buffer, offset, size, data);
+}
+
+static void* GLAPIENTRY GLRecorder_glMapBuffer(GLenum target, GLenum access)
+{
+    GLuint buffer = GLRecorder_BoundBuffer(target);
+    return GLRecorder_MapBuffer(buffer, 0, (GLsizeiptr)g_BufferStorage[buffer].size(), access != GL_READ_ONLY);
+}
+
+static void* GLAPIENTRY GLRecorder_glMapBufferRange(GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access)
+{
+    return GLRecorder_MapBuffer(GLRecorder_BoundBuffer(target), offset, length, (access & GL_MAP_WRITE_BIT) != 0);
+}
+
+static void* GLAPIENTRY GLRecorder_glMapNamedBuffer(GLuint buffer, GLenum access)
+{
+    return GLRecorder_MapBuffer(buffer, 0, (GLsizeiptr)g_BufferStorage[buffer].size(), access != GL_READ_ONLY);
+}
+
+static void* GLAPIENTRY GLRecorder_glMapNamedBufferRange(GLuint buffer, GLintptr offset, GLsizeiptr length, GLbitfield access)
+{
+    return GLRecorder_MapBuffer(buffer, offset, length, (access & GL_MAP_WRITE_BIT) != 0);
+}
+
+static GLboolean GLAPIENTRY GLRecorder_glUnmapBuffer(GLenum) { return GL_TRUE; }
+static GLboolean GLAPIENTRY GLRecorder_glUnmapNamedBuffer(GLuint) { return GL_TRUE; }
+
+static void GLAPIENTRY GLRecorder_glTexImage2D(GLenum, GLint, GLint, GLsizei width, GLsizei height, GLint, GLenum format, GLenum type, const void* pixels)
+{
+    GLRecorder_UploadPixels(width, height, 1, format, type, pixels);
+}
+
+static void GLAPIENTRY GLRecorder_glTexImage3D(GLenum, GLint, GLint, GLsizei width, GLsizei height, GLsizei depth, GLint, GLenum format, GLenum type, const void* pixels)
+{
+    GLRecorder_UploadPixels(width, height, depth, format, type, pixels);
+}
+
+static void GLAPIENTRY GLRecorder_glTexSubImage2D(GLenum, GLint, GLint, GLint, GLsizei width, GLsizei height, GLenum format, GLenum type, const void* pixels)
+{
+    GLRecorder_UploadPixels(width, height, 1, format, type, pixels);
+}
+
+static void GLAPIENTRY GLRecorder_glTexSubImage3D(GLenum, GLint, GLint, GLint, GLint, GLsizei width, GLsizei height, GLsizei depth, GLenum format, GLenum type, const void* pixels)
+{
+    GLRecorder_UploadPixels(width, height, depth, format, type, pixels);
+}
+
+static void GLAPIENTRY GLRecorder_glTextureSubImage2D(GLuint, GLint, GLint, GLint, GLsizei width, GLsizei height, GLenum format, GLenum type, const void* pixels)
+{
+    GLRecorder_UploadPixels(width, height, 1, format, type, pixels);
+}
+
+static void GLAPIENTRY GLRecorder_glTextureSubImage3D(GLuint, GLint, GLint, GLint, GLint, GLsizei width, GLsizei height, GLsizei depth, GLenum format, GLenum type, const void* pixels)
+{
+    GLRecorder_UploadPixels(width, height, depth, format, type, pixels);
+}
+
+static void GLAPIENTRY GLRecorder_glUseProgram(GLuint program)
+{
+    GLRecorder_CountStateCall(GLRecorder_SetState(GL_CURRENT_PROGRAM, 0, (GLint)program));
+}
+
+static void GLAPIENTRY GLRecorder_glBindVertexArray(GLuint array)
+{
+    GLRecorder_CountStateCall(GLRecorder_SetState(GL_VERTEX_ARRAY_BINDING, 0, (GLint)array));
+}
+
+static void GLAPIENTRY GLRecorder_glBindBuffer(GLenum target, GLuint buffer)
+{
+    GLenum binding = GL_RECORDER_BUFFER_BINDING(target);
+    if (binding)
+        GLRecorder_CountStateCall(GLRecorder_SetState(binding, GLRecorder_StateIndex(binding), (GLint)buffer));
+}
+
+// Indexed binds also bind the generic binding point, but aren't counted as redundant since the indexed binding isn't emulated.
+static void GLAPIENTRY GLRecorder_glBindBufferBase(GLenum target, GLuint, GLuint buffer)
+{
+    GLenum binding = GL_RECORDER_BUFFER_BINDING(target);
+    if (binding)
+        GLRecorder_SetState(binding, 0, (GLint)buffer);
+}
+
+static void GLAPIENTRY GLRecorder_glBindBufferRange(GLenum target, GLuint, GLuint buffer, GLintptr, GLsizeiptr)
+{
+    GLenum binding = GL_RECORDER_BUFFER_BINDING(target);
+    if (binding)
+        GLRecorder_SetState(binding, 0, (GLint)buffer);
+}
+
+static void GLAPIENTRY GLRecorder_glActiveTexture(GLenum texture)
+{
+    GLRecorder_CountStateCall(GLRecorder_SetState(GL_ACTIVE_TEXTURE, 0, (GLint)texture));
+}
+
+static void GLAPIENTRY GLRecorder_glBindTexture(GLenum target, GLuint texture)
+{
+    GLenum binding = GL_RECORDER_TEXTURE_BINDING(target);
+    if (binding)
+        GLRecorder_CountStateCall(GLRecorder_SetState(binding, GLRecorder_StateIndex(binding), (GLint)texture));
+}
+
+static void GLAPIENTRY GLRecorder_glBindSampler(GLuint unit, GLuint sampler)
+{
+    GLRecorder_CountStateCall(GLRecorder_SetState(GL_SAMPLER_BINDING, unit, (GLint)sampler));
+}
+
+static void GLAPIENTRY GLRecorder_glBindSamplers(GLuint first, GLsizei count, const GLuint* samplers)
+{
+    for (GLsizei i = 0; i < count; i++)
+        GLRecorder_SetState(GL_SAMPLER_BINDING, first + i, samplers ? (GLint)samplers[i] : 0);
+}
+
+static void GLAPIENTRY GLRecorder_glEnable(GLenum cap) { GLRecorder_CountStateCall(GLRecorder_SetState(cap, 0, GL_TRUE)); }
+static void GLAPIENTRY GLRecorder_glDisable(GLenum cap) { GLRecorder_CountStateCall(GLRecorder_SetState(cap, 0, GL_FALSE)); }
+static void GLAPIENTRY GLRecorder_glEnablei(GLenum target, GLuint index) { GLRecorder_CountStateCall(GLRecorder_SetState(target, index, GL_TRUE)); }
+static void GLAPIENTRY GLRecorder_glDisablei(GLenum target, GLuint index) { GLRecorder_CountStateCall(GLRecorder_SetState(target, index, GL_FALSE)); }
+static GLboolean GLAPIENTRY GLRecorder_glIsEnabled(GLenum cap) { return GLRecorder_GetState(cap, 0) ? GL_TRUE : GL_FALSE; }
+static GLboolean GLAPIENTRY GLRecorder_glIsEnabledi(GLenum target, GLuint index) { return GLRecorder_GetState(target, index) ? GL_TRUE : GL_FALSE; }
+
+static void GLAPIENTRY GLRecorder_glBlendFuncSeparate(GLenum sfactorRGB, GLenum dfactorRGB, GLenum sfactorAlpha, GLenum dfactorAlpha)
+{
+    // | instead of || so every value gets set
+    GLRecorder_CountStateCall(
+        GLRecorder_SetState(GL_BLEND_SRC_RGB, 0, (GLint)sfactorRGB) |
+        GLRecorder_SetState(GL_BLEND_DST_RGB, 0, (GLint)dfactorRGB) |
+        GLRecorder_SetState(GL_BLEND_SRC_ALPHA, 0, (GLint)sfactorAlpha) |
+        GLRecorder_SetState(GL_BLEND_DST_ALPHA, 0, (GLint)dfactorAlpha));
+}
+
+static void GLAPIENTRY GLRecorder_glBlendFunc(GLenum sfactor, GLenum dfactor)
+{
+    GLRecorder_glBlendFuncSeparate(sfactor, dfactor, sfactor, dfactor);
+}
+
+static void GLAPIENTRY GLRecorder_glBlendEquationSeparate(GLenum modeRGB, GLenum modeAlpha)
+{
+    GLRecorder_CountStateCall(
+        GLRecorder_SetState(GL_BLEND_EQUATION_RGB, 0, (GLint)modeRGB) |
+        GLRecorder_SetState(GL_BLEND_EQUATION_ALPHA, 0, (GLint)modeAlpha));
+}
+
+static void GLAPIENTRY GLRecorder_glBlendEquation(GLenum mode)
+{
+    GLRecorder_glBlendEquationSeparate(mode, mode);
+}
+
+static bool GLRecorder_SetBox(GLenum pname, GLint x, GLint y, GLsizei width, GLsizei height)
+{
+    return GLRecorder_SetState(pname, 0, x) | GLRecorder_SetState(pname, 1, y) | GLRecorder_SetState(pname, 2, width) | GLRecorder_SetState(pname, 3, height);
+}
+
+static void GLAPIENTRY GLRecorder_glViewport(GLint x, GLint y, GLsizei width, GLsizei height)
+{
+    GLRecorder_CountStateCall(GLRecorder_SetBox(GL_VIEWPORT, x, y, width, height));
+}
+
+static void GLAPIENTRY GLRecorder_glScissor(GLint x, GLint y, GLsizei width, GLsizei height)
+{
+    GLRecorder_CountStateCall(GLRecorder_SetBox(GL_SCISSOR_BOX, x, y, width, height));
+}
+
+static void GLAPIENTRY GLRecorder_glGetIntegerv(GLenum pname, GLint* data)
+{
+    GLuint index = GLRecorder_StateIndex(pname);
+    int count = (pname == GL_VIEWPORT || pname == GL_SCISSOR_BOX) ? 4 : 1;
+    for (int i = 0; i < count; i++)
+        data[i] = GLRecorder_GetState(pname, index + i);
+}
+
+static void GLAPIENTRY GLRecorder_glGetInteger64v(GLenum pname, GLint64* data)
+{
+    GLint values[4];
+    GLRecorder_glGetIntegerv(pname, values);
+    int count = (pname == GL_VIEWPORT || pname == GL_SCISSOR_BOX) ? 4 : 1;
+    for (int i = 0; i < count; i++)
+        data[i] = values[i];
+}
+
+static const GLubyte* GLAPIENTRY GLRecorder_glGetString(GLenum name)
+{
+    switch (name)
+    {
+    case GL_VENDOR: return (const GLubyte*)"LateLatching";
+    case GL_RENDERER: return (const GLubyte*)"GL recorder";
+    case GL_VERSION: return (const GLubyte*)"4.5.0 Core Profile";
+    case GL_SHADING_LANGUAGE_VERSION: return (const GLubyte*)"4.50";
+    }
+    return NULL;
+}
+
+static void GLAPIENTRY GLRecorder_glGetShaderiv(GLuint, GLenum pname, GLint* params)
+{
+    *params = pname == GL_COMPILE_STATUS ? GL_TRUE : 0;
+}
+
+static void GLAPIENTRY GLRecorder_glGetProgramiv(GLuint program, GLenum pname, GLint* params)
+{
+    const GLRecorderProgram& state = g_Programs[program];
+    switch (pname)
+    {
+    case GL_LINK_STATUS: *params = state.Linked ? GL_TRUE : GL_FALSE; break;
+    case GL_VALIDATE_STATUS: *params = GL_TRUE; break;
+    case GL_PROGRAM_BINARY_LENGTH: *params = (GLint)state.Binary.size(); break;
+    case GL_ATTACHED_SHADERS: *params = (GLint)state.Shaders.size(); break;
+    default: *params = 0; break;
+    }
+}
+
+static void GLAPIENTRY GLRecorder_glShaderSource(GLuint shader, GLsizei count, const GLchar* const* string, const GLint* length)
+{
+    std::string& source = g_ShaderSources[shader];
+    source.clear();
+    for (GLsizei i = 0; i < count; i++)
+    {
+        if (length && length[i] >= 0)
+            source.append(string[i], length[i]);
+        else
+            source.append(string[i]);
+    }
+}
+
+static void GLAPIENTRY GLRecorder_glAttachShader(GLuint program, GLuint shader)
+{
+    g_Programs[program].Shaders.push_back(shader);
+}
+
+static void GLAPIENTRY GLRecorder_glDetachShader(GLuint program, GLuint shader)
+{
+    std::vector<GLuint>& shaders = g_Programs[program].Shaders;
+    for (size_t i = 0; i < shaders.size(); i++)
+    {
+        if (shaders[i] == shader)
+        {
+            shaders.erase(shaders.begin() + i);
+            break;
+        }
+    }
+}
+
+static void GLAPIENTRY GLRecorder_glDeleteShader(GLuint shader)
+{
+    g_ShaderSources.erase(shader);
+}
+
+static void GLAPIENTRY GLRecorder_glDeleteProgram(GLuint program)
+{
+    g_Programs.erase(program);
+}
+
+static void GLAPIENTRY GLRecorder_glLinkProgram(GLuint program)
+{
+    GLRecorderProgram& state = g_Programs[program];
+    state.Linked = true;
+    state.Binary = GL_RECORDER_PROGRAM_BINARY_MAGIC;
+    for (GLuint shader : state.Shaders)
+        state.Binary += g_ShaderSources[shader];
+}
+
+static void GLAPIENTRY GLRecorder_glGetProgramBinary(GLuint program, GLsizei bufSize, GLsizei* length, GLenum* binaryFormat, void* binary)
+{
+    const std::string& blob = g_Programs[program].Binary;
+    GLsizei size = (GLsizei)blob.size() < bufSize ? (GLsizei)blob.size() : bufSize;
+    memcpy(binary, blob.data(), size);
+    if (length)
+    {
+        *length = size;
+    }
+    *binaryFormat = g_ProgramBinaryFormat;
+}
+
+// Like a driver, only accepts binaries of its own format, and fails the link otherwise.
+static void GLAPIENTRY GLRecorder_glProgramBinary(GLuint program, GLenum binaryFormat, const void* binary, GLsizei length)
+{
+    GLRecorderProgram& state = g_Programs[program];
+    const size_t magicSize = sizeof(GL_RECORDER_PROGRAM_BINARY_MAGIC) - 1;
+    state.Linked = binaryFormat == g_ProgramBinaryFormat && (size_t)length >= magicSize && memcmp(binary, GL_RECORDER_PROGRAM_BINARY_MAGIC, magicSize) == 0;
+    state.Binary = state.Linked ? std::string((const char*)binary, length) : std::string();
+}
+
+static GLint GLAPIENTRY GLRecorder_glGetUniformLocation(GLuint program, const GLchar* name)
+{
+    GLint location;
+    GLRecorder_GetLocation(program, name, &location);
+    return location;
+}
+
+static GLint GLAPIENTRY GLRecorder_glGetAttribLocation(GLuint program, const GLchar* name)
+{
+    GLint location;
+    GLRecorder_GetLocation(program, name, &location);
+    return location;
+}
+
+static GLenum GLAPIENTRY GLRecorder_glCheckFramebufferStatus(GLenum) { return GL_FRAMEBUFFER_COMPLETE; }
+static GLenum GLAPIENTRY GLRecorder_glCheckNamedFramebufferStatus(GLuint, GLenum) { return GL_FRAMEBUFFER_COMPLETE; }
+
+// Fences signal right away, since nothing runs behind the calls.
+static GLsync GLAPIENTRY GLRecorder_glFenceSync(GLenum, GLbitfield) { return (GLsync)(uintptr_t)g_NextName++; }
+static GLenum GLAPIENTRY GLRecorder_glClientWaitSync(GLsync, GLbitfield, GLuint64) { return GL_ALREADY_SIGNALED; }
+
+static void GLAPIENTRY GLRecorder_glGetSynciv(GLsync, GLenum pname, GLsizei bufSize, GLsizei* length, GLint* values)
+{
+    if (bufSize > 0)
+    {
+        values[0] = pname == GL_SYNC_STATUS ? GL_SIGNALED : 0;
+    }
+    if (length)
+    {
+        *length = 1;
+    }
+}
+
+// Queries are always available, and measure 0.
+static void GLAPIENTRY GLRecorder_glGetQueryObjectiv(GLuint, GLenum pname, GLint* params) { *params = pname == GL_QUERY_RESULT_AVAILABLE ? GL_TRUE : 0; }
+static void GLAPIENTRY GLRecorder_glGetQueryObjectuiv(GLuint, GLenum pname, GLuint* params) { *params = pname == GL_QUERY_RESULT_AVAILABLE ? GL_TRUE : 0; }
+static void GLAPIENTRY GLRecorder_glGetQueryObjecti64v(GLuint, GLenum pname, GLint64* params) { *params = pname == GL_QUERY_RESULT_AVAILABLE ? GL_TRUE : 0; }
+static void GLAPIENTRY GLRecorder_glGetQueryObjectui64v(GLuint, GLenum pname, GLuint64* params) { *params = pname == GL_QUERY_RESULT_AVAILABLE ? GL_TRUE : 0; }
+
+// The cast checks that the emulation has the signature of the function it replaces.
+#define GL_RECORDER_EMULATE(f) { #f, (GLRecorderProc)static_cast<decltype(::f)>(&GLRecorder_##f) }
+
+static const struct
+{
+    const char* Name;
+    GLRecorderProc Proc;
+} kEmulations[] = {
+    GL_RECORDER_EMULATE(glGenBuffers),
+    GL_RECORDER_EMULATE(glGenTextures),
+    GL_RECORDER_EMULATE(glGenVertexArrays),
+    GL_RECORDER_EMULATE(glGenSamplers),
+    GL_RECORDER_EMULATE(glGenQueries),
+    GL_RECORDER_EMULATE(glGenFramebuffers),
+    GL_RECORDER_EMULATE(glGenRenderbuffers),
+    GL_RECORDER_EMULATE(glCreateBuffers),
+    GL_RECORDER_EMULATE(glCreateTextures),
+    GL_RECORDER_EMULATE(glCreateVertexArrays),
+    GL_RECORDER_EMULATE(glCreateSamplers),
+    GL_RECORDER_EMULATE(glCreateQueries),
+    GL_RECORDER_EMULATE(glCreateFramebuffers),
+    GL_RECORDER_EMULATE(glCreateShader),
+    GL_RECORDER_EMULATE(glCreateProgram),
+    GL_RECORDER_EMULATE(glCreateShaderProgramv),
+    GL_RECORDER_EMULATE(glDeleteBuffers),
+    GL_RECORDER_EMULATE(glDeleteTextures),
+    GL_RECORDER_EMULATE(glDeleteVertexArrays),
+    GL_RECORDER_EMULATE(glBufferData),
+    GL_RECORDER_EMULATE(glBufferStorage),
+    GL_RECORDER_EMULATE(glNamedBufferData),
+    GL_RECORDER_EMULATE(glNamedBufferStorage),
+    GL_RECORDER_EMULATE(glBufferSubData),
+    GL_RECORDER_EMULATE(glNamedBufferSubData),
+    GL_RECORDER_EMULATE(glMapBuffer),
+    GL_RECORDER_EMULATE(glMapBufferRange),
+    GL_RECORDER_EMULATE(glMapNamedBuffer),
+    GL_RECORDER_EMULATE(glMapNamedBufferRange),
+    GL_RECORDER_EMULATE(glUnmapBuffer),
+    GL_RECORDER_EMULATE(glUnmapNamedBuffer),
+    GL_RECORDER_EMULATE(glTexImage2D),
+    GL_RECORDER_EMULATE(glTexImage3D),
+    GL_RECORDER_EMULATE(glTexSubImage2D),
+    GL_RECORDER_EMULATE(glTexSubImage3D),
+    GL_RECORDER_EMULATE(glTextureSubImage2D),
+    GL_RECORDER_EMULATE(glTextureSubImage3D),
+    GL_RECORDER_EMULATE(glUseProgram),
+    GL_RECORDER_EMULATE(glBindVertexArray),
+    GL_RECORDER_EMULATE(glBindBuffer),
+    GL_RECORDER_EMULATE(glBindBufferBase),
+    GL_RECORDER_EMULATE(glBindBufferRange),
+    GL_RECORDER_EMULATE(glActiveTexture),
+    GL_RECORDER_EMULATE(glBindTexture),
+    GL_RECORDER_EMULATE(glBindSampler),
+    GL_RECORDER_EMULATE(glBindSamplers),
+    GL_RECORDER_EMULATE(glEnable),
+    GL_RECORDER_EMULATE(glDisable),
+    GL_RECORDER_EMULATE(glEnablei),
+    GL_RECORDER_EMULATE(glDisablei),
+    GL_RECORDER_EMULATE(glIsEnabled),
+    GL_RECORDER_EMULATE(glIsEnabledi),
+    GL_RECORDER_EMULATE(glBlendFunc),
+    GL_RECORDER_EMULATE(glBlendFuncSeparate),
+    GL_RECORDER_EMULATE(glBlendEquation),
+    GL_RECORDER_EMULATE(glBlendEquationSeparate),
+    GL_RECORDER_EMULATE(glViewport),
+    GL_RECORDER_EMULATE(glScissor),
+    GL_RECORDER_EMULATE(glGetIntegerv),
+    GL_RECORDER_EMULATE(glGetInteger64v),
+    GL_RECORDER_EMULATE(glGetString),
+    GL_RECORDER_EMULATE(glGetShaderiv),
+    GL_RECORDER_EMULATE(glGetProgramiv),
+    GL_RECORDER_EMULATE(glShaderSource),
+    GL_RECORDER_EMULATE(glAttachShader),
+    GL_RECORDER_EMULATE(glDetachShader),
+    GL_RECORDER_EMULATE(glDeleteShader),
+    GL_RECORDER_EMULATE(glDeleteProgram),
+    GL_RECORDER_EMULATE(glLinkProgram),
+    GL_RECORDER_EMULATE(glGetProgramBinary),
+    GL_RECORDER_EMULATE(glProgramBinary),
+    GL_RECORDER_EMULATE(glGetUniformLocation),
+    GL_RECORDER_EMULATE(glGetAttribLocation),
+    GL_RECORDER_EMULATE(glCheckFramebufferStatus),
+    GL_RECORDER_EMULATE(glCheckNamedFramebufferStatus),
+    GL_RECORDER_EMULATE(glFenceSync),
+    GL_RECORDER_EMULATE(glClientWaitSync),
+    GL_RECORDER_EMULATE(glGetSynciv),
+    GL_RECORDER_EMULATE(glGetQueryObjectiv),
+    GL_RECORDER_EMULATE(glGetQueryObjectuiv),
+    GL_RECORDER_EMULATE(glGetQueryObjecti64v),
+    GL_RECORDER_EMULATE(glGetQueryObjectui64v),
+};
+
+void GLRecorder_Reset()
+{
+    g_FrameStats = GLRecorderStats();
+    g_LastFrameStats = GLRecorderStats();
+    g_TotalStats = GLRecorderStats();
+    g_Commands.clear();
+
+    g_NextName = 1;
+    g_BufferStorage.clear();
+    g_Locations.clear();
+    g_NextLocation.clear();
+    g_ShaderSources.clear();
+    g_Programs.clear();
+
+    // Initial values of the context, and limits that code might check
+    g_State.clear();
+    g_State[GLRecorder_StateKey(GL_ACTIVE_TEXTURE, 0)] = GL_TEXTURE0;
+    g_State[GLRecorder_StateKey(GL_BLEND_SRC_RGB, 0)] = GL_ONE;
+    g_State[GLRecorder_StateKey(GL_BLEND_SRC_ALPHA, 0)] = GL_ONE;
+    g_State[GLRecorder_StateKey(GL_BLEND_DST_RGB, 0)] = GL_ZERO;
+    g_State[GLRecorder_StateKey(GL_BLEND_DST_ALPHA, 0)] = GL_ZERO;
+    g_State[GLRecorder_StateKey(GL_BLEND_EQUATION_RGB, 0)] = GL_FUNC_ADD;
+    g_State[GLRecorder_StateKey(GL_BLEND_EQUATION_ALPHA, 0)] = GL_FUNC_ADD;
+    g_State[GLRecorder_StateKey(GL_DITHER, 0)] = GL_TRUE;
+    g_State[GLRecorder_StateKey(GL_MULTISAMPLE, 0)] = GL_TRUE;
+    g_State[GLRecorder_StateKey(GL_MAJOR_VERSION, 0)] = 4;
+    g_State[GLRecorder_StateKey(GL_MINOR_VERSION, 0)] = 5;
+    g_State[GLRecorder_StateKey(GL_MAX_TEXTURE_SIZE, 0)] = 16384;
+    g_State[GLRecorder_StateKey(GL_MAX_ARRAY_TEXTURE_LAYERS, 0)] = 2048;
+    g_State[GLRecorder_StateKey(GL_MAX_COMBINED_TEXTURE_IMAGE_UNITS, 0)] = 32;
+    g_State[GLRecorder_StateKey(GL_MAX_VERTEX_ATTRIBS, 0)] = 16;
+    g_State[GLRecorder_StateKey(GL_MAX_UNIFORM_BUFFER_BINDINGS, 0)] = 36;
+    g_State[GLRecorder_StateKey(GL_MAX_SHADER_STORAGE_BUFFER_BINDINGS, 0)] = 16;
+    g_State[GLRecorder_StateKey(GL_NUM_PROGRAM_BINARY_FORMATS, 0)] = 1;
+    g_State[GLRecorder_StateKey(GL_PROGRAM_BINARY_FORMATS, 0)] = (GLint)g_ProgramBinaryFormat;
+}
+
+void GLRecorder_SetProgramBinaryFormat(GLenum format)
+{
+    g_ProgramBinaryFormat = format;
+    g_State[GLRecorder_StateKey(GL_PROGRAM_BINARY_FORMATS, 0)] = (GLint)format;
+}
+
+void GLRecorder_EndFrame()
+{
+    g_LastFrameStats = g_FrameStats;
+    g_FrameStats = GLRecorderStats();
+}
+
+const GLRecorderStats& GLRecorder_GetFrameStats()
+{
+    return g_LastFrameStats;
+}
+
+const GLRecorderStats& GLRecorder_GetTotalStats()
+{
+    return g_TotalStats;
+}
+
+uint32_t GLRecorder_FindFunction(const char* name)
+{
+    for (uint32_t i = 0; i < g_FunctionCount; i++)
+    {
+        if (g_Functions[i].Name && strcmp(g_Functions[i].Name, name) == 0)
+            return i;
+    }
+    return GL_RECORDER_INVALID_FUNCTION;
+}
+
+const char* GLRecorder_GetFunctionName(uint32_t index)
+{
+    return index < g_FunctionCount ? g_Functions[index].Name : NULL;
+}
+
+void GLRecorder_SetRecording(bool recording)
+{
+    g_Recording = recording;
+}
+
+const std::vector<uint8_t>& GLRecorder_GetCommands()
+{
+    return g_Commands;
+}
+
+void GLRecorder_ClearCommands()
+{
+    g_Commands.clear();
+}
+
+// File format, in native byte order:
+// uint32_t function count, then for each function its uint16_t name length and name (not null terminated),
+// then the uint64_t size of the command stream and the stream.
+bool GLRecorder_WriteCommands(const char* path)
+{
+    FILE* file = fopen(path, "wb");
+    if (!file)
+    {
+        return false;
+    }
+
+    bool ok = fwrite(&g_FunctionCount, sizeof(g_FunctionCount), 1, file) == 1;
+    for (uint32_t i = 0; ok && i < g_FunctionCount; i++)
+    {
+        const char* name = g_Functions[i].Name ? g_Functions[i].Name : "";
+        uint16_t length = (uint16_t)strlen(name);
+        ok = fwrite(&length, sizeof(length), 1, file) == 1 && fwrite(name, 1, length, file) == length;
+    }
+
+    uint64_t size = g_Commands.size();
+    ok = ok && fwrite(&size, sizeof(size), 1, file) == 1;
+    ok = ok && fwrite(g_Commands.data(), 1, g_Commands.size(), file) == g_Commands.size();
+
+    ok = fclose(file) == 0 && ok;
+    return ok;
+}
+
+void GLRecorder_RegisterFunction(uint32_t index, const char* name)
+{
+    GLRecorderFunction& function = g_Functions[index];
+    function.Name = name;
+    function.IsDraw = strncmp(name, "glDraw", 6) == 0 || strncmp(name, "glMultiDraw", 11) == 0;
+    function.Emulation = NULL;
+    for (const auto& emulation : kEmulations)
+    {
+        if (strcmp(emulation.Name, name) == 0)
+        {
+            function.Emulation = emulation.Proc;
+            break;
+        }
+    }
+
+    if (index >= g_FunctionCount)
+    {
+        g_FunctionCount = index + 1;
+    }
+}
+
+void GLRecorder_Record(uint32_t index, const uint8_t* args, uint32_t size)
+{
+    GLRecorder_Count(&GLRecorderStats::Calls, 1);
+    g_FrameStats.CallsPerFunction[index]++;
+    g_TotalStats.CallsPerFunction[index]++;
+    if (g_Functions[index].IsDraw)
+    {
+        GLRecorder_Count(&GLRecorderStats::DrawCalls, 1);
+    }
+
+    if (g_Recording)
+    {
+        uint16_t header[2] = { (uint16_t)index, (uint16_t)size };
+        const uint8_t* headerBytes = (const uint8_t*)header;
+        g_Commands.insert(g_Commands.end(), headerBytes, headerBytes + sizeof(header));
+        g_Commands.insert(g_Commands.end(), args, args + size);
+    }
+}
+
+GLRecorderProc GLRecorder_GetEmulation(uint32_t index)
+{
+    return g_Functions[index].Emulation;
+}
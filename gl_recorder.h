@@ -0,0 +1,134 @@
+#pragma once
+
+// GL backend that records calls instead of executing them, for running the renderer without a GPU
+// (eg. on a headless Linux machine) and for tests that check how many calls, draws and uploads a frame makes.
+//
+// OpenGL_InitRecording() points every GL function at a stub that:
+// - appends the call to a binary command stream (see GLRecorder_GetCommands for the format),
+// - counts it in the stats of the current frame,
+// - emulates what's needed for the calling code to keep working: object names, buffer storage and mapping,
+//   the bindings and state that ImGui_Impl and the GL state cache query, shader and sync status, program binaries
+//   (made of the program's sources), and strings.
+// Functions that aren't emulated return 0 and write nothing to their output parameters.
+//
+// Calls that set a piece of emulated state to the value it already has are counted as redundant, so a test can
+// catch state filtering regressions. Not thread safe: use the recorder from a single thread, like a GL context.
+
+#include "opengl.h"
+
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+// More than the number of functions in opengl.h
+#define GL_RECORDER_MAX_FUNCTIONS 1024
+
+#define GL_RECORDER_INVALID_FUNCTION 0xFFFFFFFF
+
+struct GLRecorderStats
+{
+    uint64_t Calls;
+    uint64_t DrawCalls;                 // Calls to glDraw* and glMultiDraw*
+    uint64_t RedundantStateCalls;       // Calls that set emulated state to the value it already had
+    uint64_t BytesUploaded;             // Client memory passed to buffer and texture uploads
+    uint64_t BytesMapped;               // Size of the buffer ranges mapped for writing
+    uint32_t CallsPerFunction[GL_RECORDER_MAX_FUNCTIONS];
+};
+
+// Forgets all objects, state, stats and commands. Called by OpenGL_InitRecording().
+void GLRecorder_Reset();
+
+// Ends the current frame: its stats become the ones returned by GLRecorder_GetFrameStats. Call after SwapBuffers.
+void GLRecorder_EndFrame();
+
+// Stats of the last frame ended by GLRecorder_EndFrame.
+const GLRecorderStats& GLRecorder_GetFrameStats();
+
+// Stats of all the calls since GLRecorder_Reset, including the current frame.
+const GLRecorderStats& GLRecorder_GetTotalStats();
+
+// Index of a function in CallsPerFunction and in the command stream, or GL_RECORDER_INVALID_FUNCTION.
+uint32_t GLRecorder_FindFunction(const char* name);
+const char* GLRecorder_GetFunctionName(uint32_t index);
+
+// Format of the program binaries that the recorder makes and accepts. Change it to simulate a driver update,
+// which makes the driver reject the binaries of the previous format.
+#define GL_RECORDER_PROGRAM_BINARY_FORMAT 0x10000
+void GLRecorder_SetProgramBinaryFormat(GLenum format);
+
+// Recording of the command stream is enabled by default. Stats are counted either way.
+void GLRecorder_SetRecording(bool recording);
+
+// Each call is a uint16_t function index, the uint16_t size of its arguments, and the arguments in order,
+// each in its native size and byte order, except pointers which are always 8 bytes. Pointed-to data isn't recorded.
+const std::vector<uint8_t>& GLRecorder_GetCommands();
+void GLRecorder_ClearCommands();
+
+// Writes the function names and the command stream. Returns false if the file couldn't be written.
+bool GLRecorder_WriteCommands(const char* path);
+
+// Internals of the stubs and OpenGL_InitRecording()
+
+void GLRecorder_RegisterFunction(uint32_t index, const char* name);
+void GLRecorder_Record(uint32_t index, const uint8_t* args, uint32_t size);
+
+typedef void (GLAPIENTRYP GLRecorderProc)();
+
+// Emulation of the function, or NULL
+GLRecorderProc GLRecorder_GetEmulation(uint32_t index);
+
+template<class T, bool IsPointer = std::is_pointer<T>::value>
+struct GLRecorderArg
+{
+    static const uint32_t Size = sizeof(T);
+    static void Write(uint8_t*& out, T value) { memcpy(out, &value, sizeof(T)); out += sizeof(T); }
+};
+
+template<class T>
+struct GLRecorderArg<T, true>
+{
+    static const uint32_t Size = sizeof(uint64_t);
+    static void Write(uint8_t*& out, T value) { uint64_t address = (uint64_t)(uintptr_t)value; memcpy(out, &address, sizeof(address)); out += sizeof(address); }
+};
+
+template<class... Args>
+struct GLRecorderArgsSize;
+
+template<>
+struct GLRecorderArgsSize<> { static const uint32_t Value = 0; };
+
+template<class T, class... Rest>
+struct GLRecorderArgsSize<T, Rest...> { static const uint32_t Value = GLRecorderArg<T>::Size + GLRecorderArgsSize<Rest...>::Value; };
+
+template<uint32_t Index, class R, class... Args>
+struct GLRecorderStub
+{
+    static R GLAPIENTRY Call(Args... args)
+    {
+        // One more byte so the array isn't empty. Zeroed, since it's still passed to GLRecorder_Record without arguments.
+        uint8_t buffer[GLRecorderArgsSize<Args...>::Value + 1] = {};
+        uint8_t* out = buffer;
+        int expand[] = { 0, (GLRecorderArg<Args>::Write(out, args), 0)... };
+        (void)expand;
+        GLRecorder_Record(Index, buffer, (uint32_t)(out - buffer));
+
+        GLRecorderProc emulation = GLRecorder_GetEmulation(Index);
+        if (emulation)
+        {
+            return ((R (GLAPIENTRYP)(Args...))emulation)(args...);
+        }
+        return R();
+    }
+};
+
+// Loader of OpenGL_InitRecording()
+struct GLRecorderLoader
+{
+    template<uint32_t Index, class R, class... Args>
+    void Load(R (GLAPIENTRYP& proc)(Args...), const char* name)
+    {
+        GLRecorder_RegisterFunction(Index, name);
+        proc = &GLRecorderStub<Index, R, Args...>::Call;
+    }
+};
@@ -0,0 +1,777 @@
+#include "gl_state_cache.h"
+
+#include "opengl.h"
+
+#include <cstdio>
+#include <cstring>
+
+// No object is ever named this, and it's not a valid enum value either.
+#define GL_STATE_CACHE_UNKNOWN 0xFFFFFFFFu
+
+// Functions replaced by the cache. Every other function goes straight to the driver.
+#define GL_STATE_CACHE_FUNCTIONS(X) \
+    X(glUseProgram) \
+    X(glBindVertexArray) \
+    X(glDeleteVertexArrays) \
+    X(glBindBuffer) \
+    X(glBindBufferBase) \
+    X(glBindBufferRange) \
+    X(glDeleteBuffers) \
+    X(glActiveTexture) \
+    X(glBindTexture) \
+    X(glBindTextures) \
+    X(glBindTextureUnit) \
+    X(glDeleteTextures) \
+    X(glBindSampler) \
+    X(glBindSamplers) \
+    X(glDeleteSamplers) \
+    X(glEnable) \
+    X(glDisable) \
+    X(glEnablei) \
+    X(glDisablei) \
+    X(glIsEnabled) \
+    X(glBlendFunc) \
+    X(glBlendFuncSeparate) \
+    X(glBlendFunci) \
+    X(glBlendFuncSeparatei) \
+    X(glBlendEquation) \
+    X(glBlendEquationSeparate) \
+    X(glBlendEquationi) \
+    X(glBlendEquationSeparatei) \
+    X(glViewport) \
+    X(glViewportArrayv) \
+    X(glViewportIndexedf) \
+    X(glViewportIndexedfv) \
+    X(glScissor) \
+    X(glScissorArrayv) \
+    X(glScissorIndexed) \
+    X(glScissorIndexedv) \
+    X(glGetIntegerv)
+
+// The driver's entry points, called by the wrappers
+static struct
+{
+#define GL_STATE_CACHE_DECLARE(f) decltype(::f) f;
+    GL_STATE_CACHE_FUNCTIONS(GL_STATE_CACHE_DECLARE)
+#undef GL_STATE_CACHE_DECLARE
+} g_Driver;
+
+// Generic binding points of buffer targets other than GL_ELEMENT_ARRAY_BUFFER, which is part of the vertex array's state.
+static const GLenum kBufferTargets[][2] = {
+    { GL_ARRAY_BUFFER, GL_ARRAY_BUFFER_BINDING },
+    { GL_COPY_READ_BUFFER, GL_COPY_READ_BUFFER_BINDING },
+    { GL_COPY_WRITE_BUFFER, GL_COPY_WRITE_BUFFER_BINDING },
+    { GL_DRAW_INDIRECT_BUFFER, GL_DRAW_INDIRECT_BUFFER_BINDING },
+    { GL_PIXEL_PACK_BUFFER, GL_PIXEL_PACK_BUFFER_BINDING },
+    { GL_PIXEL_UNPACK_BUFFER, GL_PIXEL_UNPACK_BUFFER_BINDING },
+    { GL_SHADER_STORAGE_BUFFER, GL_SHADER_STORAGE_BUFFER_BINDING },
+    { GL_UNIFORM_BUFFER, GL_UNIFORM_BUFFER_BINDING },
+};
+
+static const GLenum kTextureTargets[][2] = {
+    { GL_TEXTURE_2D, GL_TEXTURE_BINDING_2D },
+    { GL_TEXTURE_2D_ARRAY, GL_TEXTURE_BINDING_2D_ARRAY },
+};
+
+static const GLenum kCaps[] = { GL_BLEND, GL_CULL_FACE, GL_DEPTH_TEST, GL_SCISSOR_TEST };
+
+#define GL_STATE_CACHE_COUNTOF(a) (sizeof(a) / sizeof(a[0]))
+
+struct GLStateShadow
+{
+    GLuint Program;
+    GLuint VertexArray;
+    GLuint ElementArrayBuffer;      // Of the bound vertex array
+    GLuint Buffers[GL_STATE_CACHE_COUNTOF(kBufferTargets)];
+    GLuint ActiveTexture;           // Unit index, not GL_TEXTUREi
+    GLuint Textures[GL_STATE_CACHE_TEXTURE_UNITS][GL_STATE_CACHE_COUNTOF(kTextureTargets)];
+    GLuint Samplers[GL_STATE_CACHE_TEXTURE_UNITS];
+    GLuint Caps[GL_STATE_CACHE_COUNTOF(kCaps)];
+    GLuint BlendFunc[4];            // Source RGB, destination RGB, source alpha, destination alpha
+    GLuint BlendEquationRGB, BlendEquationAlpha;
+    GLuint Viewport[4];             // All unknown or all known
+    GLuint Scissor[4];
+};
+
+// Element array buffers of vertex arrays that aren't bound, so rebinding a vertex array doesn't forget it.
+struct GLStateVertexArray
+{
+    GLuint VertexArray;
+    GLuint ElementArrayBuffer;
+};
+
+static bool g_Installed;
+static GLStateShadow g_Shadow;
+static GLStateVertexArray g_VertexArrays[GL_STATE_CACHE_VERTEX_ARRAYS];
+static GLStateCacheStats g_Stats;
+
+static int GLStateCache_BufferTarget(GLenum target)
+{
+    for (int i = 0; i < (int)GL_STATE_CACHE_COUNTOF(kBufferTargets); i++)
+    {
+        if (kBufferTargets[i][0] == target)
+            return i;
+    }
+    return -1;
+}
+
+static int GLStateCache_TextureTarget(GLenum target)
+{
+    for (int i = 0; i < (int)GL_STATE_CACHE_COUNTOF(kTextureTargets); i++)
+    {
+        if (kTextureTargets[i][0] == target)
+            return i;
+    }
+    return -1;
+}
+
+static int GLStateCache_Cap(GLenum cap)
+{
+    for (int i = 0; i < (int)GL_STATE_CACHE_COUNTOF(kCaps); i++)
+    {
+        if (kCaps[i] == cap)
+            return i;
+    }
+    return -1;
+}
+
+// Returns true if the call that sets 'value' has to go to the driver, and shadows the new value.
+static bool GLStateCache_Set(GLuint* shadow, GLuint value)
+{
+    if (*shadow == value)
+    {
+        g_Stats.CallsAvoided++;
+        return false;
+    }
+
+    *shadow = value;
+    g_Stats.CallsIssued++;
+    return true;
+}
+
+static bool GLStateCache_Set4(GLuint* shadow, GLuint a, GLuint b, GLuint c, GLuint d)
+{
+    if (shadow[0] == a && shadow[1] == b && shadow[2] == c && shadow[3] == d)
+    {
+        g_Stats.CallsAvoided++;
+        return false;
+    }
+
+    shadow[0] = a;
+    shadow[1] = b;
+    shadow[2] = c;
+    shadow[3] = d;
+    g_Stats.CallsIssued++;
+    return true;
+}
+
+static void GLStateCache_Forward()
+{
+    g_Stats.CallsIssued++;
+}
+
+static void GLStateCache_ForgetBlend()
+{
+    for (GLuint& value : g_Shadow.BlendFunc)
+        value = GL_STATE_CACHE_UNKNOWN;
+    g_Shadow.BlendEquationRGB = g_Shadow.BlendEquationAlpha = GL_STATE_CACHE_UNKNOWN;
+}
+
+static GLuint GLStateCache_VertexArrayElements(GLuint vertexArray)
+{
+    for (const GLStateVertexArray& entry : g_VertexArrays)
+    {
+        if (entry.VertexArray == vertexArray)
+            return entry.ElementArrayBuffer;
+    }
+    return GL_STATE_CACHE_UNKNOWN;
+}
+
+static void GLStateCache_RememberVertexArrayElements(GLuint vertexArray, GLuint buffer)
+{
+    if (vertexArray == GL_STATE_CACHE_UNKNOWN)
+    {
+        return;
+    }
+
+    GLStateVertexArray* slot = NULL;
+    for (GLStateVertexArray& entry : g_VertexArrays)
+    {
+        if (entry.VertexArray == vertexArray)
+        {
+            slot = &entry;
+            break;
+        }
+        if (!slot && entry.VertexArray == GL_STATE_CACHE_UNKNOWN)
+        {
+            slot = &entry;
+        }
+    }
+
+    // When full, the vertex array's element buffer will just be queried again next time it's bound.
+    if (slot)
+    {
+        slot->VertexArray = vertexArray;
+        slot->ElementArrayBuffer = buffer;
+    }
+}
+
+static void GLAPIENTRY GLStateCache_glUseProgram(GLuint program)
+{
+    if (GLStateCache_Set(&g_Shadow.Program, program))
+        g_Driver.glUseProgram(program);
+}
+
+static void GLAPIENTRY GLStateCache_glBindVertexArray(GLuint array)
+{
+    if (GLStateCache_Set(&g_Shadow.VertexArray, array))
+    {
+        g_Driver.glBindVertexArray(array);
+        g_Shadow.ElementArrayBuffer = GLStateCache_VertexArrayElements(array);
+    }
+}
+
+static void GLAPIENTRY GLStateCache_glDeleteVertexArrays(GLsizei n, const GLuint* arrays)
+{
+    GLStateCache_Forward();
+    g_Driver.glDeleteVertexArrays(n, arrays);
+
+    for (GLsizei i = 0; i < n; i++)
+    {
+        if (arrays[i] == 0)
+            continue;
+
+        // Deleting the bound vertex array binds 0
+        if (g_Shadow.VertexArray == arrays[i])
+        {
+            g_Shadow.VertexArray = 0;
+            g_Shadow.ElementArrayBuffer = GLStateCache_VertexArrayElements(0);
+        }
+
+        for (GLStateVertexArray& entry : g_VertexArrays)
+        {
+            if (entry.VertexArray == arrays[i])
+                entry.VertexArray = GL_STATE_CACHE_UNKNOWN;
+        }
+    }
+}
+
+static void GLAPIENTRY GLStateCache_glBindBuffer(GLenum target, GLuint buffer)
+{
+    if (target == GL_ELEMENT_ARRAY_BUFFER)
+    {
+        if (GLStateCache_Set(&g_Shadow.ElementArrayBuffer, buffer))
+        {
+            g_Driver.glBindBuffer(target, buffer);
+            GLStateCache_RememberVertexArrayElements(g_Shadow.VertexArray, buffer);
+        }
+        return;
+    }
+
+    int index = GLStateCache_BufferTarget(target);
+    if (index == -1)
+    {
+        GLStateCache_Forward();
+        g_Driver.glBindBuffer(target, buffer);
+    }
+    else if (GLStateCache_Set(&g_Shadow.Buffers[index], buffer))
+    {
+        g_Driver.glBindBuffer(target, buffer);
+    }
+}
+
+// Indexed binds also bind the generic binding point.
+static void GLAPIENTRY GLStateCache_glBindBufferBase(GLenum target, GLuint index, GLuint buffer)
+{
+    GLStateCache_Forward();
+    g_Driver.glBindBufferBase(target, index, buffer);
+
+    int targetIndex = GLStateCache_BufferTarget(target);
+    if (targetIndex != -1)
+        g_Shadow.Buffers[targetIndex] = buffer;
+}
+
+static void GLAPIENTRY GLStateCache_glBindBufferRange(GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size)
+{
+    GLStateCache_Forward();
+    g_Driver.glBindBufferRange(target, index, buffer, offset, size);
+
+    int targetIndex = GLStateCache_BufferTarget(target);
+    if (targetIndex != -1)
+        g_Shadow.Buffers[targetIndex] = buffer;
+}
+
+static void GLAPIENTRY GLStateCache_glDeleteBuffers(GLsizei n, const GLuint* buffers)
+{
+    GLStateCache_Forward();
+    g_Driver.glDeleteBuffers(n, buffers);
+
+    for (GLsizei i = 0; i < n; i++)
+    {
+        if (buffers[i] == 0)
+            continue;
+
+        // Deleting a buffer unbinds it from the context and the bound vertex array
+        for (GLuint& binding : g_Shadow.Buffers)
+        {
+            if (binding == buffers[i])
+                binding = 0;
+        }
+        if (g_Shadow.ElementArrayBuffer == buffers[i])
+            g_Shadow.ElementArrayBuffer = 0;
+
+        // ... but not from the other vertex arrays, so don't assume anything about those.
+        for (GLStateVertexArray& entry : g_VertexArrays)
+        {
+            if (entry.ElementArrayBuffer == buffers[i])
+                entry.VertexArray = GL_STATE_CACHE_UNKNOWN;
+        }
+        GLStateCache_RememberVertexArrayElements(g_Shadow.VertexArray, g_Shadow.ElementArrayBuffer);
+    }
+}
+
+static void GLAPIENTRY GLStateCache_glActiveTexture(GLenum texture)
+{
+    if (GLStateCache_Set(&g_Shadow.ActiveTexture, texture - GL_TEXTURE0))
+        g_Driver.glActiveTexture(texture);
+}
+
+static void GLAPIENTRY GLStateCache_glBindTexture(GLenum target, GLuint texture)
+{
+    GLuint unit = g_Shadow.ActiveTexture;
+    int index = GLStateCache_TextureTarget(target);
+    if (unit >= GL_STATE_CACHE_TEXTURE_UNITS || index == -1)
+    {
+        GLStateCache_Forward();
+        g_Driver.glBindTexture(target, texture);
+    }
+    else if (GLStateCache_Set(&g_Shadow.Textures[unit][index], texture))
+    {
+        g_Driver.glBindTexture(target, texture);
+    }
+}
+
+// Sets all the targets of the unit, since the target of a texture isn't known.
+static void GLStateCache_SetUnitTextures(GLuint unit, GLuint texture)
+{
+    if (unit < GL_STATE_CACHE_TEXTURE_UNITS)
+    {
+        for (GLuint& binding : g_Shadow.Textures[unit])
+            binding = texture == 0 ? 0 : GL_STATE_CACHE_UNKNOWN;
+    }
+}
+
+static void GLAPIENTRY GLStateCache_glBindTextures(GLuint first, GLsizei count, const GLuint* textures)
+{
+    GLStateCache_Forward();
+    g_Driver.glBindTextures(first, count, textures);
+
+    for (GLsizei i = 0; i < count; i++)
+        GLStateCache_SetUnitTextures(first + i, textures ? textures[i] : 0);
+}
+
+static void GLAPIENTRY GLStateCache_glBindTextureUnit(GLuint unit, GLuint texture)
+{
+    GLStateCache_Forward();
+    g_Driver.glBindTextureUnit(unit, texture);
+
+    GLStateCache_SetUnitTextures(unit, texture);
+}
+
+static void GLAPIENTRY GLStateCache_glDeleteTextures(GLsizei n, const GLuint* textures)
+{
+    GLStateCache_Forward();
+    g_Driver.glDeleteTextures(n, textures);
+
+    for (GLsizei i = 0; i < n; i++)
+    {
+        if (textures[i] == 0)
+            continue;
+
+        for (auto& unit : g_Shadow.Textures)
+        {
+            for (GLuint& binding : unit)
+            {
+                if (binding == textures[i])
+                    binding = 0;
+            }
+        }
+    }
+}
+
+static void GLAPIENTRY GLStateCache_glBindSampler(GLuint unit, GLuint sampler)
+{
+    if (unit >= GL_STATE_CACHE_TEXTURE_UNITS)
+    {
+        GLStateCache_Forward();
+        g_Driver.glBindSampler(unit, sampler);
+    }
+    else if (GLStateCache_Set(&g_Shadow.Samplers[unit], sampler))
+    {
+        g_Driver.glBindSampler(unit, sampler);
+    }
+}
+
+static void GLAPIENTRY GLStateCache_glBindSamplers(GLuint first, GLsizei count, const GLuint* samplers)
+{
+    GLStateCache_Forward();
+    g_Driver.glBindSamplers(first, count, samplers);
+
+    for (GLsizei i = 0; i < count; i++)
+    {
+        if (first + i < GL_STATE_CACHE_TEXTURE_UNITS)
+            g_Shadow.Samplers[first + i] = samplers ? samplers[i] : 0;
+    }
+}
+
+static void GLAPIENTRY GLStateCache_glDeleteSamplers(GLsizei count, const GLuint* samplers)
+{
+    GLStateCache_Forward();
+    g_Driver.glDeleteSamplers(count, samplers);
+
+    for (GLsizei i = 0; i < count; i++)
+    {
+        for (GLuint& binding : g_Shadow.Samplers)
+        {
+            if (samplers[i] != 0 && binding == samplers[i])
+                binding = 0;
+        }
+    }
+}
+
+static void GLAPIENTRY GLStateCache_glEnable(GLenum cap)
+{
+    int index = GLStateCache_Cap(cap);
+    if (index == -1)
+    {
+        GLStateCache_Forward();
+        g_Driver.glEnable(cap);
+    }
+    else if (GLStateCache_Set(&g_Shadow.Caps[index], GL_TRUE))
+    {
+        g_Driver.glEnable(cap);
+    }
+}
+
+static void GLAPIENTRY GLStateCache_glDisable(GLenum cap)
+{
+    int index = GLStateCache_Cap(cap);
+    if (index == -1)
+    {
+        GLStateCache_Forward();
+        g_Driver.glDisable(cap);
+    }
+    else if (GLStateCache_Set(&g_Shadow.Caps[index], GL_FALSE))
+    {
+        g_Driver.glDisable(cap);
+    }
+}
+
+// Indexed state isn't shadowed, but it changes what the non-indexed queries return for index 0.
+static void GLAPIENTRY GLStateCache_glEnablei(GLenum target, GLuint index)
+{
+    GLStateCache_Forward();
+    g_Driver.glEnablei(target, index);
+
+    int cap = GLStateCache_Cap(target);
+    if (cap != -1)
+        g_Shadow.Caps[cap] = GL_STATE_CACHE_UNKNOWN;
+}
+
+static void GLAPIENTRY GLStateCache_glDisablei(GLenum target, GLuint index)
+{
+    GLStateCache_Forward();
+    g_Driver.glDisablei(target, index);
+
+    int cap = GLStateCache_Cap(target);
+    if (cap != -1)
+        g_Shadow.Caps[cap] = GL_STATE_CACHE_UNKNOWN;
+}
+
+static GLboolean GLAPIENTRY GLStateCache_glIsEnabled(GLenum cap)
+{
+    int index = GLStateCache_Cap(cap);
+    if (index != -1 && g_Shadow.Caps[index] != GL_STATE_CACHE_UNKNOWN)
+    {
+        g_Stats.QueriesAnswered++;
+        return (GLboolean)g_Shadow.Caps[index];
+    }
+
+    g_Stats.QueriesForwarded++;
+    GLboolean enabled = g_Driver.glIsEnabled(cap);
+    if (index != -1)
+        g_Shadow.Caps[index] = enabled ? GL_TRUE : GL_FALSE;
+    return enabled;
+}
+
+static void GLAPIENTRY GLStateCache_glBlendFunc(GLenum sfactor, GLenum dfactor)
+{
+    if (GLStateCache_Set4(g_Shadow.BlendFunc, sfactor, dfactor, sfactor, dfactor))
+        g_Driver.glBlendFunc(sfactor, dfactor);
+}
+
+static void GLAPIENTRY GLStateCache_glBlendFuncSeparate(GLenum sfactorRGB, GLenum dfactorRGB, GLenum sfactorAlpha, GLenum dfactorAlpha)
+{
+    if (GLStateCache_Set4(g_Shadow.BlendFunc, sfactorRGB, dfactorRGB, sfactorAlpha, dfactorAlpha))
+        g_Driver.glBlendFuncSeparate(sfactorRGB, dfactorRGB, sfactorAlpha, dfactorAlpha);
+}
+
+static void GLAPIENTRY GLStateCache_glBlendFunci(GLuint buf, GLenum src, GLenum dst)
+{
+    GLStateCache_Forward();
+    g_Driver.glBlendFunci(buf, src, dst);
+    GLStateCache_ForgetBlend();
+}
+
+static void GLAPIENTRY GLStateCache_glBlendFuncSeparatei(GLuint buf, GLenum srcRGB, GLenum dstRGB, GLenum srcAlpha, GLenum dstAlpha)
+{
+    GLStateCache_Forward();
+    g_Driver.glBlendFuncSeparatei(buf, srcRGB, dstRGB, srcAlpha, dstAlpha);
+    GLStateCache_ForgetBlend();
+}
+
+static void GLAPIENTRY GLStateCache_glBlendEquation(GLenum mode)
+{
+    if (g_Shadow.BlendEquationRGB == mode && g_Shadow.BlendEquationAlpha == mode)
+    {
+        g_Stats.CallsAvoided++;
+        return;
+    }
+
+    GLStateCache_Forward();
+    g_Driver.glBlendEquation(mode);
+    g_Shadow.BlendEquationRGB = g_Shadow.BlendEquationAlpha = mode;
+}
+
+static void GLAPIENTRY GLStateCache_glBlendEquationSeparate(GLenum modeRGB, GLenum modeAlpha)
+{
+    if (g_Shadow.BlendEquationRGB == modeRGB && g_Shadow.BlendEquationAlpha == modeAlpha)
+    {
+        g_Stats.CallsAvoided++;
+        return;
+    }
+
+    GLStateCache_Forward();
+    g_Driver.glBlendEquationSeparate(modeRGB, modeAlpha);
+    g_Shadow.BlendEquationRGB = modeRGB;
+    g_Shadow.BlendEquationAlpha = modeAlpha;
+}
+
+static void GLAPIENTRY GLStateCache_glBlendEquationi(GLuint buf, GLenum mode)
+{
+    GLStateCache_Forward();
+    g_Driver.glBlendEquationi(buf, mode);
+    GLStateCache_ForgetBlend();
+}
+
+static void GLAPIENTRY GLStateCache_glBlendEquationSeparatei(GLuint buf, GLenum modeRGB, GLenum modeAlpha)
+{
+    GLStateCache_Forward();
+    g_Driver.glBlendEquationSeparatei(buf, modeRGB, modeAlpha);
+    GLStateCache_ForgetBlend();
+}
+
+static void GLAPIENTRY GLStateCache_glViewport(GLint x, GLint y, GLsizei width, GLsizei height)
+{
+    if (GLStateCache_Set4(g_Shadow.Viewport, x, y, width, height))
+        g_Driver.glViewport(x, y, width, height);
+}
+
+static void GLAPIENTRY GLStateCache_glViewportArrayv(GLuint first, GLsizei count, const GLfloat* v)
+{
+    GLStateCache_Forward();
+    g_Driver.glViewportArrayv(first, count, v);
+    g_Shadow.Viewport[0] = GL_STATE_CACHE_UNKNOWN;
+}
+
+static void GLAPIENTRY GLStateCache_glViewportIndexedf(GLuint index, GLfloat x, GLfloat y, GLfloat w, GLfloat h)
+{
+    GLStateCache_Forward();
+    g_Driver.glViewportIndexedf(index, x, y, w, h);
+    g_Shadow.Viewport[0] = GL_STATE_CACHE_UNKNOWN;
+}
+
+static void GLAPIENTRY GLStateCache_glViewportIndexedfv(GLuint index, const GLfloat* v)
+{
+    GLStateCache_Forward();
+    g_Driver.glViewportIndexedfv(index, v);
+    g_Shadow.Viewport[0] = GL_STATE_CACHE_UNKNOWN;
+}
+
+static void GLAPIENTRY GLStateCache_glScissor(GLint x, GLint y, GLsizei width, GLsizei height)
+{
+    if (GLStateCache_Set4(g_Shadow.Scissor, x, y, width, height))
+        g_Driver.glScissor(x, y, width, height);
+}
+
+static void GLAPIENTRY GLStateCache_glScissorArrayv(GLuint first, GLsizei count, const GLint* v)
+{
+    GLStateCache_Forward();
+    g_Driver.glScissorArrayv(first, count, v);
+    g_Shadow.Scissor[0] = GL_STATE_CACHE_UNKNOWN;
+}
+
+static void GLAPIENTRY GLStateCache_glScissorIndexed(GLuint index, GLint left, GLint bottom, GLsizei width, GLsizei height)
+{
+    GLStateCache_Forward();
+    g_Driver.glScissorIndexed(index, left, bottom, width, height);
+    g_Shadow.Scissor[0] = GL_STATE_CACHE_UNKNOWN;
+}
+
+static void GLAPIENTRY GLStateCache_glScissorIndexedv(GLuint index, const GLint* v)
+{
+    GLStateCache_Forward();
+    g_Driver.glScissorIndexedv(index, v);
+    g_Shadow.Scissor[0] = GL_STATE_CACHE_UNKNOWN;
+}
+
+// Shadow of a single-valued query, or NULL if it's not shadowed.
+static GLuint* GLStateCache_FindQuery(GLenum pname)
+{
+    switch (pname)
+    {
+    case GL_CURRENT_PROGRAM: return &g_Shadow.Program;
+    case GL_VERTEX_ARRAY_BINDING: return &g_Shadow.VertexArray;
+    case GL_ELEMENT_ARRAY_BUFFER_BINDING: return &g_Shadow.ElementArrayBuffer;
+    case GL_BLEND_SRC_RGB: return &g_Shadow.BlendFunc[0];
+    case GL_BLEND_DST_RGB: return &g_Shadow.BlendFunc[1];
+    case GL_BLEND_SRC_ALPHA: return &g_Shadow.BlendFunc[2];
+    case GL_BLEND_DST_ALPHA: return &g_Shadow.BlendFunc[3];
+    case GL_BLEND_EQUATION_RGB: return &g_Shadow.BlendEquationRGB;
+    case GL_BLEND_EQUATION_ALPHA: return &g_Shadow.BlendEquationAlpha;
+    }
+
+    for (int i = 0; i < (int)GL_STATE_CACHE_COUNTOF(kBufferTargets); i++)
+    {
+        if (kBufferTargets[i][1] == pname)
+            return &g_Shadow.Buffers[i];
+    }
+
+    GLuint unit = g_Shadow.ActiveTexture;
+    if (unit < GL_STATE_CACHE_TEXTURE_UNITS)
+    {
+        if (pname == GL_SAMPLER_BINDING)
+            return &g_Shadow.Samplers[unit];
+
+        for (int i = 0; i < (int)GL_STATE_CACHE_COUNTOF(kTextureTargets); i++)
+        {
+            if (kTextureTargets[i][1] == pname)
+                return &g_Shadow.Textures[unit][i];
+        }
+    }
+
+    return NULL;
+}
+
+static void GLAPIENTRY GLStateCache_glGetIntegerv(GLenum pname, GLint* data)
+{
+    if (pname == GL_VIEWPORT || pname == GL_SCISSOR_BOX)
+    {
+        GLuint* shadow = pname == GL_VIEWPORT ? g_Shadow.Viewport : g_Shadow.Scissor;
+        if (shadow[0] != GL_STATE_CACHE_UNKNOWN)
+        {
+            g_Stats.QueriesAnswered++;
+            for (int i = 0; i < 4; i++)
+                data[i] = (GLint)shadow[i];
+        }
+        else
+        {
+            g_Stats.QueriesForwarded++;
+            g_Driver.glGetIntegerv(pname, data);
+            for (int i = 0; i < 4; i++)
+                shadow[i] = (GLuint)data[i];
+        }
+        return;
+    }
+
+    if (pname == GL_ACTIVE_TEXTURE)
+    {
+        if (g_Shadow.ActiveTexture != GL_STATE_CACHE_UNKNOWN)
+        {
+            g_Stats.QueriesAnswered++;
+            *data = (GLint)(GL_TEXTURE0 + g_Shadow.ActiveTexture);
+        }
+        else
+        {
+            g_Stats.QueriesForwarded++;
+            g_Driver.glGetIntegerv(pname, data);
+            g_Shadow.ActiveTexture = (GLuint)*data - GL_TEXTURE0;
+        }
+        return;
+    }
+
+    GLuint* shadow = GLStateCache_FindQuery(pname);
+    if (shadow && *shadow != GL_STATE_CACHE_UNKNOWN)
+    {
+        g_Stats.QueriesAnswered++;
+        *data = (GLint)*shadow;
+        return;
+    }
+
+    g_Stats.QueriesForwarded++;
+    g_Driver.glGetIntegerv(pname, data);
+    if (shadow)
+    {
+        *shadow = (GLuint)*data;
+        if (pname == GL_ELEMENT_ARRAY_BUFFER_BINDING)
+            GLStateCache_RememberVertexArrayElements(g_Shadow.VertexArray, *shadow);
+    }
+}
+
+void GLStateCache_Install()
+{
+    if (g_Installed)
+    {
+        return;
+    }
+
+    // The wrappers would see the calls of every thread's context, and would be bypassed by the tables anyway.
+    if (OpenGL_IsDispatchEnabled())
+    {
+        fprintf(stderr, "GL state cache: not installed, since OpenGL dispatch is enabled\n");
+        return;
+    }
+
+#define GL_STATE_CACHE_INSTALL(f) g_Driver.f = ::f; ::f = GLStateCache_##f;
+    GL_STATE_CACHE_FUNCTIONS(GL_STATE_CACHE_INSTALL)
+#undef GL_STATE_CACHE_INSTALL
+
+    // The state may have changed since the last time it was installed.
+    GLStateCache_Invalidate();
+    g_Installed = true;
+}
+
+void GLStateCache_Uninstall()
+{
+    if (!g_Installed)
+    {
+        return;
+    }
+
+#define GL_STATE_CACHE_UNINSTALL(f) ::f = g_Driver.f;
+    GL_STATE_CACHE_FUNCTIONS(GL_STATE_CACHE_UNINSTALL)
+#undef GL_STATE_CACHE_UNINSTALL
+
+    g_Installed = false;
+}
+
+bool GLStateCache_IsInstalled()
+{
+    return g_Installed;
+}
+
+void GLStateCache_Invalidate()
+{
+    // Every field is a GLuint, so this makes them all unknown.
+    memset(&g_Shadow, 0xFF, sizeof(g_Shadow));
+
+    for (GLStateVertexArray& entry : g_VertexArrays)
+    {
+        entry.VertexArray = GL_STATE_CACHE_UNKNOWN;
+    }
+}
+
+const GLStateCacheStats& GLStateCache_GetStats()
+{
+    return g_Stats;
+}
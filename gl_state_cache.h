@@ -0,0 +1,40 @@
+#pragma once
+
+// Shadow copy of the GL state that gets bound and queried every frame (program, vertex array, buffer and texture bindings,
+// samplers, enables, blending, viewport and scissor).
+//
+// GLStateCache_Install() replaces the function pointers of opengl.h that set or query that state with wrappers that:
+// - skip calls that would set a value the state already has,
+// - answer glGetIntegerv/glIsEnabled from the shadow, instead of a round-trip that can stall the driver's thread.
+// Calls are never deferred, so the driver's state is always the same as the shadow. A value that the wrappers can't
+// know (eg. after glBindTextures with textures of unknown targets) is marked unknown: the next query of it goes to
+// the driver, and the next call that sets it is not skipped.
+//
+// Only tracks the context that is current when it's installed, and must only be used from that context's thread.
+// Call GLStateCache_Invalidate() if the state is changed behind its back (eg. by another library loading its own pointers).
+
+#include <cstdint>
+
+#define GL_STATE_CACHE_TEXTURE_UNITS 16
+#define GL_STATE_CACHE_VERTEX_ARRAYS 16
+
+struct GLStateCacheStats
+{
+    uint64_t CallsIssued;       // State setting calls that were passed to the driver
+    uint64_t CallsAvoided;      // State setting calls that were skipped since they wouldn't change anything
+    uint64_t QueriesAnswered;   // Queries answered from the shadow
+    uint64_t QueriesForwarded;  // Queries that went to the driver
+};
+
+// Call after OpenGL_Init(), with the context current. Does nothing while OpenGL_EnableDispatch() is in effect.
+void GLStateCache_Install();
+
+// Puts the driver's function pointers back.
+void GLStateCache_Uninstall();
+
+bool GLStateCache_IsInstalled();
+
+// Forgets all shadowed values.
+void GLStateCache_Invalidate();
+
+const GLStateCacheStats& GLStateCache_GetStats();
@@ -0,0 +1,98 @@
+#include "gl_stream_ring.h"
+
+#include "clock.h"
+
+GLStreamRing::GLStreamRing()
+{
+    Stats = GLStreamRingStats();
+    BufferName = 0;
+    Mapping = NULL;
+    RegionSize = 0;
+    for (GLsync& fence : Fences)
+    {
+        fence = NULL;
+    }
+    FrameIndex = 0;
+}
+
+void GLStreamRing::Init(GLsizeiptr initialRegionSize)
+{
+    Allocate(Align(initialRegionSize));
+}
+
+void GLStreamRing::Shutdown()
+{
+    for (GLsync& fence : Fences)
+    {
+        if (fence)
+        {
+            glDeleteSync(fence);
+            fence = NULL;
+        }
+    }
+
+    if (BufferName)
+    {
+        // Deleting a buffer unmaps it
+        glDeleteBuffers(1, &BufferName);
+        BufferName = 0;
+        Mapping = NULL;
+    }
+}
+
+void GLStreamRing::Allocate(GLsizeiptr regionSize)
+{
+    // The fences of the old buffer don't matter for the new one.
+    Shutdown();
+
+    RegionSize = regionSize;
+
+    const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    glGenBuffers(1, &BufferName);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, BufferName);
+    glBufferStorage(GL_COPY_WRITE_BUFFER, RegionSize * GL_STREAM_RING_FRAMES, NULL, flags);
+    Mapping = (unsigned char*)glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, RegionSize * GL_STREAM_RING_FRAMES, flags);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+}
+
+unsigned char* GLStreamRing::BeginFrame(GLsizeiptr size)
+{
+    if (size > RegionSize)
+    {
+        GLsizeiptr grown = RegionSize * 2;
+        Allocate(Align(size > grown ? size : grown));
+        Stats.Grows++;
+    }
+
+    GLsync& fence = Fences[FrameIndex % GL_STREAM_RING_FRAMES];
+    if (fence)
+    {
+        // The first check flushes, so the fence is sure to signal eventually.
+        GLenum status = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+        if (status == GL_TIMEOUT_EXPIRED)
+        {
+            uint64_t stallStart = GetClock()->NowNs();
+            do
+            {
+                status = glClientWaitSync(fence, 0, 1000000);
+            } while (status == GL_TIMEOUT_EXPIRED);
+
+            Stats.Stalls++;
+            Stats.StallNs += GetClock()->NowNs() - stallStart;
+        }
+
+        glDeleteSync(fence);
+        fence = NULL;
+    }
+
+    Stats.BytesStreamed += size;
+    Stats.Frames++;
+
+    return Mapping + RegionOffset();
+}
+
+void GLStreamRing::EndFrame()
+{
+    Fences[FrameIndex % GL_STREAM_RING_FRAMES] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    FrameIndex++;
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+// Persistently mapped buffer for data that is rewritten every frame (eg. ImGui's vertices and indices).
+//
+// The buffer is split into GL_STREAM_RING_FRAMES regions, and each frame writes into the next one, so the CPU can
+// fill a region while the GPU still reads the previous frames'. A fence placed after each frame's draws guards its
+// region: it's only waited on if the CPU gets GL_STREAM_RING_FRAMES frames ahead of the GPU, which counts as a stall.
+//
+// When a frame needs more than a region, the buffer is replaced with a bigger one. Deleting the old buffer is safe
+// even if the GPU still reads from it, since GL keeps it alive until then.
+
+#include "opengl.h"
+
+#include <cstdint>
+
+#define GL_STREAM_RING_FRAMES 3
+
+// Start of each allocation within a region. Covers vertex strides and index sizes.
+#define GL_STREAM_RING_ALIGNMENT 64
+
+struct GLStreamRingStats
+{
+    uint64_t BytesStreamed;
+    uint64_t Frames;
+    uint64_t Stalls;        // Frames that had to wait for the GPU to release their region
+    uint64_t StallNs;       // Total time spent waiting
+    uint64_t Grows;         // Times the buffer was reallocated
+};
+
+class GLStreamRing
+{
+public:
+    GLStreamRing();
+
+    void Init(GLsizeiptr initialRegionSize);
+    void Shutdown();
+
+    // Starts writing a frame of up to 'size' bytes. Returns the mapped memory of the frame's region.
+    // The region starts at RegionOffset() within Buffer(), which can change when the ring grows.
+    unsigned char* BeginFrame(GLsizeiptr size);
+
+    // Fences the region of the frame. Call once the draws that read it have been submitted.
+    void EndFrame();
+
+    GLuint Buffer() const { return BufferName; }
+    GLintptr RegionOffset() const { return (GLintptr)(FrameIndex % GL_STREAM_RING_FRAMES) * RegionSize; }
+    GLsizeiptr Capacity() const { return RegionSize; }
+
+    // Rounds up to GL_STREAM_RING_ALIGNMENT, for packing several arrays in a frame.
+    static GLsizeiptr Align(GLsizeiptr size) { return (size + GL_STREAM_RING_ALIGNMENT - 1) & ~(GLsizeiptr)(GL_STREAM_RING_ALIGNMENT - 1); }
+
+    GLStreamRingStats Stats;
+
+private:
+    void Allocate(GLsizeiptr regionSize);
+
+    GLuint BufferName;
+    unsigned char* Mapping;
+    GLsizeiptr RegionSize;
+    GLsync Fences[GL_STREAM_RING_FRAMES];
+    uint64_t FrameIndex;
+};
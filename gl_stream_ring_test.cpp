@@ -0,0 +1,95 @@
+#include "self_test.h"
+
+#include "gl_stream_ring.h"
+#include "gl_recorder.h"
+
+#include <cstring>
+
+// Times the fence of the next frame's region reports not signaled yet, to make the ring stall
+static int g_GLStreamRingTestTimeouts;
+
+static GLenum GLAPIENTRY GLStreamRingTest_ClientWaitSync(GLsync, GLbitfield, GLuint64)
+{
+    if (g_GLStreamRingTestTimeouts > 0)
+    {
+        g_GLStreamRingTestTimeouts--;
+        return GL_TIMEOUT_EXPIRED;
+    }
+    return GL_CONDITION_SATISFIED;
+}
+
+// Streams frames through the ring on the recording backend and checks where each frame lands, that a region is only
+// reused once its fence has been waited on, that a busy fence counts as a stall, and that growing replaces the buffer.
+SelfTestResult GLStreamRingTest_RunUploads()
+{
+    SelfTestResult result = {};
+
+    OpenGL_InitRecording();
+    const GLRecorderStats& total = GLRecorder_GetTotalStats();
+    const uint32_t* calls = total.CallsPerFunction;
+    uint32_t fenceSync = GLRecorder_FindFunction("glFenceSync");
+    uint32_t clientWaitSync = GLRecorder_FindFunction("glClientWaitSync");
+    uint32_t deleteSync = GLRecorder_FindFunction("glDeleteSync");
+    uint32_t bufferStorage = GLRecorder_FindFunction("glBufferStorage");
+
+    // One persistent mapping of every region
+    GLStreamRing ring;
+    ring.Init(1000);
+    SELF_TEST_CHECK(result, ring.Buffer() != 0 && ring.Capacity() == 1024);
+    SELF_TEST_CHECK(result, calls[bufferStorage] == 1 && total.BytesMapped == 1024 * GL_STREAM_RING_FRAMES);
+
+    // Each frame writes the next region, and data is written straight into the buffer
+    unsigned char* base = NULL;
+    bool landed = true;
+    for (int frame = 0; frame < 2 * GL_STREAM_RING_FRAMES; frame++)
+    {
+        unsigned char* mapped = ring.BeginFrame(500);
+        base = frame == 0 ? mapped : base;
+        SELF_TEST_CHECK(result, ring.RegionOffset() == (frame % GL_STREAM_RING_FRAMES) * 1024);
+        SELF_TEST_CHECK(result, mapped == base + ring.RegionOffset());
+
+        memset(mapped, frame + 1, 500);
+        const unsigned char* buffer = (const unsigned char*)glMapNamedBufferRange(ring.Buffer(), ring.RegionOffset(), 500, GL_MAP_READ_BIT);
+        landed = landed && buffer && buffer[0] == frame + 1 && buffer[499] == frame + 1;
+        ring.EndFrame();
+    }
+    SELF_TEST_CHECK(result, landed);
+    SELF_TEST_CHECK(result, calls[bufferStorage] == 1);
+
+    // The frames that came back to a region waited on its fence, without stalling since it was signaled.
+    SELF_TEST_CHECK(result, calls[fenceSync] == 2 * GL_STREAM_RING_FRAMES);
+    SELF_TEST_CHECK(result, calls[clientWaitSync] == GL_STREAM_RING_FRAMES && calls[deleteSync] == GL_STREAM_RING_FRAMES);
+    SELF_TEST_CHECK(result, ring.Stats.Frames == 2 * GL_STREAM_RING_FRAMES && ring.Stats.BytesStreamed == 2 * GL_STREAM_RING_FRAMES * 500);
+    SELF_TEST_CHECK(result, ring.Stats.Stalls == 0);
+
+    // A region the GPU still reads: the ring waits until its fence signals
+    GLenum (GLAPIENTRYP recorderClientWaitSync)(GLsync, GLbitfield, GLuint64) = glClientWaitSync;
+    glClientWaitSync = &GLStreamRingTest_ClientWaitSync;
+    g_GLStreamRingTestTimeouts = 3;
+    ring.BeginFrame(500);
+    ring.EndFrame();
+    glClientWaitSync = recorderClientWaitSync;
+    SELF_TEST_CHECK(result, g_GLStreamRingTestTimeouts == 0);
+    SELF_TEST_CHECK(result, ring.Stats.Stalls == 1);
+
+    // A frame bigger than a region: a new buffer at least twice as big, and the old one's fences are dropped
+    GLuint oldBuffer = ring.Buffer();
+    uint32_t deletesBeforeGrow = calls[deleteSync];
+    uint32_t waitsBeforeGrow = calls[clientWaitSync];
+    ring.BeginFrame(1500);
+    SELF_TEST_CHECK(result, ring.Stats.Grows == 1 && ring.Capacity() == 2048);
+    SELF_TEST_CHECK(result, ring.Buffer() != oldBuffer && calls[bufferStorage] == 2);
+    SELF_TEST_CHECK(result, calls[deleteSync] == deletesBeforeGrow + GL_STREAM_RING_FRAMES && calls[clientWaitSync] == waitsBeforeGrow);
+    ring.EndFrame();
+
+    ring.BeginFrame(GL_STREAM_RING_ALIGNMENT * 100);
+    SELF_TEST_CHECK(result, ring.Stats.Grows == 2 && ring.Capacity() == GL_STREAM_RING_ALIGNMENT * 100);
+    ring.EndFrame();
+
+    // Every fence is deleted in the end
+    ring.Shutdown();
+    SELF_TEST_CHECK(result, ring.Buffer() == 0);
+    SELF_TEST_CHECK(result, calls[deleteSync] == calls[fenceSync]);
+
+    return result;
+}
@@ -0,0 +1,191 @@
+#include "gui_allocator.h"
+
+#include "imgui.h"
+#include "imgui_internal.h"
+
+#include <cassert>
+#include <cstdlib>
+
+#define GUI_ALLOCATOR_ALIGNMENT 16
+
+// With IMGUI_MEM_INSTRUMENTATION, ImGui asks for its header on top of every allocation. Blocks have room for it, so
+// the power of 2 sizes ImVector grows to still get the class of their size, and the largest class still goes to a pool.
+#ifdef IMGUI_MEM_INSTRUMENTATION
+#define GUI_ALLOCATOR_HEADROOM IMGUI_MEM_HEADER_SIZE
+#else
+#define GUI_ALLOCATOR_HEADROOM 0
+#endif
+
+#define GUI_ALLOCATOR_CLASS_COUNT 12
+static_assert((GUI_ALLOCATOR_MIN_POOLED << (GUI_ALLOCATOR_CLASS_COUNT - 1)) == GUI_ALLOCATOR_MAX_POOLED, "");
+static_assert(GUI_ALLOCATOR_MIN_POOLED >= sizeof(void*) && GUI_ALLOCATOR_MIN_POOLED % GUI_ALLOCATOR_ALIGNMENT == 0, "");
+static_assert(GUI_ALLOCATOR_HEADROOM % GUI_ALLOCATOR_ALIGNMENT == 0, "");
+static_assert(GUI_ALLOCATOR_SLAB_SIZE >= GUI_ALLOCATOR_MAX_POOLED + GUI_ALLOCATOR_HEADROOM, "");
+static_assert(GUI_ALLOCATOR_POOL_REGION_SIZE % GUI_ALLOCATOR_SLAB_SIZE == 0, "");
+
+#define GUI_ALLOCATOR_SLAB_COUNT (GUI_ALLOCATOR_POOL_REGION_SIZE / GUI_ALLOCATOR_SLAB_SIZE)
+
+struct GuiAllocatorFreeBlock
+{
+    GuiAllocatorFreeBlock* Next;
+};
+
+struct GuiAllocatorClass
+{
+    GuiAllocatorFreeBlock* FreeList;
+    unsigned char* SlabCursor;      // Next never allocated block of the class' last slab
+    unsigned char* SlabEnd;
+};
+
+static struct
+{
+    unsigned char* Arena;
+    size_t ArenaUsed;
+    int ArenaLive;                  // Arena allocations not freed yet, should be 0 at every new frame
+
+    unsigned char* Pool;
+    int SlabsCarved;
+    unsigned char SlabClass[GUI_ALLOCATOR_SLAB_COUNT];
+    GuiAllocatorClass Classes[GUI_ALLOCATOR_CLASS_COUNT];
+
+    GuiAllocatorStats Stats;
+} g_GuiAllocator;
+
+static size_t GuiAllocator_BlockSize(int sizeClass)
+{
+    return ((size_t)GUI_ALLOCATOR_MIN_POOLED << sizeClass) + GUI_ALLOCATOR_HEADROOM;
+}
+
+static int GuiAllocator_SizeClass(size_t size)
+{
+    int sizeClass = 0;
+    while (GuiAllocator_BlockSize(sizeClass) < size)
+    {
+        sizeClass++;
+    }
+    return sizeClass;
+}
+
+void GuiAllocator_Install()
+{
+    if (!g_GuiAllocator.Pool)
+    {
+        g_GuiAllocator.Arena = (unsigned char*)malloc(GUI_ALLOCATOR_ARENA_SIZE);
+        g_GuiAllocator.Pool = (unsigned char*)malloc(GUI_ALLOCATOR_POOL_REGION_SIZE);
+        assert(g_GuiAllocator.Arena && g_GuiAllocator.Pool);
+    }
+
+    ImGuiIO& io = ImGui::GetIO();
+    io.MemAllocFn = GuiAllocator_Alloc;
+    io.MemFreeFn = GuiAllocator_Free;
+    io.MemAllocTransientFn = GuiAllocator_AllocTransient;
+}
+
+void GuiAllocator_NewFrame()
+{
+    // A buffer kept past its frame would be overwritten by the next frame's, so rather keep the arena as is
+    assert(g_GuiAllocator.ArenaLive == 0);
+    if (g_GuiAllocator.ArenaLive == 0)
+    {
+        g_GuiAllocator.ArenaUsed = 0;
+        g_GuiAllocator.Stats.ArenaBytes = 0;
+    }
+}
+
+void* GuiAllocator_Alloc(size_t size)
+{
+    GuiAllocatorStats& stats = g_GuiAllocator.Stats;
+
+    if (size <= GUI_ALLOCATOR_MAX_POOLED + GUI_ALLOCATOR_HEADROOM && g_GuiAllocator.Pool)
+    {
+        const int sizeClass = GuiAllocator_SizeClass(size);
+        const size_t blockSize = GuiAllocator_BlockSize(sizeClass);
+        GuiAllocatorClass& poolClass = g_GuiAllocator.Classes[sizeClass];
+
+        if (GuiAllocatorFreeBlock* block = poolClass.FreeList)
+        {
+            poolClass.FreeList = block->Next;
+            stats.PoolAllocs++;
+            stats.PoolBytes += blockSize;
+            return block;
+        }
+
+        // Blocks don't always divide a slab, the end of one that can't hold another block is left unused
+        if ((size_t)(poolClass.SlabEnd - poolClass.SlabCursor) < blockSize && g_GuiAllocator.SlabsCarved < GUI_ALLOCATOR_SLAB_COUNT)
+        {
+            const int slab = g_GuiAllocator.SlabsCarved++;
+            g_GuiAllocator.SlabClass[slab] = (unsigned char)sizeClass;
+            poolClass.SlabCursor = g_GuiAllocator.Pool + (size_t)slab * GUI_ALLOCATOR_SLAB_SIZE;
+            poolClass.SlabEnd = poolClass.SlabCursor + GUI_ALLOCATOR_SLAB_SIZE;
+            stats.SlabBytes += GUI_ALLOCATOR_SLAB_SIZE;
+        }
+
+        if ((size_t)(poolClass.SlabEnd - poolClass.SlabCursor) >= blockSize)
+        {
+            void* block = poolClass.SlabCursor;
+            poolClass.SlabCursor += blockSize;
+            stats.PoolAllocs++;
+            stats.PoolBytes += blockSize;
+            return block;
+        }
+    }
+
+    stats.HeapAllocs++;
+    return malloc(size);
+}
+
+void* GuiAllocator_AllocTransient(size_t size)
+{
+    const size_t alignedSize = (size + GUI_ALLOCATOR_ALIGNMENT - 1) & ~(size_t)(GUI_ALLOCATOR_ALIGNMENT - 1);
+    if (!g_GuiAllocator.Arena || alignedSize > GUI_ALLOCATOR_ARENA_SIZE - g_GuiAllocator.ArenaUsed)
+    {
+        return GuiAllocator_Alloc(size);
+    }
+
+    void* block = g_GuiAllocator.Arena + g_GuiAllocator.ArenaUsed;
+    g_GuiAllocator.ArenaUsed += alignedSize;
+    g_GuiAllocator.ArenaLive++;
+
+    GuiAllocatorStats& stats = g_GuiAllocator.Stats;
+    stats.ArenaAllocs++;
+    stats.ArenaBytes = g_GuiAllocator.ArenaUsed;
+    if (stats.ArenaPeakBytes < stats.ArenaBytes)
+    {
+        stats.ArenaPeakBytes = stats.ArenaBytes;
+    }
+    return block;
+}
+
+void GuiAllocator_Free(void* ptr)
+{
+    if (!ptr)
+    {
+        return;
+    }
+
+    unsigned char* p = (unsigned char*)ptr;
+    if (p >= g_GuiAllocator.Arena && p < g_GuiAllocator.Arena + GUI_ALLOCATOR_ARENA_SIZE)
+    {
+        g_GuiAllocator.ArenaLive--;
+        return;
+    }
+
+    if (p >= g_GuiAllocator.Pool && p < g_GuiAllocator.Pool + GUI_ALLOCATOR_POOL_REGION_SIZE)
+    {
+        const int sizeClass = g_GuiAllocator.SlabClass[(size_t)(p - g_GuiAllocator.Pool) / GUI_ALLOCATOR_SLAB_SIZE];
+        GuiAllocatorClass& poolClass = g_GuiAllocator.Classes[sizeClass];
+        GuiAllocatorFreeBlock* block = (GuiAllocatorFreeBlock*)ptr;
+        block->Next = poolClass.FreeList;
+        poolClass.FreeList = block;
+        g_GuiAllocator.Stats.PoolBytes -= GuiAllocator_BlockSize(sizeClass);
+        return;
+    }
+
+    g_GuiAllocator.Stats.HeapFrees++;
+    free(ptr);
+}
+
+const GuiAllocatorStats& GuiAllocator_GetStats()
+{
+    return g_GuiAllocator.Stats;
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+// Allocator for ImGui (ImGuiIO::MemAllocFn/MemFreeFn/MemAllocTransientFn), so that building the GUI doesn't go to the
+// heap once it has reached its steady state. Allocations go to the first tier that can serve them:
+// - Frame arena: for ImGui::MemAllocTransient() buffers, which are freed before the next NewFrame(). Allocating is
+//   a pointer bump, freeing does nothing, and the whole arena is reset by GuiAllocator_NewFrame().
+// - Size-class pools: for everything else up to GUI_ALLOCATOR_MAX_POOLED bytes, which is most ImVector storage.
+//   Sizes are rounded up to a power of 2 (plus ImGui's header with IMGUI_MEM_INSTRUMENTATION), and each class
+//   carves GUI_ALLOCATOR_SLAB_SIZE slabs out of one region reserved at install. Freed blocks go on their class' free
+//   list and are never returned, so a buffer that grows and shrinks back (eg. a draw list's channels, or the window
+//   sort buffer) reuses the same blocks every time.
+// - Heap: malloc, for larger blocks and once the arena or the pool region is exhausted.
+// Pointers outside of the arena and pool region are passed to free(), so blocks allocated before the install are fine.
+//
+// Like ImGui, it must only be used from one thread.
+
+#include <cstddef>
+#include <cstdint>
+
+#define GUI_ALLOCATOR_ARENA_SIZE (256 * 1024)
+#define GUI_ALLOCATOR_POOL_REGION_SIZE (16 * 1024 * 1024)
+#define GUI_ALLOCATOR_SLAB_SIZE (64 * 1024)
+
+// Smallest and largest size classes, powers of 2. The smallest must hold a free list link.
+#define GUI_ALLOCATOR_MIN_POOLED 16
+#define GUI_ALLOCATOR_MAX_POOLED (32 * 1024)
+
+struct GuiAllocatorStats
+{
+    uint64_t ArenaAllocs;
+    uint64_t PoolAllocs;
+    uint64_t HeapAllocs;
+    uint64_t HeapFrees;
+    size_t   ArenaBytes;        // Used in the current frame
+    size_t   ArenaPeakBytes;    // Most used in a frame
+    size_t   PoolBytes;         // Of blocks in use, rounded up to their size class
+    size_t   SlabBytes;         // Carved out of the pool region
+};
+
+// Sets the current ImGui context's allocation functions. Call before anything allocates from it (eg. building fonts).
+void GuiAllocator_Install();
+
+// Resets the frame arena. Call before ImGui::NewFrame().
+void GuiAllocator_NewFrame();
+
+void* GuiAllocator_Alloc(size_t size);
+void* GuiAllocator_AllocTransient(size_t size);
+void GuiAllocator_Free(void* ptr);
+
+const GuiAllocatorStats& GuiAllocator_GetStats();
@@ -0,0 +1,110 @@
+#include "hash_benchmark.h"
+
+#include "imgui.h"
+#include "imgui_internal.h"
+#include "clock.h"
+
+#include <cstring>
+
+static const char* const kHashBenchmarkLabels[] = {
+    "GUI", "Debug", "Profiler", "Mode", "Fullscreen", "Adaptive VSync", "Swap Interval", "Show profiler",
+    "Reset latency", "Dump latency CSV", "Replay input trace", "Replay speed (0 = unthrottled)",
+    "Hide OS Cursor (overrides current mode)", "Never sleep the Window thread", "Single-submission ImGui draws",
+    "##hidden", "##value", "##scrolling", "##combo", "##slider",
+    "Settings###settings", "Frame 1234###frame", "Record input trace (input_trace.bin)###record",
+    "Window options", "Widgets", "Graphs widgets", "Layout", "Popups & Modal windows", "Columns", "Filtering",
+    "Keyboard, Mouse & Focus", "#CLOSE", "#COLLAPSE", "#SCROLLX", "#SCROLLY", "#RESIZE", "#MOVE", "#BUTTON",
+    "OK", "Cancel", "Apply", "Item 0", "Item 1", "Item 42", "Node 7", "Child 3", "Tab 12",
+};
+
+static volatile ImU32 g_HashBenchmarkSink;
+
+// The implementation ImHash had before it was sliced by 8, as the reference.
+static ImU32 HashBenchmark_LegacyHash(const void* data, int data_size, ImU32 seed)
+{
+    static ImU32 crc32_lut[256] = { 0 };
+    if (!crc32_lut[1])
+    {
+        const ImU32 polynomial = 0xEDB88320;
+        for (ImU32 i = 0; i < 256; i++)
+        {
+            ImU32 crc = i;
+            for (ImU32 j = 0; j < 8; j++)
+                crc = (crc >> 1) ^ (ImU32(-int(crc & 1)) & polynomial);
+            crc32_lut[i] = crc;
+        }
+    }
+
+    seed = ~seed;
+    ImU32 crc = seed;
+    const unsigned char* current = (const unsigned char*)data;
+
+    if (data_size > 0)
+    {
+        while (data_size--)
+            crc = (crc >> 8) ^ crc32_lut[(crc & 0xFF) ^ *current++];
+    }
+    else
+    {
+        while (unsigned char c = *current++)
+        {
+            if (c == '#' && current[0] == '#' && current[1] == '#')
+                crc = seed;
+            crc = (crc >> 8) ^ crc32_lut[(crc & 0xFF) ^ c];
+        }
+    }
+    return ~crc;
+}
+
+template<class Hash>
+static uint64_t HashBenchmark_Time(int iterations, const int* sizes, Hash hash)
+{
+    const int labelCount = IM_ARRAYSIZE(kHashBenchmarkLabels);
+
+    // Chained through the seed like the ID stack, which also keeps the compiler from skipping the work
+    ImU32 seed = 0;
+    uint64_t start = GetClock()->NowNs();
+    for (int i = 0; i < iterations; i++)
+    {
+        for (int j = 0; j < labelCount; j++)
+        {
+            seed = hash(kHashBenchmarkLabels[j], 0, seed);
+            seed = hash(kHashBenchmarkLabels[j], sizes[j], seed);
+        }
+    }
+    uint64_t elapsed = GetClock()->NowNs() - start;
+
+    g_HashBenchmarkSink = seed;
+    return elapsed;
+}
+
+HashBenchmarkResult HashBenchmark_Run(int iterations)
+{
+    const int labelCount = IM_ARRAYSIZE(kHashBenchmarkLabels);
+
+    HashBenchmarkResult result = {};
+    result.Labels = labelCount;
+
+    int sizes[labelCount];
+    for (int j = 0; j < labelCount; j++)
+    {
+        sizes[j] = (int)strlen(kHashBenchmarkLabels[j]);
+        result.Bytes += sizes[j];
+
+        const ImU32 seeds[] = { 0, 0x12345678, 0xFFFFFFFF };
+        for (ImU32 seed : seeds)
+        {
+            if (ImHash(kHashBenchmarkLabels[j], 0, seed) != HashBenchmark_LegacyHash(kHashBenchmarkLabels[j], 0, seed) ||
+                ImHash(kHashBenchmarkLabels[j], sizes[j], seed) != HashBenchmark_LegacyHash(kHashBenchmarkLabels[j], sizes[j], seed))
+            {
+                result.Mismatches++;
+                break;
+            }
+        }
+    }
+
+    result.Hashes = (uint64_t)iterations * labelCount * 2;
+    result.LegacyNs = HashBenchmark_Time(iterations, sizes, HashBenchmark_LegacyHash);
+    result.CurrentNs = HashBenchmark_Time(iterations, sizes, ImHash);
+    return result;
+}
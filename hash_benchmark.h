@@ -0,0 +1,21 @@
+#pragma once
+
+// Microbenchmark of ImHash against the byte-at-a-time CRC32 it replaced, which also checks that both produce the same IDs.
+//
+// The labels are like the ones hashed every frame: short widget labels, "##" labels without visible text,
+// "label###id" labels whose hash restarts at the ###, and longer window and tree node names. Each is hashed both as a
+// zero-terminated string (GetID, Begin) and with a known size (labels ending at a "##" or given with an end pointer).
+
+#include <cstdint>
+
+struct HashBenchmarkResult
+{
+    uint32_t Labels;
+    uint64_t Bytes;         // Total length of the labels
+    uint64_t Hashes;        // Hashes per implementation
+    uint64_t LegacyNs;
+    uint64_t CurrentNs;
+    uint32_t Mismatches;    // Labels whose IDs differ between the two, should always be 0
+};
+
+HashBenchmarkResult HashBenchmark_Run(int iterations);
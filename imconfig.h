@@ -45,6 +45,12 @@
         operator MyVec4() const { return MyVec4(x,y,z,w); }
 */
 
+//---- Back ImGuiStorage (tree node states, etc.) with a hash table instead of a sorted array, for O(1) lookups and insertions with many keys
+#define IMGUI_STORAGE_OPEN_ADDRESSING
+
+//---- Attribute ImGui's allocations to its subsystems (draw lists, fonts, storage...), for ShowMetricsWindow() and SaveMemStatsToDisk(). Adds 16 bytes per allocation
+//#define IMGUI_MEM_INSTRUMENTATION
+
 //---- Use 32-bit vertex indices (instead of default: 16-bit) to allow meshes with more than 64K vertices
 //#define ImDrawIdx unsigned int
 
@@ -842,6 +842,7 @@ ImGuiIO::ImGuiIO()
     RenderDrawListsFn = NULL;
     MemAllocFn = malloc;
     MemFreeFn = free;
+    MemAllocTransientFn = NULL;
     GetClipboardTextFn = GetClipboardTextFn_DefaultImpl;   // Platform dependent default implementations
     SetClipboardTextFn = SetClipboardTextFn_DefaultImpl;
     ClipboardUserData = NULL;
@@ -988,12 +989,12 @@ int ImFormatStringV(char* buf, int buf_size, const char* fmt, va_list args)
     return w;
 }
 
-// Pass data_size==0 for zero-terminated strings
-// FIXME-OPT: Replace with e.g. FNV1a hash? CRC32 pretty much randomly access 1KB. Need to do proper measurements.
-ImU32 ImHash(const void* data, int data_size, ImU32 seed)
+// CRC32 (polynomial 0xEDB88320), sliced by 8: table k holds the CRC of a byte followed by k zero bytes, so 8 bytes
+// are folded in per step with 8 independent lookups instead of 8 dependent ones. Same results as the byte-wise table.
+static ImU32 ImCrc32(ImU32 crc, const unsigned char* data, size_t data_size)
 {
-    static ImU32 crc32_lut[256] = { 0 };
-    if (!crc32_lut[1])
+    static ImU32 crc32_lut[8][256] = { { 0 } };
+    if (!crc32_lut[7][1])
     {
         const ImU32 polynomial = 0xEDB88320;
         for (ImU32 i = 0; i < 256; i++)
@@ -1001,35 +1002,50 @@ ImU32 ImHash(const void* data, int data_size, ImU32 seed)
             ImU32 crc = i;
             for (ImU32 j = 0; j < 8; j++)
                 crc = (crc >> 1) ^ (ImU32(-int(crc & 1)) & polynomial);
-            crc32_lut[i] = crc;
+            crc32_lut[0][i] = crc;
         }
+        for (int k = 1; k < 8; k++)
+            for (ImU32 i = 0; i < 256; i++)
+                crc32_lut[k][i] = (crc32_lut[k - 1][i] >> 8) ^ crc32_lut[0][crc32_lut[k - 1][i] & 0xFF];
     }
 
+    // The words are assembled from bytes rather than loaded, so this doesn't depend on alignment or endianness.
+    // Compilers turn these into plain loads on little-endian targets.
+    while (data_size >= 8)
+    {
+        ImU32 lo = crc ^ ((ImU32)data[0] | ((ImU32)data[1] << 8) | ((ImU32)data[2] << 16) | ((ImU32)data[3] << 24));
+        ImU32 hi = (ImU32)data[4] | ((ImU32)data[5] << 8) | ((ImU32)data[6] << 16) | ((ImU32)data[7] << 24);
+        crc = crc32_lut[7][lo & 0xFF] ^ crc32_lut[6][(lo >> 8) & 0xFF] ^ crc32_lut[5][(lo >> 16) & 0xFF] ^ crc32_lut[4][lo >> 24] ^
+              crc32_lut[3][hi & 0xFF] ^ crc32_lut[2][(hi >> 8) & 0xFF] ^ crc32_lut[1][(hi >> 16) & 0xFF] ^ crc32_lut[0][hi >> 24];
+        data += 8;
+        data_size -= 8;
+    }
+    while (data_size--)
+        crc = (crc >> 8) ^ crc32_lut[0][(crc & 0xFF) ^ *data++];
+    return crc;
+}
+
+// Pass data_size==0 for zero-terminated strings
+// See ImHashLiteral() in imgui_internal.h for hashing string literals at compile time.
+ImU32 ImHash(const void* data, int data_size, ImU32 seed)
+{
     seed = ~seed;
-    ImU32 crc = seed;
     const unsigned char* current = (const unsigned char*)data;
 
+    // Known size
     if (data_size > 0)
-    {
-        // Known size
-        while (data_size--)
-            crc = (crc >> 8) ^ crc32_lut[(crc & 0xFF) ^ *current++];
-    }
-    else
-    {
-        // Zero-terminated string
-        while (unsigned char c = *current++)
-        {
-            // We support a syntax of "label###id" where only "###id" is included in the hash, and only "label" gets displayed.
-            // Because this syntax is rarely used we are optimizing for the common case.
-            // - If we reach ### in the string we discard the hash so far and reset to the seed.
-            // - We don't do 'current += 2; continue;' after handling ### to keep the code smaller.
-            if (c == '#' && current[0] == '#' && current[1] == '#')
-                crc = seed;
-            crc = (crc >> 8) ^ crc32_lut[(crc & 0xFF) ^ c];
-        }
-    }
-    return ~crc;
+        return ~ImCrc32(seed, current, (size_t)data_size);
+
+    // Zero-terminated string
+    // We support a syntax of "label###id" where only "###id" is included in the hash, and only "label" gets displayed.
+    // Every ### resets the hash to the seed, so only the part from the last ### counts. Because this syntax is rarely
+    // used, the string is scanned for '#' with memchr, which is vectorized, and the rest is hashed 8 bytes at a time.
+    size_t size = strlen((const char*)current);
+    const unsigned char* start = current;
+    for (const unsigned char* p = current; (p = (const unsigned char*)memchr(p, '#', size - (size_t)(p - current))) != NULL; p++)
+        if (p[1] == '#' && p[2] == '#')
+            start = p;
+    return ~ImCrc32(seed, start, size - (size_t)(start - current));
 }
 
 //-----------------------------------------------------------------------------
@@ -1356,6 +1372,168 @@ void* ImFileLoadToMemory(const char* filename, const char* file_open_mode, int*
 //-----------------------------------------------------------------------------
 
 // Helper: Key->value storage
+#ifdef IMGUI_STORAGE_OPEN_ADDRESSING
+
+void ImGuiStorage::Clear()
+{
+    Data.clear();
+    Slots.clear();
+}
+
+// Keys are usually already hashes, but not always (eg. PushID(int) with small integers), so spread them out
+static inline int StorageSlotHome(ImGuiID key, int mask)
+{
+    ImU32 h = key * 0x9E3779B1u;
+    return (int)((h ^ (h >> 16)) & (ImU32)mask);
+}
+
+// Slot holding key, or the empty slot where it would be inserted. Slots must not be empty.
+static int StorageFindSlot(const ImVector<ImGuiStorage::Slot>& slots, ImGuiID key)
+{
+    const int mask = slots.Size - 1;
+    int i = StorageSlotHome(key, mask);
+    while (slots[i].index != -1 && slots[i].key != key)
+        i = (i + 1) & mask;
+    return i;
+}
+
+static void StorageRehash(ImGuiStorage& storage, int slot_count)
+{
+    storage.Slots.resize(slot_count);
+    for (int i = 0; i < slot_count; i++)
+        storage.Slots[i].index = -1;
+    for (int i = 0; i < storage.Data.Size; i++)
+    {
+        ImGuiStorage::Slot& slot = storage.Slots[StorageFindSlot(storage.Slots, storage.Data[i].key)];
+        slot.key = storage.Data[i].key;
+        slot.index = i;
+    }
+}
+
+static const ImGuiStorage::Pair* StorageFind(const ImGuiStorage& storage, ImGuiID key)
+{
+    if (storage.Slots.Size == 0)
+        return NULL;
+    const int index = storage.Slots[StorageFindSlot(storage.Slots, key)].index;
+    return index != -1 ? &storage.Data[index] : NULL;
+}
+
+// Returns the existing pair, or inserts new_pair. A single probe does both the lookup and the insertion.
+static ImGuiStorage::Pair* StorageFindOrInsert(ImGuiStorage& storage, const ImGuiStorage::Pair& new_pair)
+{
+    ImGuiMemTagScope mem_tag(ImGuiMemTag_Storage);
+    if ((storage.Data.Size + 1) * 4 > storage.Slots.Size * 3)
+        StorageRehash(storage, storage.Slots.Size ? storage.Slots.Size * 2 : 16);
+    ImGuiStorage::Slot& slot = storage.Slots[StorageFindSlot(storage.Slots, new_pair.key)];
+    if (slot.index == -1)
+    {
+        slot.key = new_pair.key;
+        slot.index = storage.Data.Size;
+        storage.Data.push_back(new_pair);
+    }
+    return &storage.Data[slot.index];
+}
+
+int ImGuiStorage::GetInt(ImGuiID key, int default_val) const
+{
+    const Pair* pair = StorageFind(*this, key);
+    return pair ? pair->val_i : default_val;
+}
+
+bool ImGuiStorage::GetBool(ImGuiID key, bool default_val) const
+{
+    return GetInt(key, default_val ? 1 : 0) != 0;
+}
+
+float ImGuiStorage::GetFloat(ImGuiID key, float default_val) const
+{
+    const Pair* pair = StorageFind(*this, key);
+    return pair ? pair->val_f : default_val;
+}
+
+void* ImGuiStorage::GetVoidPtr(ImGuiID key) const
+{
+    const Pair* pair = StorageFind(*this, key);
+    return pair ? pair->val_p : NULL;
+}
+
+// References are only valid until a new value is added to the storage. Calling a Set***() function or a Get***Ref() function invalidates the pointer.
+int* ImGuiStorage::GetIntRef(ImGuiID key, int default_val)
+{
+    return &StorageFindOrInsert(*this, Pair(key, default_val))->val_i;
+}
+
+bool* ImGuiStorage::GetBoolRef(ImGuiID key, bool default_val)
+{
+    return (bool*)GetIntRef(key, default_val ? 1 : 0);
+}
+
+float* ImGuiStorage::GetFloatRef(ImGuiID key, float default_val)
+{
+    return &StorageFindOrInsert(*this, Pair(key, default_val))->val_f;
+}
+
+void** ImGuiStorage::GetVoidPtrRef(ImGuiID key, void* default_val)
+{
+    return &StorageFindOrInsert(*this, Pair(key, default_val))->val_p;
+}
+
+void ImGuiStorage::SetInt(ImGuiID key, int val)
+{
+    StorageFindOrInsert(*this, Pair(key, val))->val_i = val;
+}
+
+void ImGuiStorage::SetBool(ImGuiID key, bool val)
+{
+    SetInt(key, val ? 1 : 0);
+}
+
+void ImGuiStorage::SetFloat(ImGuiID key, float val)
+{
+    StorageFindOrInsert(*this, Pair(key, val))->val_f = val;
+}
+
+void ImGuiStorage::SetVoidPtr(ImGuiID key, void* val)
+{
+    StorageFindOrInsert(*this, Pair(key, val))->val_p = val;
+}
+
+// Moves the last pair into the removed one's place in Data, and shifts the following slots of the probe sequence back
+// over the emptied slot instead of leaving a tombstone, so lookups never slow down after many removals.
+void ImGuiStorage::Remove(ImGuiID key)
+{
+    if (Slots.Size == 0)
+        return;
+    int hole = StorageFindSlot(Slots, key);
+    const int index = Slots[hole].index;
+    if (index == -1)
+        return;
+
+    const int last = Data.Size - 1;
+    if (index != last)
+    {
+        Data[index] = Data[last];
+        Slots[StorageFindSlot(Slots, Data[index].key)].index = index;
+    }
+    Data.pop_back();
+
+    const int mask = Slots.Size - 1;
+    for (int i = (hole + 1) & mask; Slots[i].index != -1; i = (i + 1) & mask)
+    {
+        // Slot i can move back into the hole unless its home is cyclically within (hole, i]
+        const int home = StorageSlotHome(Slots[i].key, mask);
+        const bool stays = (hole <= i) ? (hole < home && home <= i) : (hole < home || home <= i);
+        if (!stays)
+        {
+            Slots[hole] = Slots[i];
+            hole = i;
+        }
+    }
+    Slots[hole].index = -1;
+}
+
+#else
+
 void ImGuiStorage::Clear()
 {
     Data.clear();
@@ -1416,6 +1594,7 @@ void* ImGuiStorage::GetVoidPtr(ImGuiID key) const
 // References are only valid until a new value is added to the storage. Calling a Set***() function or a Get***Ref() function invalidates the pointer.
 int* ImGuiStorage::GetIntRef(ImGuiID key, int default_val)
 {
+    ImGuiMemTagScope mem_tag(ImGuiMemTag_Storage);
     ImVector<Pair>::iterator it = LowerBound(Data, key);
     if (it == Data.end() || it->key != key)
         it = Data.insert(it, Pair(key, default_val));
@@ -1429,6 +1608,7 @@ bool* ImGuiStorage::GetBoolRef(ImGuiID key, bool default_val)
 
 float* ImGuiStorage::GetFloatRef(ImGuiID key, float default_val)
 {
+    ImGuiMemTagScope mem_tag(ImGuiMemTag_Storage);
     ImVector<Pair>::iterator it = LowerBound(Data, key);
     if (it == Data.end() || it->key != key)
         it = Data.insert(it, Pair(key, default_val));
@@ -1437,6 +1617,7 @@ float* ImGuiStorage::GetFloatRef(ImGuiID key, float default_val)
 
 void** ImGuiStorage::GetVoidPtrRef(ImGuiID key, void* default_val)
 {
+    ImGuiMemTagScope mem_tag(ImGuiMemTag_Storage);
     ImVector<Pair>::iterator it = LowerBound(Data, key);
     if (it == Data.end() || it->key != key)
         it = Data.insert(it, Pair(key, default_val));
@@ -1446,6 +1627,7 @@ void** ImGuiStorage::GetVoidPtrRef(ImGuiID key, void* default_val)
 // FIXME-OPT: Need a way to reuse the result of lower_bound when doing GetInt()/SetInt() - not too bad because it only happens on explicit interaction (maximum one a frame)
 void ImGuiStorage::SetInt(ImGuiID key, int val)
 {
+    ImGuiMemTagScope mem_tag(ImGuiMemTag_Storage);
     ImVector<Pair>::iterator it = LowerBound(Data, key);
     if (it == Data.end() || it->key != key)
     {
@@ -1462,6 +1644,7 @@ void ImGuiStorage::SetBool(ImGuiID key, bool val)
 
 void ImGuiStorage::SetFloat(ImGuiID key, float val)
 {
+    ImGuiMemTagScope mem_tag(ImGuiMemTag_Storage);
     ImVector<Pair>::iterator it = LowerBound(Data, key);
     if (it == Data.end() || it->key != key)
     {
@@ -1473,6 +1656,7 @@ void ImGuiStorage::SetFloat(ImGuiID key, float val)
 
 void ImGuiStorage::SetVoidPtr(ImGuiID key, void* val)
 {
+    ImGuiMemTagScope mem_tag(ImGuiMemTag_Storage);
     ImVector<Pair>::iterator it = LowerBound(Data, key);
     if (it == Data.end() || it->key != key)
     {
@@ -1482,6 +1666,15 @@ void ImGuiStorage::SetVoidPtr(ImGuiID key, void* val)
     it->val_p = val;
 }
 
+void ImGuiStorage::Remove(ImGuiID key)
+{
+    ImVector<Pair>::iterator it = LowerBound(Data, key);
+    if (it != Data.end() && it->key == key)
+        Data.erase(it);
+}
+
+#endif // IMGUI_STORAGE_OPEN_ADDRESSING
+
 void ImGuiStorage::SetAllInt(int v)
 {
     for (int i = 0; i < Data.Size; i++)
@@ -2033,18 +2226,186 @@ float ImGui::CalcWrapWidthForPos(const ImVec2& pos, float wrap_pos_x)
 
 //-----------------------------------------------------------------------------
 
+#ifdef IMGUI_MEM_INSTRUMENTATION
+
+// Prepended to every allocation so MemFree() knows what it frees. Padded to 16 bytes, to keep the alignment of MemAllocFn.
+struct ImGuiMemHeader
+{
+    size_t      Size;
+    ImGuiMemTag Tag;
+};
+static_assert(sizeof(ImGuiMemHeader) <= IMGUI_MEM_HEADER_SIZE, "");
+
+static void* MemTrackAlloc(void* block, size_t sz)
+{
+    if (!block)
+        return NULL;
+    ImGuiContext& g = *GImGui;
+    ImGuiMemHeader* header = (ImGuiMemHeader*)block;
+    header->Size = sz;
+    header->Tag = g.MemTag;
+    ImGuiMemTagStats& stats = g.MemTagStats[g.MemTag];
+    stats.Bytes += sz;
+    if (stats.PeakBytes < stats.Bytes)
+        stats.PeakBytes = stats.Bytes;
+    stats.Allocs++;
+    stats.FrameAllocs++;
+    stats.FrameAllocBytes += sz;
+    return (unsigned char*)block + IMGUI_MEM_HEADER_SIZE;
+}
+
+static void* MemTrackFree(void* ptr)
+{
+    ImGuiMemHeader* header = (ImGuiMemHeader*)((unsigned char*)ptr - IMGUI_MEM_HEADER_SIZE);
+    ImGuiMemTagStats& stats = GImGui->MemTagStats[header->Tag];
+    stats.Bytes -= header->Size;
+    stats.Allocs--;
+    stats.FrameFrees++;
+    return header;
+}
+
 void* ImGui::MemAlloc(size_t sz)
 {
     GImGui->IO.MetricsAllocs++;
+    GImGui->FrameAllocs++;
+    return MemTrackAlloc(GImGui->IO.MemAllocFn(sz + IMGUI_MEM_HEADER_SIZE), sz);
+}
+
+void* ImGui::MemAllocTransient(size_t sz)
+{
+    if (!GImGui->IO.MemAllocTransientFn)
+        return MemAlloc(sz);
+    GImGui->IO.MetricsAllocs++;
+    GImGui->FrameAllocs++;
+    return MemTrackAlloc(GImGui->IO.MemAllocTransientFn(sz + IMGUI_MEM_HEADER_SIZE), sz);
+}
+
+void ImGui::MemFree(void* ptr)
+{
+    if (!ptr)
+        return;
+    GImGui->IO.MetricsAllocs--;
+    GImGui->FrameFrees++;
+    GImGui->IO.MemFreeFn(MemTrackFree(ptr));
+}
+
+#else
+
+void* ImGui::MemAlloc(size_t sz)
+{
+    GImGui->IO.MetricsAllocs++;
+    GImGui->FrameAllocs++;
     return GImGui->IO.MemAllocFn(sz);
 }
 
+void* ImGui::MemAllocTransient(size_t sz)
+{
+    if (!GImGui->IO.MemAllocTransientFn)
+        return MemAlloc(sz);
+    GImGui->IO.MetricsAllocs++;
+    GImGui->FrameAllocs++;
+    return GImGui->IO.MemAllocTransientFn(sz);
+}
+
 void ImGui::MemFree(void* ptr)
 {
-    if (ptr) GImGui->IO.MetricsAllocs--;
+    if (ptr) { GImGui->IO.MetricsAllocs--; GImGui->FrameFrees++; }
     return GImGui->IO.MemFreeFn(ptr);
 }
 
+#endif // IMGUI_MEM_INSTRUMENTATION
+
+void ImGui::MemTrackExternal(const char* name, size_t bytes)
+{
+    ImGuiContext& g = *GImGui;
+    for (int i = 0; i < g.MemExternal.Size; i++)
+    {
+        ImGuiMemExternal& external = g.MemExternal[i];
+        if (strcmp(external.Name, name) == 0)
+        {
+            external.Bytes = bytes;
+            if (external.PeakBytes < bytes)
+                external.PeakBytes = bytes;
+            return;
+        }
+    }
+    ImGuiMemExternal external;
+    external.Name = name;
+    external.Bytes = external.PeakBytes = bytes;
+    g.MemExternal.push_back(external);
+}
+
+static const char* const GMemTagNames[ImGuiMemTag_COUNT] = { "Other", "Windows", "DrawLists", "Fonts", "Storage", "TextEdit", "Settings" };
+
+// Bytes reserved by the buffers of a draw list, which never shrink, and how many of them its last frame used
+static size_t GetDrawListMemory(const ImDrawList* draw_list, size_t* out_used_bytes)
+{
+    size_t reserved_bytes = (size_t)draw_list->CmdBuffer.Capacity * sizeof(ImDrawCmd) + (size_t)draw_list->IdxBuffer.Capacity * sizeof(ImDrawIdx) + (size_t)draw_list->VtxBuffer.Capacity * sizeof(ImDrawVert);
+    reserved_bytes += (size_t)draw_list->_ClipRectStack.Capacity * sizeof(ImVec4) + (size_t)draw_list->_TextureIdStack.Capacity * sizeof(ImTextureID) + (size_t)draw_list->_Path.Capacity * sizeof(ImVec2);
+    reserved_bytes += (size_t)draw_list->_Channels.Capacity * sizeof(ImDrawChannel);
+    for (int i = 1; i < draw_list->_Channels.Size; i++) // Channel 0 is a copy of CmdBuffer/IdxBuffer
+        reserved_bytes += (size_t)draw_list->_Channels[i].CmdBuffer.Capacity * sizeof(ImDrawCmd) + (size_t)draw_list->_Channels[i].IdxBuffer.Capacity * sizeof(ImDrawIdx);
+    *out_used_bytes = (size_t)draw_list->CmdBuffer.Size * sizeof(ImDrawCmd) + (size_t)draw_list->IdxBuffer.Size * sizeof(ImDrawIdx) + (size_t)draw_list->VtxBuffer.Size * sizeof(ImDrawVert);
+    return reserved_bytes;
+}
+
+// Largest draw lists first
+static int DrawListMemoryComparer(const void* lhs, const void* rhs)
+{
+    size_t a_used, b_used;
+    const size_t a = GetDrawListMemory((*(const ImGuiWindow**)lhs)->DrawList, &a_used);
+    const size_t b = GetDrawListMemory((*(const ImGuiWindow**)rhs)->DrawList, &b_used);
+    return (a < b) ? +1 : (a > b) ? -1 : 0;
+}
+
+static void WriteCsvString(FILE* f, const char* str)
+{
+    fputc('"', f);
+    for (const char* p = str; *p; p++)
+    {
+        if (*p == '"')
+            fputc('"', f);
+        fputc(*p, f);
+    }
+    fputc('"', f);
+}
+
+bool ImGui::SaveMemStatsToDisk(const char* filename)
+{
+    ImGuiContext& g = *GImGui;
+    FILE* f = ImFileOpen(filename, "wt");
+    if (!f)
+        return false;
+
+    fprintf(f, "section,name,bytes,peak_bytes,used_bytes,allocs,last_frame_allocs,last_frame_frees,last_frame_alloc_bytes\n");
+#ifdef IMGUI_MEM_INSTRUMENTATION
+    for (int i = 0; i < ImGuiMemTag_COUNT; i++)
+    {
+        const ImGuiMemTagStats& stats = g.MemTagStats[i];
+        fprintf(f, "tag,%s,%llu,%llu,,%d,%d,%d,%llu\n", GMemTagNames[i], (unsigned long long)stats.Bytes, (unsigned long long)stats.PeakBytes,
+            stats.Allocs, stats.LastFrameAllocs, stats.LastFrameFrees, (unsigned long long)stats.LastFrameAllocBytes);
+    }
+#endif
+    for (int i = 0; i < g.MemExternal.Size; i++)
+    {
+        const ImGuiMemExternal& external = g.MemExternal[i];
+        fprintf(f, "external,");
+        WriteCsvString(f, external.Name);
+        fprintf(f, ",%llu,%llu,,,,,\n", (unsigned long long)external.Bytes, (unsigned long long)external.PeakBytes);
+    }
+    for (int i = 0; i < g.Windows.Size; i++)
+    {
+        size_t used_bytes;
+        const size_t reserved_bytes = GetDrawListMemory(g.Windows[i]->DrawList, &used_bytes);
+        fprintf(f, "draw_list,");
+        WriteCsvString(f, g.Windows[i]->Name);
+        fprintf(f, ",%llu,,%llu,,,,\n", (unsigned long long)reserved_bytes, (unsigned long long)used_bytes);
+    }
+
+    fclose(f);
+    return true;
+}
+
 const char* ImGui::GetClipboardText()
 {
     return GImGui->IO.GetClipboardTextFn ? GImGui->IO.GetClipboardTextFn(GImGui->IO.ClipboardUserData) : "";
@@ -2149,6 +2510,18 @@ void ImGui::NewFrame()
 
     g.Time += g.IO.DeltaTime;
     g.FrameCount += 1;
+    g.IO.MetricsFrameAllocs = g.FrameAllocs;
+    g.IO.MetricsFrameFrees = g.FrameFrees;
+    g.FrameAllocs = g.FrameFrees = 0;
+    for (int i = 0; i < ImGuiMemTag_COUNT; i++)
+    {
+        ImGuiMemTagStats& stats = g.MemTagStats[i];
+        stats.LastFrameAllocs = stats.FrameAllocs;
+        stats.LastFrameFrees = stats.FrameFrees;
+        stats.LastFrameAllocBytes = stats.FrameAllocBytes;
+        stats.FrameAllocs = stats.FrameFrees = 0;
+        stats.FrameAllocBytes = 0;
+    }
     g.Tooltip[0] = '\0';
     g.OverlayDrawList.Clear();
     g.OverlayDrawList.PushTextureID(g.IO.Fonts->TexID);
@@ -2383,6 +2756,8 @@ void ImGui::Shutdown()
         ImGui::MemFree(g.Windows[i]);
     }
     g.Windows.clear();
+    g.WindowsById.Clear();
+    g.MemExternal.clear();
     g.WindowsSortBuffer.clear();
     g.CurrentWindow = NULL;
     g.CurrentWindowStack.clear();
@@ -2443,6 +2818,7 @@ static ImGuiIniData* FindWindowSettings(const char* name)
 
 static ImGuiIniData* AddWindowSettings(const char* name)
 {
+    ImGuiMemTagScope mem_tag(ImGuiMemTag_Settings);
     GImGui->Settings.resize(GImGui->Settings.Size + 1);
     ImGuiIniData* ini = &GImGui->Settings.back();
     ini->Name = ImStrdup(name);
@@ -2457,6 +2833,7 @@ static ImGuiIniData* AddWindowSettings(const char* name)
 // FIXME: Write something less rubbish
 static void LoadIniSettingsFromDisk(const char* ini_filename)
 {
+    ImGuiMemTagScope mem_tag(ImGuiMemTag_Settings);
     ImGuiContext& g = *GImGui;
     if (!ini_filename)
         return;
@@ -2724,6 +3101,7 @@ void ImGui::Render()
     {
         // Gather windows to render
         g.IO.MetricsRenderVertices = g.IO.MetricsRenderIndices = g.IO.MetricsActiveWindows = 0;
+        g.IO.MetricsRenderDrawCalls = g.IO.MetricsRenderStateChanges = 0;
         for (int i = 0; i < IM_ARRAYSIZE(g.RenderDrawLists); i++)
             g.RenderDrawLists[i].resize(0);
         for (int i = 0; i != g.Windows.Size; i++)
@@ -3758,17 +4136,15 @@ static ImVec2 FindBestPopupWindowPos(const ImVec2& base_pos, const ImVec2& size,
 
 ImGuiWindow* ImGui::FindWindowByName(const char* name)
 {
-    // FIXME-OPT: Store sorted hashes -> pointers so we can do a bissection in a contiguous block
+    // Windows are only ever added (by CreateNewWindow) and removed all at once (by Shutdown), so the index can't go stale
     ImGuiContext& g = *GImGui;
     ImGuiID id = ImHash(name, 0);
-    for (int i = 0; i < g.Windows.Size; i++)
-        if (g.Windows[i]->ID == id)
-            return g.Windows[i];
-    return NULL;
+    return (ImGuiWindow*)g.WindowsById.GetVoidPtr(id);
 }
 
 static ImGuiWindow* CreateNewWindow(const char* name, ImVec2 size, ImGuiWindowFlags flags)
 {
+    ImGuiMemTagScope mem_tag(ImGuiMemTag_Windows);
     ImGuiContext& g = *GImGui;
 
     // Create window the first time
@@ -3830,6 +4206,7 @@ static ImGuiWindow* CreateNewWindow(const char* name, ImVec2 size, ImGuiWindowFl
         g.Windows.insert(g.Windows.begin(), window); // Quite slow but rare and only once
     else
         g.Windows.push_back(window);
+    g.WindowsById.SetVoidPtr(window->ID, window);
     return window;
 }
 
@@ -3874,6 +4251,7 @@ bool ImGui::Begin(const char* name, bool* p_open, ImGuiWindowFlags flags)
 
 bool ImGui::Begin(const char* name, bool* p_open, const ImVec2& size_on_first_use, float bg_alpha, ImGuiWindowFlags flags)
 {
+    ImGuiMemTagScope mem_tag(ImGuiMemTag_Windows);
     ImGuiContext& g = *GImGui;
     const ImGuiStyle& style = g.Style;
     IM_ASSERT(name != NULL);                        // Window name required
@@ -7664,6 +8042,7 @@ static bool InputTextFilterCharacter(unsigned int* p_char, ImGuiInputTextFlags f
 // FIXME: Rather messy function partly because we are doing UTF8 > u16 > UTF8 conversions on the go to more easily handle stb_textedit calls. Ideally we should stay in UTF-8 all the time. See https://github.com/nothings/stb/issues/188
 bool ImGui::InputTextEx(const char* label, char* buf, int buf_size, const ImVec2& size_arg, ImGuiInputTextFlags flags, ImGuiTextEditCallback callback, void* user_data)
 {
+    ImGuiMemTagScope mem_tag(ImGuiMemTag_TextEdit);
     ImGuiWindow* window = GetCurrentWindow();
     if (window->SkipItems)
         return false;
@@ -7936,7 +8315,7 @@ bool ImGui::InputTextEx(const char* label, char* buf, int buf_size, const ImVec2
             {
                 // Filter pasted buffer
                 const int clipboard_len = (int)strlen(clipboard);
-                ImWchar* clipboard_filtered = (ImWchar*)ImGui::MemAlloc((clipboard_len+1) * sizeof(ImWchar));
+                ImWchar* clipboard_filtered = (ImWchar*)ImGui::MemAllocTransient((clipboard_len+1) * sizeof(ImWchar));
                 int clipboard_filtered_len = 0;
                 for (const char* s = clipboard; *s; )
                 {
@@ -9629,6 +10008,7 @@ void ImGui::ValueColor(const char* prefix, ImU32 v)
 
 static const char* GetClipboardTextFn_DefaultImpl(void*)
 {
+    ImGuiMemTagScope mem_tag(ImGuiMemTag_TextEdit);
     static ImVector<char> buf_local;
     buf_local.clear();
     if (!OpenClipboard(NULL))
@@ -9674,6 +10054,7 @@ static const char* GetClipboardTextFn_DefaultImpl(void*)
 // Local ImGui-only clipboard implementation, if user hasn't defined better clipboard handlers
 static void SetClipboardTextFn_DefaultImpl(void*, const char* text)
 {
+    ImGuiMemTagScope mem_tag(ImGuiMemTag_TextEdit);
     ImGuiContext& g = *GImGui;
     if (g.PrivateClipboard)
     {
@@ -9727,7 +10108,51 @@ void ImGui::ShowMetricsWindow(bool* p_open)
         ImGui::Text("ImGui %s", ImGui::GetVersion());
         ImGui::Text("Application average %.3f ms/frame (%.1f FPS)", 1000.0f / ImGui::GetIO().Framerate, ImGui::GetIO().Framerate);
         ImGui::Text("%d vertices, %d indices (%d triangles)", ImGui::GetIO().MetricsRenderVertices, ImGui::GetIO().MetricsRenderIndices, ImGui::GetIO().MetricsRenderIndices / 3);
-        ImGui::Text("%d allocations", ImGui::GetIO().MetricsAllocs);
+        ImGui::Text("%d draw calls, %d state changes", ImGui::GetIO().MetricsRenderDrawCalls, ImGui::GetIO().MetricsRenderStateChanges);
+        ImGui::Text("%d allocations, %d allocated and %d freed last frame", ImGui::GetIO().MetricsAllocs, ImGui::GetIO().MetricsFrameAllocs, ImGui::GetIO().MetricsFrameFrees);
+        if (ImGui::TreeNode("Memory"))
+        {
+            ImGuiContext& g = *GImGui;
+#ifdef IMGUI_MEM_INSTRUMENTATION
+            ImGui::Columns(5, "##memtags");
+            ImGui::Text("Tag"); ImGui::NextColumn();
+            ImGui::Text("KB"); ImGui::NextColumn();
+            ImGui::Text("Peak KB"); ImGui::NextColumn();
+            ImGui::Text("Allocations"); ImGui::NextColumn();
+            ImGui::Text("Last frame"); ImGui::NextColumn();
+            ImGui::Separator();
+            for (int i = 0; i < ImGuiMemTag_COUNT; i++)
+            {
+                const ImGuiMemTagStats& stats = g.MemTagStats[i];
+                ImGui::Text("%s", GMemTagNames[i]); ImGui::NextColumn();
+                ImGui::Text("%.1f", stats.Bytes / 1024.0f); ImGui::NextColumn();
+                ImGui::Text("%.1f", stats.PeakBytes / 1024.0f); ImGui::NextColumn();
+                ImGui::Text("%d", stats.Allocs); ImGui::NextColumn();
+                ImGui::Text("+%d -%d (%.1f KB)", stats.LastFrameAllocs, stats.LastFrameFrees, stats.LastFrameAllocBytes / 1024.0f); ImGui::NextColumn();
+            }
+            ImGui::Columns(1);
+            ImGui::Separator();
+#endif
+            for (int i = 0; i < g.MemExternal.Size; i++)
+                ImGui::BulletText("%s: %.1f KB (peak %.1f KB)", g.MemExternal[i].Name, g.MemExternal[i].Bytes / 1024.0f, g.MemExternal[i].PeakBytes / 1024.0f);
+            if (ImGui::TreeNode("Draw lists", "Draw list buffers of %d windows, largest first", g.Windows.Size))
+            {
+                ImVector<ImGuiWindow*> windows;
+                windows.resize(g.Windows.Size);
+                memcpy(windows.Data, g.Windows.Data, (size_t)g.Windows.Size * sizeof(ImGuiWindow*));
+                qsort(windows.Data, (size_t)windows.Size, sizeof(ImGuiWindow*), DrawListMemoryComparer);
+                for (int i = 0; i < windows.Size; i++)
+                {
+                    size_t used_bytes;
+                    const size_t reserved_bytes = GetDrawListMemory(windows[i]->DrawList, &used_bytes);
+                    ImGui::BulletText("'%s': %.1f KB reserved, %.1f KB used", windows[i]->Name, reserved_bytes / 1024.0f, used_bytes / 1024.0f);
+                }
+                ImGui::TreePop();
+            }
+            if (ImGui::Button("Save to imgui_memory.csv"))
+                SaveMemStatsToDisk("imgui_memory.csv");
+            ImGui::TreePop();
+        }
         static bool show_clip_rects = true;
         ImGui::Checkbox("Show clipping rectangles when hovering a ImDrawCmd", &show_clip_rects);
         ImGui::Separator();
@@ -9811,7 +10236,11 @@ void ImGui::ShowMetricsWindow(bool* p_open)
                 ImGui::BulletText("Scroll: (%.2f,%.2f)", window->Scroll.x, window->Scroll.y);
                 if (window->RootWindow != window) NodeWindow(window->RootWindow, "RootWindow");
                 if (window->DC.ChildWindows.Size > 0) NodeWindows(window->DC.ChildWindows, "ChildWindows");
+#ifdef IMGUI_STORAGE_OPEN_ADDRESSING
+                ImGui::BulletText("Storage: %d bytes", window->StateStorage.Data.Size * (int)sizeof(ImGuiStorage::Pair) + window->StateStorage.Slots.Size * (int)sizeof(ImGuiStorage::Slot));
+#else
                 ImGui::BulletText("Storage: %d bytes", window->StateStorage.Data.Size * (int)sizeof(ImGuiStorage::Pair));
+#endif
                 ImGui::TreePop();
             }
         };
@@ -450,7 +450,10 @@ namespace ImGui
 
     // Helpers functions to access functions pointers in ImGui::GetIO()
     IMGUI_API void*         MemAlloc(size_t sz);
+    IMGUI_API void*         MemAllocTransient(size_t sz);                                       // for buffers freed (with MemFree) before the next NewFrame()
     IMGUI_API void          MemFree(void* ptr);
+    IMGUI_API void          MemTrackExternal(const char* name, size_t bytes);                  // report memory ImGui doesn't allocate (e.g. GPU buffers), to show along its own in ShowMetricsWindow(). 'name' must stay valid
+    IMGUI_API bool          SaveMemStatsToDisk(const char* filename);                           // write the memory shown in ShowMetricsWindow() as CSV
     IMGUI_API const char*   GetClipboardText();
     IMGUI_API void          SetClipboardText(const char* text);
 
@@ -766,6 +769,7 @@ struct ImGuiIO
     // (default to posix malloc/free)
     void*       (*MemAllocFn)(size_t sz);
     void        (*MemFreeFn)(void* ptr);
+    void*       (*MemAllocTransientFn)(size_t sz);  // Optional: for buffers freed before the next NewFrame() (e.g. from a frame arena), still freed with MemFreeFn(). NULL to use MemAllocFn
 
     // Optional: notify OS Input Method Editor of the screen position of your cursor for text input position (e.g. when using Japanese/Chinese IME in Windows)
     // (default to use native imm32 api on Windows)
@@ -801,8 +805,12 @@ struct ImGuiIO
     bool        WantTextInput;              // Some text input widget is active, which will read input characters from the InputCharacters array. Use to activate on screen keyboard if your system needs one
     float       Framerate;                  // Application framerate estimation, in frame per second. Solely for convenience. Rolling average estimation based on IO.DeltaTime over 120 frames
     int         MetricsAllocs;              // Number of active memory allocations
+    int         MetricsFrameAllocs;         // Memory allocations between the last two calls to NewFrame()
+    int         MetricsFrameFrees;          // Memory frees between the last two calls to NewFrame()
     int         MetricsRenderVertices;      // Vertices output during last call to Render()
     int         MetricsRenderIndices;       // Indices output during last call to Render() = number of triangles * 3
+    int         MetricsRenderDrawCalls;     // Draw calls issued by your RenderDrawListsFn during last call to Render(). Set by the renderer, if it counts them
+    int         MetricsRenderStateChanges;  // Texture/scissor/buffer state changes issued by your RenderDrawListsFn during last call to Render(). Set by the renderer, if it counts them
     int         MetricsActiveWindows;       // Number of visible root windows (exclude child windows)
     ImVec2      MouseDelta;                 // Mouse delta. Note that this is zero if either current or previous position are negative, so a disappearing/reappearing mouse won't have a huge delta for one frame.
 
@@ -971,10 +979,22 @@ struct ImGuiStorage
     };
     ImVector<Pair>      Data;
 
-    // - Get***() functions find pair, never add/allocate. Pairs are sorted so a query is O(log N)
+#ifdef IMGUI_STORAGE_OPEN_ADDRESSING
+    // Hash table indexing Data, with linear probing. Data is then in insertion order (minus removals), not sorted.
+    struct Slot
+    {
+        ImGuiID key;
+        int     index;      // Into Data, -1 if the slot is empty
+    };
+    ImVector<Slot>      Slots;      // Power of 2 size, never more than 3/4 full
+#endif
+
+    // - Get***() functions find pair, never add/allocate. Pairs are sorted so a query is O(log N), or hashed with IMGUI_STORAGE_OPEN_ADDRESSING so it is O(1)
     // - Set***() functions find pair, insertion on demand if missing.
-    // - Sorted insertion is costly, paid once. A typical frame shouldn't need to insert any new pair.
+    // - Sorted insertion is costly (O(N), it moves every following pair), paid once. A typical frame shouldn't need to insert any new pair.
+    // - Iterating Data visits every pair once in either case, but only in key order without IMGUI_STORAGE_OPEN_ADDRESSING.
     IMGUI_API void      Clear();
+    IMGUI_API void      Remove(ImGuiID key);
     IMGUI_API int       GetInt(ImGuiID key, int default_val = 0) const;
     IMGUI_API void      SetInt(ImGuiID key, int val);
     IMGUI_API bool      GetBool(ImGuiID key, bool default_val = false) const;
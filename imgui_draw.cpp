@@ -164,6 +164,7 @@ void ImDrawList::ClearFreeMemory()
 
 void ImDrawList::AddDrawCmd()
 {
+    ImGuiMemTagScope mem_tag(ImGuiMemTag_DrawLists);
     ImDrawCmd draw_cmd;
     draw_cmd.ClipRect = GetCurrentClipRect();
     draw_cmd.TextureId = GetCurrentTextureId();
@@ -276,6 +277,7 @@ void ImDrawList::PopTextureID()
 
 void ImDrawList::ChannelsSplit(int channels_count)
 {
+    ImGuiMemTagScope mem_tag(ImGuiMemTag_DrawLists);
     IM_ASSERT(_ChannelsCurrent == 0 && _ChannelsCount == 1);
     int old_channels_count = _Channels.Size;
     if (old_channels_count < channels_count)
@@ -309,6 +311,7 @@ void ImDrawList::ChannelsSplit(int channels_count)
 
 void ImDrawList::ChannelsMerge()
 {
+    ImGuiMemTagScope mem_tag(ImGuiMemTag_DrawLists);
     // Note that we never use or rely on channels.Size because it is merely a buffer that we never shrink back to 0 to keep all sub-buffers ready for use.
     if (_ChannelsCount <= 1)
         return;
@@ -356,6 +359,7 @@ void ImDrawList::ChannelsSetCurrent(int idx)
 // NB: this can be called with negative count for removing primitives (as long as the result does not underflow)
 void ImDrawList::PrimReserve(int idx_count, int vtx_count)
 {
+    ImGuiMemTagScope mem_tag(ImGuiMemTag_DrawLists);
     ImDrawCmd& draw_cmd = CmdBuffer.Data[CmdBuffer.Size-1];
     draw_cmd.ElemCount += idx_count;
 
@@ -1096,6 +1100,7 @@ void    ImFontAtlas::Clear()
 
 void    ImFontAtlas::GetTexDataAsAlpha8(unsigned char** out_pixels, int* out_width, int* out_height, int* out_bytes_per_pixel)
 {
+    ImGuiMemTagScope mem_tag(ImGuiMemTag_Fonts);
     // Build atlas on demand
     if (TexPixelsAlpha8 == NULL)
     {
@@ -1112,6 +1117,7 @@ void    ImFontAtlas::GetTexDataAsAlpha8(unsigned char** out_pixels, int* out_wid
 
 void    ImFontAtlas::GetTexDataAsRGBA32(unsigned char** out_pixels, int* out_width, int* out_height, int* out_bytes_per_pixel)
 {
+    ImGuiMemTagScope mem_tag(ImGuiMemTag_Fonts);
     // Convert to RGBA32 format on demand
     // Although it is likely to be the most commonly used format, our font rendering is 1 channel / 8 bpp
     if (!TexPixelsRGBA32)
@@ -1133,6 +1139,7 @@ void    ImFontAtlas::GetTexDataAsRGBA32(unsigned char** out_pixels, int* out_wid
 
 ImFont* ImFontAtlas::AddFont(const ImFontConfig* font_cfg)
 {
+    ImGuiMemTagScope mem_tag(ImGuiMemTag_Fonts);
     IM_ASSERT(font_cfg->FontData != NULL && font_cfg->FontDataSize > 0);
     IM_ASSERT(font_cfg->SizePixels > 0.0f);
 
@@ -1198,6 +1205,7 @@ ImFont* ImFontAtlas::AddFontDefault(const ImFontConfig* font_cfg_template)
 
 ImFont* ImFontAtlas::AddFontFromFileTTF(const char* filename, float size_pixels, const ImFontConfig* font_cfg_template, const ImWchar* glyph_ranges)
 {
+    ImGuiMemTagScope mem_tag(ImGuiMemTag_Fonts);
     int data_size = 0;
     void* data = ImFileLoadToMemory(filename, "rb", &data_size, 0);
     if (!data)
@@ -1231,6 +1239,7 @@ ImFont* ImFontAtlas::AddFontFromMemoryTTF(void* ttf_data, int ttf_size, float si
 
 ImFont* ImFontAtlas::AddFontFromMemoryCompressedTTF(const void* compressed_ttf_data, int compressed_ttf_size, float size_pixels, const ImFontConfig* font_cfg_template, const ImWchar* glyph_ranges)
 {
+    ImGuiMemTagScope mem_tag(ImGuiMemTag_Fonts);
     const unsigned int buf_decompressed_size = stb_decompress_length((unsigned char*)compressed_ttf_data);
     unsigned char* buf_decompressed_data = (unsigned char *)ImGui::MemAlloc(buf_decompressed_size);
     stb_decompress(buf_decompressed_data, (unsigned char*)compressed_ttf_data, (unsigned int)compressed_ttf_size);
@@ -1243,6 +1252,7 @@ ImFont* ImFontAtlas::AddFontFromMemoryCompressedTTF(const void* compressed_ttf_d
 
 ImFont* ImFontAtlas::AddFontFromMemoryCompressedBase85TTF(const char* compressed_ttf_data_base85, float size_pixels, const ImFontConfig* font_cfg, const ImWchar* glyph_ranges)
 {
+    ImGuiMemTagScope mem_tag(ImGuiMemTag_Fonts);
     int compressed_ttf_size = (((int)strlen(compressed_ttf_data_base85) + 4) / 5) * 4;
     void* compressed_ttf = ImGui::MemAlloc((size_t)compressed_ttf_size);
     Decode85((const unsigned char*)compressed_ttf_data_base85, (unsigned char*)compressed_ttf);
@@ -1253,6 +1263,7 @@ ImFont* ImFontAtlas::AddFontFromMemoryCompressedBase85TTF(const char* compressed
 
 bool    ImFontAtlas::Build()
 {
+    ImGuiMemTagScope mem_tag(ImGuiMemTag_Fonts);
     IM_ASSERT(ConfigData.Size > 0);
 
     TexID = NULL;
@@ -9,23 +9,339 @@
 #include <windowsx.h>
 
 #include "imgui.h"
+#include "imgui_internal.h"
 #include "imgui_impl.h"
 
 #include "opengl.h"
+#include "clock.h"
+#include "spsc_queue.h"
+#include "gl_stream_ring.h"
+#include "shader_cache.h"
+
+#include <atomic>
+#include <cstring>
+
+// Window messages posted by the window thread, for the render thread to feed to ImGui in ImGui_Impl_NewFrame.
+#define IMGUI_IMPL_EVENT_QUEUE_SIZE 4096
+
+// Initial size of the vertices and indices of one frame. The stream ring grows if a frame needs more.
+#define IMGUI_IMPL_STREAM_RING_SIZE (256 * 1024)
+
+struct ImGui_Impl_Event
+{
+    uint64_t TimestampNs;
+    UINT     Msg;
+    WPARAM   wParam;
+    LPARAM   lParam;
+};
+
+// Same layout as the commands read by glMultiDrawElementsIndirect
+struct ImGui_Impl_DrawCommand
+{
+    GLuint   Count;
+    GLuint   InstanceCount;
+    GLuint   FirstIndex;
+    GLint    BaseVertex;
+    GLuint   BaseInstance;
+};
+
+// Consecutive draw commands that use the same texture and clip rectangle, or a user callback
+struct ImGui_Impl_DrawBatch
+{
+    const ImDrawList* CmdList;
+    const ImDrawCmd*  Cmd;          // First ImDrawCmd of the batch, for its texture and clip rectangle, or its callback
+    int               FirstCommand;
+    int               CommandCount;
+};
 
 // Data
-static double       g_Time = 0.0f;
-static bool         g_MousePressed[3] = { false, false, false };
-static float        g_MouseWheel = 0.0f;
+static uint64_t     g_Time = 0;
+static SpscQueue<ImGui_Impl_Event, IMGUI_IMPL_EVENT_QUEUE_SIZE> g_EventQueue;
+static std::atomic<uint32_t> g_DroppedEvents;
+static bool         g_TrackingMouseLeave = false;   // Window thread only
+static int          g_CapturedMouseButtons = 0;     // Window thread only: a bit per button pressed in the window and not released yet
 static GLuint       g_FontTexture = 0;
-static int          g_ShaderHandle = 0, g_VertHandle = 0, g_FragHandle = 0;
+static int          g_ShaderHandle = 0;
 static int          g_AttribLocationTex = 0, g_AttribLocationProjMtx = 0;
 static int          g_AttribLocationPosition = 0, g_AttribLocationUV = 0, g_AttribLocationColor = 0;
-static unsigned int g_VboHandle = 0, g_VaoHandle = 0, g_ElementsHandle = 0;
+static unsigned int g_VaoHandle = 0;
+static GLStreamRing g_StreamRing;
+static bool         g_SingleSubmission = true;
+static ImVector<ImGui_Impl_DrawCommand> g_DrawCommands;
+static ImVector<ImGui_Impl_DrawBatch> g_DrawBatches;
+static int          g_DrawCalls = 0, g_StateChanges = 0;
+static bool         g_LayerCache = false;
+static GLuint       g_LayerFramebuffer = 0, g_LayerTexture = 0;
+static int          g_LayerWidth = 0, g_LayerHeight = 0;
+static bool         g_LayerValid = false;
+static ImU32        g_LayerHash = 0;                // Hash of the frame drawn into the layer
+static ImVector<ImU32> g_ListHashes;                // Hash of each list of the last frame, to count the ones that changed
+static ImGui_Impl_LayerStats g_LayerStats;
+
+// The clip rect is (x1, y1, x2, y2) from the top left, and the scissor box is (x, y, width, height) from the bottom left.
+// SoftRenderer::Render converts clip rects the same way, so both draw the same pixels.
+static void ImGui_Impl_SetScissor(const ImVec4& clip_rect)
+{
+    ImGuiIO& io = ImGui::GetIO();
+    glScissor(
+        (int)(clip_rect.x),
+        (int)(io.DisplaySize.y * io.DisplayFramebufferScale.y - clip_rect.w),
+        (int)(clip_rect.z - clip_rect.x),
+        (int)(clip_rect.w - clip_rect.y));
+}
+
+// One vertex buffer binding and one glDraw* call per ImDrawCmd, plus the texture, sampler and scissor of each command.
+static void ImGui_Impl_SubmitPerList(ImDrawData* draw_data, GLintptr vtx_offset, GLintptr idx_offset)
+{
+    for (int n = 0; n < draw_data->CmdListsCount; n++)
+    {
+        const ImDrawList* cmd_list = draw_data->CmdLists[n];
+        const ImDrawIdx* idx_buffer_offset = (const ImDrawIdx*)idx_offset;
+
+        glBindVertexBuffer(0, g_StreamRing.Buffer(), vtx_offset, sizeof(ImDrawVert));
+        g_StateChanges++;
+        vtx_offset += (GLintptr)cmd_list->VtxBuffer.Size * sizeof(ImDrawVert);
+        idx_offset += (GLintptr)cmd_list->IdxBuffer.Size * sizeof(ImDrawIdx);
+
+        for (int cmd_i = 0; cmd_i < cmd_list->CmdBuffer.Size; cmd_i++)
+        {
+            const ImDrawCmd* pcmd = &cmd_list->CmdBuffer[cmd_i];
+            if (pcmd->UserCallback)
+            {
+                pcmd->UserCallback(cmd_list, pcmd);
+            }
+            else
+            {
+                glBindTexture(GL_TEXTURE_2D, (GLuint)(intptr_t)pcmd->TextureId);
+                glBindSampler(0, 0); // rely on combined texture/sampler state.
+                ImGui_Impl_SetScissor(pcmd->ClipRect);
+                glDrawElements(GL_TRIANGLES, (GLsizei)pcmd->ElemCount, sizeof(ImDrawIdx) == 2 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT, idx_buffer_offset);
+                g_StateChanges += 3;
+                g_DrawCalls++;
+            }
+            idx_buffer_offset += pcmd->ElemCount;
+        }
+    }
+}
+
+// Builds the draw commands of the whole frame on the CPU, as if all the lists were one:
+// each command offsets its indices with BaseVertex instead of rebinding the vertex buffer.
+// Commands are batched while the texture and clip rectangle stay the same, and contiguous ones are merged.
+static void ImGui_Impl_BuildBatches(ImDrawData* draw_data, GLintptr idx_offset)
+{
+    g_DrawCommands.resize(0);
+    g_DrawBatches.resize(0);
+
+    GLuint first_index = (GLuint)(idx_offset / sizeof(ImDrawIdx));
+    GLint base_vertex = 0;
+    for (int n = 0; n < draw_data->CmdListsCount; n++)
+    {
+        const ImDrawList* cmd_list = draw_data->CmdLists[n];
+        for (int cmd_i = 0; cmd_i < cmd_list->CmdBuffer.Size; cmd_i++)
+        {
+            const ImDrawCmd* pcmd = &cmd_list->CmdBuffer[cmd_i];
+            ImGui_Impl_DrawBatch* batch = g_DrawBatches.empty() ? NULL : &g_DrawBatches.back();
+            ImGui_Impl_DrawCommand command = { pcmd->ElemCount, 1, first_index, base_vertex, 0 };
+            first_index += pcmd->ElemCount;
+
+            if (pcmd->UserCallback)
+            {
+                ImGui_Impl_DrawBatch callback = { cmd_list, pcmd, g_DrawCommands.Size, 0 };
+                g_DrawBatches.push_back(callback);
+            }
+            else if (batch && !batch->Cmd->UserCallback && batch->Cmd->TextureId == pcmd->TextureId && memcmp(&batch->Cmd->ClipRect, &pcmd->ClipRect, sizeof(ImVec4)) == 0)
+            {
+                ImGui_Impl_DrawCommand& last = g_DrawCommands.back();
+                if (last.BaseVertex == command.BaseVertex && last.FirstIndex + last.Count == command.FirstIndex)
+                {
+                    last.Count += command.Count;
+                }
+                else
+                {
+                    g_DrawCommands.push_back(command);
+                    batch->CommandCount++;
+                }
+            }
+            else
+            {
+                ImGui_Impl_DrawBatch draw = { cmd_list, pcmd, g_DrawCommands.Size, 1 };
+                g_DrawBatches.push_back(draw);
+                g_DrawCommands.push_back(command);
+            }
+        }
+        base_vertex += cmd_list->VtxBuffer.Size;
+    }
+}
+
+// One vertex buffer binding for the frame, and one glDraw* call per batch. Texture and scissor are only set when they change,
+// and the sampler is reset at the start and after each callback.
+static void ImGui_Impl_SubmitBatches(GLintptr vtx_offset, GLintptr indirect_offset)
+{
+    const GLenum idx_type = sizeof(ImDrawIdx) == 2 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+
+    glBindVertexBuffer(0, g_StreamRing.Buffer(), vtx_offset, sizeof(ImDrawVert));
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, g_StreamRing.Buffer());
+    g_StateChanges += 2;
+
+    const ImDrawCmd* state = NULL; // Command whose texture and clip rectangle are currently set
+    for (int batch_i = 0; batch_i < g_DrawBatches.Size; batch_i++)
+    {
+        const ImGui_Impl_DrawBatch& batch = g_DrawBatches[batch_i];
+        if (batch.Cmd->UserCallback)
+        {
+            batch.Cmd->UserCallback(batch.CmdList, batch.Cmd);
+            state = NULL;
+            continue;
+        }
+
+        if (!state)
+        {
+            glBindSampler(0, 0); // rely on combined texture/sampler state, even if a callback bound a sampler.
+            g_StateChanges++;
+        }
+        if (!state || state->TextureId != batch.Cmd->TextureId)
+        {
+            glBindTexture(GL_TEXTURE_2D, (GLuint)(intptr_t)batch.Cmd->TextureId);
+            g_StateChanges++;
+        }
+        if (!state || memcmp(&state->ClipRect, &batch.Cmd->ClipRect, sizeof(ImVec4)) != 0)
+        {
+            ImGui_Impl_SetScissor(batch.Cmd->ClipRect);
+            g_StateChanges++;
+        }
+        state = batch.Cmd;
+
+        if (batch.CommandCount == 1)
+        {
+            const ImGui_Impl_DrawCommand& command = g_DrawCommands[batch.FirstCommand];
+            glDrawElementsBaseVertex(GL_TRIANGLES, (GLsizei)command.Count, idx_type, (const GLvoid*)((intptr_t)command.FirstIndex * sizeof(ImDrawIdx)), command.BaseVertex);
+        }
+        else
+        {
+            glMultiDrawElementsIndirect(GL_TRIANGLES, idx_type, (const GLvoid*)(indirect_offset + batch.FirstCommand * sizeof(ImGui_Impl_DrawCommand)), batch.CommandCount, 0);
+        }
+        g_DrawCalls++;
+    }
+}
+
+// Hash of everything that affects how a list draws. ImDrawCmd is hashed a field at a time, since it has padding.
+static ImU32 ImGui_Impl_HashDrawList(const ImDrawList* cmd_list)
+{
+    ImU32 hash = 0;
+    if (cmd_list->VtxBuffer.Size > 0)
+        hash = ImHash(cmd_list->VtxBuffer.Data, cmd_list->VtxBuffer.Size * (int)sizeof(ImDrawVert), hash);
+    if (cmd_list->IdxBuffer.Size > 0)
+        hash = ImHash(cmd_list->IdxBuffer.Data, cmd_list->IdxBuffer.Size * (int)sizeof(ImDrawIdx), hash);
+    for (const ImDrawCmd* pcmd = cmd_list->CmdBuffer.begin(); pcmd != cmd_list->CmdBuffer.end(); pcmd++)
+    {
+        hash = ImHash(&pcmd->ElemCount, sizeof(pcmd->ElemCount), hash);
+        hash = ImHash(&pcmd->ClipRect, sizeof(pcmd->ClipRect), hash);
+        hash = ImHash(&pcmd->TextureId, sizeof(pcmd->TextureId), hash);
+    }
+    return hash;
+}
+
+// Hashes the lists of the frame, and counts the ones that changed since the last frame.
+// Returns false if the frame can't be cached because a list has a user callback.
+static bool ImGui_Impl_HashFrame(ImDrawData* draw_data, ImU32* frame_hash)
+{
+    ImGuiIO& io = ImGui::GetIO();
+    ImU32 hash = ImHash(&io.DisplaySize, sizeof(io.DisplaySize), 0);
+    hash = ImHash(&io.DisplayFramebufferScale, sizeof(io.DisplayFramebufferScale), hash);
+
+    int last_count = g_ListHashes.Size;
+    g_ListHashes.resize(draw_data->CmdListsCount);
+    g_LayerStats.Lists = draw_data->CmdListsCount;
+    g_LayerStats.ListsChanged = 0;
+
+    bool cacheable = true;
+    for (int n = 0; n < draw_data->CmdListsCount; n++)
+    {
+        const ImDrawList* cmd_list = draw_data->CmdLists[n];
+        for (const ImDrawCmd* pcmd = cmd_list->CmdBuffer.begin(); pcmd != cmd_list->CmdBuffer.end(); pcmd++)
+        {
+            if (pcmd->UserCallback)
+                cacheable = false;
+        }
+
+        ImU32 list_hash = ImGui_Impl_HashDrawList(cmd_list);
+        if (n >= last_count || g_ListHashes[n] != list_hash)
+            g_LayerStats.ListsChanged++;
+        g_ListHashes[n] = list_hash;
+        hash = ImHash(&list_hash, sizeof(list_hash), hash);
+    }
+
+    *frame_hash = hash;
+    return cacheable;
+}
+
+// Redirects the draws into the layer, cleared to transparent. Alpha is accumulated with ONE, ONE_MINUS_SRC_ALPHA,
+// so the layer ends up with premultiplied colors that composite the same as drawing the lists directly.
+static void ImGui_Impl_BeginLayer(int width, int height)
+{
+    if (!g_LayerFramebuffer)
+    {
+        glGenFramebuffers(1, &g_LayerFramebuffer);
+        glGenTextures(1, &g_LayerTexture);
+    }
+
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, g_LayerFramebuffer);
+
+    if (width != g_LayerWidth || height != g_LayerHeight)
+    {
+        glBindTexture(GL_TEXTURE_2D, g_LayerTexture);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+        glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, g_LayerTexture, 0);
+        g_LayerWidth = width;
+        g_LayerHeight = height;
+        g_StateChanges++;
+    }
+
+    const GLfloat transparent[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+    glDisable(GL_SCISSOR_TEST);
+    glClearBufferfv(GL_COLOR, 0, transparent);
+    glEnable(GL_SCISSOR_TEST);
+    glBlendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+    g_StateChanges += 2;
+}
+
+// Size of the composite quad's vertices and indices in the stream ring
+#define IMGUI_IMPL_QUAD_SIZE (GLStreamRing::Align(4 * sizeof(ImDrawVert)) + GLStreamRing::Align(6 * sizeof(ImDrawIdx)))
+
+// Draws the layer over 'framebuffer' with a quad streamed at 'offset' in the ring ('stream' in its mapping).
+static void ImGui_Impl_CompositeLayer(GLuint framebuffer, unsigned char* stream, GLintptr offset)
+{
+    ImGuiIO& io = ImGui::GetIO();
+    const float w = io.DisplaySize.x, h = io.DisplaySize.y;
+
+    // Texture rows go bottom-up
+    ImDrawVert* vtx = (ImDrawVert*)stream;
+    vtx[0].pos = ImVec2(0, 0); vtx[0].uv = ImVec2(0, 1); vtx[0].col = IM_COL32_WHITE;
+    vtx[1].pos = ImVec2(w, 0); vtx[1].uv = ImVec2(1, 1); vtx[1].col = IM_COL32_WHITE;
+    vtx[2].pos = ImVec2(w, h); vtx[2].uv = ImVec2(1, 0); vtx[2].col = IM_COL32_WHITE;
+    vtx[3].pos = ImVec2(0, h); vtx[3].uv = ImVec2(0, 0); vtx[3].col = IM_COL32_WHITE;
+
+    GLsizeiptr vtx_size = GLStreamRing::Align(4 * sizeof(ImDrawVert));
+    ImDrawIdx* idx = (ImDrawIdx*)(stream + vtx_size);
+    idx[0] = 0; idx[1] = 1; idx[2] = 2;
+    idx[3] = 0; idx[4] = 2; idx[5] = 3;
+
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, framebuffer);
+    glDisable(GL_SCISSOR_TEST);
+    glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+    glBindTexture(GL_TEXTURE_2D, g_LayerTexture);
+    glBindVertexBuffer(0, g_StreamRing.Buffer(), offset, sizeof(ImDrawVert));
+    glDrawElements(GL_TRIANGLES, 6, sizeof(ImDrawIdx) == 2 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT, (const GLvoid*)(offset + vtx_size));
+    g_StateChanges += 5;
+    g_DrawCalls++;
+}
 
 // This is the main rendering function that you have to implement and provide to ImGui (via setting up 'RenderDrawListsFn' in the ImGuiIO structure)
 // If text or lines are blurry when integrating ImGui in your engine:
 // - in your Render function, try translating your projection matrix by (0.5f,0.5f) or (0.375f,0.375f)
+// A NULL draw_data composites the layer of the last frame again (see ImGui_Impl_RenderCachedLayer).
 void ImGui_Impl_RenderDrawLists(ImDrawData* draw_data)
 {
     // Avoid rendering when minimized, scale coordinates for retina displays (screen coordinates != framebuffer coordinates)
@@ -34,7 +350,8 @@ void ImGui_Impl_RenderDrawLists(ImDrawData* draw_data)
     int fb_height = (int)(io.DisplaySize.y);
     if (fb_width == 0 || fb_height == 0)
         return;
-    draw_data->ScaleClipRects(io.DisplayFramebufferScale);
+    if (draw_data)
+        draw_data->ScaleClipRects(io.DisplayFramebufferScale);
 
     // Backup GL state
     GLint last_active_texture; glGetIntegerv(GL_ACTIVE_TEXTURE, &last_active_texture);
@@ -45,6 +362,8 @@ void ImGui_Impl_RenderDrawLists(ImDrawData* draw_data)
     GLint last_array_buffer; glGetIntegerv(GL_ARRAY_BUFFER_BINDING, &last_array_buffer);
     GLint last_element_array_buffer; glGetIntegerv(GL_ELEMENT_ARRAY_BUFFER_BINDING, &last_element_array_buffer);
     GLint last_vertex_array; glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &last_vertex_array);
+    GLint last_draw_indirect_buffer; glGetIntegerv(GL_DRAW_INDIRECT_BUFFER_BINDING, &last_draw_indirect_buffer);
+    GLint last_draw_framebuffer; glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &last_draw_framebuffer);
     GLint last_blend_src_rgb; glGetIntegerv(GL_BLEND_SRC_RGB, &last_blend_src_rgb);
     GLint last_blend_dst_rgb; glGetIntegerv(GL_BLEND_DST_RGB, &last_blend_dst_rgb);
     GLint last_blend_src_alpha; glGetIntegerv(GL_BLEND_SRC_ALPHA, &last_blend_src_alpha);
@@ -81,39 +400,82 @@ void ImGui_Impl_RenderDrawLists(ImDrawData* draw_data)
     glUniformMatrix4fv(g_AttribLocationProjMtx, 1, GL_FALSE, &ortho_projection[0][0]);
     glBindVertexArray(g_VaoHandle);
 
-    for (int n = 0; n < draw_data->CmdListsCount; n++)
+    g_DrawCalls = g_StateChanges = 0;
+
+    // Skip the upload and the draws if the frame looks the same as the one in the layer
+    int layer_width = (int)(io.DisplaySize.x * io.DisplayFramebufferScale.x);
+    int layer_height = (int)(io.DisplaySize.y * io.DisplayFramebufferScale.y);
+    ImU32 frame_hash = 0;
+    bool use_layer = !draw_data || (g_LayerCache && ImGui_Impl_HashFrame(draw_data, &frame_hash));
+    bool reuse_layer = !draw_data || (use_layer && g_LayerValid && g_LayerHash == frame_hash && g_LayerWidth == layer_width && g_LayerHeight == layer_height);
+
+    // Copy the vertices of all the lists, then the indices of all the lists, into this frame's region of the stream ring
+    // (followed by the draw commands in single-submission mode, and the composite quad when using the layer)
+    GLsizeiptr vtx_size = 0, idx_size = 0, cmd_size = 0;
+    if (!reuse_layer)
     {
-        const ImDrawList* cmd_list = draw_data->CmdLists[n];
-        const ImDrawIdx* idx_buffer_offset = 0;
+        vtx_size = GLStreamRing::Align((GLsizeiptr)draw_data->TotalVtxCount * sizeof(ImDrawVert));
+        idx_size = GLStreamRing::Align((GLsizeiptr)draw_data->TotalIdxCount * sizeof(ImDrawIdx));
+        if (g_SingleSubmission)
+        {
+            for (int n = 0; n < draw_data->CmdListsCount; n++)
+                cmd_size += (GLsizeiptr)draw_data->CmdLists[n]->CmdBuffer.Size * sizeof(ImGui_Impl_DrawCommand);
+        }
+    }
+    GLsizeiptr quad_size = use_layer ? IMGUI_IMPL_QUAD_SIZE : 0;
+
+    unsigned char* stream = g_StreamRing.BeginFrame(vtx_size + idx_size + GLStreamRing::Align(cmd_size) + quad_size);
+    GLintptr vtx_offset = g_StreamRing.RegionOffset();
+    GLintptr idx_offset = vtx_offset + vtx_size;
+    GLintptr cmd_offset = idx_offset + idx_size;
+    GLintptr quad_offset = cmd_offset + GLStreamRing::Align(cmd_size);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, g_StreamRing.Buffer());
 
-        glBindBuffer(GL_ARRAY_BUFFER, g_VboHandle);
-        glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)cmd_list->VtxBuffer.Size * sizeof(ImDrawVert), (const GLvoid*)cmd_list->VtxBuffer.Data, GL_STREAM_DRAW);
+    if (reuse_layer)
+    {
+        g_LayerStats.FramesReused++;
+    }
+    else
+    {
+        ImDrawVert* vtx_dst = (ImDrawVert*)stream;
+        ImDrawIdx* idx_dst = (ImDrawIdx*)(stream + vtx_size);
+        for (int n = 0; n < draw_data->CmdListsCount; n++)
+        {
+            const ImDrawList* cmd_list = draw_data->CmdLists[n];
+            memcpy(vtx_dst, cmd_list->VtxBuffer.Data, cmd_list->VtxBuffer.Size * sizeof(ImDrawVert));
+            memcpy(idx_dst, cmd_list->IdxBuffer.Data, cmd_list->IdxBuffer.Size * sizeof(ImDrawIdx));
+            vtx_dst += cmd_list->VtxBuffer.Size;
+            idx_dst += cmd_list->IdxBuffer.Size;
+        }
 
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, g_ElementsHandle);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, (GLsizeiptr)cmd_list->IdxBuffer.Size * sizeof(ImDrawIdx), (const GLvoid*)cmd_list->IdxBuffer.Data, GL_STREAM_DRAW);
+        if (use_layer)
+            ImGui_Impl_BeginLayer(layer_width, layer_height);
 
-        for (int cmd_i = 0; cmd_i < cmd_list->CmdBuffer.Size; cmd_i++)
+        if (g_SingleSubmission)
         {
-            const ImDrawCmd* pcmd = &cmd_list->CmdBuffer[cmd_i];
-            if (pcmd->UserCallback)
-            {
-                pcmd->UserCallback(cmd_list, pcmd);
-            }
-            else
-            {
-                glBindTexture(GL_TEXTURE_2D, (GLuint)(intptr_t)pcmd->TextureId);
-                glBindSampler(0, 0); // rely on combined texture/sampler state.
-                glScissor(
-                    (int)(pcmd->ClipRect.x), 
-                    (int)((io.DisplaySize.y * io.DisplayFramebufferScale.y - pcmd->ClipRect.w - 1)),
-                    (int)(pcmd->ClipRect.z),
-                    (int)(pcmd->ClipRect.w));
-                glDrawElements(GL_TRIANGLES, (GLsizei)pcmd->ElemCount, sizeof(ImDrawIdx) == 2 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT, idx_buffer_offset);
-            }
-            idx_buffer_offset += pcmd->ElemCount;
+            ImGui_Impl_BuildBatches(draw_data, idx_offset);
+            memcpy(stream + vtx_size + idx_size, g_DrawCommands.Data, g_DrawCommands.Size * sizeof(ImGui_Impl_DrawCommand));
+            ImGui_Impl_SubmitBatches(vtx_offset, cmd_offset);
+        }
+        else
+        {
+            ImGui_Impl_SubmitPerList(draw_data, vtx_offset, idx_offset);
         }
+
+        g_LayerValid = use_layer;
+        g_LayerHash = frame_hash;
+        if (use_layer)
+            g_LayerStats.FramesDrawn++;
     }
 
+    if (use_layer)
+        ImGui_Impl_CompositeLayer((GLuint)last_draw_framebuffer, stream + (quad_offset - vtx_offset), quad_offset);
+
+    g_StreamRing.EndFrame();
+
+    io.MetricsRenderDrawCalls = g_DrawCalls;
+    io.MetricsRenderStateChanges = g_StateChanges;
+
     // Restore modified GL state
     glUseProgram(last_program);
     glBindTexture(GL_TEXTURE_2D, last_texture);
@@ -122,6 +484,8 @@ void ImGui_Impl_RenderDrawLists(ImDrawData* draw_data)
     glBindVertexArray(last_vertex_array);
     glBindBuffer(GL_ARRAY_BUFFER, last_array_buffer);
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, last_element_array_buffer);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, last_draw_indirect_buffer);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, last_draw_framebuffer);
     glBlendEquationSeparate(last_blend_equation_rgb, last_blend_equation_alpha);
     glBlendFuncSeparate(last_blend_src_rgb, last_blend_dst_rgb, last_blend_src_alpha, last_blend_dst_alpha);
     if (last_enable_blend) glEnable(GL_BLEND); else glDisable(GL_BLEND);
@@ -179,6 +543,23 @@ bool ImGui_Impl_ProcessEvent(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam)
         if (wParam > 0 && wParam < 0x10000)
             io.AddInputCharacter((unsigned short)wParam);
         return true;
+    case WM_MOUSELEAVE:
+        // Otherwise whatever was under the mouse when it left stays hovered
+        io.MousePos = ImVec2(-1, -1);
+        return true;
+    case WM_SIZE:
+        io.DisplaySize = ImVec2((float)LOWORD(lParam), (float)HIWORD(lParam));
+        return true;
+    case WM_KILLFOCUS:
+        // Buttons and keys released while another window has the focus are never reported to us.
+        io.MousePos = ImVec2(-1, -1);
+        memset(io.MouseDown, 0, sizeof(io.MouseDown));
+        memset(io.KeysDown, 0, sizeof(io.KeysDown));
+        return true;
+    case WM_CAPTURECHANGED:
+        // Same for buttons released while another window has the mouse capture. The focus, and so the keys, may stay.
+        memset(io.MouseDown, 0, sizeof(io.MouseDown));
+        return true;
     default:
         break;
     }
@@ -186,6 +567,207 @@ bool ImGui_Impl_ProcessEvent(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam)
     return false;
 }
 
+static void ImGui_Impl_TrackMouseLeave(HWND hWnd)
+{
+    TRACKMOUSEEVENT track = { sizeof(track), TME_LEAVE, hWnd, 0 };
+    g_TrackingMouseLeave = TrackMouseEvent(&track) != FALSE;
+}
+
+bool ImGui_Impl_PostEvent(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam)
+{
+    int releasedButton = 0;
+
+    switch (msg)
+    {
+    case WM_LBUTTONDOWN: case WM_RBUTTONDOWN: case WM_MBUTTONDOWN:
+        // Hold the mouse capture while any button is down, so the release and the moves are reported even once the
+        // mouse is dragged out of the window. Otherwise the button would stay down until the next click.
+        if (g_CapturedMouseButtons == 0)
+            SetCapture(hWnd);
+        g_CapturedMouseButtons |= msg == WM_LBUTTONDOWN ? 1 : msg == WM_RBUTTONDOWN ? 2 : 4;
+        break;
+    case WM_LBUTTONUP: case WM_RBUTTONUP: case WM_MBUTTONUP:
+        releasedButton = msg == WM_LBUTTONUP ? 1 : msg == WM_RBUTTONUP ? 2 : 4;
+        break;
+    case WM_CAPTURECHANGED:
+        // Sent when ReleaseCapture below gives it back, or when another window takes it
+        g_CapturedMouseButtons = 0;
+        break;
+    case WM_MOUSEWHEEL:
+    case WM_KEYDOWN: case WM_KEYUP:
+    case WM_CHAR:
+    case WM_SIZE:
+    case WM_KILLFOCUS:
+        break;
+    case WM_MOUSEMOVE:
+        // Windows only sends WM_MOUSELEAVE once per request, so ask again each time the mouse comes back
+        if (!g_TrackingMouseLeave)
+            ImGui_Impl_TrackMouseLeave(hWnd);
+        break;
+    case WM_MOUSELEAVE:
+        g_TrackingMouseLeave = false;
+        // The mouse is still ours while captured. Leaving is requested again once the capture is released.
+        if (g_CapturedMouseButtons != 0)
+            return true;
+        break;
+    default:
+        return false;
+    }
+
+    ImGui_Impl_Event e = { GetClock()->NowNs(), msg, wParam, lParam };
+    if (!g_EventQueue.TryPush(e))
+    {
+        // The render thread is more than a whole queue behind. Nothing sensible to do but count it.
+        g_DroppedEvents.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // After queuing the release, so it comes before the WM_CAPTURECHANGED that ReleaseCapture sends.
+    if (releasedButton & g_CapturedMouseButtons)
+    {
+        g_CapturedMouseButtons &= ~releasedButton;
+        if (g_CapturedMouseButtons == 0)
+        {
+            ReleaseCapture();
+            // Reports WM_MOUSELEAVE right away if the button was released outside the window
+            ImGui_Impl_TrackMouseLeave(hWnd);
+        }
+    }
+    return true;
+}
+
+uint32_t ImGui_Impl_DroppedEventCount()
+{
+    return g_DroppedEvents.load(std::memory_order_relaxed);
+}
+
+const GLStreamRing& ImGui_Impl_GetStreamRing()
+{
+    return g_StreamRing;
+}
+
+void ImGui_Impl_SetSingleSubmission(bool enabled)
+{
+    g_SingleSubmission = enabled;
+}
+
+bool ImGui_Impl_GetSingleSubmission()
+{
+    return g_SingleSubmission;
+}
+
+void ImGui_Impl_SetLayerCache(bool enabled)
+{
+    g_LayerCache = enabled;
+    g_LayerValid = false;
+}
+
+bool ImGui_Impl_GetLayerCache()
+{
+    return g_LayerCache;
+}
+
+const ImGui_Impl_LayerStats& ImGui_Impl_GetLayerStats()
+{
+    return g_LayerStats;
+}
+
+bool ImGui_Impl_HasCachedLayer()
+{
+    ImGuiIO& io = ImGui::GetIO();
+    return g_LayerValid &&
+        g_LayerWidth == (int)(io.DisplaySize.x * io.DisplayFramebufferScale.x) &&
+        g_LayerHeight == (int)(io.DisplaySize.y * io.DisplayFramebufferScale.y);
+}
+
+void ImGui_Impl_RenderCachedLayer()
+{
+    IM_ASSERT(ImGui_Impl_HasCachedLayer());
+    ImGui_Impl_RenderDrawLists(NULL);
+}
+
+bool ImGui_Impl_HasGuiInput()
+{
+    ImGuiIO& io = ImGui::GetIO();
+    ImGuiContext& g = *GImGui;
+
+    uint32_t count = g_EventQueue.AvailableLatest();
+    for (uint32_t i = 0; i < count; i++)
+    {
+        // Moving the mouse off a window ends its hover, which ImGui reports as WantCaptureMouse
+        const ImGui_Impl_Event& e = g_EventQueue.At(i);
+        if (e.Msg != WM_MOUSEMOVE || io.WantCaptureMouse)
+            return true;
+
+        float x = (float)GET_X_LPARAM(e.lParam) / io.DisplayFramebufferScale.x;
+        float y = (float)GET_Y_LPARAM(e.lParam) / io.DisplayFramebufferScale.y;
+        for (int n = 0; n < g.Windows.Size; n++)
+        {
+            const ImGuiWindow* window = g.Windows[n];
+            if (window->Active &&
+                x >= window->Pos.x && x < window->Pos.x + window->Size.x &&
+                y >= window->Pos.y && y < window->Pos.y + window->Size.y)
+                return true;
+        }
+    }
+    return false;
+}
+
+// A release of a button or key that was pressed earlier in the same batch ends the batch, and is left for the next frame,
+// so ImGui sees presses that are shorter than a frame as held for at least one frame.
+void ImGui_Impl_ProcessEvents(HWND hWnd, uint64_t frameStartNs)
+{
+    bool mousePressed[3] = {};
+    bool keyPressed[256] = {};
+
+    uint32_t count = g_EventQueue.Available();
+    uint32_t processed = 0;
+    for (; processed < count; processed++)
+    {
+        const ImGui_Impl_Event& e = g_EventQueue.At(processed);
+        if (e.TimestampNs > frameStartNs)
+        {
+            break;
+        }
+
+        int button = -1;
+        switch (e.Msg)
+        {
+        case WM_LBUTTONDOWN: case WM_LBUTTONUP: button = 0; break;
+        case WM_RBUTTONDOWN: case WM_RBUTTONUP: button = 1; break;
+        case WM_MBUTTONDOWN: case WM_MBUTTONUP: button = 2; break;
+        }
+
+        if (e.Msg == WM_LBUTTONUP || e.Msg == WM_RBUTTONUP || e.Msg == WM_MBUTTONUP)
+        {
+            if (mousePressed[button])
+                break;
+        }
+        else if (button != -1)
+        {
+            mousePressed[button] = true;
+        }
+        else if (e.Msg == WM_CAPTURECHANGED)
+        {
+            // Releases every button
+            if (mousePressed[0] || mousePressed[1] || mousePressed[2])
+                break;
+        }
+        else if (e.Msg == WM_KEYUP && e.wParam < 256)
+        {
+            if (keyPressed[e.wParam])
+                break;
+        }
+        else if (e.Msg == WM_KEYDOWN && e.wParam < 256)
+        {
+            keyPressed[e.wParam] = true;
+        }
+
+        ImGui_Impl_ProcessEvent(hWnd, e.Msg, e.wParam, e.lParam);
+    }
+
+    g_EventQueue.Consume(processed);
+}
+
 void ImGui_Impl_CreateFontsTexture()
 {
     // Build texture atlas
@@ -244,16 +826,11 @@ bool ImGui_Impl_CreateDeviceObjects()
         "	Out_Color = Frag_Color * texture( Texture, Frag_UV.st);\n"
         "}\n";
 
-    g_ShaderHandle = glCreateProgram();
-    g_VertHandle = glCreateShader(GL_VERTEX_SHADER);
-    g_FragHandle = glCreateShader(GL_FRAGMENT_SHADER);
-    glShaderSource(g_VertHandle, 1, &vertex_shader, 0);
-    glShaderSource(g_FragHandle, 1, &fragment_shader, 0);
-    glCompileShader(g_VertHandle);
-    glCompileShader(g_FragHandle);
-    glAttachShader(g_ShaderHandle, g_VertHandle);
-    glAttachShader(g_ShaderHandle, g_FragHandle);
-    glLinkProgram(g_ShaderHandle);
+    const ShaderCacheStage stages[] = {
+        { GL_VERTEX_SHADER, 1, &vertex_shader },
+        { GL_FRAGMENT_SHADER, 1, &fragment_shader },
+    };
+    g_ShaderHandle = ShaderCache_LinkProgram(stages, (int)(sizeof(stages) / sizeof(stages[0])));
 
     g_AttribLocationTex = glGetUniformLocation(g_ShaderHandle, "Texture");
     g_AttribLocationProjMtx = glGetUniformLocation(g_ShaderHandle, "ProjMtx");
@@ -261,21 +838,23 @@ bool ImGui_Impl_CreateDeviceObjects()
     g_AttribLocationUV = glGetAttribLocation(g_ShaderHandle, "UV");
     g_AttribLocationColor = glGetAttribLocation(g_ShaderHandle, "Color");
 
-    glGenBuffers(1, &g_VboHandle);
-    glGenBuffers(1, &g_ElementsHandle);
+    g_StreamRing.Init(IMGUI_IMPL_STREAM_RING_SIZE);
 
+    // The vertex buffer is attached to binding 0 by ImGui_Impl_RenderDrawLists, since it moves within the stream ring.
     glGenVertexArrays(1, &g_VaoHandle);
     glBindVertexArray(g_VaoHandle);
-    glBindBuffer(GL_ARRAY_BUFFER, g_VboHandle);
     glEnableVertexAttribArray(g_AttribLocationPosition);
     glEnableVertexAttribArray(g_AttribLocationUV);
     glEnableVertexAttribArray(g_AttribLocationColor);
 
 #define OFFSETOF(TYPE, ELEMENT) ((size_t)&(((TYPE *)0)->ELEMENT))
-    glVertexAttribPointer(g_AttribLocationPosition, 2, GL_FLOAT, GL_FALSE, sizeof(ImDrawVert), (GLvoid*)OFFSETOF(ImDrawVert, pos));
-    glVertexAttribPointer(g_AttribLocationUV, 2, GL_FLOAT, GL_FALSE, sizeof(ImDrawVert), (GLvoid*)OFFSETOF(ImDrawVert, uv));
-    glVertexAttribPointer(g_AttribLocationColor, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(ImDrawVert), (GLvoid*)OFFSETOF(ImDrawVert, col));
+    glVertexAttribFormat(g_AttribLocationPosition, 2, GL_FLOAT, GL_FALSE, (GLuint)OFFSETOF(ImDrawVert, pos));
+    glVertexAttribFormat(g_AttribLocationUV, 2, GL_FLOAT, GL_FALSE, (GLuint)OFFSETOF(ImDrawVert, uv));
+    glVertexAttribFormat(g_AttribLocationColor, 4, GL_UNSIGNED_BYTE, GL_TRUE, (GLuint)OFFSETOF(ImDrawVert, col));
 #undef OFFSETOF
+    glVertexAttribBinding(g_AttribLocationPosition, 0);
+    glVertexAttribBinding(g_AttribLocationUV, 0);
+    glVertexAttribBinding(g_AttribLocationColor, 0);
 
     ImGui_Impl_CreateFontsTexture();
 
@@ -314,6 +893,12 @@ void ImGui_Impl_Init(HWND hWnd)
 
     io.ImeWindowHandle = hWnd;
 
+    // Afterwards, the display size is kept up to date by WM_SIZE
+    RECT clientRect;
+    GetClientRect(hWnd, &clientRect);
+    io.DisplaySize = ImVec2((float)(clientRect.right - clientRect.left), (float)(clientRect.bottom - clientRect.top));
+    io.MousePos = ImVec2(-1, -1);
+
     io.RenderDrawListsFn = ImGui_Impl_RenderDrawLists;
 }
 
@@ -324,40 +909,13 @@ void ImGui_Impl_NewFrame(HWND hWnd)
 
     ImGuiIO& io = ImGui::GetIO();
 
-    // Setup display size (every frame to accommodate for window resizing)
-    {
-        RECT clientRect;
-        GetClientRect(hWnd, &clientRect);
-        io.DisplaySize = ImVec2((float)(clientRect.right - clientRect.left), (float)(clientRect.bottom - clientRect.top));
-    }
-
     // Setup time step
-    DWORD time = GetTickCount();
-    double current_time = time / 1000.0;
-    io.DeltaTime = g_Time > 0.0 ? (float)(current_time - g_Time) : (float)(1.0f / 60.0f);
+    uint64_t current_time = GetClock()->NowNs();
+    io.DeltaTime = g_Time > 0 ? (float)((current_time - g_Time) / 1e9) : (float)(1.0f / 60.0f);
     g_Time = current_time;
 
-    // Setup inputs
-    POINT cursor;
-    GetCursorPos(&cursor);
-    ScreenToClient(hWnd, &cursor);
-
-    if (hWnd == GetForegroundWindow())
-    {
-        io.MousePos = ImVec2((float)cursor.x, (float)cursor.y);   // Mouse position, in pixels (set to -1,-1 if no mouse / on another screen, etc.)
-    }
-    else
-    {
-        io.MousePos = ImVec2(-1, -1);
-    }
-
-    io.MouseDown[0] = g_MousePressed[0] || (GetAsyncKeyState(VK_LBUTTON) & 0x8000) != 0;		// If a mouse press event came, always pass it as "mouse held this frame", so we don't miss click-release events that are shorter than 1 frame.
-    io.MouseDown[1] = g_MousePressed[1] || (GetAsyncKeyState(VK_RBUTTON) & 0x8000) != 0;
-    io.MouseDown[2] = g_MousePressed[2] || (GetAsyncKeyState(VK_MBUTTON) & 0x8000) != 0;
-    g_MousePressed[0] = g_MousePressed[1] = g_MousePressed[2] = false;
-
-    io.MouseWheel = g_MouseWheel;
-    g_MouseWheel = 0.0f;
+    // Setup inputs (and display size) from the window messages posted since the last frame
+    ImGui_Impl_ProcessEvents(hWnd, current_time);
 
     // Start the frame
     ImGui::NewFrame();
@@ -1,6 +1,55 @@
 #include <Windows.h>
+#include <cstdint>
+
+#include "gl_stream_ring.h"
 
 void ImGui_Impl_Init(HWND hWnd);
 
 void ImGui_Impl_NewFrame(HWND hWnd);
 bool ImGui_Impl_ProcessEvent(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam);
+
+// Called by the window procedure, on the window thread. Queues the message for the next ImGui_Impl_NewFrame,
+// which runs ImGui_Impl_ProcessEvent on it from the render thread. Returns true if the message is used by ImGui.
+bool ImGui_Impl_PostEvent(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam);
+
+// Feeds ImGui the queued messages posted before 'frameStartNs', in order. Called by ImGui_Impl_NewFrame, and directly by
+// the self-tests, which have no GL context for ImGui_Impl_NewFrame.
+void ImGui_Impl_ProcessEvents(HWND hWnd, uint64_t frameStartNs);
+
+// Number of messages dropped because the render thread fell a whole queue behind.
+uint32_t ImGui_Impl_DroppedEventCount();
+
+// The ring that ImGui's vertices and indices are streamed through, for its statistics.
+const GLStreamRing& ImGui_Impl_GetStreamRing();
+
+// In single-submission mode (the default), the draw commands of all lists are drawn from one vertex buffer binding
+// with base-vertex and multi-draw-indirect calls, and texture/scissor changes are skipped when redundant.
+// Otherwise, each ImDrawCmd is drawn with its own state setup. ImGuiIO::MetricsRenderDrawCalls/StateChanges count both.
+void ImGui_Impl_SetSingleSubmission(bool enabled);
+bool ImGui_Impl_GetSingleSubmission();
+
+struct ImGui_Impl_LayerStats
+{
+    uint64_t FramesDrawn;       // Frames whose lists were uploaded and drawn into the layer
+    uint64_t FramesReused;      // Frames that only composited the layer of an earlier frame
+    int      Lists;             // Lists of the last frame
+    int      ListsChanged;      // Lists of the last frame whose contents differ from the frame before
+};
+
+// With the layer cache, the lists are drawn into a texture the size of the framebuffer, which is then composited over
+// it. A frame whose lists hash the same as the layer's skips the upload and the draws, and only composites the layer
+// again. Frames with user callbacks are always drawn directly, since those may draw anything.
+// Off by default: a frame whose GUI changed pays for the extra pass and the composite, on the way to the swap.
+void ImGui_Impl_SetLayerCache(bool enabled);
+bool ImGui_Impl_GetLayerCache();
+const ImGui_Impl_LayerStats& ImGui_Impl_GetLayerStats();
+
+// For building the GUI at a lower rate than the frames are drawn: ImGui_Impl_RenderCachedLayer composites the layer of
+// the last ImGui::Render again, without a new frame. There's no layer to reuse if the layer cache is disabled, the last
+// frame had user callbacks, or the display was resized, in which case a frame has to be built.
+bool ImGui_Impl_HasCachedLayer();
+void ImGui_Impl_RenderCachedLayer();
+
+// Returns true if the messages queued for the next ImGui_Impl_NewFrame can change the GUI: anything but mouse moves,
+// and mouse moves that land on a window or happen while ImGui has the mouse (eg. hovering or dragging).
+bool ImGui_Impl_HasGuiInput();
@@ -0,0 +1,52 @@
+#include "self_test.h"
+
+#include "imgui_impl.h"
+#include "imgui.h"
+#include "clock.h"
+
+#include <windowsx.h>
+
+// Feeds ImGui_Impl_PostEvent the messages of a drag that starts in the window and ends outside of it, as the window
+// receives them while it holds the mouse capture, and checks what ImGui sees frame by frame.
+// There's no window, so SetCapture and TrackMouseEvent fail, and only the queue and ImGui's inputs are checked.
+SelfTestResult ImGuiImplTest_RunMouseCapture()
+{
+    SelfTestResult result = {};
+
+    ImGuiIO& io = ImGui::GetIO();
+    io.DisplaySize = ImVec2(640, 480);
+    io.DisplayFramebufferScale = ImVec2(1, 1);
+    io.MousePos = ImVec2(-1, -1);
+
+    // Press in the window, then drag out past the left edge and release there.
+    ImGui_Impl_PostEvent(NULL, WM_MOUSEMOVE, 0, MAKELPARAM(10, 20));
+    ImGui_Impl_PostEvent(NULL, WM_LBUTTONDOWN, MK_LBUTTON, MAKELPARAM(10, 20));
+    ImGui_Impl_PostEvent(NULL, WM_MOUSEMOVE, MK_LBUTTON, MAKELPARAM(-30, 25));
+    ImGui_Impl_PostEvent(NULL, WM_LBUTTONUP, 0, MAKELPARAM(-30, 25));
+    ImGui_Impl_PostEvent(NULL, WM_CAPTURECHANGED, 0, 0);
+
+    // The release is left for the next frame, so the press lasts a frame, but the move outside is seen right away.
+    ImGui_Impl_ProcessEvents(NULL, GetClock()->NowNs());
+    SELF_TEST_CHECK(result, io.MouseDown[0]);
+    SELF_TEST_CHECK(result, io.MousePos.x == -30 && io.MousePos.y == 25);
+
+    ImGui_Impl_ProcessEvents(NULL, GetClock()->NowNs());
+    SELF_TEST_CHECK(result, !io.MouseDown[0]);
+
+    // Another window taking the capture in the middle of a drag releases the buttons too.
+    ImGui_Impl_PostEvent(NULL, WM_RBUTTONDOWN, MK_RBUTTON, MAKELPARAM(100, 100));
+    ImGui_Impl_ProcessEvents(NULL, GetClock()->NowNs());
+    SELF_TEST_CHECK(result, io.MouseDown[1]);
+
+    ImGui_Impl_PostEvent(NULL, WM_CAPTURECHANGED, 0, 0);
+    ImGui_Impl_ProcessEvents(NULL, GetClock()->NowNs());
+    SELF_TEST_CHECK(result, !io.MouseDown[1]);
+
+    // Nothing left queued, and nothing dropped
+    ImGui_Impl_ProcessEvents(NULL, GetClock()->NowNs());
+    SELF_TEST_CHECK(result, !io.MouseDown[0] && !io.MouseDown[1] && !io.MouseDown[2]);
+    SELF_TEST_CHECK(result, ImGui_Impl_DroppedEventCount() == 0);
+
+    io.MousePos = ImVec2(-1, -1);
+    return result;
+}
@@ -46,6 +46,7 @@ typedef int ImGuiLayoutType;      // enum ImGuiLayoutType_
 typedef int ImGuiButtonFlags;     // enum ImGuiButtonFlags_
 typedef int ImGuiTreeNodeFlags;   // enum ImGuiTreeNodeFlags_
 typedef int ImGuiSliderFlags;     // enum ImGuiSliderFlags_
+typedef int ImGuiMemTag;          // enum ImGuiMemTag_
 
 //-------------------------------------------------------------------------
 // STB libraries
@@ -94,6 +95,12 @@ IMGUI_API bool          ImIsPointInTriangle(const ImVec2& p, const ImVec2& a, co
 static inline bool      ImCharIsSpace(int c)            { return c == ' ' || c == '\t' || c == 0x3000; }
 static inline int       ImUpperPowerOfTwo(int v)        { v--; v |= v >> 1; v |= v >> 2; v |= v >> 4; v |= v >> 8; v |= v >> 16; v++; return v; }
 
+// Same value as ImHash(str, 0, seed), computed at compile time when used on a literal, eg. 'constexpr ImGuiID id = ImHashLiteral("Debug");'
+// Written as C++11 constexpr (one return statement, hence the recursion), bit by bit since a constexpr function can't have a table.
+static inline constexpr ImU32 ImHashLiteralBits(ImU32 crc, int bits)                            { return bits == 0 ? crc : ImHashLiteralBits((crc >> 1) ^ (0xEDB88320 & (0u - (crc & 1))), bits - 1); }
+static inline constexpr ImU32 ImHashLiteralStep(const char* str, ImU32 start, ImU32 crc)        { return *str == 0 ? ~crc : ImHashLiteralStep(str + 1, start, ImHashLiteralBits(((str[0] == '#' && str[1] == '#' && str[2] == '#') ? start : crc) ^ (unsigned char)str[0], 8)); }
+static inline constexpr ImU32 ImHashLiteral(const char* str, ImU32 seed = 0)                    { return ImHashLiteralStep(str, ~seed, ~seed); }
+
 // Helpers: String
 IMGUI_API int           ImStricmp(const char* str1, const char* str2);
 IMGUI_API int           ImStrnicmp(const char* str1, const char* str2, int count);
@@ -209,6 +216,19 @@ enum ImGuiCorner
     ImGuiCorner_All         = 0x0F
 };
 
+// What MemAlloc() attributes allocations to with IMGUI_MEM_INSTRUMENTATION, set with ImGuiMemTagScope
+enum ImGuiMemTag_
+{
+    ImGuiMemTag_Other,          // Outside of any scope: ID stacks, user's ImVector<>, etc.
+    ImGuiMemTag_Windows,        // ImGuiWindow and the state Begin() keeps in them
+    ImGuiMemTag_DrawLists,
+    ImGuiMemTag_Fonts,          // Font atlas, glyphs and texture data
+    ImGuiMemTag_Storage,        // ImGuiStorage (tree node states, etc.)
+    ImGuiMemTag_TextEdit,       // InputText() buffers and clipboard
+    ImGuiMemTag_Settings,       // .ini settings
+    ImGuiMemTag_COUNT
+};
+
 // 2D axis aligned bounding-box
 // NB: we can't rely on ImVec2 math operators being available here
 struct IMGUI_API ImRect
@@ -347,6 +367,30 @@ struct ImGuiMouseCursorData
     ImVec2              TexUvMax[2];
 };
 
+// Memory attributed to an ImGuiMemTag
+struct ImGuiMemTagStats
+{
+    size_t      Bytes;
+    size_t      PeakBytes;
+    int         Allocs;                 // Live allocations
+    int         FrameAllocs;            // Since NewFrame()
+    int         FrameFrees;
+    size_t      FrameAllocBytes;
+    int         LastFrameAllocs;        // Between the last two calls to NewFrame()
+    int         LastFrameFrees;
+    size_t      LastFrameAllocBytes;
+
+    ImGuiMemTagStats() { memset(this, 0, sizeof(*this)); }
+};
+
+// Memory that ImGui doesn't allocate, reported with MemTrackExternal()
+struct ImGuiMemExternal
+{
+    const char* Name;
+    size_t      Bytes;
+    size_t      PeakBytes;
+};
+
 // Storage for current popup stack
 struct ImGuiPopupRef
 {
@@ -374,7 +418,13 @@ struct ImGuiContext
     int                     FrameCount;
     int                     FrameCountEnded;
     int                     FrameCountRendered;
+    int                     FrameAllocs;                        // MemAlloc() calls since NewFrame(), for IO.MetricsFrameAllocs
+    int                     FrameFrees;
+    ImGuiMemTag             MemTag;                             // Attributed to MemAlloc() calls, see ImGuiMemTagScope
+    ImGuiMemTagStats        MemTagStats[ImGuiMemTag_COUNT];     // With IMGUI_MEM_INSTRUMENTATION
+    ImVector<ImGuiMemExternal> MemExternal;
     ImVector<ImGuiWindow*>  Windows;
+    ImGuiStorage            WindowsById;                        // ImGuiWindow::ID -> ImGuiWindow*, for FindWindowByName()
     ImVector<ImGuiWindow*>  WindowsSortBuffer;
     ImGuiWindow*            CurrentWindow;                      // Being drawn into
     ImVector<ImGuiWindow*>  CurrentWindowStack;
@@ -466,6 +516,8 @@ struct ImGuiContext
         Time = 0.0f;
         FrameCount = 0;
         FrameCountEnded = FrameCountRendered = -1;
+        FrameAllocs = FrameFrees = 0;
+        MemTag = ImGuiMemTag_Other;
         CurrentWindow = NULL;
         FocusedWindow = NULL;
         HoveredWindow = NULL;
@@ -690,6 +742,23 @@ public:
     ImRect      MenuBarRect() const                     { float y1 = Pos.y + TitleBarHeight(); return ImRect(Pos.x, y1, Pos.x + SizeFull.x, y1 + MenuBarHeight()); }
 };
 
+// Bytes MemAlloc() prepends to every allocation with IMGUI_MEM_INSTRUMENTATION, to know what MemFree() frees.
+// Keeps the 16-byte alignment of MemAllocFn.
+#define IMGUI_MEM_HEADER_SIZE 16
+
+// Attributes the allocations made during its lifetime to a tag. Scopes nest, so eg. draw list buffers that grow while
+// Begin() is in a ImGuiMemTag_Windows scope are still attributed to ImGuiMemTag_DrawLists.
+struct ImGuiMemTagScope
+{
+#ifdef IMGUI_MEM_INSTRUMENTATION
+    ImGuiMemTag BackupTag;
+    ImGuiMemTagScope(ImGuiMemTag tag)   { BackupTag = GImGui->MemTag; GImGui->MemTag = tag; }
+    ~ImGuiMemTagScope()                 { GImGui->MemTag = BackupTag; }
+#else
+    ImGuiMemTagScope(ImGuiMemTag)       {}
+#endif
+};
+
 //-----------------------------------------------------------------------------
 // Internal API
 // No guarantee of forward compatibility here.
@@ -0,0 +1,291 @@
+#if defined(_MSC_VER) && !defined(_CRT_SECURE_NO_WARNINGS)
+#define _CRT_SECURE_NO_WARNINGS
+#endif
+
+#include "input_trace.h"
+
+#include <cstring>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static void InputTrace_Flush(InputTraceWriter* writer)
+{
+    if (writer->BufferedCount > 0)
+    {
+        fwrite(writer->Buffer, sizeof(InputTraceRecord), writer->BufferedCount, writer->File);
+        writer->BufferedCount = 0;
+    }
+}
+
+static void InputTrace_WriteHeader(InputTraceWriter* writer, uint64_t recordCount)
+{
+    InputTraceHeader header = {};
+    header.Magic = INPUT_TRACE_MAGIC;
+    header.Version = INPUT_TRACE_VERSION;
+    header.HeaderSize = sizeof(InputTraceHeader);
+    header.RecordSize = sizeof(InputTraceRecord);
+    header.RecordCount = recordCount;
+    header.StartTimestampNs = writer->StartTimestampNs;
+
+    fseek(writer->File, 0, SEEK_SET);
+    fwrite(&header, sizeof(header), 1, writer->File);
+}
+
+bool InputTrace_BeginRecording(InputTraceWriter* writer, const char* path, uint64_t startTimestampNs)
+{
+    writer->File = fopen(path, "wb");
+    if (!writer->File)
+    {
+        return false;
+    }
+
+    writer->RecordCount = 0;
+    writer->StartTimestampNs = startTimestampNs;
+    writer->BufferedCount = 0;
+
+    InputTrace_WriteHeader(writer, INPUT_TRACE_UNFINISHED);
+    return true;
+}
+
+void InputTrace_Record(InputTraceWriter* writer, uint64_t timestampNs, int x, int y, InputTraceSource source)
+{
+    InputTraceRecord& record = writer->Buffer[writer->BufferedCount];
+    record.TimestampNs = timestampNs;
+    record.X = x;
+    record.Y = y;
+    record.Source = source;
+    record.Reserved = 0;
+
+    writer->RecordCount++;
+    writer->BufferedCount++;
+    if (writer->BufferedCount == INPUT_TRACE_WRITE_CHUNK)
+    {
+        InputTrace_Flush(writer);
+    }
+}
+
+void InputTrace_EndRecording(InputTraceWriter* writer)
+{
+    if (!writer->File)
+    {
+        return;
+    }
+
+    InputTrace_Flush(writer);
+    InputTrace_WriteHeader(writer, writer->RecordCount);
+    fclose(writer->File);
+    writer->File = NULL;
+}
+
+bool InputTrace_Open(InputTraceView* view, const char* path)
+{
+    memset(view, 0, sizeof(*view));
+
+#ifdef _WIN32
+    HANDLE hFile = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (hFile == INVALID_HANDLE_VALUE)
+    {
+        return false;
+    }
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(hFile, &fileSize) || fileSize.QuadPart < (LONGLONG)sizeof(InputTraceHeader))
+    {
+        CloseHandle(hFile);
+        return false;
+    }
+
+    HANDLE hMapping = CreateFileMappingA(hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (hMapping == NULL)
+    {
+        CloseHandle(hFile);
+        return false;
+    }
+
+    void* mapping = MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, 0);
+    if (mapping == NULL)
+    {
+        CloseHandle(hMapping);
+        CloseHandle(hFile);
+        return false;
+    }
+
+    view->FileHandle = (intptr_t)hFile;
+    view->MappingHandle = (intptr_t)hMapping;
+    view->MappingSize = (size_t)fileSize.QuadPart;
+#else
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+    {
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(InputTraceHeader))
+    {
+        close(fd);
+        return false;
+    }
+
+    void* mapping = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (mapping == MAP_FAILED)
+    {
+        close(fd);
+        return false;
+    }
+
+    view->FileHandle = fd;
+    view->MappingSize = (size_t)st.st_size;
+#endif
+
+    view->Mapping = mapping;
+
+    const InputTraceHeader* header = (const InputTraceHeader*)mapping;
+    if (header->Magic != INPUT_TRACE_MAGIC ||
+        header->Version != INPUT_TRACE_VERSION ||
+        header->HeaderSize < sizeof(InputTraceHeader) ||
+        header->RecordSize != sizeof(InputTraceRecord) ||
+        header->HeaderSize > view->MappingSize)
+    {
+        InputTrace_Close(view);
+        return false;
+    }
+
+    uint64_t recordsInFile = (view->MappingSize - header->HeaderSize) / header->RecordSize;
+
+    view->Header = header;
+    view->Records = (const InputTraceRecord*)((const char*)mapping + header->HeaderSize);
+    view->RecordCount = header->RecordCount == INPUT_TRACE_UNFINISHED || header->RecordCount > recordsInFile ? recordsInFile : header->RecordCount;
+    return true;
+}
+
+void InputTrace_Close(InputTraceView* view)
+{
+#ifdef _WIN32
+    if (view->Mapping) UnmapViewOfFile(view->Mapping);
+    if (view->MappingHandle) CloseHandle((HANDLE)view->MappingHandle);
+    if (view->FileHandle) CloseHandle((HANDLE)view->FileHandle);
+#else
+    if (view->Mapping)
+    {
+        munmap(view->Mapping, view->MappingSize);
+        close((int)view->FileHandle);
+    }
+#endif
+    memset(view, 0, sizeof(*view));
+}
+
+#ifdef INPUT_TRACE_MAIN
+#include "late_latch_ring.h"
+#include "latency_histogram.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <thread>
+
+// Same layout as the app's InputBufferItem, without depending on GL headers.
+struct InputTraceReplayItem
+{
+    uint32_t X, Y;
+    uint64_t TimestampNs;
+};
+
+#define INPUT_TRACE_REPLAY_RING_SIZE 16384
+
+static LateLatchRingStorage<InputTraceReplayItem, INPUT_TRACE_REPLAY_RING_SIZE> g_ReplayRingStorage;
+static LatencyHistogram g_ReplayLatchLatency;
+
+// Replays a trace into a host-memory late-latch ring with no window or GL context, while a latch thread stands in for
+// the cursor's vertex shader and reads the latest sample at a fixed rate.
+// Usage: input_trace <trace> [speed = 1, 0 is unthrottled] [latch rate in Hz = 1000]
+// The trace checksum and the final latched sample only depend on the trace, so two runs can be compared bit-for-bit.
+int main(int argc, char* argv[])
+{
+    if (argc < 2)
+    {
+        fprintf(stderr, "Usage: %s <trace> [speed] [latch Hz]\n", argv[0]);
+        return 2;
+    }
+
+    double speed = argc > 2 ? atof(argv[2]) : 1.0;
+    double latchHz = argc > 3 ? atof(argv[3]) : 1000.0;
+    if (speed < 0.0 || latchHz <= 0.0)
+    {
+        fprintf(stderr, "Speed must be >= 0 and the latch rate > 0\n");
+        return 2;
+    }
+
+    InputTraceView view;
+    if (!InputTrace_Open(&view, argv[1]))
+    {
+        fprintf(stderr, "Failed to open input trace %s\n", argv[1]);
+        return 1;
+    }
+
+    Clock* clock = GetClock();
+
+    LateLatchRing<InputTraceReplayItem, INPUT_TRACE_REPLAY_RING_SIZE> ring;
+    ring.Init(g_ReplayRingStorage.Slots, &g_ReplayRingStorage.Published, InputTraceReplayItem{ 0, 0, clock->NowNs() });
+
+    std::atomic<bool> replayDone(false);
+    uint64_t latches = 0;
+    std::thread latchThread([&] {
+        uint64_t periodNs = uint64_t(1e9 / latchHz);
+        uint64_t next = clock->NowNs();
+        while (!replayDone.load(std::memory_order_acquire))
+        {
+            InputTraceReplayItem item;
+            ring.ReadLatest(&item);
+            g_ReplayLatchLatency.Record(clock->NowNs() - item.TimestampNs);
+            latches++;
+
+            next += periodNs;
+            clock->SleepUntilNs(next);
+        }
+    });
+
+    uint64_t sourceCounts[INPUTTRACESOURCE_COUNT] = {};
+    uint64_t checksum = 0xCBF29CE484222325ull;
+    uint64_t replayStart = clock->NowNs();
+    InputTrace_Replay(view, clock, speed, NULL, [&](const InputTraceRecord& record) {
+        // Timestamp with the replay time, like the app does, so latency is measured the same way as for live input.
+        ring.Publish(InputTraceReplayItem{ uint32_t(record.X), uint32_t(record.Y), clock->NowNs() });
+
+        if (record.Source < INPUTTRACESOURCE_COUNT)
+        {
+            sourceCounts[record.Source]++;
+        }
+
+        checksum = (checksum ^ record.TimestampNs) * 0x100000001B3ull;
+        checksum = (checksum ^ (((uint64_t)(uint32_t)record.X << 32) | (uint32_t)record.Y)) * 0x100000001B3ull;
+        checksum = (checksum ^ record.Source) * 0x100000001B3ull;
+    });
+    uint64_t replayNs = clock->NowNs() - replayStart;
+
+    replayDone.store(true, std::memory_order_release);
+    latchThread.join();
+
+    InputTraceReplayItem last;
+    uint32_t lastTicket = ring.ReadLatest(&last);
+    bool lastMatches = view.RecordCount == 0 ||
+        (last.X == uint32_t(view.Records[view.RecordCount - 1].X) && last.Y == uint32_t(view.Records[view.RecordCount - 1].Y));
+
+    printf("Records: %llu (%llu WM_MOUSEMOVE, %llu polled)\n", (unsigned long long)view.RecordCount,
+        (unsigned long long)sourceCounts[INPUTTRACESOURCE_MOUSEMOVE], (unsigned long long)sourceCounts[INPUTTRACESOURCE_POLL]);
+    printf("Checksum: %016llx\n", (unsigned long long)checksum);
+    printf("Last latched: ticket %u, (%d, %d)%s\n", lastTicket, (int)last.X, (int)last.Y, lastMatches ? "" : " (doesn't match the last record)");
+    printf("Replay: %.3f ms, %.1f M samples/s\n", replayNs / 1e6, replayNs > 0 ? view.RecordCount * 1e3 / replayNs : 0.0);
+    printf("Latches: %llu, latency p50 %.3f ms, p99 %.3f ms, max %.3f ms\n", (unsigned long long)latches,
+        g_ReplayLatchLatency.Percentile(50.0) / 1e6, g_ReplayLatchLatency.Percentile(99.0) / 1e6, g_ReplayLatchLatency.Max() / 1e6);
+
+    InputTrace_Close(&view);
+    return lastMatches ? 0 : 1;
+}
+#endif
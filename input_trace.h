@@ -0,0 +1,118 @@
+#pragma once
+
+// Binary traces of the input samples fed to the late-latch ring, for deterministic replay.
+//
+// File layout (little-endian, no padding between records, so the file can be memory-mapped and indexed directly):
+//   InputTraceHeader
+//   InputTraceRecord[RecordCount]
+//
+// RecordCount is written when the recording ends. A trace that was never finished (eg. the process was killed)
+// has RecordCount == INPUT_TRACE_UNFINISHED, and readers recover the count from the file size instead.
+//
+// Build with INPUT_TRACE_MAIN defined to get a command-line driver that replays a trace into a late-latch ring
+// without a window or a GL context (so it also runs on Linux build machines) and prints a summary.
+
+#include "clock.h"
+
+#include <cstdint>
+#include <cstdio>
+
+#define INPUT_TRACE_MAGIC 0x5254494C // "LITR"
+#define INPUT_TRACE_VERSION 1
+#define INPUT_TRACE_UNFINISHED 0xFFFFFFFFFFFFFFFFull
+
+// Records are buffered and written in chunks of this many, so the input thread only hits the disk occasionally.
+#define INPUT_TRACE_WRITE_CHUNK 4096
+
+enum InputTraceSource
+{
+    INPUTTRACESOURCE_MOUSEMOVE, // WM_MOUSEMOVE
+    INPUTTRACESOURCE_POLL,      // GetCursorPos in the window thread's message loop
+    INPUTTRACESOURCE_COUNT
+};
+
+struct InputTraceHeader
+{
+    uint32_t Magic;
+    uint32_t Version;
+    uint32_t HeaderSize;
+    uint32_t RecordSize;
+    uint64_t RecordCount;
+    uint64_t StartTimestampNs;
+};
+
+struct InputTraceRecord
+{
+    uint64_t TimestampNs;
+    int32_t X, Y;
+    uint32_t Source;
+    uint32_t Reserved;
+};
+
+static_assert(sizeof(InputTraceHeader) == 32, "InputTraceHeader is part of the file format");
+static_assert(sizeof(InputTraceRecord) == 24, "InputTraceRecord is part of the file format");
+
+// Writes a trace. Not thread-safe: calls to InputTrace_Record must be serialized by the caller.
+struct InputTraceWriter
+{
+    FILE* File;
+    uint64_t RecordCount;
+    uint64_t StartTimestampNs;
+    uint32_t BufferedCount;
+    InputTraceRecord Buffer[INPUT_TRACE_WRITE_CHUNK];
+};
+
+bool InputTrace_BeginRecording(InputTraceWriter* writer, const char* path, uint64_t startTimestampNs);
+void InputTrace_Record(InputTraceWriter* writer, uint64_t timestampNs, int x, int y, InputTraceSource source);
+void InputTrace_EndRecording(InputTraceWriter* writer);
+
+// Read-only memory mapping of a trace file.
+struct InputTraceView
+{
+    const InputTraceHeader* Header;
+    const InputTraceRecord* Records;
+    uint64_t RecordCount;
+
+    // Platform handles
+    void* Mapping;
+    size_t MappingSize;
+    intptr_t FileHandle;
+    intptr_t MappingHandle;
+};
+
+bool InputTrace_Open(InputTraceView* view, const char* path);
+void InputTrace_Close(InputTraceView* view);
+
+// Calls publish(record) for each record of the trace, at the original pace divided by 'speed', as measured by 'clock'.
+// A speed of 0 replays as fast as possible. Runs on the calling thread; no window or GL context is needed.
+// With a VirtualClock, the replay is fully deterministic and doesn't actually wait.
+// Returns early if 'cancel' becomes true.
+template<class PublishFn>
+void InputTrace_Replay(const InputTraceView& view, Clock* clock, double speed, const volatile bool* cancel, PublishFn publish)
+{
+    if (view.RecordCount == 0)
+    {
+        return;
+    }
+
+    uint64_t start = clock->NowNs();
+    uint64_t firstTimestampNs = view.Records[0].TimestampNs;
+
+    for (uint64_t i = 0; i < view.RecordCount; i++)
+    {
+        if (cancel && *cancel)
+        {
+            return;
+        }
+
+        const InputTraceRecord& record = view.Records[i];
+
+        if (speed > 0.0)
+        {
+            double offsetNs = double(record.TimestampNs - firstTimestampNs) / speed;
+            clock->SleepUntilNs(start + uint64_t(offsetNs));
+        }
+
+        publish(record);
+    }
+}
@@ -0,0 +1,11 @@
+#pragma once
+
+// How the cursor position gets from the OS to the screen. Shared between the app and the latency simulator.
+enum LatchMode
+{
+    LATCHMODE_LATE,
+    LATCHMODE_UNIFORM,
+    LATCHMODE_SETCURSOR,
+    LATCHMODE_ALL,
+    LATCHMODE_COUNT
+};
@@ -0,0 +1,167 @@
+#pragma once
+
+// Multi-producer ring of input samples that is read "late" by a consumer (typically a vertex shader reading a persistently mapped buffer).
+//
+// Each slot carries a sequence word that implements a seqlock:
+//   Sequence == 2*ticket+1  -> the slot is being written for 'ticket'
+//   Sequence == 2*ticket+2  -> the slot holds a complete value for 'ticket'
+// A producer reserves a ticket, writes the slot under the seqlock, then advances the published counter to its ticket (never backwards).
+// So a consumer that reads the published counter and then the slot it points to never sees a half-written value,
+// and a CPU consumer can also detect that it raced with a producer that lapped the ring, and retry.
+//
+// Sequence words are 32 bits so the GPU can read them, which bounds the lifetime of the ring: StableSequence(2^31 - 1)
+// wraps to 0, the value of slots that were never written. Tickets up to MaxTicket are safe; call Reinit() before then.
+//
+// The slots and the published counter can live in externally owned memory (eg. a GL_MAP_PERSISTENT_BIT mapping),
+// which is why they're attached with Init() instead of being members. LateLatchRingStorage provides host memory for CPU-only use.
+
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+
+#define LATE_LATCH_CACHE_LINE_SIZE 64
+
+template<class T, uint32_t N>
+class LateLatchRing
+{
+    static_assert((N & (N - 1)) == 0, "LateLatchRing size must be a power of two");
+    static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t), "Sequence must have the same layout as a uint32_t so the GPU can read it");
+
+public:
+    struct Slot
+    {
+        std::atomic<uint32_t> Sequence;
+        T Value;
+    };
+
+    static const uint32_t Size = N;
+    static const uint32_t MaxTicket = 0x7FFFFFFE;
+
+    static uint32_t WritingSequence(uint32_t ticket) { return ticket * 2 + 1; }
+    static uint32_t StableSequence(uint32_t ticket) { return ticket * 2 + 2; }
+
+    LateLatchRing()
+    {
+        NextTicket.store(0, std::memory_order_relaxed);
+        Slots.store(NULL, std::memory_order_relaxed);
+        Published = NULL;
+    }
+
+    // Attach the ring to N slots and a published counter, and publish 'initial' as ticket 0.
+    // Producers that call Publish() before Init() returns are dropped (see IsAttached()).
+    void Init(Slot* slots, std::atomic<uint32_t>* published, const T& initial)
+    {
+        slots[0].Value = initial;
+        slots[0].Sequence.store(StableSequence(0), std::memory_order_relaxed);
+        for (uint32_t i = 1; i < N; i++)
+        {
+            // No ticket up to MaxTicket maps to 0, so readers reject slots that were never written.
+            slots[i].Sequence.store(0, std::memory_order_relaxed);
+        }
+
+        published->store(0, std::memory_order_relaxed);
+        Published = published;
+        NextTicket.store(1, std::memory_order_relaxed);
+
+        Slots.store(slots, std::memory_order_release);
+    }
+
+    // Restart the tickets of an attached ring at 0, publishing 'initial' as ticket 0 in the same memory.
+    // Not safe against concurrent producers: call it from the only producer, once Publish() returned MaxTicket.
+    // The published counter doesn't move until slot 0 holds 'initial', so the GPU always finds a whole value.
+    void Reinit(const T& initial)
+    {
+        Init(Slots.load(std::memory_order_relaxed), Published, initial);
+    }
+
+    bool IsAttached() const
+    {
+        return Slots.load(std::memory_order_acquire) != NULL;
+    }
+
+    // Safe to call from any number of threads concurrently. Returns the ticket assigned to the value.
+    // Assumes that no producer stalls for N publishes in the middle of writing its slot.
+    uint32_t Publish(const T& value)
+    {
+        Slot* slots = Slots.load(std::memory_order_acquire);
+
+        uint32_t ticket = NextTicket.fetch_add(1, std::memory_order_relaxed);
+        Slot& slot = slots[ticket & (N - 1)];
+
+        slot.Sequence.store(WritingSequence(ticket), std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        slot.Value = value;
+        slot.Sequence.store(StableSequence(ticket), std::memory_order_release);
+
+        // Only move the published counter forward, so a slow producer can't hide a newer sample.
+        uint32_t published = Published->load(std::memory_order_relaxed);
+        while ((int32_t)(ticket - published) > 0)
+        {
+            if (Published->compare_exchange_weak(published, ticket, std::memory_order_release, std::memory_order_relaxed))
+            {
+                break;
+            }
+        }
+
+        return ticket;
+    }
+
+    uint32_t LatestTicket() const
+    {
+        return Published->load(std::memory_order_acquire);
+    }
+
+    // Reads the value for a specific ticket. Returns false if the slot is mid-write or has been overwritten by a newer ticket.
+    bool TryRead(uint32_t ticket, T* value) const
+    {
+        const Slot& slot = Slots.load(std::memory_order_acquire)[ticket & (N - 1)];
+
+        uint32_t before = slot.Sequence.load(std::memory_order_acquire);
+        if (before != StableSequence(ticket))
+        {
+            return false;
+        }
+
+        T copy = slot.Value;
+        std::atomic_thread_fence(std::memory_order_acquire);
+
+        uint32_t after = slot.Sequence.load(std::memory_order_relaxed);
+        if (after != before)
+        {
+            return false;
+        }
+
+        *value = copy;
+        return true;
+    }
+
+    // Reads the most recently published value. Retries while racing with producers that lap the ring.
+    uint32_t ReadLatest(T* value) const
+    {
+        for (;;)
+        {
+            uint32_t ticket = LatestTicket();
+            if (TryRead(ticket, value))
+            {
+                return ticket;
+            }
+        }
+    }
+
+private:
+    // Written by every producer: keep it away from the read-mostly fields below.
+    alignas(LATE_LATCH_CACHE_LINE_SIZE) std::atomic<uint32_t> NextTicket;
+
+    alignas(LATE_LATCH_CACHE_LINE_SIZE) std::atomic<Slot*> Slots;
+    std::atomic<uint32_t>* Published;
+};
+
+// Host memory for a LateLatchRing that is not shared with the GPU.
+// Give it static storage: new doesn't align to cache lines before C++17.
+template<class T, uint32_t N>
+struct LateLatchRingStorage
+{
+    alignas(LATE_LATCH_CACHE_LINE_SIZE) typename LateLatchRing<T, N>::Slot Slots[N];
+    alignas(LATE_LATCH_CACHE_LINE_SIZE) std::atomic<uint32_t> Published;
+    char Padding[LATE_LATCH_CACHE_LINE_SIZE - sizeof(std::atomic<uint32_t>)];
+};
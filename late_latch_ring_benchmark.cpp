@@ -0,0 +1,105 @@
+#include "late_latch_ring_benchmark.h"
+
+#include "late_latch_ring.h"
+#include "clock.h"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+// Like InputBufferItem in main.cpp, with a check of the other fields to catch torn reads
+struct LateLatchRingBenchmarkItem
+{
+    uint32_t X, Y;
+    uint64_t Timestamp;
+    uint64_t Check;
+};
+
+#define LATE_LATCH_RING_BENCHMARK_SIZE 16384
+
+typedef LateLatchRing<LateLatchRingBenchmarkItem, LATE_LATCH_RING_BENCHMARK_SIZE> LateLatchRingBenchmarkRing;
+
+static LateLatchRingStorage<LateLatchRingBenchmarkItem, LATE_LATCH_RING_BENCHMARK_SIZE> g_LateLatchRingBenchmarkStorage;
+
+static uint64_t LateLatchRingBenchmark_Check(uint32_t x, uint32_t y, uint64_t timestamp)
+{
+    return (((uint64_t)x << 32) | y) ^ (timestamp * 0x9E3779B97F4A7C15ull);
+}
+
+static void LateLatchRingBenchmark_Publish(LateLatchRingBenchmarkRing& ring, int producer, int publishes)
+{
+    for (int i = 0; i < publishes; i++)
+    {
+        uint64_t now = GetClock()->NowNs();
+        ring.Publish(LateLatchRingBenchmarkItem{ (uint32_t)producer, (uint32_t)i, now, LateLatchRingBenchmark_Check(producer, i, now) });
+    }
+}
+
+LateLatchRingBenchmarkResult LateLatchRingBenchmark_Run(int producers, int publishesPerProducer)
+{
+    LateLatchRingBenchmarkResult result = {};
+    result.Producers = producers;
+    result.Publishes = publishesPerProducer;
+
+    LateLatchRingBenchmarkRing ring;
+    LateLatchRingBenchmarkItem initial = { 0, 0, 0, LateLatchRingBenchmark_Check(0, 0, 0) };
+
+    ring.Init(g_LateLatchRingBenchmarkStorage.Slots, &g_LateLatchRingBenchmarkStorage.Published, initial);
+    uint64_t start = GetClock()->NowNs();
+    LateLatchRingBenchmark_Publish(ring, 0, publishesPerProducer);
+    result.SingleProducerNs = GetClock()->NowNs() - start;
+
+    ring.Init(g_LateLatchRingBenchmarkStorage.Slots, &g_LateLatchRingBenchmarkStorage.Published, initial);
+    std::atomic<int> producersStarted(0);
+    std::atomic<int> producersDone(0);
+    std::atomic<uint64_t> contendedNs(0);
+    std::vector<std::thread> threads;
+    for (int p = 0; p < producers; p++)
+    {
+        threads.push_back(std::thread([&, p] {
+            // Start together, so they all contend
+            producersStarted++;
+            while (producersStarted.load() < producers)
+            {
+                std::this_thread::yield();
+            }
+
+            uint64_t producerStart = GetClock()->NowNs();
+            LateLatchRingBenchmark_Publish(ring, p, publishesPerProducer);
+            contendedNs += GetClock()->NowNs() - producerStart;
+            producersDone++;
+        }));
+    }
+
+    uint32_t lastTicket = 0;
+    uint64_t readStart = GetClock()->NowNs();
+    while (producersDone.load() < producers)
+    {
+        LateLatchRingBenchmarkItem item;
+        uint32_t ticket = ring.ReadLatest(&item);
+        uint64_t now = GetClock()->NowNs();
+        result.Reads++;
+
+        if (item.Check != LateLatchRingBenchmark_Check(item.X, item.Y, item.Timestamp))
+        {
+            result.Mismatches++;
+        }
+        else if (ticket != lastTicket)
+        {
+            uint64_t latency = now > item.Timestamp ? now - item.Timestamp : 0;
+            result.NewSamples++;
+            result.LatchLatencyNs += latency;
+            result.MaxLatchLatencyNs = latency > result.MaxLatchLatencyNs ? latency : result.MaxLatchLatencyNs;
+            lastTicket = ticket;
+        }
+    }
+    result.ReadNs = GetClock()->NowNs() - readStart;
+
+    for (std::thread& thread : threads)
+    {
+        thread.join();
+    }
+    result.ContendedNs = contendedNs.load();
+
+    return result;
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+// Microbenchmark of LateLatchRing with the input samples of main.cpp, in a ring of the same size.
+//
+// - Publish: one producer alone, then several producers at once, which contend on the ticket and published counters.
+// - Latch: a consumer reading the latest sample while the producers run, like the GPU does once per frame but as
+//   often as it can. The age of each new sample it sees is the latency from publish to latch. Every sample is
+//   also checked for torn reads.
+
+#include <cstdint>
+
+struct LateLatchRingBenchmarkResult
+{
+    int      Producers;
+    uint64_t Publishes;             // Per producer
+    uint64_t SingleProducerNs;      // Publishes of one producer alone
+    uint64_t ContendedNs;           // Publishes of all the producers at once, summed over the producers
+    uint64_t Reads;                 // ReadLatest calls of the consumer while the producers ran
+    uint64_t ReadNs;                // Including reading the clock after each
+    uint64_t NewSamples;            // Reads that found a newer ticket than the previous read
+    uint64_t LatchLatencyNs;        // Sum over the new samples of the time from their publish to their read
+    uint64_t MaxLatchLatencyNs;
+    uint32_t Mismatches;            // Torn samples, should always be 0
+};
+
+LateLatchRingBenchmarkResult LateLatchRingBenchmark_Run(int producers, int publishesPerProducer);
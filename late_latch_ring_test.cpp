@@ -0,0 +1,131 @@
+#include "self_test.h"
+
+#include "late_latch_ring.h"
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+// Big enough to be copied in several stores, so a torn read mixes two samples and fails the check.
+struct LateLatchRingTestItem
+{
+    uint32_t Producer;
+    uint32_t Count;         // Samples the producer published before this one
+    uint64_t Payload[6];
+    uint64_t Check;
+};
+
+#define LATE_LATCH_RING_TEST_SIZE 16384
+#define LATE_LATCH_RING_TEST_PUBLISHES 200000
+
+typedef LateLatchRing<LateLatchRingTestItem, LATE_LATCH_RING_TEST_SIZE> LateLatchRingTestRing;
+
+static LateLatchRingStorage<LateLatchRingTestItem, LATE_LATCH_RING_TEST_SIZE> g_LateLatchRingTestStorage;
+
+static uint64_t LateLatchRingTest_Checksum(const LateLatchRingTestItem& item)
+{
+    uint64_t check = ((uint64_t)item.Producer << 32) | item.Count;
+    for (uint64_t payload : item.Payload)
+        check = (check ^ payload) * 0x100000001B3ull;
+    return check;
+}
+
+static LateLatchRingTestItem LateLatchRingTest_Make(uint32_t producer, uint32_t count)
+{
+    LateLatchRingTestItem item;
+    item.Producer = producer;
+    item.Count = count;
+    for (int i = 0; i < 6; i++)
+        item.Payload[i] = (((uint64_t)producer << 32) | count) * (i + 1);
+    item.Check = LateLatchRingTest_Checksum(item);
+    return item;
+}
+
+// Producers publish as fast as they can while a consumer reads the latest sample and recent ones by ticket, which
+// laps the ring many times. Every value read has to be whole, and the latest ticket must never go backwards.
+SelfTestResult LateLatchRingTest_RunStress()
+{
+    SelfTestResult result = {};
+
+    // One core is left to the consumer. More producers than cores would stall writers mid-slot for longer than
+    // a lap of the ring, which the ring assumes never happens.
+    int producerCount = std::max(1, std::min(4, (int)std::thread::hardware_concurrency() - 1));
+
+    LateLatchRingTestRing ring;
+    ring.Init(g_LateLatchRingTestStorage.Slots, &g_LateLatchRingTestStorage.Published, LateLatchRingTest_Make(0xFFFFFFFF, 0));
+
+    std::atomic<int> producersDone(0);
+    std::vector<std::thread> producers;
+    for (int p = 0; p < producerCount; p++)
+    {
+        producers.push_back(std::thread([&ring, &producersDone, p] {
+            for (uint32_t i = 0; i < LATE_LATCH_RING_TEST_PUBLISHES; i++)
+            {
+                ring.Publish(LateLatchRingTest_Make(p, i));
+            }
+            producersDone++;
+        }));
+    }
+
+    uint32_t reads = 0;
+    uint32_t torn = 0;
+    uint32_t backwards = 0;
+    uint32_t lastTicket = 0;
+    std::vector<uint32_t> lastCounts(producerCount, 0);
+    uint32_t countsBackwards = 0;
+    while (producersDone.load() < producerCount)
+    {
+        LateLatchRingTestItem item;
+        uint32_t ticket = ring.ReadLatest(&item);
+        reads++;
+        if (item.Check != LateLatchRingTest_Checksum(item))
+            torn++;
+        if ((int32_t)(ticket - lastTicket) < 0)
+            backwards++;
+        lastTicket = ticket;
+
+        // A producer's samples get increasing tickets, so the latest one can't be older than one seen before.
+        if (item.Producer < (uint32_t)producerCount)
+        {
+            if (item.Count < lastCounts[item.Producer])
+                countsBackwards++;
+            lastCounts[item.Producer] = item.Count;
+        }
+
+        // Tickets that may be overwritten while they're read
+        for (uint32_t back = 1; back < LATE_LATCH_RING_TEST_SIZE; back *= 4)
+        {
+            if (ring.TryRead(ticket - back, &item) && item.Check != LateLatchRingTest_Checksum(item))
+                torn++;
+        }
+    }
+
+    for (std::thread& producer : producers)
+        producer.join();
+
+    SELF_TEST_CHECK(result, reads > 0);
+    SELF_TEST_CHECK(result, torn == 0);
+    SELF_TEST_CHECK(result, backwards == 0);
+    SELF_TEST_CHECK(result, countsBackwards == 0);
+
+    // Every publish got its own ticket, and the last one is published.
+    uint32_t total = (uint32_t)producerCount * LATE_LATCH_RING_TEST_PUBLISHES;
+    SELF_TEST_CHECK(result, ring.LatestTicket() == total);
+
+    // The last lap is still in the ring, anything older has been overwritten.
+    LateLatchRingTestItem item;
+    SELF_TEST_CHECK(result, ring.TryRead(total, &item) && item.Check == LateLatchRingTest_Checksum(item));
+    SELF_TEST_CHECK(result, ring.TryRead(total - LATE_LATCH_RING_TEST_SIZE + 1, &item));
+    SELF_TEST_CHECK(result, !ring.TryRead(total - LATE_LATCH_RING_TEST_SIZE, &item));
+
+    // Restarting the tickets keeps the latest value readable as ticket 0, and forgets the older ones.
+    LateLatchRingTestItem latest;
+    ring.ReadLatest(&latest);
+    ring.Reinit(latest);
+    SELF_TEST_CHECK(result, ring.LatestTicket() == 0 && ring.TryRead(0, &item) && item.Check == latest.Check);
+    SELF_TEST_CHECK(result, !ring.TryRead(total, &item) && !ring.TryRead(1, &item));
+    SELF_TEST_CHECK(result, ring.Publish(latest) == 1);
+
+    return result;
+}
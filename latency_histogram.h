@@ -0,0 +1,178 @@
+#pragma once
+
+// Lock-free histogram of nanosecond latencies with HDR-style log-linear buckets.
+//
+// Values below 2^LATENCY_HISTOGRAM_SUB_BUCKET_BITS are counted exactly.
+// Above that, every power of two is split into 2^LATENCY_HISTOGRAM_SUB_BUCKET_BITS linear sub-buckets,
+// so the reported percentiles are within ~3% of the recorded values regardless of magnitude.
+//
+// Record() can be called from any thread. Readers (percentiles, CSV dump) see a consistent-enough snapshot
+// for display purposes: each bucket is read atomically, but not all buckets at the same instant.
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+#define LATENCY_HISTOGRAM_SUB_BUCKET_BITS 5
+#define LATENCY_HISTOGRAM_MAX_MSB 47 // ~39 hours in nanoseconds, larger values are clamped.
+
+class LatencyHistogram
+{
+public:
+    static const int SubBucketCount = 1 << LATENCY_HISTOGRAM_SUB_BUCKET_BITS;
+    static const int BucketCount = SubBucketCount + (LATENCY_HISTOGRAM_MAX_MSB - LATENCY_HISTOGRAM_SUB_BUCKET_BITS + 1) * SubBucketCount;
+
+    LatencyHistogram()
+    {
+        Reset();
+    }
+
+    void Reset()
+    {
+        for (int i = 0; i < BucketCount; i++)
+        {
+            Counts[i].store(0, std::memory_order_relaxed);
+        }
+        TotalCount.store(0, std::memory_order_relaxed);
+        MinValue.store(UINT64_MAX, std::memory_order_relaxed);
+        MaxValue.store(0, std::memory_order_relaxed);
+    }
+
+    void Record(uint64_t ns)
+    {
+        Counts[BucketIndex(ns)].fetch_add(1, std::memory_order_relaxed);
+        TotalCount.fetch_add(1, std::memory_order_relaxed);
+
+        uint64_t prev = MinValue.load(std::memory_order_relaxed);
+        while (ns < prev && !MinValue.compare_exchange_weak(prev, ns, std::memory_order_relaxed)) { }
+        prev = MaxValue.load(std::memory_order_relaxed);
+        while (ns > prev && !MaxValue.compare_exchange_weak(prev, ns, std::memory_order_relaxed)) { }
+    }
+
+    uint64_t Count() const { return TotalCount.load(std::memory_order_relaxed); }
+    uint64_t Min() const { uint64_t m = MinValue.load(std::memory_order_relaxed); return m == UINT64_MAX ? 0 : m; }
+    uint64_t Max() const { return MaxValue.load(std::memory_order_relaxed); }
+
+    // Returns the highest value equivalent to the given percentile (0..100), or 0 if nothing was recorded.
+    uint64_t Percentile(double percentile) const
+    {
+        uint64_t counts[BucketCount];
+        uint64_t total = 0;
+        for (int i = 0; i < BucketCount; i++)
+        {
+            counts[i] = Counts[i].load(std::memory_order_relaxed);
+            total += counts[i];
+        }
+
+        if (total == 0)
+        {
+            return 0;
+        }
+
+        uint64_t target = (uint64_t)(percentile / 100.0 * (double)total + 0.5);
+        if (target < 1) target = 1;
+        if (target > total) target = total;
+
+        uint64_t cumulative = 0;
+        for (int i = 0; i < BucketCount; i++)
+        {
+            cumulative += counts[i];
+            if (cumulative >= target)
+            {
+                uint64_t upper = BucketUpperBound(i);
+                uint64_t max = Max();
+                return upper < max ? upper : max;
+            }
+        }
+
+        return Max();
+    }
+
+    // One row per non-empty bucket: lower_ns,upper_ns,count,cumulative_fraction
+    void WriteCSV(FILE* f) const
+    {
+        uint64_t total = Count();
+
+        fprintf(f, "lower_ns,upper_ns,count,cumulative_fraction\n");
+
+        uint64_t cumulative = 0;
+        for (int i = 0; i < BucketCount; i++)
+        {
+            uint64_t count = Counts[i].load(std::memory_order_relaxed);
+            if (count == 0)
+            {
+                continue;
+            }
+
+            cumulative += count;
+            fprintf(f, "%llu,%llu,%llu,%f\n",
+                (unsigned long long)BucketLowerBound(i),
+                (unsigned long long)BucketUpperBound(i),
+                (unsigned long long)count,
+                total ? (double)cumulative / (double)total : 0.0);
+        }
+    }
+
+    static int BucketIndex(uint64_t ns)
+    {
+        if (ns < (uint64_t)SubBucketCount)
+        {
+            return (int)ns;
+        }
+
+        int msb = MostSignificantBit(ns);
+        if (msb > LATENCY_HISTOGRAM_MAX_MSB)
+        {
+            return BucketCount - 1;
+        }
+
+        int shift = msb - LATENCY_HISTOGRAM_SUB_BUCKET_BITS;
+        int sub = (int)(ns >> shift) - SubBucketCount;
+        return SubBucketCount + shift * SubBucketCount + sub;
+    }
+
+    static uint64_t BucketLowerBound(int index)
+    {
+        if (index < SubBucketCount)
+        {
+            return (uint64_t)index;
+        }
+
+        int shift = (index - SubBucketCount) / SubBucketCount;
+        int sub = (index - SubBucketCount) % SubBucketCount;
+        return (uint64_t)(SubBucketCount + sub) << shift;
+    }
+
+    static uint64_t BucketUpperBound(int index)
+    {
+        if (index < SubBucketCount)
+        {
+            return (uint64_t)index;
+        }
+
+        int shift = (index - SubBucketCount) / SubBucketCount;
+        return BucketLowerBound(index) + ((uint64_t)1 << shift) - 1;
+    }
+
+private:
+    // x must be non-zero
+    static int MostSignificantBit(uint64_t x)
+    {
+#ifdef _MSC_VER
+        unsigned long msb;
+        _BitScanReverse64(&msb, x);
+        return (int)msb;
+#else
+        return 63 - __builtin_clzll(x);
+#endif
+    }
+
+    std::atomic<uint64_t> Counts[BucketCount];
+    std::atomic<uint64_t> TotalCount;
+    std::atomic<uint64_t> MinValue;
+    std::atomic<uint64_t> MaxValue;
+};
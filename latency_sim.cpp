@@ -0,0 +1,334 @@
+#include "latency_sim.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <random>
+#include <thread>
+#include <vector>
+
+#define LATENCY_SIM_MAX_FRAMES_IN_FLIGHT 8
+#define LATENCY_SIM_CPU_WORK_MS 200
+
+typedef int64_t SimTime; // nanoseconds on the virtual clock
+
+static SimTime MsToSimTime(double ms)
+{
+    return SimTime(ms * 1e6);
+}
+
+void LatencySim_DefaultConfig(LatencySimConfig* config)
+{
+    config->LatchMode = LATCHMODE_LATE;
+    config->RefreshHz = 60.0;
+    config->SwapInterval = 1;
+    config->AdaptiveVSync = false;
+    config->SleepBeforeDrawMs = 0;
+    config->SimulateCPUWork = false;
+    config->FinishAtEndOfFrame = true;
+    config->MaxFramesInFlight = 3;
+    config->SleepGranularityMs = 1.0;
+    config->CPUFrameMs = 1.0;
+    config->CPUJitterMs = 0.25;
+    config->GPUFrameMs = 0.5;
+    config->InputRateHz = 1000.0;
+    config->OSEventDelayMs = 0.5;
+    config->DurationSeconds = 10.0;
+    config->Seed = 1;
+}
+
+struct LatencySimInput
+{
+    SimTime Interval;
+    SimTime Phase;
+    SimTime Delay;
+
+    // Time at which the most recent mouse report that reached the window thread by 't' was generated, or -1 if none did.
+    SimTime LatestEventBefore(SimTime t) const
+    {
+        SimTime sinceFirst = t - Delay - Phase;
+        if (sinceFirst < 0)
+        {
+            return -1;
+        }
+        return Phase + (sinceFirst / Interval) * Interval;
+    }
+};
+
+// Sleep() sleeps for at least the requested time, in multiples of the timer resolution.
+static SimTime SimulateSleep(int ms, SimTime granularity)
+{
+    SimTime requested = MsToSimTime(ms);
+    if (granularity <= 0)
+    {
+        return requested;
+    }
+    return ((requested + granularity - 1) / granularity) * granularity;
+}
+
+// First time at or after 't' at which scanout reaches the row at 'row' (0 = top, 1 = bottom) of the screen.
+static SimTime ScanoutTime(SimTime t, double row, SimTime period)
+{
+    SimTime rowOffset = SimTime(row * double(period));
+    SimTime k = (t - rowOffset + period - 1) / period;
+    return k * period + rowOffset;
+}
+
+static void RunSetCursor(const LatencySimInput& input, SimTime period, SimTime duration, std::mt19937_64& rng, LatencySimResult* result)
+{
+    std::uniform_real_distribution<double> rowDistribution(0.0, 1.0);
+
+    // The OS moves the hardware cursor independently of our frames: the position it uses is sampled at vblank.
+    for (SimTime vblank = period; vblank < duration; vblank += period)
+    {
+        SimTime eventTime = input.LatestEventBefore(vblank);
+        if (eventTime < 0)
+        {
+            continue;
+        }
+
+        SimTime photon = vblank + SimTime(rowDistribution(rng) * double(period));
+        result->InputToPhoton.Record(uint64_t(photon - eventTime));
+        result->FramesDisplayed++;
+    }
+
+    result->FramesSimulated = result->FramesDisplayed;
+    result->AverageFrameMs = double(period) / 1e6;
+}
+
+void LatencySim_Run(const LatencySimConfig& config, LatencySimResult* result)
+{
+    result->InputToPhoton.Reset();
+    result->FramesSimulated = 0;
+    result->FramesDisplayed = 0;
+    result->AverageFrameMs = 0.0;
+
+    std::mt19937_64 rng(config.Seed);
+    std::uniform_real_distribution<double> unitDistribution(0.0, 1.0);
+
+    const SimTime period = SimTime(1e9 / config.RefreshHz);
+    const SimTime duration = SimTime(config.DurationSeconds * 1e9);
+    const SimTime granularity = MsToSimTime(config.SleepGranularityMs);
+
+    LatencySimInput input;
+    input.Interval = std::max<SimTime>(1, SimTime(1e9 / config.InputRateHz));
+    input.Phase = SimTime(unitDistribution(rng) * double(input.Interval));
+    input.Delay = MsToSimTime(config.OSEventDelayMs);
+
+    if (config.LatchMode == LATCHMODE_SETCURSOR)
+    {
+        RunSetCursor(input, period, duration, rng, result);
+        return;
+    }
+
+    const int framesInFlight = std::max(1, std::min(config.MaxFramesInFlight, LATENCY_SIM_MAX_FRAMES_IN_FLIGHT));
+    SimTime presentHistory[LATENCY_SIM_MAX_FRAMES_IN_FLIGHT] = {};
+
+    SimTime cpuTime = 0;
+    SimTime gpuFree = 0;
+    SimTime lastPresent = 0;
+    SimTime lastPresentVblank = 0;
+
+    // A frame's cursor row is only seen if the next frame doesn't flip before scanout reaches it (tearing).
+    bool hasPending = false;
+    SimTime pendingPhoton = 0;
+    SimTime pendingEventTime = 0;
+
+    uint64_t frame = 0;
+    for (; cpuTime < duration; frame++)
+    {
+        // ImGui_Impl_NewFrame, building the GUI, ImGui::Render and submitting the cursor
+        cpuTime += MsToSimTime(config.CPUFrameMs + config.CPUJitterMs * unitDistribution(rng));
+
+        if (config.SimulateCPUWork)
+        {
+            cpuTime += SimulateSleep(LATENCY_SIM_CPU_WORK_MS, granularity);
+        }
+
+        if (config.SleepBeforeDrawMs > 0)
+        {
+            cpuTime += SimulateSleep(config.SleepBeforeDrawMs, granularity);
+        }
+
+        SimTime submitTime = cpuTime;
+
+        // Double buffering: the back buffer is the one that was on screen until the previous flip.
+        SimTime gpuStart = std::max(submitTime, std::max(gpuFree, lastPresent));
+        SimTime gpuDone = gpuStart + MsToSimTime(config.GPUFrameMs);
+        gpuFree = gpuDone;
+
+        // The late-latched vertex shader runs at the very end of the frame, the uniform was set at submission.
+        SimTime sampleTime = config.LatchMode == LATCHMODE_LATE ? gpuDone : submitTime;
+
+        // SwapBuffers
+        SimTime presentTime;
+        bool vsync = config.AdaptiveVSync || config.SwapInterval > 0;
+        if (!vsync)
+        {
+            presentTime = gpuDone;
+        }
+        else
+        {
+            int interval = config.AdaptiveVSync ? 1 : config.SwapInterval;
+            SimTime targetVblank = lastPresentVblank + interval * period;
+            SimTime nextVblank = ((gpuDone + period - 1) / period) * period;
+
+            if (config.AdaptiveVSync && frame > 0 && gpuDone > targetVblank)
+            {
+                // Missed the vblank: adaptive VSync tears instead of waiting for the next one.
+                presentTime = gpuDone;
+                lastPresentVblank = nextVblank - period;
+            }
+            else
+            {
+                presentTime = std::max(nextVblank, targetVblank);
+                lastPresentVblank = presentTime;
+            }
+        }
+
+        if (hasPending)
+        {
+            if (presentTime > pendingPhoton)
+            {
+                result->InputToPhoton.Record(uint64_t(pendingPhoton - pendingEventTime));
+                result->FramesDisplayed++;
+            }
+            hasPending = false;
+        }
+
+        SimTime eventTime = config.LatchMode == LATCHMODE_LATE || config.LatchMode == LATCHMODE_UNIFORM ? input.LatestEventBefore(sampleTime) : -1;
+        if (eventTime >= 0)
+        {
+            hasPending = true;
+            pendingPhoton = ScanoutTime(presentTime, unitDistribution(rng), period);
+            pendingEventTime = eventTime;
+        }
+
+        lastPresent = presentTime;
+
+        if (config.FinishAtEndOfFrame)
+        {
+            // glFinish returns once the swap has been executed.
+            cpuTime = std::max(cpuTime, presentTime);
+        }
+        else
+        {
+            // SwapBuffers blocks when too many frames are queued.
+            SimTime oldestPresent = presentHistory[frame % framesInFlight];
+            if (frame >= uint64_t(framesInFlight))
+            {
+                cpuTime = std::max(cpuTime, oldestPresent);
+            }
+        }
+        presentHistory[frame % framesInFlight] = presentTime;
+    }
+
+    if (hasPending)
+    {
+        result->InputToPhoton.Record(uint64_t(pendingPhoton - pendingEventTime));
+        result->FramesDisplayed++;
+    }
+
+    result->FramesSimulated = frame;
+    result->AverageFrameMs = frame > 0 ? double(cpuTime) / double(frame) / 1e6 : 0.0;
+}
+
+void LatencySim_RunGrid(const LatencySimConfig* configs, LatencySimResult* results, int count, int threadCount)
+{
+    if (threadCount <= 0)
+    {
+        threadCount = std::max(1, (int)std::thread::hardware_concurrency());
+    }
+    threadCount = std::min(threadCount, count);
+
+    std::atomic<int> nextConfig(0);
+    auto Worker = [&]
+    {
+        for (;;)
+        {
+            int i = nextConfig.fetch_add(1, std::memory_order_relaxed);
+            if (i >= count)
+            {
+                return;
+            }
+            LatencySim_Run(configs[i], &results[i]);
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (int i = 1; i < threadCount; i++)
+    {
+        threads.push_back(std::thread(Worker));
+    }
+    Worker();
+    for (std::thread& thread : threads)
+    {
+        thread.join();
+    }
+}
+
+void LatencySim_WriteCSVHeader(FILE* f)
+{
+    fprintf(f, "latch_mode,refresh_hz,swap_interval,adaptive_vsync,sleep_before_draw_ms,simulate_cpu_work,finish_at_end_of_frame,"
+               "cpu_frame_ms,gpu_frame_ms,input_rate_hz,frames,frames_displayed,avg_frame_ms,p50_ms,p99_ms,p99_9_ms,max_ms\n");
+}
+
+void LatencySim_WriteCSVRow(FILE* f, const LatencySimConfig& config, const LatencySimResult& result)
+{
+    static const char* kModeNames[LATCHMODE_COUNT] = { "late", "uniform", "setcursor", "all" };
+
+    const LatencyHistogram& h = result.InputToPhoton;
+    fprintf(f, "%s,%g,%d,%d,%d,%d,%d,%g,%g,%g,%llu,%llu,%.3f,%.3f,%.3f,%.3f,%.3f\n",
+        config.LatchMode >= 0 && config.LatchMode < LATCHMODE_COUNT ? kModeNames[config.LatchMode] : "?",
+        config.RefreshHz, config.SwapInterval, (int)config.AdaptiveVSync, config.SleepBeforeDrawMs,
+        (int)config.SimulateCPUWork, (int)config.FinishAtEndOfFrame,
+        config.CPUFrameMs, config.GPUFrameMs, config.InputRateHz,
+        (unsigned long long)result.FramesSimulated, (unsigned long long)result.FramesDisplayed, result.AverageFrameMs,
+        h.Percentile(50.0) / 1e6, h.Percentile(99.0) / 1e6, h.Percentile(99.9) / 1e6, h.Max() / 1e6);
+}
+
+#ifdef LATENCY_SIM_MAIN
+// Sweeps every latch mode against the vsync and sleep settings exposed in the GUI, and prints one CSV row per combination.
+int main()
+{
+    std::vector<LatencySimConfig> configs;
+
+    const int kModes[] = { LATCHMODE_LATE, LATCHMODE_UNIFORM, LATCHMODE_SETCURSOR };
+    const int kSwapIntervals[] = { 0, 1, 2, -1 }; // -1 is adaptive VSync
+    const int kSleepsBeforeDraw[] = { 0, 2, 4, 8, 12, 14 };
+    const bool kFinish[] = { true, false };
+
+    for (int mode : kModes)
+    {
+        for (int swapInterval : kSwapIntervals)
+        {
+            for (int sleepBeforeDraw : kSleepsBeforeDraw)
+            {
+                for (bool finish : kFinish)
+                {
+                    LatencySimConfig config;
+                    LatencySim_DefaultConfig(&config);
+                    config.LatchMode = mode;
+                    config.SwapInterval = swapInterval < 0 ? 0 : swapInterval;
+                    config.AdaptiveVSync = swapInterval < 0;
+                    config.SleepBeforeDrawMs = sleepBeforeDraw;
+                    config.FinishAtEndOfFrame = finish;
+                    config.Seed = configs.size() + 1;
+                    configs.push_back(config);
+                }
+            }
+        }
+    }
+
+    std::vector<LatencySimResult> results(configs.size());
+    LatencySim_RunGrid(configs.data(), results.data(), (int)configs.size(), 0);
+
+    LatencySim_WriteCSVHeader(stdout);
+    for (size_t i = 0; i < configs.size(); i++)
+    {
+        LatencySim_WriteCSVRow(stdout, configs[i], results[i]);
+    }
+
+    return 0;
+}
+#endif
@@ -0,0 +1,59 @@
+#pragma once
+
+// Discrete-event model of the main loop in main.cpp, used to predict input-to-photon latency without a display.
+//
+// Everything runs on a virtual nanosecond clock, so results are deterministic for a given seed and
+// a parameter grid can be swept in parallel on a headless machine.
+//
+// Modeled per frame: the CPU work of building and submitting the GUI, Sleep(sleepBeforeDraw) and the simulated
+// CPU work with the OS timer granularity, the GPU executing the frame (and the late-latch happening when the
+// cursor's vertex shader runs), SwapBuffers with the swap interval or adaptive VSync, glFinish at end of frame
+// (or the driver's frames-in-flight limit without it), and scanout of the row that contains the cursor.
+// Input events arrive periodically from the mouse and are delivered to the window thread after an OS delay.
+//
+// Build with LATENCY_SIM_MAIN defined to get a command-line driver that sweeps a default grid and prints CSV.
+
+#include "latch_mode.h"
+#include "latency_histogram.h"
+
+#include <cstdint>
+#include <cstdio>
+
+struct LatencySimConfig
+{
+    int LatchMode;              // LATCHMODE_LATE, LATCHMODE_UNIFORM or LATCHMODE_SETCURSOR
+    double RefreshHz;
+    int SwapInterval;           // Ignored if AdaptiveVSync
+    bool AdaptiveVSync;         // WGL_EXT_swap_control_tear with interval -1
+    int SleepBeforeDrawMs;
+    bool SimulateCPUWork;       // Sleep(200) in the main loop
+    bool FinishAtEndOfFrame;
+    int MaxFramesInFlight;      // Driver queue depth when not calling glFinish
+    double SleepGranularityMs;  // Sleep() rounds up to the OS timer resolution
+    double CPUFrameMs;          // ImGui_Impl_NewFrame + building the GUI + ImGui::Render + cursor submission
+    double CPUJitterMs;         // Uniformly distributed extra CPU time per frame
+    double GPUFrameMs;          // GPU time of the frame before the cursor is drawn
+    double InputRateHz;         // Mouse polling rate
+    double OSEventDelayMs;      // Time from the mouse report to the window thread publishing it
+    double DurationSeconds;
+    uint64_t Seed;
+};
+
+struct LatencySimResult
+{
+    LatencyHistogram InputToPhoton;
+    uint64_t FramesSimulated;
+    uint64_t FramesDisplayed;   // Frames of which at least the cursor row was scanned out
+    double AverageFrameMs;
+};
+
+// Reasonable defaults for a 60Hz monitor and a light GUI.
+void LatencySim_DefaultConfig(LatencySimConfig* config);
+
+void LatencySim_Run(const LatencySimConfig& config, LatencySimResult* result);
+
+// Runs every config on 'threadCount' threads (0 means one per core). results must have room for 'count' entries.
+void LatencySim_RunGrid(const LatencySimConfig* configs, LatencySimResult* results, int count, int threadCount);
+
+void LatencySim_WriteCSVHeader(FILE* f);
+void LatencySim_WriteCSVRow(FILE* f, const LatencySimConfig& config, const LatencySimResult& result);
@@ -1,3 +1,7 @@
+#if defined(_MSC_VER) && !defined(_CRT_SECURE_NO_WARNINGS)
+#define _CRT_SECURE_NO_WARNINGS
+#endif
+
 #include <Windows.h>
 #include <Windowsx.h>
 
@@ -7,25 +11,39 @@
 #include "imgui_impl.h"
 #include "imgui.h"
 
+#include "latch_mode.h"
+#include "late_latch_ring.h"
+#include "latency_histogram.h"
+#include "input_trace.h"
+#include "frame_scheduler.h"
+#include "clock.h"
+#include "ani_cursor.h"
+#include "profiler.h"
+#include "gl_state_cache.h"
+#include "gui_allocator.h"
+#include "shader_cache.h"
+#include "soft_renderer.h"
+#include "hash_benchmark.h"
+#include "window_benchmark.h"
+#include "storage_benchmark.h"
+#include "opengl_benchmark.h"
+#include "late_latch_ring_benchmark.h"
+#include "spsc_queue_benchmark.h"
+#include "self_test.h"
+
 #include <cstdio>
 #include <cstdlib>
 #include <cstdint>
+#include <cstring>
 #include <cassert>
 #include <string>
+#include <vector>
 #include <thread>
 #include <future>
+#include <mutex>
 
 #pragma comment(lib, "opengl32.lib")
 
-enum LatchMode
-{
-    LATCHMODE_LATE,
-    LATCHMODE_UNIFORM,
-    LATCHMODE_SETCURSOR,
-    LATCHMODE_ALL,
-    LATCHMODE_COUNT
-};
-
 int g_CurrLatchMode;
 
 #define RENDER_WIDTH 1280
@@ -34,19 +52,34 @@ int g_CurrLatchMode;
 struct InputBufferItem
 {
     GLuint x, y;
+    uint64_t timestamp; // GetClock()->NowNs() when the input was received. The sequence number is the ring ticket.
 };
 
-#define INPUT_BUFFER_ITEM_SIZE_IN_DWORDS (sizeof(InputBufferItem) / 4)
-#define INPUT_BUFFER_ITEM_X_OFFSET (offsetof(InputBufferItem, x) / 4)
-#define INPUT_BUFFER_ITEM_Y_OFFSET (offsetof(InputBufferItem, y) / 4)
-
 #define INPUT_BUFFER_SIZE 16384
 static_assert((INPUT_BUFFER_SIZE & (INPUT_BUFFER_SIZE - 1)) == 0, "");
 
-#define INPUT_BUFFER_SIZE_IN_BYTES (INPUT_BUFFER_SIZE * sizeof(InputBufferItem))
+typedef LateLatchRing<InputBufferItem, INPUT_BUFFER_SIZE> InputRing;
+
+// The GPU reads the ring's slots directly, so the shader offsets are derived from the slot layout.
+#define INPUT_BUFFER_ITEM_SIZE_IN_DWORDS (sizeof(InputRing::Slot) / 4)
+#define INPUT_BUFFER_ITEM_X_OFFSET ((offsetof(InputRing::Slot, Value) + offsetof(InputBufferItem, x)) / 4)
+#define INPUT_BUFFER_ITEM_Y_OFFSET ((offsetof(InputRing::Slot, Value) + offsetof(InputBufferItem, y)) / 4)
+
+#define INPUT_BUFFER_SIZE_IN_BYTES (INPUT_BUFFER_SIZE * sizeof(InputRing::Slot))
+
+// Value of LatchedCounter before any vertex latched. Tickets never reach it, since PublishLateLatchInput() restarts them
+// at InputRing::MaxTicket.
+#define LATCH_RESET_VALUE 0xFFFFFFFF
 
 #define CURSOR_SIZE 32
 
+// Number of frames of latched counters that can be in flight before being read back
+#define LATCH_READBACK_FRAMES 4
+// Number of frames of latch history kept for the CSV dump
+#define LATCH_HISTORY_SIZE 1024
+// Number of frames of GPU timer queries in flight
+#define GPU_TIMER_FRAMES 4
+
 // GLSL bindings
 #define INPUT_BUFFER_SSBO_BINDING           0
 #define INPUT_COUNTER_BUFFER_SSBO_BINDING   1
@@ -57,15 +90,14 @@ static_assert((INPUT_BUFFER_SIZE & (INPUT_BUFFER_SIZE - 1)) == 0, "");
 #define PROJECTION_MATRIX_UNIFORM_LOCATION 0
 #define INPUT_UNIFORM_LOCATION             1
 #define TINT_UNIFORM_LOCATION              2
+#define CURSOR_FRAME_UNIFORM_LOCATION      3
 
 void GLAPIENTRY DebugCallbackGL(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length, const GLchar *message, const void *userParam)
 {
     fprintf(stderr, "DebugCallbackGL: %s\n", message);
 }
 
-volatile InputBufferItem* g_MappedInputBufferItems;
-volatile uint32_t* g_MappedInputCounter;
-uint32_t g_InputCounter;
+InputRing g_InputRing;
 
 static HCURSOR hCustomCursor = LoadCursorFromFile(TEXT("Ragnarok.ani"));
 
@@ -73,23 +105,78 @@ bool g_HideCursor;
 
 bool g_NoSleepWindowThread;
 
-void UpdateLateLatchBuffer(int x, int y)
+#define INPUT_TRACE_PATH "input_trace.bin"
+#define SOFT_RENDERER_TGA_PATH "gui_soft.tga"
+
+// Recording is toggled by the render thread while the window thread records, so the writer is protected by a mutex.
+std::atomic<bool> g_RecordingTrace;
+std::mutex g_TraceWriterMutex;
+InputTraceWriter g_TraceWriter;
+
+// While a trace is replaying, live input is ignored so it doesn't interleave with the replayed samples.
+std::atomic<bool> g_ReplayingTrace;
+volatile bool g_CancelReplay;
+
+void PublishLateLatchInput(int x, int y, uint64_t timestamp)
 {
-    if ((g_CurrLatchMode == LATCHMODE_LATE || g_CurrLatchMode == LATCHMODE_ALL) && g_MappedInputBufferItems && g_MappedInputCounter)
+    if ((g_CurrLatchMode == LATCHMODE_LATE || g_CurrLatchMode == LATCHMODE_ALL) && g_InputRing.IsAttached())
     {
-        LONG inputCounter = InterlockedAdd((LONG*)&g_InputCounter, 1);
-        inputCounter = inputCounter & (INPUT_BUFFER_SIZE - 1);
+        // Live input and trace replay never publish at the same time, so this is the only producer
+        InputBufferItem item = { GLuint(x), GLuint(y), timestamp };
+        if (g_InputRing.Publish(item) == InputRing::MaxTicket)
+        {
+            g_InputRing.Reinit(item);
+        }
+    }
+}
 
-        g_MappedInputBufferItems[inputCounter].x = x;
-        g_MappedInputBufferItems[inputCounter].y = y;
-        *g_MappedInputCounter = inputCounter;
+void UpdateLateLatchBuffer(int x, int y, InputTraceSource source)
+{
+    if (g_ReplayingTrace.load(std::memory_order_relaxed))
+    {
+        return;
     }
+
+    uint64_t timestamp = GetClock()->NowNs();
+
+    if (g_RecordingTrace.load(std::memory_order_acquire))
+    {
+        std::lock_guard<std::mutex> lock(g_TraceWriterMutex);
+        if (g_TraceWriter.File)
+        {
+            InputTrace_Record(&g_TraceWriter, timestamp, x, y, source);
+        }
+    }
+
+    PublishLateLatchInput(x, y, timestamp);
+}
+
+void ReplayTraceMain(double speed)
+{
+    InputTraceView view;
+    if (InputTrace_Open(&view, INPUT_TRACE_PATH))
+    {
+        InputTrace_Replay(view, GetClock(), speed, &g_CancelReplay, [](const InputTraceRecord& record) {
+            // Timestamp with the replay time, so latency is measured the same way as for live input.
+            PublishLateLatchInput(record.X, record.Y, GetClock()->NowNs());
+        });
+        InputTrace_Close(&view);
+    }
+    else
+    {
+        fprintf(stderr, "Failed to open input trace %s\n", INPUT_TRACE_PATH);
+    }
+
+    g_ReplayingTrace = false;
 }
 
 LRESULT CALLBACK WndProc(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam)
 {
     bool ok;
 
+    // ImGui runs on the render thread, so its input is queued rather than handled here.
+    ImGui_Impl_PostEvent(hWnd, msg, wParam, lParam);
+
     switch (msg)
     {
     case WM_CLOSE:
@@ -121,7 +208,7 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam)
         ok = GetClientRect(hWnd, &client);
         assert(ok);
 
-        UpdateLateLatchBuffer(GET_X_LPARAM(lParam), (client.bottom - client.top) - 1 - GET_Y_LPARAM(lParam));
+        UpdateLateLatchBuffer(GET_X_LPARAM(lParam), (client.bottom - client.top) - 1 - GET_Y_LPARAM(lParam), INPUTTRACESOURCE_MOUSEMOVE);
         break;
     }
     }
@@ -131,6 +218,8 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam)
 
 void WindowMain(std::promise<HWND> hWndPromise)
 {
+    Profiler_RegisterThread("Window");
+
     // Register window class
     WNDCLASS wc = {};
     wc.style = CS_OWNDC;
@@ -176,11 +265,15 @@ void WindowMain(std::promise<HWND> hWndPromise)
             }
         }
 
+        // Only recorded when there were messages, since this spins with g_NoSleepWindowThread
+        uint64_t pumpStart = GetClock()->NowNs();
+        int pumpedCount = 0;
+
         POINT cursor;
         RECT rect;
         if (GetCursorPos(&cursor) && ScreenToClient(hWnd, &cursor) && GetClientRect(hWnd, &rect))
         {
-            UpdateLateLatchBuffer(cursor.x, (rect.bottom - rect.top) - 1 - cursor.y);
+            UpdateLateLatchBuffer(cursor.x, (rect.bottom - rect.top) - 1 - cursor.y, INPUTTRACESOURCE_POLL);
         }
         
         MSG msg;
@@ -195,12 +288,26 @@ void WindowMain(std::promise<HWND> hWndPromise)
 
             TranslateMessage(&msg);
             DispatchMessageW(&msg);
+            pumpedCount++;
+        }
+
+        if (pumpedCount > 0 && Profiler_IsEnabled())
+        {
+            Profiler_Record("Pump messages", pumpStart, GetClock()->NowNs(), 0);
         }
     }
 }
 
-int main()
+int main(int argc, char* argv[])
 {
+    // Headless: runs the checks of self_test.h without a window or a GL context, and fails if any check did
+    if (argc > 1 && strcmp(argv[1], "--self-test") == 0)
+    {
+        return SelfTest_RunAll() == 0 ? 0 : 1;
+    }
+
+    Profiler_RegisterThread("Render");
+
     std::promise<HWND> hWndPromise;
     std::future<HWND> hWndFuture = hWndPromise.get_future();
     std::thread windowThread = std::thread([&] {
@@ -261,6 +368,9 @@ int main()
 
     OpenGL_Init();
 
+    // Skips the state changes and queries that ImGui_Impl_RenderDrawLists makes every frame
+    GLStateCache_Install();
+
     // Enable OpenGL debugging
 #ifdef _DEBUG
     glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
@@ -269,13 +379,16 @@ int main()
     glDebugMessageCallback(DebugCallbackGL, 0);
 #endif
 
+    // Before ImGui_Impl_Init builds the fonts, so the GUI's allocations all go through it
+    GuiAllocator_Install();
     ImGui_Impl_Init(hWnd);
 
     const std::string preamble =
-        "#define INPUT_BUFFER_ITEM_SIZE_IN_DWORDS " + std::to_string(sizeof(InputBufferItem) / 4) + "\n" +
-        "#define INPUT_BUFFER_ITEM_X_OFFSET " + std::to_string(offsetof(InputBufferItem, x) / 4) + "\n" +
-        "#define INPUT_BUFFER_ITEM_Y_OFFSET " + std::to_string(offsetof(InputBufferItem, y) / 4) + "\n" +
+        "#define INPUT_BUFFER_ITEM_SIZE_IN_DWORDS " + std::to_string(INPUT_BUFFER_ITEM_SIZE_IN_DWORDS) + "\n" +
+        "#define INPUT_BUFFER_ITEM_X_OFFSET " + std::to_string(INPUT_BUFFER_ITEM_X_OFFSET) + "\n" +
+        "#define INPUT_BUFFER_ITEM_Y_OFFSET " + std::to_string(INPUT_BUFFER_ITEM_Y_OFFSET) + "\n" +
         "#define INPUT_BUFFER_SIZE " + std::to_string(INPUT_BUFFER_SIZE) + "\n" +
+        "#define LATCH_RESET_VALUE " + std::to_string(LATCH_RESET_VALUE) + "u\n" +
         "#define CURSOR_SIZE " + std::to_string(CURSOR_SIZE) + "\n" +
         "#define INPUT_BUFFER_SSBO_BINDING " + std::to_string(INPUT_BUFFER_SSBO_BINDING) + "\n" +
         "#define INPUT_COUNTER_BUFFER_SSBO_BINDING " + std::to_string(INPUT_COUNTER_BUFFER_SSBO_BINDING) + "\n" +
@@ -283,7 +396,8 @@ int main()
         "#define CURSOR_TEXTURE_TEXTURE_BINDING " + std::to_string(CURSOR_TEXTURE_TEXTURE_BINDING) + "\n" +
         "#define PROJECTION_MATRIX_UNIFORM_LOCATION " + std::to_string(PROJECTION_MATRIX_UNIFORM_LOCATION) + "\n" +
         "#define INPUT_UNIFORM_LOCATION " + std::to_string(INPUT_UNIFORM_LOCATION) + "\n" +
-        "#define TINT_UNIFORM_LOCATION " + std::to_string(TINT_UNIFORM_LOCATION) + "\n";
+        "#define TINT_UNIFORM_LOCATION " + std::to_string(TINT_UNIFORM_LOCATION) + "\n" +
+        "#define CURSOR_FRAME_UNIFORM_LOCATION " + std::to_string(CURSOR_FRAME_UNIFORM_LOCATION) + "\n";
         
     const char* const preamble_cstr = preamble.c_str();
 
@@ -308,8 +422,8 @@ out vec2 TexCoord;
 void main()
 {
     uint counter = InputCounter;
-    uint latched = atomicCompSwap(LatchedCounter, INPUT_BUFFER_SIZE, counter);
-    if (latched == INPUT_BUFFER_SIZE) {
+    uint latched = atomicCompSwap(LatchedCounter, LATCH_RESET_VALUE, counter);
+    if (latched == LATCH_RESET_VALUE) {
         latched = counter;
     }
 
@@ -352,7 +466,10 @@ void main()
         preamble_cstr,
 R"GLSL(
 layout(binding = CURSOR_TEXTURE_TEXTURE_BINDING)
-uniform sampler2D CursorTexture;
+uniform sampler2DArray CursorTexture;
+
+layout(location = CURSOR_FRAME_UNIFORM_LOCATION)
+uniform uint CursorFrame;
 
 layout(location = TINT_UNIFORM_LOCATION)
 uniform vec4 Tint;
@@ -363,7 +480,7 @@ out vec4 FragColor;
 
 void main()
 {
-    FragColor = texture(CursorTexture, TexCoord) * Tint;
+    FragColor = texture(CursorTexture, vec3(TexCoord, float(CursorFrame))) * Tint;
 
     if (FragColor.a == 0.0)
     {
@@ -373,72 +490,62 @@ void main()
 )GLSL"
     };
 
-    auto CompileShader = [&](GLenum type, GLsizei count, const GLchar *const* strings)
-    {
-        GLuint shader = glCreateShader(type);
-        glShaderSource(shader, count, strings, NULL);
-        glCompileShader(shader);
-
-        GLint logLength;
-        glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &logLength);
-        if (logLength > 0)
-        {
-            GLchar* infolog = (GLchar*)malloc(logLength);
-            glGetShaderInfoLog(shader, logLength, NULL, infolog);
-            fprintf(stderr, "%s", infolog);
-            free(infolog);
-        }
-        return shader;
+    // Loaded from the binaries of the previous launch when possible
+    const ShaderCacheStage latched_stages[] = {
+        { GL_VERTEX_SHADER, _countof(latched_vs_srcs), latched_vs_srcs },
+        { GL_FRAGMENT_SHADER, _countof(fs_srcs), fs_srcs },
+    };
+    const ShaderCacheStage uniform_stages[] = {
+        { GL_VERTEX_SHADER, _countof(uniform_vs_srcs), uniform_vs_srcs },
+        { GL_FRAGMENT_SHADER, _countof(fs_srcs), fs_srcs },
     };
+    GLuint latched_sp = ShaderCache_LinkProgram(latched_stages, _countof(latched_stages));
+    GLuint uniform_sp = ShaderCache_LinkProgram(uniform_stages, _countof(uniform_stages));
 
-    auto LinkProgram = [&](GLuint vs, GLuint fs)
+    // Decode every frame of the cursor once
+    AniCursor aniCursor;
+    ok = AniCursor_Load(&aniCursor, "Ragnarok.ani");
+    if (!ok)
     {
-        GLuint program = glCreateProgram();
-        if (vs) glAttachShader(program, vs);
-        if (fs) glAttachShader(program, fs);
-        glLinkProgram(program);
-
-        GLint logLength;
-        glGetProgramiv(program, GL_INFO_LOG_LENGTH, &logLength);
-        if (logLength > 0)
+        fprintf(stderr, "Failed to decode Ragnarok.ani\n");
+    }
+    assert(ok);
+
+    // Resample each frame to CURSOR_SIZE and flip it bottom-up for GL
+    std::vector<unsigned char> cursorFrames((size_t)aniCursor.FrameCount * CURSOR_SIZE * CURSOR_SIZE * 4);
+    for (int frame = 0; frame < aniCursor.FrameCount; frame++)
+    {
+        const unsigned char* src = aniCursor.FramePixels(frame);
+        unsigned char* dst = &cursorFrames[(size_t)frame * CURSOR_SIZE * CURSOR_SIZE * 4];
+        for (int y = 0; y < CURSOR_SIZE; y++)
         {
-            GLchar* infolog = (GLchar*)malloc(logLength);
-            glGetProgramInfoLog(program, logLength, NULL, infolog);
-            fprintf(stderr, "%s", infolog);
-            free(infolog);
+            int srcY = (CURSOR_SIZE - 1 - y) * aniCursor.Height / CURSOR_SIZE;
+            for (int x = 0; x < CURSOR_SIZE; x++)
+            {
+                int srcX = x * aniCursor.Width / CURSOR_SIZE;
+                memcpy(&dst[(y * CURSOR_SIZE + x) * 4], &src[(srcY * aniCursor.Width + srcX) * 4], 4);
+            }
         }
-        return program;
-    };
-
-    GLuint latched_vs = CompileShader(GL_VERTEX_SHADER, _countof(latched_vs_srcs), latched_vs_srcs);
-    GLuint uniform_vs = CompileShader(GL_VERTEX_SHADER, _countof(uniform_vs_srcs), uniform_vs_srcs);
-    GLuint fs = CompileShader(GL_FRAGMENT_SHADER, _countof(fs_srcs), fs_srcs);
-    GLuint latched_sp = LinkProgram(latched_vs, fs);
-    GLuint uniform_sp = LinkProgram(uniform_vs, fs);
+    }
 
-    // Initialize the cursor texture
+    // Upload all the frames of the cursor once, as layers of an array texture.
+    // Animating the cursor is then only a matter of changing the CursorFrame uniform.
     GLuint cursorTexture;
     glGenTextures(1, &cursorTexture);
-    glBindTexture(GL_TEXTURE_2D, cursorTexture);
-    glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA8, CURSOR_SIZE, CURSOR_SIZE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    glBindTexture(GL_TEXTURE_2D, 0);
-
-    GLuint cursorUploadBuffer;
-    glGenBuffers(1, &cursorUploadBuffer);
-    glBindBuffer(GL_ARRAY_BUFFER, cursorUploadBuffer);
-    glBufferStorage(GL_ARRAY_BUFFER, CURSOR_SIZE * CURSOR_SIZE * 4, NULL, GL_CLIENT_STORAGE_BIT | GL_MAP_WRITE_BIT);
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-
-    // Create DC to decode the cursor
-    HDC hdcMem = CreateCompatibleDC(hDC);
-    // Create the bitmap to use as a canvas.
-    HBITMAP hbmCanvas = CreateCompatibleBitmap(hDC, CURSOR_SIZE, CURSOR_SIZE);
-
-    // Select the bitmap into the device context.
-    HGDIOBJ hbmOld = SelectObject(hdcMem, hbmCanvas);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, cursorTexture);
+    glTexStorage3D(GL_TEXTURE_2D_ARRAY, 1, GL_RGBA8, CURSOR_SIZE, CURSOR_SIZE, aniCursor.FrameCount);
+    glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, 0, CURSOR_SIZE, CURSOR_SIZE, aniCursor.FrameCount, GL_RGBA, GL_UNSIGNED_BYTE, cursorFrames.data());
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+    // Uniforms are per-program, so remember what each cursor program last got to skip redundant updates.
+    GLint cursorFrameUniform[LATCHMODE_COUNT];
+    for (GLint& frame : cursorFrameUniform)
+    {
+        frame = -1;
+    }
 
-    uint64_t cursorTimeline = 0;
+    uint64_t cursorTimelineNs = 0;
 
     GLuint nullVAO;
     glGenVertexArrays(1, &nullVAO);
@@ -449,14 +556,14 @@ void main()
     glGenBuffers(1, &inputBuffer);
     glBindBuffer(GL_ARRAY_BUFFER, inputBuffer);
     glBufferStorage(GL_ARRAY_BUFFER, INPUT_BUFFER_SIZE_IN_BYTES, NULL, GL_CLIENT_STORAGE_BIT | GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT);
-    InputBufferItem* pInputBuffer = (InputBufferItem*)glMapBufferRange(GL_ARRAY_BUFFER, 0, INPUT_BUFFER_SIZE_IN_BYTES, GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT);
+    InputRing::Slot* pInputBuffer = (InputRing::Slot*)glMapBufferRange(GL_ARRAY_BUFFER, 0, INPUT_BUFFER_SIZE_IN_BYTES, GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT);
     glBindBuffer(GL_ARRAY_BUFFER, 0);
 
     GLuint inputCounterBuffer;
     glGenBuffers(1, &inputCounterBuffer);
     glBindBuffer(GL_ARRAY_BUFFER, inputCounterBuffer);
     glBufferStorage(GL_ARRAY_BUFFER, sizeof(GLuint), NULL, GL_CLIENT_STORAGE_BIT | GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT);
-    GLuint* pInputCounter = (GLuint*)glMapBufferRange(GL_ARRAY_BUFFER, 0, sizeof(GLuint), GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT);
+    std::atomic<uint32_t>* pInputCounter = (std::atomic<uint32_t>*)glMapBufferRange(GL_ARRAY_BUFFER, 0, sizeof(GLuint), GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT);
     glBindBuffer(GL_ARRAY_BUFFER, 0);
 
     GLuint latchedCounterBuffer;
@@ -465,12 +572,54 @@ void main()
     glBufferStorage(GL_ARRAY_BUFFER, sizeof(GLuint), NULL, 0);
     glBindBuffer(GL_ARRAY_BUFFER, 0);
 
-    pInputBuffer[0] = InputBufferItem{ 0, 0 };
-    *pInputCounter = 0;
-    
-    g_InputCounter = 1;
-    g_MappedInputBufferItems = pInputBuffer;
-    g_MappedInputCounter = pInputCounter;
+    g_InputRing.Init(pInputBuffer, pInputCounter, InputBufferItem{ 0, 0, GetClock()->NowNs() });
+
+    // After each late-latched draw, the latched counter is copied here along with a GPU timestamp,
+    // and read back a few frames later to know which input was used and how old it was.
+    GLuint latchReadbackBuffer;
+    glGenBuffers(1, &latchReadbackBuffer);
+    glBindBuffer(GL_ARRAY_BUFFER, latchReadbackBuffer);
+    glBufferStorage(GL_ARRAY_BUFFER, LATCH_READBACK_FRAMES * sizeof(GLuint), NULL, GL_CLIENT_STORAGE_BIT | GL_MAP_READ_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT);
+    const GLuint* pLatchReadback = (const GLuint*)glMapBufferRange(GL_ARRAY_BUFFER, 0, LATCH_READBACK_FRAMES * sizeof(GLuint), GL_MAP_READ_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    GLuint latchTimestampQueries[LATCH_READBACK_FRAMES];
+    glGenQueries(LATCH_READBACK_FRAMES, latchTimestampQueries);
+
+    // Listed along ImGui's own memory in its metrics window
+    ImGui::MemTrackExternal("GL cursor texture", (size_t)CURSOR_SIZE * CURSOR_SIZE * 4 * aniCursor.FrameCount);
+    ImGui::MemTrackExternal("GL input buffer", INPUT_BUFFER_SIZE_IN_BYTES);
+    ImGui::MemTrackExternal("GL input and latched counters", 2 * sizeof(GLuint));
+    ImGui::MemTrackExternal("GL latch readback buffer", LATCH_READBACK_FRAMES * sizeof(GLuint));
+
+    GLsync latchReadbackFences[LATCH_READBACK_FRAMES] = {};
+    uint64_t latchReadbackFrameIndices[LATCH_READBACK_FRAMES] = {}; // Frame that latched into each readback slot
+    uint32_t latchReadbackHead = 0;
+    uint32_t latchReadbackTail = 0;
+
+    struct LatchRecord
+    {
+        uint64_t frame;
+        uint32_t ticket;
+        int64_t latencyNs; // -1 if the input was already overwritten in the ring
+    };
+
+    LatchRecord latchHistory[LATCH_HISTORY_SIZE] = {};
+    uint64_t latchHistoryCount = 0;
+
+    LatencyHistogram latchLatency;
+
+    // GL_TIMESTAMP and GetClock() have different origins
+    auto CalibrateGPUClock = [&]
+    {
+        GLint64 gpuNow;
+        glGetInteger64v(GL_TIMESTAMP, &gpuNow);
+        return int64_t(GetClock()->NowNs()) - int64_t(gpuNow);
+    };
+
+    int64_t gpuToCpuTimeOffset = CalibrateGPUClock();
+
+    uint64_t frameIndex = 0;
 
     bool isFullscreen = false;
 
@@ -488,18 +637,150 @@ void main()
 
     int sleepBeforeDraw = 0;
 
-    ULONGLONG then = GetTickCount64();
+    // Replaces sleepBeforeDraw with a sleep computed from the measured vblank timing and frame costs
+    bool justInTimeFrameStart = false;
+
+    bool showProfiler = false;
+    bool showImGuiMetrics = false;
+
+    // Builds the GUI only when input can change it or guiRefreshHz asks for it. Other frames composite the GUI layer
+    // of the last build, which takes ImGui off the path between the latch and the swap.
+    bool decoupledGui = false;
+    int guiRefreshHz = 10;
+    uint64_t lastGuiBuildNs = 0;
+
+    // To show the state cache's counts per frame
+    GLStateCacheStats glStateStatsLastFrame = GLStateCache_GetStats();
+    GuiAllocatorStats guiAllocatorStatsLastFrame = GuiAllocator_GetStats();
+
+    // Renders the GUI on the CPU into a TGA, as a reference for the GL output. Started on first use.
+    SoftRenderer softRenderer;
+    bool softRendererStarted = false;
+    bool softRenderRequested = false;
+
+    HashBenchmarkResult hashBenchmark = {};
+    WindowBenchmarkResult windowBenchmark = {};
+    StorageBenchmarkResult storageBenchmark = {};
+    OpenGLBenchmarkResult glBenchmark = {};
+    LateLatchRingBenchmarkResult ringBenchmark = {};
+    SpscQueueBenchmarkResult queueBenchmark = {};
+
+    DEVMODE displayMode = {};
+    displayMode.dmSize = sizeof(displayMode);
+    FrameSchedulerConfig frameSchedulerConfig;
+    FrameScheduler_DefaultConfig(&frameSchedulerConfig);
+    if (EnumDisplaySettings(NULL, ENUM_CURRENT_SETTINGS, &displayMode) && displayMode.dmDisplayFrequency > 1)
+    {
+        frameSchedulerConfig.NominalRefreshHz = displayMode.dmDisplayFrequency;
+    }
+
+    FrameScheduler frameScheduler;
+    frameScheduler.Init(frameSchedulerConfig);
+
+    GLuint gpuTimerQueries[GPU_TIMER_FRAMES][2];
+    glGenQueries(GPU_TIMER_FRAMES * 2, &gpuTimerQueries[0][0]);
+    uint64_t gpuTimerVblanks[GPU_TIMER_FRAMES] = {}; // When each timed frame's swap completed, 0 if not at a known vblank
+    uint32_t gpuTimerHead = 0;
+    uint32_t gpuTimerTail = 0;
+
+    bool recordTrace = false;
+    float replaySpeed = 1.0f;
+    std::thread replayThread;
+
+    uint64_t then = GetClock()->NowNs();
 
     for (;;)
     {
-        ULONGLONG now = GetTickCount64();
-        ULONGLONG dt = now - then;
-        cursorTimeline += dt;
+        PROFILE_SCOPE(PROFILER_FRAME_EVENT);
+
+        uint64_t now = GetClock()->NowNs();
+        uint64_t dt = now - then;
+        cursorTimelineNs += dt;
+
+        ProfilerScope collectScope("Collect readbacks");
+
+        // Collect the GPU times of previous frames
+        while (gpuTimerTail != gpuTimerHead)
+        {
+            GLuint* queries = gpuTimerQueries[gpuTimerTail % GPU_TIMER_FRAMES];
+
+            GLuint available;
+            glGetQueryObjectuiv(queries[1], GL_QUERY_RESULT_AVAILABLE, &available);
+            if (!available)
+            {
+                break;
+            }
+
+            GLuint64 gpuStart, gpuEnd;
+            glGetQueryObjectui64v(queries[0], GL_QUERY_RESULT, &gpuStart);
+            glGetQueryObjectui64v(queries[1], GL_QUERY_RESULT, &gpuEnd);
+            frameScheduler.OnGPUFrameTime(gpuEnd > gpuStart ? gpuEnd - gpuStart : 0);
+
+            uint64_t vblank = gpuTimerVblanks[gpuTimerTail % GPU_TIMER_FRAMES];
+            if (vblank)
+            {
+                int64_t idle = int64_t(vblank) - (int64_t(gpuEnd) + gpuToCpuTimeOffset);
+                frameScheduler.OnFrameIdle(idle > 0 ? uint64_t(idle) : 0);
+            }
+
+            gpuTimerTail++;
+        }
+
+        // Collect the latches of previous frames that the GPU has finished
+        while (latchReadbackTail != latchReadbackHead)
+        {
+            uint32_t readbackIndex = latchReadbackTail % LATCH_READBACK_FRAMES;
 
-        ImGui_Impl_NewFrame(hWnd);
+            GLenum status = glClientWaitSync(latchReadbackFences[readbackIndex], 0, 0);
+            if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+            {
+                break;
+            }
+
+            glDeleteSync(latchReadbackFences[readbackIndex]);
+            latchReadbackFences[readbackIndex] = NULL;
+
+            GLuint64 gpuLatchTime;
+            glGetQueryObjectui64v(latchTimestampQueries[readbackIndex], GL_QUERY_RESULT, &gpuLatchTime);
+
+            LatchRecord& record = latchHistory[latchHistoryCount % LATCH_HISTORY_SIZE];
+            record.frame = latchReadbackFrameIndices[readbackIndex];
+            record.ticket = pLatchReadback[readbackIndex];
+            record.latencyNs = -1;
 
-        ImGui::SetNextWindowSize(ImVec2(700, 350), ImGuiSetCond_Always);
-        if (ImGui::Begin("GUI"))
+            InputBufferItem latchedItem;
+            if (g_InputRing.TryRead(record.ticket, &latchedItem))
+            {
+                int64_t latency = int64_t(gpuLatchTime) + gpuToCpuTimeOffset - int64_t(latchedItem.timestamp);
+                record.latencyNs = latency > 0 ? latency : 0;
+                latchLatency.Record(uint64_t(record.latencyNs));
+            }
+
+            latchHistoryCount++;
+            latchReadbackTail++;
+        }
+
+        collectScope.End();
+
+        bool buildGui = !decoupledGui ||
+            !ImGui_Impl_HasCachedLayer() ||
+            now - lastGuiBuildNs >= 1000000000ull / guiRefreshHz ||
+            ImGui_Impl_HasGuiInput();
+        if (buildGui)
+        {
+            PROFILE_SCOPE("ImGui_Impl_NewFrame");
+            GuiAllocator_NewFrame();
+            ImGui_Impl_NewFrame(hWnd);
+            lastGuiBuildNs = now;
+        }
+
+        ProfilerScope guiScope("Build GUI");
+
+        if (buildGui)
+        {
+            ImGui::SetNextWindowSize(ImVec2(700, 450), ImGuiSetCond_Always);
+        }
+        if (buildGui && ImGui::Begin("GUI"))
         {
             ImGui::Text("GL_VENDOR: %s\n", glGetString(GL_VENDOR));
             ImGui::Text("GL_RENDERER: %s\n", glGetString(GL_RENDERER));
@@ -598,24 +879,357 @@ void main()
 
             ImGui::Checkbox("glFinish at end of frame", &finishAtEndOfFrame);
 
-            ImGui::InputInt("Sleep milliseconds before drawing", &sleepBeforeDraw);
-            if (sleepBeforeDraw < 0)
-                sleepBeforeDraw = 0;
+            ImGui::Checkbox("Just-in-time frame start (replaces sleep before drawing)", &justInTimeFrameStart);
+
+            if (justInTimeFrameStart)
+            {
+                if (!finishAtEndOfFrame || (!adaptiveVSync && swapInterval == 0))
+                {
+                    ImGui::Text("Just-in-time frame start needs VSync and glFinish at end of frame to track vblanks");
+                }
+
+                ImGui::Text("Refresh: %.3f Hz  CPU: %.3f ms  GPU: %.3f ms  Budget: %.3f ms",
+                    1e9 / frameScheduler.PeriodNs(),
+                    frameScheduler.CPUTime.EstimateNs() / 1e6,
+                    frameScheduler.GPUTime.EstimateNs() / 1e6,
+                    frameScheduler.BudgetNs() / 1e6);
+
+                // Measured on the real clock: how late the wait for the frame start returns, and how long finished
+                // frames wait for their vblank (the latency the scheduler is trying to remove)
+                ImGui::Text("Wake-up late: %.3f ms (p%.0f %.3f ms)  Idle before vblank: %.3f ms (p%.0f %.3f ms)",
+                    frameScheduler.WakeLateness.EwmaNs / 1e6,
+                    frameScheduler.WakeLateness.Percentile, frameScheduler.WakeLateness.PercentileNs() / 1e6,
+                    frameScheduler.IdleTime.EwmaNs / 1e6,
+                    frameScheduler.IdleTime.Percentile, frameScheduler.IdleTime.PercentileNs() / 1e6);
+            }
+            else
+            {
+                ImGui::InputInt("Sleep milliseconds before drawing", &sleepBeforeDraw);
+                if (sleepBeforeDraw < 0)
+                    sleepBeforeDraw = 0;
+            }
 
             ImGui::Checkbox("Never sleep the Window thread", &g_NoSleepWindowThread);
+
+            ImGui::Checkbox("Show profiler", &showProfiler);
+            ImGui::SameLine();
+            ImGui::Checkbox("Show ImGui metrics", &showImGuiMetrics);
+
+            const GLStreamRingStats& imguiStreamStats = ImGui_Impl_GetStreamRing().Stats;
+            ImGui::MemTrackExternal("GL ImGui vertex stream", (size_t)ImGui_Impl_GetStreamRing().Capacity() * GL_STREAM_RING_FRAMES);
+            ImGui::Text("ImGui vertex stream: %.1f KB/frame in %.0f KB regions, %llu stalls (%.2f ms), %llu grows",
+                imguiStreamStats.Frames ? imguiStreamStats.BytesStreamed / 1024.0 / imguiStreamStats.Frames : 0.0,
+                ImGui_Impl_GetStreamRing().Capacity() / 1024.0,
+                (unsigned long long)imguiStreamStats.Stalls,
+                imguiStreamStats.StallNs / 1e6,
+                (unsigned long long)imguiStreamStats.Grows);
+
+            bool singleSubmission = ImGui_Impl_GetSingleSubmission();
+            if (ImGui::Checkbox("Single-submission ImGui draws", &singleSubmission))
+            {
+                ImGui_Impl_SetSingleSubmission(singleSubmission);
+            }
+            ImGui::SameLine();
+            ImGui::Text("%d draw calls, %d state changes", ImGui::GetIO().MetricsRenderDrawCalls, ImGui::GetIO().MetricsRenderStateChanges);
+
+            bool layerCache = ImGui_Impl_GetLayerCache();
+            if (ImGui::Checkbox("Cache ImGui layer", &layerCache))
+            {
+                ImGui_Impl_SetLayerCache(layerCache);
+            }
+            const ImGui_Impl_LayerStats& layerStats = ImGui_Impl_GetLayerStats();
+            ImGui::SameLine();
+            ImGui::Text("%llu frames drawn, %llu reused, %d of %d lists changed",
+                (unsigned long long)layerStats.FramesDrawn,
+                (unsigned long long)layerStats.FramesReused,
+                layerStats.ListsChanged, layerStats.Lists);
+
+            // Frames that don't build the GUI composite its layer, so there has to be one
+            if (ImGui::Checkbox("Decouple GUI refresh", &decoupledGui) && decoupledGui)
+            {
+                ImGui_Impl_SetLayerCache(true);
+            }
+            ImGui::SameLine();
+            ImGui::SliderInt("GUI refresh (Hz)", &guiRefreshHz, 1, 60);
+            // Ctrl+click lets any value be typed in, and the refresh interval divides by it
+            guiRefreshHz = guiRefreshHz < 1 ? 1 : guiRefreshHz;
+
+            bool glStateCache = GLStateCache_IsInstalled();
+            if (ImGui::Checkbox("GL state cache", &glStateCache))
+            {
+                if (glStateCache)
+                    GLStateCache_Install();
+                else
+                    GLStateCache_Uninstall();
+            }
+            const GLStateCacheStats& glStateStats = GLStateCache_GetStats();
+            ImGui::SameLine();
+            ImGui::Text("%llu calls issued, %llu avoided, %llu of %llu queries answered",
+                (unsigned long long)(glStateStats.CallsIssued - glStateStatsLastFrame.CallsIssued),
+                (unsigned long long)(glStateStats.CallsAvoided - glStateStatsLastFrame.CallsAvoided),
+                (unsigned long long)(glStateStats.QueriesAnswered - glStateStatsLastFrame.QueriesAnswered),
+                (unsigned long long)(glStateStats.QueriesAnswered - glStateStatsLastFrame.QueriesAnswered +
+                    glStateStats.QueriesForwarded - glStateStatsLastFrame.QueriesForwarded));
+            glStateStatsLastFrame = glStateStats;
+
+            const GuiAllocatorStats& guiAllocatorStats = GuiAllocator_GetStats();
+            ImGui::Text("ImGui allocations: %llu arena, %llu pooled, %llu heap; %.0f KB pooled in %.0f KB of slabs, %.1f KB arena peak",
+                (unsigned long long)(guiAllocatorStats.ArenaAllocs - guiAllocatorStatsLastFrame.ArenaAllocs),
+                (unsigned long long)(guiAllocatorStats.PoolAllocs - guiAllocatorStatsLastFrame.PoolAllocs),
+                (unsigned long long)(guiAllocatorStats.HeapAllocs - guiAllocatorStatsLastFrame.HeapAllocs),
+                guiAllocatorStats.PoolBytes / 1024.0,
+                guiAllocatorStats.SlabBytes / 1024.0,
+                guiAllocatorStats.ArenaPeakBytes / 1024.0);
+            guiAllocatorStatsLastFrame = guiAllocatorStats;
+
+            const ShaderCacheStats& shaderCacheStats = ShaderCache_GetStats();
+            ImGui::Text("Shader programs: %u from cache (%.2f ms), %u compiled (%.2f ms), %u binaries rejected",
+                shaderCacheStats.Hits, shaderCacheStats.LoadNs / 1e6,
+                shaderCacheStats.Misses, shaderCacheStats.CompileNs / 1e6,
+                shaderCacheStats.Rejected);
+
+            const OpenGLLoaderStats& glLoaderStats = OpenGL_GetLoaderStats();
+            ImGui::Text("GL functions: %u of %u resolved, init %.3f ms + %.3f ms on first calls",
+                glLoaderStats.Resolved, glLoaderStats.Functions, glLoaderStats.InitNs / 1e6, glLoaderStats.ResolveNs / 1e6);
+            if (ImGui::Button("Benchmark GL loader"))
+            {
+                glBenchmark = OpenGLBenchmark_Run(100);
+            }
+            if (glBenchmark.Iterations)
+            {
+                ImGui::SameLine();
+                ImGui::Text("Lazy: %.1f us init + %.1f us to resolve %u functions. Eager: %.1f us to resolve %u of %u functions (%u unpatched)",
+                    glBenchmark.LazyInitNs / 1e3 / glBenchmark.Iterations,
+                    ((double)glBenchmark.FirstCallNs - (double)glBenchmark.CallNs) / 1e3 / glBenchmark.Iterations,
+                    glBenchmark.Queries,
+                    glBenchmark.EagerInitNs / 1e3 / glBenchmark.Iterations,
+                    glBenchmark.Supported, glBenchmark.Functions, glBenchmark.Unpatched);
+            }
+
+            if (ImGui::Button("Benchmark late latch ring"))
+            {
+                ringBenchmark = LateLatchRingBenchmark_Run(4, 1000000);
+            }
+            if (ringBenchmark.Reads)
+            {
+                ImGui::SameLine();
+                ImGui::Text("Publish: %.1f ns alone, %.1f ns with %d producers. Latch: %.1f ns per read, %.2f us avg latency, %.2f us max (%u torn)",
+                    (double)ringBenchmark.SingleProducerNs / ringBenchmark.Publishes,
+                    (double)ringBenchmark.ContendedNs / (ringBenchmark.Publishes * ringBenchmark.Producers),
+                    ringBenchmark.Producers,
+                    (double)ringBenchmark.ReadNs / ringBenchmark.Reads,
+                    ringBenchmark.NewSamples ? ringBenchmark.LatchLatencyNs / 1e3 / ringBenchmark.NewSamples : 0.0,
+                    ringBenchmark.MaxLatchLatencyNs / 1e3,
+                    ringBenchmark.Mismatches);
+            }
+
+            if (ImGui::Button("Benchmark GUI event queue"))
+            {
+                queueBenchmark = SpscQueueBenchmark_Run(4000000);
+            }
+            if (queueBenchmark.Items)
+            {
+                ImGui::SameLine();
+                ImGui::Text("%.1f M events/s lock-free, %.1f M events/s with a mutex (%.1f events per batch, %llu full, %u mismatched)",
+                    queueBenchmark.Items * 1e3 / queueBenchmark.QueueNs,
+                    queueBenchmark.Items * 1e3 / queueBenchmark.MutexNs,
+                    (double)queueBenchmark.Items / queueBenchmark.Batches,
+                    (unsigned long long)queueBenchmark.QueueFullSpins,
+                    queueBenchmark.Mismatches);
+            }
+
+            if (ImGui::Button("Benchmark ImHash"))
+            {
+                hashBenchmark = HashBenchmark_Run(10000);
+            }
+            if (hashBenchmark.Hashes)
+            {
+                ImGui::SameLine();
+                ImGui::Text("%.1f ns per label before, %.1f ns now (%u labels, %u mismatched IDs)",
+                    (double)hashBenchmark.LegacyNs / hashBenchmark.Hashes,
+                    (double)hashBenchmark.CurrentNs / hashBenchmark.Hashes,
+                    hashBenchmark.Labels, hashBenchmark.Mismatches);
+            }
+
+            if (ImGui::Button("Benchmark window lookup"))
+            {
+                windowBenchmark = WindowBenchmark_Run(200, 4, 100);
+            }
+            if (windowBenchmark.Frames)
+            {
+                ImGui::SameLine();
+                ImGui::Text("%.3f ms per frame, %.1f ns per lookup before, %.1f ns now (%d windows, %u mismatched)",
+                    windowBenchmark.FrameNs / 1e6 / windowBenchmark.Frames,
+                    (double)windowBenchmark.LinearLookupNs / windowBenchmark.Lookups,
+                    (double)windowBenchmark.LookupNs / windowBenchmark.Lookups,
+                    windowBenchmark.Windows, windowBenchmark.Mismatches);
+            }
+
+            if (ImGui::Button("Benchmark tree node storage"))
+            {
+                storageBenchmark = StorageBenchmark_Run(20000, 100);
+            }
+            if (storageBenchmark.Keys)
+            {
+                ImGui::SameLine();
+                ImGui::Text("%d keys: insert %.0f ns sorted, %.0f ns now; lookup %.0f ns sorted, %.0f ns now (%u mismatched)",
+                    storageBenchmark.Keys,
+                    (double)storageBenchmark.SortedInsertNs / storageBenchmark.Keys,
+                    (double)storageBenchmark.InsertNs / storageBenchmark.Keys,
+                    (double)storageBenchmark.SortedLookupNs / storageBenchmark.Keys,
+                    (double)storageBenchmark.LookupNs / storageBenchmark.Keys,
+                    storageBenchmark.Mismatches);
+                ImGui::Text("Tree of %d nodes: %.3f ms first frame, %.3f ms per frame toggling nodes",
+                    storageBenchmark.Keys, storageBenchmark.FirstFrameNs / 1e6,
+                    storageBenchmark.FrameNs / 1e6 / storageBenchmark.Frames);
+            }
+
+            if (ImGui::Button("Software render GUI (" SOFT_RENDERER_TGA_PATH ")"))
+            {
+                softRenderRequested = true;
+            }
+            if (softRendererStarted)
+            {
+                ImGui::SameLine();
+                ImGui::Text("%llu triangles, %llu bin entries, %.3f ms",
+                    (unsigned long long)softRenderer.Stats.Triangles,
+                    (unsigned long long)softRenderer.Stats.BinEntries,
+                    softRenderer.Stats.RenderNs / 1e6);
+            }
+
+            if (ImGui::Checkbox("Record input trace (" INPUT_TRACE_PATH ")", &recordTrace))
+            {
+                std::lock_guard<std::mutex> lock(g_TraceWriterMutex);
+                if (recordTrace)
+                {
+                    recordTrace = InputTrace_BeginRecording(&g_TraceWriter, INPUT_TRACE_PATH, GetClock()->NowNs());
+                    g_RecordingTrace = recordTrace;
+                }
+                else
+                {
+                    g_RecordingTrace = false;
+                    InputTrace_EndRecording(&g_TraceWriter);
+                }
+            }
+
+            if (g_ReplayingTrace)
+            {
+                if (ImGui::Button("Stop replay"))
+                {
+                    g_CancelReplay = true;
+                }
+            }
+            else if (!recordTrace)
+            {
+                if (ImGui::Button("Replay input trace"))
+                {
+                    if (replayThread.joinable())
+                    {
+                        replayThread.join();
+                    }
+
+                    g_CancelReplay = false;
+                    g_ReplayingTrace = true;
+                    replayThread = std::thread(ReplayTraceMain, (double)replaySpeed);
+                }
+            }
+
+            ImGui::SameLine();
+            ImGui::InputFloat("Replay speed (0 = unthrottled)", &replaySpeed);
+            if (replaySpeed < 0.0f)
+                replaySpeed = 0.0f;
+
+            ImGui::Separator();
+
+            // Time from receiving the input to the GPU finishing the late-latched draw that used it
+            ImGui::Text("Input-to-latch latency (%llu frames)", (unsigned long long)latchLatency.Count());
+            ImGui::Text("p50: %.3f ms  p99: %.3f ms  p99.9: %.3f ms  max: %.3f ms",
+                latchLatency.Percentile(50.0) / 1e6,
+                latchLatency.Percentile(99.0) / 1e6,
+                latchLatency.Percentile(99.9) / 1e6,
+                latchLatency.Max() / 1e6);
+
+            if (latchHistoryCount > 0)
+            {
+                const LatchRecord& lastRecord = latchHistory[(latchHistoryCount - 1) % LATCH_HISTORY_SIZE];
+                ImGui::Text("Last latched sequence: %u", lastRecord.ticket);
+            }
+
+            if (ImGui::Button("Reset latency"))
+            {
+                latchLatency.Reset();
+                latchHistoryCount = 0;
+                gpuToCpuTimeOffset = CalibrateGPUClock();
+            }
+
+            ImGui::SameLine();
+
+            if (ImGui::Button("Dump latency CSV"))
+            {
+                FILE* f = fopen("latch_latency.csv", "w");
+                if (f)
+                {
+                    latchLatency.WriteCSV(f);
+                    fclose(f);
+                }
+
+                f = fopen("latch_frames.csv", "w");
+                if (f)
+                {
+                    fprintf(f, "frame,sequence,latency_ns\n");
+                    uint64_t first = latchHistoryCount > LATCH_HISTORY_SIZE ? latchHistoryCount - LATCH_HISTORY_SIZE : 0;
+                    for (uint64_t i = first; i < latchHistoryCount; i++)
+                    {
+                        const LatchRecord& record = latchHistory[i % LATCH_HISTORY_SIZE];
+                        fprintf(f, "%llu,%u,%lld\n", (unsigned long long)record.frame, record.ticket, (long long)record.latencyNs);
+                    }
+                    fclose(f);
+                }
+            }
+        }
+        if (buildGui)
+        {
+            ImGui::End();
+
+            if (showProfiler)
+            {
+                Profiler_ShowWindow(&showProfiler);
+            }
+            if (showImGuiMetrics)
+            {
+                ImGui::ShowMetricsWindow(&showImGuiMetrics);
+            }
         }
-        ImGui::End();
+
+        guiScope.End();
 
         if (simulateCPUWork)
         {
+            PROFILE_SCOPE("Simulate CPU work");
             Sleep(200);
         }
 
-        if (sleepBeforeDraw > 0)
+        if (justInTimeFrameStart)
+        {
+            PROFILE_SCOPE("Wait for frame start");
+            uint64_t frameStart = frameScheduler.NextFrameStart(GetClock()->NowNs(), adaptiveVSync ? 1 : swapInterval);
+            GetClock()->SleepUntilNs(frameStart);
+            frameScheduler.OnFrameStarted(frameStart, GetClock()->NowNs());
+        }
+        else if (sleepBeforeDraw > 0)
         {
+            PROFILE_SCOPE("Wait for frame start");
             Sleep(sleepBeforeDraw);
         }
 
+        uint64_t drawStartTime = GetClock()->NowNs();
+
+        bool timeGPU = gpuTimerHead - gpuTimerTail < GPU_TIMER_FRAMES;
+        if (timeGPU)
+        {
+            glQueryCounter(gpuTimerQueries[gpuTimerHead % GPU_TIMER_FRAMES][0], GL_TIMESTAMP);
+        }
+
         RECT client;
         ok = GetClientRect(hWnd, &client);
         assert(ok);
@@ -624,64 +1238,46 @@ void main()
         glClear(GL_COLOR_BUFFER_BIT);
         glViewport(0, 0, client.right - client.left, client.bottom - client.top);
 
-        ImGui::Render();
-
-        if (g_CurrLatchMode == LATCHMODE_LATE || g_CurrLatchMode == LATCHMODE_UNIFORM || g_CurrLatchMode == LATCHMODE_ALL)
+        if (buildGui)
         {
-            unsigned char cursorMem[CURSOR_SIZE * CURSOR_SIZE * 4];
-
-            UINT iconFrameRate = 8; // close enough
-            UINT istepIfAniCur = UINT(cursorTimeline / (16.666 * iconFrameRate));
-
-            // Draw the cursor's image into the canvas.
-            ok = DrawIconEx(hdcMem, 0, 0, hCustomCursor, CURSOR_SIZE, CURSOR_SIZE, istepIfAniCur, NULL, DI_IMAGE) != FALSE;
-            if (!ok) {
-                // hack because there's no apparent windows API to know how many frames there are
-                cursorTimeline = cursorTimeline % UINT(istepIfAniCur * 16.666 * iconFrameRate);
-                istepIfAniCur = UINT(cursorTimeline / (16.666 * iconFrameRate));
-                ok = DrawIconEx(hdcMem, 0, 0, hCustomCursor, CURSOR_SIZE, CURSOR_SIZE, istepIfAniCur, NULL, DI_IMAGE) != FALSE;
-                assert(ok);
-            }
+            PROFILE_SCOPE("ImGui::Render");
+            ImGui::Render();
+        }
+        else
+        {
+            PROFILE_SCOPE("ImGui cached layer");
+            ImGui_Impl_RenderCachedLayer();
+        }
 
-            // set the color based on the image
-            for (int y = 0; y < CURSOR_SIZE; y++)
+        if (softRenderRequested)
+        {
+            PROFILE_SCOPE("Software render");
+            if (!softRendererStarted)
             {
-                for (int x = 0; x < CURSOR_SIZE; x++)
-                {
-                    COLORREF clr = GetPixel(hdcMem, x, CURSOR_SIZE - 1 - y);
-                    cursorMem[(y * CURSOR_SIZE + x) * 4 + 0] = GetRValue(clr);
-                    cursorMem[(y * CURSOR_SIZE + x) * 4 + 1] = GetGValue(clr);
-                    cursorMem[(y * CURSOR_SIZE + x) * 4 + 2] = GetBValue(clr);
-                }
+                softRenderer.Init(0);
+                softRendererStarted = true;
             }
+            softRenderer.Resize(client.right - client.left, client.bottom - client.top);
+            softRenderer.Clear(IM_COL32(51, 51, 51, 255));
+            softRenderer.Render(ImGui::GetDrawData());
+            softRenderer.WriteTGA(SOFT_RENDERER_TGA_PATH);
+            softRenderRequested = false;
+        }
 
-            // Draw the cursor's mask into the canvas.
-            ok = DrawIconEx(hdcMem, 0, 0, hCustomCursor, CURSOR_SIZE, CURSOR_SIZE, istepIfAniCur, NULL, DI_MASK) != FALSE;
-            assert(ok);
-
-            // set the alpha based on the mask
-            for (int y = 0; y < CURSOR_SIZE; y++)
+        if (g_CurrLatchMode == LATCHMODE_LATE || g_CurrLatchMode == LATCHMODE_UNIFORM || g_CurrLatchMode == LATCHMODE_ALL)
+        {
+            // Keep the timeline within one cycle so it doesn't lose precision
+            uint64_t cursorCycleNs = AniCursor_CycleNs(aniCursor);
+            if (cursorCycleNs > 0)
             {
-                for (int x = 0; x < CURSOR_SIZE; x++)
-                {
-                    COLORREF clr = GetPixel(hdcMem, x, CURSOR_SIZE - 1 - y);
-                    cursorMem[(y * CURSOR_SIZE + x) * 4 + 3] = clr ? 0 : 255;
-                }
+                cursorTimelineNs %= cursorCycleNs;
             }
 
-            // Copy the cursor into the upload buffer
-            glBindBuffer(GL_ARRAY_BUFFER, cursorUploadBuffer);
-            unsigned char* pCursorPBO = (unsigned char*)glMapBufferRange(GL_ARRAY_BUFFER, 0, CURSOR_SIZE * CURSOR_SIZE * 4, GL_MAP_WRITE_BIT);
-            memcpy(pCursorPBO, cursorMem, CURSOR_SIZE * CURSOR_SIZE * 4);
-            glUnmapBuffer(GL_ARRAY_BUFFER);
-            glBindBuffer(GL_ARRAY_BUFFER, 0);
+            ProfilerScope cursorDecodeScope("Cursor decode");
+            int cursorFrame = AniCursor_FrameAtTime(aniCursor, cursorTimelineNs);
+            cursorDecodeScope.End();
 
-            // upload cursor for this frame
-            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, cursorUploadBuffer);
-            glBindTexture(GL_TEXTURE_2D, cursorTexture);
-            glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, CURSOR_SIZE, CURSOR_SIZE, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
-            glBindTexture(GL_TEXTURE_2D, 0);
-            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+            ProfilerScope cursorDrawScope("Cursor draw loop");
 
             // iterator for LATCHMODE_ALL
             for (int currLatchLoopMode = g_CurrLatchMode == LATCHMODE_ALL ? 0 : g_CurrLatchMode; 
@@ -696,7 +1292,7 @@ void main()
 
                 if (currLatchLoopMode == LATCHMODE_LATE)
                 {
-                    const GLuint kResetLatch = INPUT_BUFFER_SIZE;
+                    const GLuint kResetLatch = LATCH_RESET_VALUE;
                     glBindBuffer(GL_ARRAY_BUFFER, latchedCounterBuffer);
                     glClearBufferData(GL_ARRAY_BUFFER, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, &kResetLatch);
                     glBindBuffer(GL_ARRAY_BUFFER, 0);
@@ -721,6 +1317,12 @@ void main()
 
                 glBindTextures(CURSOR_TEXTURE_TEXTURE_BINDING, 1, &cursorTexture);
 
+                if (cursorFrameUniform[currLatchLoopMode] != cursorFrame)
+                {
+                    glUniform1ui(CURSOR_FRAME_UNIFORM_LOCATION, cursorFrame);
+                    cursorFrameUniform[currLatchLoopMode] = cursorFrame;
+                }
+
                 GLfloat ortho[] = {
                     2.0f / (client.right - client.left), 0.0f, 0.0f, 0.0f,
                     0.0f, 2.0f / (client.bottom - client.top), 0.0f, 0.0f,
@@ -753,6 +1355,26 @@ void main()
                 glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
                 glBindVertexArray(0);
 
+                // Read back which input got latched, unless the GPU is too far behind to keep track.
+                if (currLatchLoopMode == LATCHMODE_LATE && latchReadbackHead - latchReadbackTail < LATCH_READBACK_FRAMES)
+                {
+                    uint32_t readbackIndex = latchReadbackHead % LATCH_READBACK_FRAMES;
+
+                    // LatchedCounter was written through an SSBO
+                    glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+
+                    glBindBuffer(GL_COPY_READ_BUFFER, latchedCounterBuffer);
+                    glBindBuffer(GL_COPY_WRITE_BUFFER, latchReadbackBuffer);
+                    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, readbackIndex * sizeof(GLuint), sizeof(GLuint));
+                    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+                    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+
+                    glQueryCounter(latchTimestampQueries[readbackIndex], GL_TIMESTAMP);
+                    latchReadbackFences[readbackIndex] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+                    latchReadbackFrameIndices[readbackIndex] = frameIndex;
+                    latchReadbackHead++;
+                }
+
                 glBlendFunc(GL_ONE, GL_ZERO);
                 glDisable(GL_BLEND);
 
@@ -768,14 +1390,42 @@ void main()
             }
         }
 
-        ok = SwapBuffers(hDC) != FALSE;
-        assert(ok);
+        if (timeGPU)
+        {
+            glQueryCounter(gpuTimerQueries[gpuTimerHead % GPU_TIMER_FRAMES][1], GL_TIMESTAMP);
+            gpuTimerHead++;
+        }
+
+        frameScheduler.OnCPUFrameTime(GetClock()->NowNs() - drawStartTime);
+
+        {
+            PROFILE_SCOPE("SwapBuffers");
+            ok = SwapBuffers(hDC) != FALSE;
+            assert(ok);
+        }
 
+        uint64_t vblank = 0;
         if (finishAtEndOfFrame)
         {
-            glFinish();
+            {
+                PROFILE_SCOPE("glFinish");
+                glFinish();
+            }
+
+            // With VSync, the swap has just happened at a vblank.
+            if (adaptiveVSync || swapInterval > 0)
+            {
+                vblank = GetClock()->NowNs();
+                frameScheduler.OnSwapCompleted(vblank);
+            }
+        }
+
+        if (timeGPU)
+        {
+            gpuTimerVblanks[(gpuTimerHead - 1) % GPU_TIMER_FRAMES] = vblank;
         }
 
         then = now;
+        frameIndex++;
     }
 }
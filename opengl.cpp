@@ -703,23 +703,23 @@ void (GLAPIENTRYP glNamedBufferPageCommitmentEXT)(GLuint buffer, GLintptr offset
 void (GLAPIENTRYP glNamedBufferPageCommitmentARB)(GLuint buffer, GLintptr offset, GLsizeiptr size, GLboolean commit);
 void (GLAPIENTRYP glTexPageCommitmentARB)(GLenum target, GLint level, GLint xoffset, GLint yoffset, GLint zoffset, GLsizei width, GLsizei height, GLsizei depth, GLboolean commit);
 
-#include <Windows.h>
+#include "gl_recorder.h"
+#include "gl_state_cache.h"
+#include "clock.h"
 
-template<class F>
-void GetProcGL(F*& proc, const char* name)
-{
-    proc = (F*)wglGetProcAddress(name);
-    if (!proc)
-    {
-        // Fall back to GetProcAddress to get GL 1 functions. wglGetProcAddress returns NULL on those.
-        static HMODULE hOpenGL32 = LoadLibrary(TEXT("OpenGL32.dll"));
-        proc = (F*)GetProcAddress(hOpenGL32, name);
-    }
-}
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
 
-#define GET_PROC_GL(n) GetProcGL(n, #n)
+// Index of each function, for loaders that need a compile time constant per function
+enum { GL_PROC_FIRST_INDEX = __COUNTER__ + 1 };
 
-void OpenGL_Init()
+#define GET_PROC_GL(n) loader.template Load<__COUNTER__ - GL_PROC_FIRST_INDEX>(n, #n)
+
+// Calls loader.Load<index>(proc, name) for every GL function.
+template<class Loader>
+static void OpenGL_LoadProcs(Loader& loader)
 {
     GET_PROC_GL(glCullFace);
     GET_PROC_GL(glFrontFace);
@@ -1422,3 +1422,255 @@ void OpenGL_Init()
     GET_PROC_GL(glNamedBufferPageCommitmentARB);
     GET_PROC_GL(glTexPageCommitmentARB);
 }
+
+// The counter is now one past the last function's index
+enum { GL_PROC_COUNT = __COUNTER__ - GL_PROC_FIRST_INDEX };
+static_assert(GL_PROC_COUNT <= GL_RECORDER_MAX_FUNCTIONS, "GL_RECORDER_MAX_FUNCTIONS is too small");
+static_assert(GL_PROC_COUNT <= OPENGL_MAX_FUNCTIONS, "OPENGL_MAX_FUNCTIONS is too small");
+
+typedef void (GLAPIENTRYP OpenGL_Proc)();
+
+#ifdef _WIN32
+
+#include <Windows.h>
+
+static OpenGL_Proc OpenGL_GetProcAddress(const char* name)
+{
+    OpenGL_Proc proc = (OpenGL_Proc)wglGetProcAddress(name);
+    if (!proc)
+    {
+        // Fall back to GetProcAddress to get GL 1 functions. wglGetProcAddress returns NULL on those.
+        static HMODULE hOpenGL32 = LoadLibrary(TEXT("OpenGL32.dll"));
+        proc = (OpenGL_Proc)GetProcAddress(hOpenGL32, name);
+    }
+    return proc;
+}
+
+#else
+
+#include <dlfcn.h>
+
+// libOpenGL is GLVND's library of the core functions, libGL the older one that also has GLX.
+static void* OpenGL_OpenLibrary()
+{
+    void* library = dlopen("libOpenGL.so.0", RTLD_LAZY | RTLD_LOCAL);
+    return library ? library : dlopen("libGL.so.1", RTLD_LAZY | RTLD_LOCAL);
+}
+
+static OpenGL_Proc OpenGL_GetProcAddress(const char* name)
+{
+    // Extensions that the library doesn't export come from eglGetProcAddress, which returns core functions too since EGL 1.5.
+    static void* libGL = OpenGL_OpenLibrary();
+    static void* libEGL = dlopen("libEGL.so.1", RTLD_LAZY | RTLD_LOCAL);
+    static OpenGL_Proc (*eglGetProcAddress)(const char*) = libEGL ? (OpenGL_Proc (*)(const char*))dlsym(libEGL, "eglGetProcAddress") : NULL;
+
+    OpenGL_Proc proc = libGL ? (OpenGL_Proc)dlsym(libGL, name) : NULL;
+    if (!proc && eglGetProcAddress)
+    {
+        proc = eglGetProcAddress(name);
+    }
+    return proc;
+}
+
+#endif
+
+static const char* g_OpenGLProcNames[GL_PROC_COUNT];
+static OpenGLLoaderStats g_OpenGLLoaderStats;
+
+// Set by OpenGL_InitRecording, which has no driver for dispatch tables to resolve from.
+static bool g_OpenGLRecording;
+static bool g_OpenGLDispatchEnabled;
+
+static OpenGL_Proc OpenGL_Resolve(const char* name)
+{
+    uint64_t start = GetClock()->NowNs();
+    OpenGL_Proc proc = OpenGL_GetProcAddress(name);
+    uint64_t elapsed = GetClock()->NowNs() - start;
+
+    if (!proc)
+    {
+        // Calling it would have crashed on a NULL pointer with the old eager loader, so fail just as hard but say why.
+        fprintf(stderr, "OpenGL: %s is not supported by the driver\n", name);
+        abort();
+    }
+
+    // Several threads can resolve functions with dispatch tables.
+    static std::mutex statsMutex;
+    std::lock_guard<std::mutex> lock(statsMutex);
+    g_OpenGLLoaderStats.Resolved++;
+    g_OpenGLLoaderStats.ResolveNs += elapsed;
+    return proc;
+}
+
+// Trampoline that the function pointer points to until the first call, which resolves the function
+// and patches the pointer so the next calls go straight to the driver.
+template<int Index, class R, class... Args>
+struct OpenGL_LazyProc
+{
+    typedef R (GLAPIENTRYP Proc)(Args...);
+
+    static Proc* Slot;
+    static std::atomic<Proc> Resolved;
+
+    static R GLAPIENTRY Call(Args... args)
+    {
+        // Threads racing on the first call may all look the function up, which finds the same one every time.
+        Proc resolved = Resolved.load(std::memory_order_acquire);
+        if (!resolved)
+        {
+            resolved = (Proc)OpenGL_Resolve(g_OpenGLProcNames[Index]);
+            Resolved.store(resolved, std::memory_order_release);
+        }
+
+        // Unless a wrapper (eg. the GL state cache) replaced the trampoline in the meantime,
+        // in which case it keeps calling the trampoline it saved, and only pays for the check above.
+        if (*Slot == &Call)
+        {
+            *Slot = resolved;
+        }
+
+        return resolved(args...);
+    }
+};
+
+template<int Index, class R, class... Args>
+typename OpenGL_LazyProc<Index, R, Args...>::Proc* OpenGL_LazyProc<Index, R, Args...>::Slot;
+
+template<int Index, class R, class... Args>
+std::atomic<typename OpenGL_LazyProc<Index, R, Args...>::Proc> OpenGL_LazyProc<Index, R, Args...>::Resolved;
+
+struct OpenGL_LazyLoader
+{
+    template<int Index, class R, class... Args>
+    void Load(R (GLAPIENTRYP& proc)(Args...), const char* name)
+    {
+        // Resolve again after a reinit, since the functions of the new context can be different ones
+        g_OpenGLProcNames[Index] = name;
+        OpenGL_LazyProc<Index, R, Args...>::Slot = &proc;
+        OpenGL_LazyProc<Index, R, Args...>::Resolved.store(NULL);
+        proc = &OpenGL_LazyProc<Index, R, Args...>::Call;
+    }
+};
+
+void OpenGL_Init()
+{
+    uint64_t start = GetClock()->NowNs();
+
+    OpenGL_LazyLoader loader;
+    OpenGL_LoadProcs(loader);
+    g_OpenGLRecording = false;
+    g_OpenGLDispatchEnabled = false;
+
+    // Every function is resolved again after a reinit
+    g_OpenGLLoaderStats.Functions = GL_PROC_COUNT;
+    g_OpenGLLoaderStats.Resolved = 0;
+    g_OpenGLLoaderStats.ResolveNs = 0;
+    g_OpenGLLoaderStats.InitNs = GetClock()->NowNs() - start;
+}
+
+uint64_t OpenGL_BenchmarkEagerInit()
+{
+    uint64_t start = GetClock()->NowNs();
+
+    uint32_t found = 0;
+    for (const char* name : g_OpenGLProcNames)
+    {
+        if (name && OpenGL_GetProcAddress(name))
+            found++;
+    }
+
+    uint64_t elapsed = GetClock()->NowNs() - start;
+    g_OpenGLLoaderStats.EagerInitNs = elapsed;
+    g_OpenGLLoaderStats.Supported = found;
+    return elapsed;
+}
+
+const OpenGLLoaderStats& OpenGL_GetLoaderStats()
+{
+    return g_OpenGLLoaderStats;
+}
+
+static OpenGLDispatch g_OpenGLDefaultDispatch;
+static thread_local OpenGLDispatch* g_OpenGLCurrentDispatch;
+
+// What the tables resolve to: the recorder's stubs with the recording backend, the driver's functions otherwise.
+static OpenGL_Proc g_OpenGLRecordingProcs[GL_PROC_COUNT];
+
+// What the function pointers point to with dispatch enabled
+template<int Index, class R, class... Args>
+struct OpenGL_DispatchProc
+{
+    typedef R (GLAPIENTRYP Proc)(Args...);
+
+    static R GLAPIENTRY Call(Args... args)
+    {
+        OpenGLDispatch* dispatch = g_OpenGLCurrentDispatch ? g_OpenGLCurrentDispatch : &g_OpenGLDefaultDispatch;
+        OpenGL_Proc& proc = dispatch->Procs[Index];
+        if (!proc)
+        {
+            proc = g_OpenGLRecordingProcs[Index] ? g_OpenGLRecordingProcs[Index] : OpenGL_Resolve(g_OpenGLProcNames[Index]);
+        }
+        return ((Proc)proc)(args...);
+    }
+};
+
+struct OpenGL_DispatchLoader
+{
+    template<int Index, class R, class... Args>
+    void Load(R (GLAPIENTRYP& proc)(Args...), const char* name)
+    {
+        // OpenGL_InitRecording doesn't go through the lazy loader, so the names may not be there yet
+        g_OpenGLProcNames[Index] = name;
+        g_OpenGLRecordingProcs[Index] = g_OpenGLRecording ? (OpenGL_Proc)proc : NULL;
+        proc = &OpenGL_DispatchProc<Index, R, Args...>::Call;
+    }
+};
+
+bool OpenGL_EnableDispatch()
+{
+    if (g_OpenGLDispatchEnabled)
+    {
+        return true;
+    }
+
+    // The cache saved the pointers it wraps and puts them back when it's uninstalled,
+    // which would silently turn dispatch off, or bypass it until then if it was installed first.
+    if (GLStateCache_IsInstalled())
+    {
+        fprintf(stderr, "OpenGL: uninstall the GL state cache before enabling dispatch\n");
+        return false;
+    }
+
+    // The default table starts empty rather than from the pointers, so it doesn't pick up wrappers or trampolines.
+    // It's cleared in case it resolved functions of another backend before a reinit.
+    g_OpenGLDefaultDispatch = OpenGLDispatch();
+    OpenGL_DispatchLoader loader;
+    OpenGL_LoadProcs(loader);
+    g_OpenGLDispatchEnabled = true;
+    return true;
+}
+
+bool OpenGL_IsDispatchEnabled()
+{
+    return g_OpenGLDispatchEnabled;
+}
+
+void OpenGL_MakeDispatchCurrent(OpenGLDispatch* dispatch)
+{
+    g_OpenGLCurrentDispatch = dispatch;
+}
+
+OpenGLDispatch* OpenGL_GetCurrentDispatch()
+{
+    return g_OpenGLCurrentDispatch ? g_OpenGLCurrentDispatch : &g_OpenGLDefaultDispatch;
+}
+
+void OpenGL_InitRecording()
+{
+    GLRecorder_Reset();
+
+    GLRecorderLoader loader;
+    OpenGL_LoadProcs(loader);
+    g_OpenGLRecording = true;
+    g_OpenGLDispatchEnabled = false;
+}
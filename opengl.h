@@ -2,9 +2,33 @@
 
 // Include this file in order to use OpenGL functions
 
+#include <cstdint>
+
 // Call this once after creating your OpenGL context to load the GL functions from the GL driver.
+// Functions are resolved on their first call, so this costs next to nothing and the app only pays for what it uses.
+// Calling a function that the driver doesn't have aborts with its name.
 void OpenGL_Init();
 
+struct OpenGLLoaderStats
+{
+    uint32_t Functions;     // In opengl.h
+    uint32_t Resolved;      // By a first call since the last OpenGL_Init
+    uint64_t InitNs;        // Time spent in OpenGL_Init
+    uint64_t ResolveNs;     // Time spent resolving functions on their first call
+    uint32_t Supported;     // Functions found by OpenGL_BenchmarkEagerInit
+    uint64_t EagerInitNs;   // Time taken by OpenGL_BenchmarkEagerInit
+};
+
+const OpenGLLoaderStats& OpenGL_GetLoaderStats();
+
+// Looks up every function like an eager loader would (without changing the pointers), to compare with OpenGL_Init.
+// Returns the time it took.
+uint64_t OpenGL_BenchmarkEagerInit();
+
+// Call this instead of OpenGL_Init to point the GL functions at the recording backend of gl_recorder.h,
+// which needs no GL driver or context.
+void OpenGL_InitRecording();
+
 // Derived from Khronos' glcorearb.h, which was distributed under the following license:
 /*
 ** Copyright (c) 2013-2016 The Khronos Group Inc.
@@ -3583,3 +3607,30 @@ typedef struct GLDispatchComputeIndirectCommand {
 #define GL_TEXTURE_MAX_ANISOTROPY_EXT     0x84FE
 #define GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT 0x84FF
 #endif /* GL_EXT_texture_filter_anisotropic */
+
+// More than the number of functions in this file
+#define OPENGL_MAX_FUNCTIONS 1024
+
+// Function pointers of one context, for driving several contexts from several threads (eg. an offscreen context
+// for uploads or readbacks next to the window's). A table can only be used by one thread at a time.
+struct OpenGLDispatch
+{
+    // Indexed in the order of opengl.cpp. Each is resolved on its first call through the table, on the thread the
+    // table is current on, so its context has to be current too.
+    void (GLAPIENTRYP Procs[OPENGL_MAX_FUNCTIONS])();
+
+    OpenGLDispatch() : Procs() {}
+};
+
+// Makes the GL functions call through the dispatch table of the calling thread, instead of the process-wide
+// pointers. Threads that haven't made a table current use a default one, which the first context's thread can keep using.
+// Call after OpenGL_Init or OpenGL_InitRecording (which both turn it back off, so tables made before have to be cleared),
+// before starting the other threads. Without it, calls don't pay for the extra indirection.
+// Wrappers installed over the function pointers would see the calls of every thread, so the GL state cache refuses
+// to be installed while dispatch is enabled, and this refuses (returns false) while the cache is installed.
+bool OpenGL_EnableDispatch();
+bool OpenGL_IsDispatchEnabled();
+
+// Makes 'dispatch' the table of the calling thread, or the default table if NULL. Call after making its context current.
+void OpenGL_MakeDispatchCurrent(OpenGLDispatch* dispatch);
+OpenGLDispatch* OpenGL_GetCurrentDispatch();
@@ -0,0 +1,72 @@
+#include "opengl_benchmark.h"
+
+#include "opengl.h"
+#include "gl_state_cache.h"
+#include "clock.h"
+
+// Calls f, and counts the call in 'unpatched' if it didn't replace its trampoline
+#define OPENGL_BENCHMARK_CALL(f, args) \
+    { auto proc = f; f args; calls++; if (f == proc) unpatched++; }
+
+// Queries that don't change any state or raise errors, so they can be called in the middle of a frame
+static void OpenGLBenchmark_Query(uint32_t& calls, uint32_t& unpatched)
+{
+    GLint viewport[4];
+    GLfloat lineWidth;
+    OPENGL_BENCHMARK_CALL(glGetString, (GL_VENDOR));
+    OPENGL_BENCHMARK_CALL(glGetIntegerv, (GL_VIEWPORT, viewport));
+    OPENGL_BENCHMARK_CALL(glGetFloatv, (GL_LINE_WIDTH, &lineWidth));
+    OPENGL_BENCHMARK_CALL(glIsEnabled, (GL_BLEND));
+    OPENGL_BENCHMARK_CALL(glIsBuffer, (0));
+    OPENGL_BENCHMARK_CALL(glIsTexture, (0));
+    OPENGL_BENCHMARK_CALL(glIsSampler, (0));
+    OPENGL_BENCHMARK_CALL(glIsProgram, (0));
+    OPENGL_BENCHMARK_CALL(glIsShader, (0));
+    OPENGL_BENCHMARK_CALL(glIsVertexArray, (0));
+    OPENGL_BENCHMARK_CALL(glIsFramebuffer, (0));
+    OPENGL_BENCHMARK_CALL(glIsRenderbuffer, (0));
+    OPENGL_BENCHMARK_CALL(glIsQuery, (0));
+    OPENGL_BENCHMARK_CALL(glGetError, ());
+}
+
+#undef OPENGL_BENCHMARK_CALL
+
+OpenGLBenchmarkResult OpenGLBenchmark_Run(int iterations)
+{
+    OpenGLBenchmarkResult result = {};
+    result.Iterations = iterations;
+
+    // OpenGL_Init turns both off, and the cache would keep calling the pointers it saved before.
+    bool stateCache = GLStateCache_IsInstalled();
+    bool dispatch = OpenGL_IsDispatchEnabled();
+    GLStateCache_Uninstall();
+
+    for (int i = 0; i < iterations; i++)
+    {
+        uint64_t start = GetClock()->NowNs();
+        OpenGL_Init();
+        uint64_t initEnd = GetClock()->NowNs();
+        uint32_t calls = 0;
+        OpenGLBenchmark_Query(calls, result.Unpatched);
+        uint64_t firstCallsEnd = GetClock()->NowNs();
+        uint32_t alreadyPatched = 0;
+        OpenGLBenchmark_Query(calls, alreadyPatched);
+        uint64_t callsEnd = GetClock()->NowNs();
+
+        result.Queries = calls / 2;
+        result.LazyInitNs += initEnd - start;
+        result.FirstCallNs += firstCallsEnd - initEnd;
+        result.CallNs += callsEnd - firstCallsEnd;
+        result.EagerInitNs += OpenGL_BenchmarkEagerInit();
+    }
+
+    result.Functions = OpenGL_GetLoaderStats().Functions;
+    result.Supported = OpenGL_GetLoaderStats().Supported;
+
+    if (dispatch)
+        OpenGL_EnableDispatch();
+    if (stateCache)
+        GLStateCache_Install();
+
+    return result;
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+// Benchmark of the lazy GL loader against an eager one, which is what a cold start pays for.
+//
+// Each iteration reinitializes the loader and times OpenGL_Init, the first calls of a few harmless queries (which go
+// through the trampolines and resolve the functions), the same calls again (which go straight to the driver, so the
+// difference is the cost of resolving), and an eager lookup of every function. Checks that every first call patched
+// its pointer.
+//
+// Needs the context current, on the thread that makes the GL calls, with no other thread calling GL. The GL state cache
+// and dispatch are put back the way they were.
+
+#include <cstdint>
+
+struct OpenGLBenchmarkResult
+{
+    uint32_t Functions;     // In opengl.h
+    uint32_t Iterations;
+    uint32_t Queries;       // Functions called per iteration
+    uint64_t LazyInitNs;    // OpenGL_Init
+    uint64_t FirstCallNs;   // First calls of the queries, resolving them
+    uint64_t CallNs;        // Later calls of the queries
+    uint64_t EagerInitNs;   // Looking up every function, like the eager loader did
+    uint32_t Supported;     // Functions found by the eager lookup
+    uint32_t Unpatched;     // First calls that left their pointer on the trampoline, should always be 0
+};
+
+OpenGLBenchmarkResult OpenGLBenchmark_Run(int iterations);
@@ -0,0 +1,108 @@
+#include "self_test.h"
+
+#include "opengl.h"
+#include "gl_recorder.h"
+#include "gl_state_cache.h"
+
+#include <atomic>
+#include <thread>
+
+#define OPENGL_TEST_CALLS_PER_THREAD 10000
+
+// Entries that the test puts in the tables itself, so the calls of each thread can be told apart
+static std::atomic<uint32_t> g_OpenGLTestFrontCalls;
+static std::atomic<uint32_t> g_OpenGLTestBackCalls;
+static std::atomic<uint32_t> g_OpenGLTestWrongModes;
+
+static void GLAPIENTRY OpenGLTest_CullFaceFront(GLenum mode)
+{
+    g_OpenGLTestFrontCalls++;
+    if (mode != GL_FRONT)
+        g_OpenGLTestWrongModes++;
+}
+
+static void GLAPIENTRY OpenGLTest_CullFaceBack(GLenum mode)
+{
+    g_OpenGLTestBackCalls++;
+    if (mode != GL_BACK)
+        g_OpenGLTestWrongModes++;
+}
+
+// Makes 'dispatch' current and calls glCullFace through it, like the thread of another context would.
+static void OpenGLTest_CallCullFace(OpenGLDispatch* dispatch, GLenum mode, bool* wasCurrent)
+{
+    OpenGL_MakeDispatchCurrent(dispatch);
+    *wasCurrent = OpenGL_GetCurrentDispatch() == dispatch;
+    for (int i = 0; i < OPENGL_TEST_CALLS_PER_THREAD; i++)
+    {
+        glCullFace(mode);
+    }
+}
+
+SelfTestResult OpenGLTest_RunDispatch()
+{
+    SelfTestResult result = {};
+
+    OpenGL_InitRecording();
+    SELF_TEST_CHECK(result, !OpenGL_IsDispatchEnabled());
+
+    uint32_t cullFace = GLRecorder_FindFunction("glCullFace");
+    uint32_t frontFace = GLRecorder_FindFunction("glFrontFace");
+    const uint32_t* calls = GLRecorder_GetTotalStats().CallsPerFunction;
+
+    // Each refuses while the other is in effect
+    GLStateCache_Install();
+    SELF_TEST_CHECK(result, !OpenGL_EnableDispatch());
+    SELF_TEST_CHECK(result, !OpenGL_IsDispatchEnabled());
+    GLStateCache_Uninstall();
+
+    SELF_TEST_CHECK(result, OpenGL_EnableDispatch());
+    GLStateCache_Install();
+    SELF_TEST_CHECK(result, !GLStateCache_IsInstalled());
+
+    // Without a table of its own, this thread uses the default one, which resolves to the recorder.
+    OpenGLDispatch* defaultDispatch = OpenGL_GetCurrentDispatch();
+    glCullFace(GL_BACK);
+    SELF_TEST_CHECK(result, calls[cullFace] == 1);
+    SELF_TEST_CHECK(result, defaultDispatch->Procs[cullFace] != NULL);
+
+    // Two threads calling the same function at once each go through their own table
+    OpenGLDispatch front;
+    OpenGLDispatch back;
+    front.Procs[cullFace] = (void (GLAPIENTRYP)())&OpenGLTest_CullFaceFront;
+    back.Procs[cullFace] = (void (GLAPIENTRYP)())&OpenGLTest_CullFaceBack;
+
+    bool frontWasCurrent = false;
+    bool backWasCurrent = false;
+    std::thread frontThread(OpenGLTest_CallCullFace, &front, GL_FRONT, &frontWasCurrent);
+    std::thread backThread(OpenGLTest_CallCullFace, &back, GL_BACK, &backWasCurrent);
+    frontThread.join();
+    backThread.join();
+
+    SELF_TEST_CHECK(result, frontWasCurrent && backWasCurrent);
+    SELF_TEST_CHECK(result, g_OpenGLTestFrontCalls == OPENGL_TEST_CALLS_PER_THREAD);
+    SELF_TEST_CHECK(result, g_OpenGLTestBackCalls == OPENGL_TEST_CALLS_PER_THREAD);
+    SELF_TEST_CHECK(result, g_OpenGLTestWrongModes == 0);
+    SELF_TEST_CHECK(result, calls[cullFace] == 1);
+
+    // A function that a table hasn't called yet is resolved in that table only
+    std::thread([&] {
+        OpenGL_MakeDispatchCurrent(&front);
+        glFrontFace(GL_CW);
+    }).join();
+    SELF_TEST_CHECK(result, front.Procs[frontFace] != NULL);
+    SELF_TEST_CHECK(result, back.Procs[frontFace] == NULL);
+    SELF_TEST_CHECK(result, defaultDispatch->Procs[frontFace] == NULL);
+    SELF_TEST_CHECK(result, calls[frontFace] == 1);
+
+    // Another thread without a table shares the default one
+    OpenGLDispatch* otherDefault = NULL;
+    std::thread([&] { otherDefault = OpenGL_GetCurrentDispatch(); }).join();
+    SELF_TEST_CHECK(result, otherDefault == defaultDispatch);
+
+    // Reinitializing turns dispatch back off
+    OpenGL_InitRecording();
+    SELF_TEST_CHECK(result, !OpenGL_IsDispatchEnabled());
+
+    return result;
+}
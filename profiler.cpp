@@ -0,0 +1,453 @@
+#if defined(_MSC_VER) && !defined(_CRT_SECURE_NO_WARNINGS)
+#define _CRT_SECURE_NO_WARNINGS
+#endif
+
+#include "profiler.h"
+
+#include "late_latch_ring.h"
+#include "clock.h"
+#include "imgui.h"
+
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#define PROFILER_TRACE_PATH "profiler_trace.json"
+
+// Number of frames shown as bars by Profiler_ShowWindow
+#define PROFILER_SHOWN_FRAMES 120
+
+typedef LateLatchRing<ProfilerEvent, PROFILER_RING_SIZE> ProfilerRing;
+
+struct ProfilerThread
+{
+    char Name[PROFILER_THREAD_NAME_SIZE];
+    ProfilerRing Ring;
+    LateLatchRingStorage<ProfilerEvent, PROFILER_RING_SIZE> Storage;
+};
+
+// A thread's entry is published in g_ProfilerThreads once its storage is initialized.
+static ProfilerThread g_ProfilerThreadStorage[PROFILER_MAX_THREADS];
+static std::atomic<ProfilerThread*> g_ProfilerThreads[PROFILER_MAX_THREADS];
+static std::atomic<uint32_t> g_ProfilerThreadCount;
+static std::atomic<bool> g_ProfilerEnabled(true);
+
+static thread_local ProfilerThread* g_CurrentProfilerThread;
+static thread_local bool g_CurrentProfilerThreadFull;
+static thread_local uint32_t g_CurrentProfilerDepth;
+
+void Profiler_RegisterThread(const char* name)
+{
+    if (g_CurrentProfilerThread || g_CurrentProfilerThreadFull)
+    {
+        return;
+    }
+
+    uint32_t index = g_ProfilerThreadCount.fetch_add(1, std::memory_order_relaxed);
+    if (index >= PROFILER_MAX_THREADS)
+    {
+        // Too many threads: this one doesn't record.
+        g_CurrentProfilerThreadFull = true;
+        return;
+    }
+
+    ProfilerThread* thread = &g_ProfilerThreadStorage[index];
+    if (name)
+    {
+        snprintf(thread->Name, sizeof(thread->Name), "%s", name);
+    }
+    else
+    {
+        snprintf(thread->Name, sizeof(thread->Name), "Thread %u", index);
+    }
+
+    // Ticket 0 holds this blank event, which readers skip.
+    thread->Ring.Init(thread->Storage.Slots, &thread->Storage.Published, ProfilerEvent{ "", 0, 0, 0 });
+
+    g_ProfilerThreads[index].store(thread, std::memory_order_release);
+    g_CurrentProfilerThread = thread;
+}
+
+void Profiler_SetEnabled(bool enabled)
+{
+    g_ProfilerEnabled.store(enabled, std::memory_order_relaxed);
+}
+
+bool Profiler_IsEnabled()
+{
+    return g_ProfilerEnabled.load(std::memory_order_relaxed);
+}
+
+void Profiler_Record(const char* name, uint64_t startNs, uint64_t endNs, uint32_t depth)
+{
+    if (!g_CurrentProfilerThread)
+    {
+        Profiler_RegisterThread(NULL);
+        if (!g_CurrentProfilerThread)
+        {
+            return;
+        }
+    }
+
+    g_CurrentProfilerThread->Ring.Publish(ProfilerEvent{ name, startNs, endNs, depth });
+}
+
+ProfilerScope::ProfilerScope(const char* name)
+{
+    Name = name;
+    Open = Profiler_IsEnabled();
+    if (Open)
+    {
+        StartNs = GetClock()->NowNs();
+        g_CurrentProfilerDepth++;
+    }
+}
+
+ProfilerScope::~ProfilerScope()
+{
+    End();
+}
+
+void ProfilerScope::End()
+{
+    if (!Open)
+    {
+        return;
+    }
+
+    Open = false;
+    g_CurrentProfilerDepth--;
+    Profiler_Record(Name, StartNs, GetClock()->NowNs(), g_CurrentProfilerDepth);
+}
+
+static uint32_t Profiler_ThreadCount()
+{
+    uint32_t count = g_ProfilerThreadCount.load(std::memory_order_relaxed);
+    return count < PROFILER_MAX_THREADS ? count : PROFILER_MAX_THREADS;
+}
+
+// Copies the events of a thread that are still in its ring, in the order they ended.
+static void Profiler_ReadEvents(const ProfilerThread& thread, std::vector<ProfilerEvent>* events)
+{
+    events->clear();
+
+    uint32_t latest = thread.Ring.LatestTicket();
+    uint32_t count = latest < PROFILER_RING_SIZE ? latest : PROFILER_RING_SIZE;
+    for (uint32_t ticket = latest - count + 1; count > 0; ticket++, count--)
+    {
+        // Events that get overwritten while reading are skipped.
+        ProfilerEvent event;
+        if (thread.Ring.TryRead(ticket, &event))
+        {
+            events->push_back(event);
+        }
+    }
+}
+
+bool Profiler_WriteChromeTrace(const char* path)
+{
+    uint32_t threadCount = Profiler_ThreadCount();
+
+    std::vector<ProfilerEvent> events[PROFILER_MAX_THREADS];
+    uint64_t originNs = UINT64_MAX;
+    for (uint32_t i = 0; i < threadCount; i++)
+    {
+        ProfilerThread* thread = g_ProfilerThreads[i].load(std::memory_order_acquire);
+        if (thread)
+        {
+            Profiler_ReadEvents(*thread, &events[i]);
+            for (const ProfilerEvent& event : events[i])
+            {
+                originNs = event.StartNs < originNs ? event.StartNs : originNs;
+            }
+        }
+    }
+
+    FILE* f = fopen(path, "w");
+    if (!f)
+    {
+        return false;
+    }
+
+    // Event names are string literals from the code, so they don't need escaping.
+    fprintf(f, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    fprintf(f, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"LateLatching\"}}");
+    for (uint32_t i = 0; i < threadCount; i++)
+    {
+        ProfilerThread* thread = g_ProfilerThreads[i].load(std::memory_order_acquire);
+        if (!thread)
+        {
+            continue;
+        }
+
+        fprintf(f, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"%s\"}}", i, thread->Name);
+        for (const ProfilerEvent& event : events[i])
+        {
+            fprintf(f, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+                event.Name, i, (event.StartNs - originNs) / 1e3, (event.EndNs - event.StartNs) / 1e3);
+        }
+    }
+    fprintf(f, "\n]}\n");
+
+    bool ok = !ferror(f);
+    ok = fclose(f) == 0 && ok;
+    return ok;
+}
+
+static ImU32 Profiler_EventColor(const char* name)
+{
+    // FNV-1a of the name, so a phase keeps its color from frame to frame.
+    uint32_t hash = 2166136261u;
+    for (const char* c = name; *c; c++)
+    {
+        hash = (hash ^ (unsigned char)*c) * 16777619u;
+    }
+    return ImColor::HSV((hash % 360) / 360.0f, 0.6f, 0.8f);
+}
+
+struct ProfilerPhaseStats
+{
+    const char* Name;
+    uint64_t TotalNs;
+    uint64_t LastNs;
+    uint32_t Count;
+};
+
+void Profiler_ShowWindow(bool* open)
+{
+    ImGui::SetNextWindowSize(ImVec2(700, 500), ImGuiSetCond_FirstUseEver);
+    if (!ImGui::Begin("Profiler", open))
+    {
+        ImGui::End();
+        return;
+    }
+
+    bool enabled = Profiler_IsEnabled();
+    if (ImGui::Checkbox("Record", &enabled))
+    {
+        Profiler_SetEnabled(enabled);
+    }
+    ImGui::SameLine();
+    if (ImGui::Button("Export Chrome trace (" PROFILER_TRACE_PATH ")"))
+    {
+        Profiler_WriteChromeTrace(PROFILER_TRACE_PATH);
+    }
+
+    // Kept around to avoid reallocating every frame
+    static std::vector<ProfilerEvent> s_Events[PROFILER_MAX_THREADS];
+    static std::vector<ProfilerEvent> s_Frames;
+    static std::vector<ProfilerEvent> s_Phases;
+    static std::vector<uint32_t> s_FirstPhase;
+    static std::vector<ProfilerPhaseStats> s_Stats;
+
+    uint32_t threadCount = Profiler_ThreadCount();
+    ProfilerThread* threads[PROFILER_MAX_THREADS] = {};
+    int frameThread = -1;
+    for (uint32_t i = 0; i < threadCount; i++)
+    {
+        threads[i] = g_ProfilerThreads[i].load(std::memory_order_acquire);
+        if (!threads[i])
+        {
+            continue;
+        }
+
+        Profiler_ReadEvents(*threads[i], &s_Events[i]);
+        if (frameThread == -1)
+        {
+            for (const ProfilerEvent& event : s_Events[i])
+            {
+                if (event.Depth == 0 && strcmp(event.Name, PROFILER_FRAME_EVENT) == 0)
+                {
+                    frameThread = (int)i;
+                    break;
+                }
+            }
+        }
+    }
+
+    if (frameThread == -1)
+    {
+        ImGui::Text("No frames recorded yet");
+        ImGui::End();
+        return;
+    }
+
+    // Split the frame thread's events into frames and their top-level phases.
+    // Events are in the order they ended, so a frame's phases are just before it.
+    s_Frames.clear();
+    s_Phases.clear();
+    s_FirstPhase.clear();
+    uint32_t firstPendingPhase = 0;
+    for (const ProfilerEvent& event : s_Events[frameThread])
+    {
+        if (event.Depth == 0 && strcmp(event.Name, PROFILER_FRAME_EVENT) == 0)
+        {
+            s_Frames.push_back(event);
+            s_FirstPhase.push_back(firstPendingPhase);
+            firstPendingPhase = (uint32_t)s_Phases.size();
+        }
+        else if (event.Depth == 1)
+        {
+            s_Phases.push_back(event);
+        }
+    }
+    s_FirstPhase.push_back(firstPendingPhase);
+
+    uint32_t firstFrame = s_Frames.size() > PROFILER_SHOWN_FRAMES ? (uint32_t)s_Frames.size() - PROFILER_SHOWN_FRAMES : 0;
+    uint32_t frameCount = (uint32_t)s_Frames.size() - firstFrame;
+
+    uint64_t maxFrameNs = 1;
+    for (uint32_t i = firstFrame; i < s_Frames.size(); i++)
+    {
+        uint64_t frameNs = s_Frames[i].EndNs - s_Frames[i].StartNs;
+        maxFrameNs = frameNs > maxFrameNs ? frameNs : maxFrameNs;
+    }
+
+    ImDrawList* drawList = ImGui::GetWindowDrawList();
+    const ImU32 frameColor = ImColor(0.3f, 0.3f, 0.3f, 1.0f);
+    const ImU32 textColor = ImColor(0.0f, 0.0f, 0.0f, 1.0f);
+    const char* hoveredName = NULL;
+    uint64_t hoveredNs = 0;
+
+    // Bars of the last frames, bottom to top. Gaps between the phases are time spent outside of any phase.
+    ImGui::Text("Last %u frames (max %.2f ms)", frameCount, maxFrameNs / 1e6);
+    {
+        ImVec2 origin = ImGui::GetCursorScreenPos();
+        ImVec2 size(ImGui::GetContentRegionAvailWidth(), 150.0f);
+        float barWidth = size.x / PROFILER_SHOWN_FRAMES;
+        float nsToPixels = size.y / maxFrameNs;
+
+        for (uint32_t i = 0; i < frameCount; i++)
+        {
+            const ProfilerEvent& frame = s_Frames[firstFrame + i];
+            float x0 = origin.x + (PROFILER_SHOWN_FRAMES - frameCount + i) * barWidth;
+            float x1 = x0 + barWidth - 1.0f;
+            float bottom = origin.y + size.y;
+
+            ImVec2 frameMin(x0, bottom - (frame.EndNs - frame.StartNs) * nsToPixels);
+            drawList->AddRectFilled(frameMin, ImVec2(x1, bottom), frameColor);
+            if (ImGui::IsMouseHoveringRect(frameMin, ImVec2(x1, bottom)))
+            {
+                hoveredName = frame.Name;
+                hoveredNs = frame.EndNs - frame.StartNs;
+            }
+
+            for (uint32_t p = s_FirstPhase[firstFrame + i]; p < s_FirstPhase[firstFrame + i + 1]; p++)
+            {
+                const ProfilerEvent& phase = s_Phases[p];
+                ImVec2 phaseMin(x0, bottom - (phase.EndNs - frame.StartNs) * nsToPixels);
+                ImVec2 phaseMax(x1, bottom - (phase.StartNs - frame.StartNs) * nsToPixels);
+                drawList->AddRectFilled(phaseMin, phaseMax, Profiler_EventColor(phase.Name));
+                if (ImGui::IsMouseHoveringRect(phaseMin, phaseMax))
+                {
+                    hoveredName = phase.Name;
+                    hoveredNs = phase.EndNs - phase.StartNs;
+                }
+            }
+        }
+
+        ImGui::Dummy(size);
+    }
+
+    // Flame view of the last frame: one row per nesting level of each thread, including the other threads' events
+    // that overlap the frame.
+    const ProfilerEvent& lastFrame = s_Frames.back();
+    ImGui::Text("Last frame (%.2f ms)", (lastFrame.EndNs - lastFrame.StartNs) / 1e6);
+    {
+        float rowHeight = ImGui::GetTextLineHeight() + 2.0f;
+        ImVec2 origin = ImGui::GetCursorScreenPos();
+        float width = ImGui::GetContentRegionAvailWidth();
+        float nsToPixels = width / (lastFrame.EndNs - lastFrame.StartNs + 1);
+        float y = origin.y;
+
+        for (uint32_t t = 0; t < threadCount; t++)
+        {
+            if (!threads[t])
+            {
+                continue;
+            }
+
+            uint32_t maxDepth = 0;
+            bool any = false;
+            for (const ProfilerEvent& event : s_Events[t])
+            {
+                if (event.EndNs < lastFrame.StartNs || event.StartNs > lastFrame.EndNs)
+                {
+                    continue;
+                }
+
+                uint64_t start = event.StartNs > lastFrame.StartNs ? event.StartNs : lastFrame.StartNs;
+                uint64_t end = event.EndNs < lastFrame.EndNs ? event.EndNs : lastFrame.EndNs;
+                ImVec2 eventMin(origin.x + (start - lastFrame.StartNs) * nsToPixels, y + event.Depth * rowHeight);
+                ImVec2 eventMax(origin.x + (end - lastFrame.StartNs) * nsToPixels + 1.0f, eventMin.y + rowHeight - 1.0f);
+                drawList->AddRectFilled(eventMin, eventMax, Profiler_EventColor(event.Name));
+
+                if (eventMax.x - eventMin.x > ImGui::CalcTextSize(event.Name).x + 4.0f)
+                {
+                    drawList->AddText(ImVec2(eventMin.x + 2.0f, eventMin.y + 1.0f), textColor, event.Name);
+                }
+                if (ImGui::IsMouseHoveringRect(eventMin, eventMax))
+                {
+                    hoveredName = event.Name;
+                    hoveredNs = event.EndNs - event.StartNs;
+                }
+
+                maxDepth = event.Depth > maxDepth ? event.Depth : maxDepth;
+                any = true;
+            }
+
+            if (any)
+            {
+                drawList->AddText(ImVec2(origin.x + width - ImGui::CalcTextSize(threads[t]->Name).x, y), ImColor(1.0f, 1.0f, 1.0f, 0.5f), threads[t]->Name);
+                y += (maxDepth + 1) * rowHeight + 4.0f;
+            }
+        }
+
+        ImGui::Dummy(ImVec2(width, y - origin.y));
+    }
+
+    if (hoveredName)
+    {
+        ImGui::SetTooltip("%s: %.3f ms", hoveredName, hoveredNs / 1e6);
+    }
+
+    // Average of each phase over the frames shown above
+    s_Stats.clear();
+    for (uint32_t p = s_FirstPhase[firstFrame]; p < s_FirstPhase[s_Frames.size()]; p++)
+    {
+        const ProfilerEvent& phase = s_Phases[p];
+        ProfilerPhaseStats* stats = NULL;
+        for (ProfilerPhaseStats& existing : s_Stats)
+        {
+            if (strcmp(existing.Name, phase.Name) == 0)
+            {
+                stats = &existing;
+                break;
+            }
+        }
+        if (!stats)
+        {
+            s_Stats.push_back(ProfilerPhaseStats{ phase.Name, 0, 0, 0 });
+            stats = &s_Stats.back();
+        }
+
+        stats->TotalNs += phase.EndNs - phase.StartNs;
+        stats->LastNs = phase.EndNs - phase.StartNs;
+        stats->Count++;
+    }
+
+    ImGui::Columns(3);
+    ImGui::Text("Phase"); ImGui::NextColumn();
+    ImGui::Text("Average per frame (ms)"); ImGui::NextColumn();
+    ImGui::Text("Last (ms)"); ImGui::NextColumn();
+    for (const ProfilerPhaseStats& stats : s_Stats)
+    {
+        ImGui::TextColored(ImColor(Profiler_EventColor(stats.Name)), "%s", stats.Name); ImGui::NextColumn();
+        ImGui::Text("%.3f", stats.TotalNs / 1e6 / frameCount); ImGui::NextColumn();
+        ImGui::Text("%.3f", stats.LastNs / 1e6); ImGui::NextColumn();
+    }
+    ImGui::Columns(1);
+
+    ImGui::End();
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+// Scoped CPU timers for the phases of a frame, to see where frame time goes.
+//
+// Every thread that records events gets its own ring (a LateLatchRing), so recording never takes a lock and the
+// render thread can read the events of the other threads while they are being written. Old events are overwritten.
+// Threads register on their first event, or explicitly with Profiler_RegisterThread to get a readable name.
+// Timestamps come from GetClock(), so they line up with the other timings of the app.
+//
+// The events can be exported as Chrome trace-event JSON (open it in chrome://tracing or ui.perfetto.dev),
+// and Profiler_ShowWindow shows the recent frames in an ImGui window.
+
+#include <cstdint>
+
+#define PROFILER_MAX_THREADS 8
+#define PROFILER_RING_SIZE 8192
+#define PROFILER_THREAD_NAME_SIZE 32
+
+// Name of the scope that spans a whole frame. Profiler_ShowWindow uses these to split the timeline into frames.
+#define PROFILER_FRAME_EVENT "Frame"
+
+struct ProfilerEvent
+{
+    const char* Name;   // Must outlive the profiler (eg. a string literal)
+    uint64_t StartNs;
+    uint64_t EndNs;
+    uint32_t Depth;     // Number of scopes of the same thread this one is nested in
+};
+
+void Profiler_RegisterThread(const char* name);
+
+// Recording is enabled by default. Scopes that are open when it gets disabled still record their end.
+void Profiler_SetEnabled(bool enabled);
+bool Profiler_IsEnabled();
+
+// Records an event for the calling thread.
+void Profiler_Record(const char* name, uint64_t startNs, uint64_t endNs, uint32_t depth);
+
+// Writes the events of all threads that are still in their rings. Returns false if the file couldn't be written.
+bool Profiler_WriteChromeTrace(const char* path);
+
+// Shows the last frames of the thread that records PROFILER_FRAME_EVENT scopes. Call between ImGui::NewFrame and ImGui::Render.
+void Profiler_ShowWindow(bool* open);
+
+// Times the enclosing scope, or until End() is called.
+class ProfilerScope
+{
+public:
+    explicit ProfilerScope(const char* name);
+    ~ProfilerScope();
+
+    void End();
+
+private:
+    const char* Name;
+    uint64_t StartNs;
+    bool Open;
+};
+
+#define PROFILER_CONCAT_IMPL(a, b) a##b
+#define PROFILER_CONCAT(a, b) PROFILER_CONCAT_IMPL(a, b)
+#define PROFILE_SCOPE(name) ProfilerScope PROFILER_CONCAT(profilerScope, __LINE__)(name)
@@ -0,0 +1,44 @@
+#include "self_test.h"
+
+#include <cstdio>
+
+struct SelfTest
+{
+    const char* Name;
+    SelfTestResult (*Run)();
+};
+
+static const SelfTest kSelfTests[] = {
+    { "OpenGL per-thread dispatch", OpenGLTest_RunDispatch },
+    { "Late latch ring stress", LateLatchRingTest_RunStress },
+    { "SPSC queue stress", SpscQueueTest_RunStress },
+    { "Shader cache miss, hit and reject", ShaderCacheTest_RunMissHitReject },
+    { "Frame scheduler synthetic trace", FrameSchedulerTest_RunSyntheticTrace },
+    { "Ragnarok.ani decoding", AniCursorTest_RunRagnarok },
+    { "GL stream ring uploads", GLStreamRingTest_RunUploads },
+    { "ImGui mouse capture", ImGuiImplTest_RunMouseCapture },
+    { "Soft renderer draw data", SoftRendererTest_RunDrawData },
+};
+
+bool SelfTest_Check(SelfTestResult& result, bool passed, const char* condition, const char* file, int line)
+{
+    result.Checks++;
+    if (!passed)
+    {
+        result.Failures++;
+        fprintf(stderr, "%s(%d): check failed: %s\n", file, line, condition);
+    }
+    return passed;
+}
+
+uint32_t SelfTest_RunAll()
+{
+    uint32_t failures = 0;
+    for (const SelfTest& test : kSelfTests)
+    {
+        SelfTestResult result = test.Run();
+        printf("%s: %u checks, %u failed\n", test.Name, result.Checks, result.Failures);
+        failures += result.Failures;
+    }
+    return failures;
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+// Checks of the modules that don't need a GPU or a window, run headless with "LateLatching --self-test".
+// Each module's checks live next to it, in <module>_test.cpp, and are listed in self_test.cpp.
+// GL code is checked against the recording backend of gl_recorder.h, so the checks leave the GL functions pointing at it.
+
+#include <cstdint>
+
+struct SelfTestResult
+{
+    uint32_t Checks;
+    uint32_t Failures;
+};
+
+// Counts the check, and prints its condition and location to stderr if it failed. Returns whether it passed.
+#define SELF_TEST_CHECK(result, condition) SelfTest_Check(result, (condition), #condition, __FILE__, __LINE__)
+bool SelfTest_Check(SelfTestResult& result, bool passed, const char* condition, const char* file, int line);
+
+// Runs every test and prints a line per test to stdout. Returns the total number of failed checks.
+uint32_t SelfTest_RunAll();
+
+// Tests of each module
+SelfTestResult OpenGLTest_RunDispatch();
+SelfTestResult LateLatchRingTest_RunStress();
+SelfTestResult SpscQueueTest_RunStress();
+SelfTestResult ShaderCacheTest_RunMissHitReject();
+SelfTestResult FrameSchedulerTest_RunSyntheticTrace();
+SelfTestResult AniCursorTest_RunRagnarok();
+SelfTestResult GLStreamRingTest_RunUploads();
+SelfTestResult ImGuiImplTest_RunMouseCapture();
+SelfTestResult SoftRendererTest_RunDrawData();
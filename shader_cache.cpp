@@ -0,0 +1,272 @@
+#if defined(_MSC_VER) && !defined(_CRT_SECURE_NO_WARNINGS)
+#define _CRT_SECURE_NO_WARNINGS
+#endif
+
+#include "shader_cache.h"
+
+#include "clock.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+
+static const char* g_ShaderCacheDirectory = SHADER_CACHE_DIRECTORY;
+static ShaderCacheStats g_ShaderCacheStats;
+
+static uint64_t ShaderCache_Hash(uint64_t hash, const void* data, size_t size)
+{
+    // FNV-1a
+    const unsigned char* bytes = (const unsigned char*)data;
+    for (size_t i = 0; i < size; i++)
+    {
+        hash = (hash ^ bytes[i]) * 1099511628211ull;
+    }
+    return hash;
+}
+
+static uint64_t ShaderCache_HashString(uint64_t hash, const char* s)
+{
+    // Hash the terminator too, so strings can't run into each other
+    return ShaderCache_Hash(hash, s ? s : "", s ? strlen(s) + 1 : 1);
+}
+
+static uint64_t ShaderCache_Key(const ShaderCacheStage* stages, int stageCount)
+{
+    uint64_t hash = 14695981039346656037ull;
+
+    const GLenum driverStrings[] = { GL_VENDOR, GL_RENDERER, GL_VERSION, GL_SHADING_LANGUAGE_VERSION };
+    for (GLenum name : driverStrings)
+    {
+        hash = ShaderCache_HashString(hash, (const char*)glGetString(name));
+    }
+
+    for (int i = 0; i < stageCount; i++)
+    {
+        hash = ShaderCache_Hash(hash, &stages[i].Type, sizeof(stages[i].Type));
+        hash = ShaderCache_Hash(hash, &stages[i].Count, sizeof(stages[i].Count));
+        for (GLsizei j = 0; j < stages[i].Count; j++)
+        {
+            hash = ShaderCache_HashString(hash, stages[i].Strings[j]);
+        }
+    }
+
+    return hash;
+}
+
+static std::string ShaderCache_Path(uint64_t key)
+{
+    char name[32];
+    snprintf(name, sizeof(name), "/%016llx.bin", (unsigned long long)key);
+    return std::string(g_ShaderCacheDirectory) + name;
+}
+
+static bool ShaderCache_LinkSucceeded(GLuint program)
+{
+    GLint status = GL_FALSE;
+    glGetProgramiv(program, GL_LINK_STATUS, &status);
+    return status == GL_TRUE;
+}
+
+static GLuint ShaderCache_Load(uint64_t key)
+{
+    FILE* f = fopen(ShaderCache_Path(key).c_str(), "rb");
+    if (!f)
+    {
+        return 0;
+    }
+
+    ShaderCacheHeader header;
+    std::vector<unsigned char> binary;
+    bool ok = fread(&header, sizeof(header), 1, f) == 1 &&
+        header.Magic == SHADER_CACHE_MAGIC &&
+        header.Version == SHADER_CACHE_VERSION &&
+        header.Key == key;
+
+    // A corrupt size mustn't decide how much gets allocated, so it has to fit in what's left of the file
+    long binaryStart = ok ? ftell(f) : -1;
+    if (binaryStart >= 0 && fseek(f, 0, SEEK_END) == 0)
+    {
+        long fileEnd = ftell(f);
+        ok = fileEnd >= binaryStart && header.BinarySize <= (unsigned long)(fileEnd - binaryStart) &&
+            fseek(f, binaryStart, SEEK_SET) == 0;
+    }
+    else
+    {
+        ok = false;
+    }
+
+    if (ok)
+    {
+        binary.resize(header.BinarySize);
+        ok = fread(binary.data(), 1, binary.size(), f) == binary.size();
+    }
+    fclose(f);
+
+    if (!ok)
+    {
+        return 0;
+    }
+
+    GLuint program = glCreateProgram();
+    glProgramBinary(program, header.BinaryFormat, binary.data(), (GLsizei)binary.size());
+    if (!ShaderCache_LinkSucceeded(program))
+    {
+        glDeleteProgram(program);
+        g_ShaderCacheStats.Rejected++;
+        return 0;
+    }
+
+    return program;
+}
+
+static void ShaderCache_Store(uint64_t key, GLuint program)
+{
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0)
+    {
+        return;
+    }
+
+    std::vector<unsigned char> binary(length);
+    GLenum format = 0;
+    glGetProgramBinary(program, length, &length, &format, binary.data());
+
+    ShaderCacheHeader header = {};
+    header.Magic = SHADER_CACHE_MAGIC;
+    header.Version = SHADER_CACHE_VERSION;
+    header.Key = key;
+    header.BinaryFormat = format;
+    header.BinarySize = (uint32_t)length;
+
+#ifdef _WIN32
+    _mkdir(g_ShaderCacheDirectory);
+#else
+    mkdir(g_ShaderCacheDirectory, 0755);
+#endif
+
+    // Write to a temporary file first, so a crash can't leave a truncated binary under the real name.
+    std::string path = ShaderCache_Path(key);
+    std::string temporaryPath = path + ".tmp";
+    FILE* f = fopen(temporaryPath.c_str(), "wb");
+    if (!f)
+    {
+        return;
+    }
+
+    bool ok = fwrite(&header, sizeof(header), 1, f) == 1 && fwrite(binary.data(), 1, header.BinarySize, f) == header.BinarySize;
+    ok = fclose(f) == 0 && ok;
+
+    // rename doesn't replace an existing file on Windows
+    remove(path.c_str());
+    if (ok && rename(temporaryPath.c_str(), path.c_str()) == 0)
+    {
+        g_ShaderCacheStats.Stored++;
+    }
+    else
+    {
+        remove(temporaryPath.c_str());
+    }
+}
+
+static GLuint ShaderCache_Compile(const ShaderCacheStage* stages, int stageCount)
+{
+    GLuint program = glCreateProgram();
+
+    // Some drivers only keep what glGetProgramBinary needs when asked before linking
+    glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+
+    std::vector<GLuint> shaders;
+    for (int i = 0; i < stageCount; i++)
+    {
+        GLuint shader = glCreateShader(stages[i].Type);
+        glShaderSource(shader, stages[i].Count, stages[i].Strings, NULL);
+        glCompileShader(shader);
+
+        GLint logLength;
+        glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &logLength);
+        if (logLength > 0)
+        {
+            GLchar* infolog = (GLchar*)malloc(logLength);
+            glGetShaderInfoLog(shader, logLength, NULL, infolog);
+            fprintf(stderr, "%s", infolog);
+            free(infolog);
+        }
+
+        glAttachShader(program, shader);
+        shaders.push_back(shader);
+    }
+
+    glLinkProgram(program);
+
+    GLint logLength;
+    glGetProgramiv(program, GL_INFO_LOG_LENGTH, &logLength);
+    if (logLength > 0)
+    {
+        GLchar* infolog = (GLchar*)malloc(logLength);
+        glGetProgramInfoLog(program, logLength, NULL, infolog);
+        fprintf(stderr, "%s", infolog);
+        free(infolog);
+    }
+
+    // The program keeps working without its shaders
+    for (GLuint shader : shaders)
+    {
+        glDetachShader(program, shader);
+        glDeleteShader(shader);
+    }
+
+    return program;
+}
+
+GLuint ShaderCache_LinkProgram(const ShaderCacheStage* stages, int stageCount)
+{
+    uint64_t key = 0;
+    if (g_ShaderCacheDirectory)
+    {
+        uint64_t loadStart = GetClock()->NowNs();
+        key = ShaderCache_Key(stages, stageCount);
+        GLuint program = ShaderCache_Load(key);
+        g_ShaderCacheStats.LoadNs += GetClock()->NowNs() - loadStart;
+
+        if (program)
+        {
+            g_ShaderCacheStats.Hits++;
+            return program;
+        }
+    }
+
+    uint64_t compileStart = GetClock()->NowNs();
+    g_ShaderCacheStats.Misses++;
+    GLuint program = ShaderCache_Compile(stages, stageCount);
+    if (g_ShaderCacheDirectory && ShaderCache_LinkSucceeded(program))
+    {
+        ShaderCache_Store(key, program);
+    }
+    g_ShaderCacheStats.CompileNs += GetClock()->NowNs() - compileStart;
+
+    return program;
+}
+
+uint64_t ShaderCache_GetKey(const ShaderCacheStage* stages, int stageCount)
+{
+    return ShaderCache_Key(stages, stageCount);
+}
+
+void ShaderCache_SetDirectory(const char* directory)
+{
+    g_ShaderCacheDirectory = directory;
+}
+
+const ShaderCacheStats& ShaderCache_GetStats()
+{
+    return g_ShaderCacheStats;
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+// Cache of linked shader programs, so launches after the first skip compiling and linking GLSL.
+//
+// A program is keyed by a 64-bit hash of its stages' types and sources (including any preamble passed as one of
+// the strings) and of the driver's identity (vendor, renderer and version strings), since a binary only loads on
+// the driver that produced it. The glGetProgramBinary blob is stored in SHADER_CACHE_DIRECTORY under the hex key.
+//
+// If the file is missing, doesn't match the key, is shorter than its header says, or the driver rejects the binary
+// (eg. after a driver update that kept its version string), the program is compiled from source and the file is replaced.
+
+#include "opengl.h"
+
+#include <cstdint>
+
+#define SHADER_CACHE_DIRECTORY "shader_cache"
+
+#define SHADER_CACHE_MAGIC 0x4353534C // "LSSC"
+#define SHADER_CACHE_VERSION 1
+
+struct ShaderCacheHeader
+{
+    uint32_t Magic;
+    uint32_t Version;
+    uint64_t Key;               // Same as the file name, in case the name got mixed up
+    uint32_t BinaryFormat;
+    uint32_t BinarySize;        // Bytes of binary after the header
+};
+
+struct ShaderCacheStage
+{
+    GLenum Type;
+    GLsizei Count;
+    const GLchar* const* Strings;
+};
+
+struct ShaderCacheStats
+{
+    uint32_t Hits;          // Programs loaded from their binary
+    uint32_t Misses;        // Programs compiled from source
+    uint32_t Rejected;      // Misses that had a binary the driver didn't accept
+    uint32_t Stored;        // Binaries written
+    uint64_t LoadNs;        // Time spent reading and loading binaries, including rejected ones
+    uint64_t CompileNs;     // Time spent compiling, linking and storing
+};
+
+// Returns the linked program made of the stages. Compile and link errors are printed to stderr, like a compile from source.
+GLuint ShaderCache_LinkProgram(const ShaderCacheStage* stages, int stageCount);
+
+// Key of the program made of the stages with the current driver. Its binary is stored as "<directory>/<key in 16 hex digits>.bin".
+uint64_t ShaderCache_GetKey(const ShaderCacheStage* stages, int stageCount);
+
+// Defaults to SHADER_CACHE_DIRECTORY. Set to NULL to disable the cache and always compile.
+void ShaderCache_SetDirectory(const char* directory);
+
+const ShaderCacheStats& ShaderCache_GetStats();
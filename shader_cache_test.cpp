@@ -0,0 +1,105 @@
+#if defined(_MSC_VER) && !defined(_CRT_SECURE_NO_WARNINGS)
+#define _CRT_SECURE_NO_WARNINGS
+#endif
+
+#include "self_test.h"
+
+#include "shader_cache.h"
+#include "gl_recorder.h"
+
+#include <cstdio>
+#include <string>
+
+#ifdef _WIN32
+#include <direct.h>
+#define rmdir _rmdir
+#else
+#include <unistd.h>
+#endif
+
+// Next to the real cache, so the test doesn't throw away the app's binaries
+#define SHADER_CACHE_TEST_DIRECTORY "shader_cache_test"
+
+static const char* const kShaderCacheTestVertex[] = { "#version 440 core\n", "void main() { gl_Position = vec4(0); }\n" };
+static const char* const kShaderCacheTestFragment[] = { "#version 440 core\n", "out vec4 Color;\nvoid main() { Color = vec4(1); }\n" };
+
+static const ShaderCacheStage kShaderCacheTestStages[] = {
+    { GL_VERTEX_SHADER, 2, kShaderCacheTestVertex },
+    { GL_FRAGMENT_SHADER, 2, kShaderCacheTestFragment },
+};
+
+// Overwrites the size in the header of the stored binary, or cuts the file short of its binary if 'size' is 0.
+static bool ShaderCacheTest_Corrupt(const std::string& path, uint32_t size)
+{
+    FILE* f = fopen(path.c_str(), "rb");
+    if (!f)
+        return false;
+    ShaderCacheHeader header;
+    bool ok = fread(&header, sizeof(header), 1, f) == 1;
+    fclose(f);
+
+    f = fopen(path.c_str(), "wb");
+    if (!ok || !f)
+        return false;
+    header.BinarySize = size ? size : header.BinarySize;
+    ok = fwrite(&header, sizeof(header), 1, f) == 1;
+    ok = fclose(f) == 0 && ok;
+    return ok;
+}
+
+// Links the same program against the recording backend through a miss, a hit, a binary the driver rejects after
+// a format change, and files whose header claims more binary than they hold, which must never reach the driver.
+SelfTestResult ShaderCacheTest_RunMissHitReject()
+{
+    SelfTestResult result = {};
+
+    OpenGL_InitRecording();
+    ShaderCache_SetDirectory(SHADER_CACHE_TEST_DIRECTORY);
+
+    char name[32];
+    snprintf(name, sizeof(name), "/%016llx.bin", (unsigned long long)ShaderCache_GetKey(kShaderCacheTestStages, 2));
+    std::string path = std::string(SHADER_CACHE_TEST_DIRECTORY) + name;
+    remove(path.c_str());
+
+    const ShaderCacheStats& stats = ShaderCache_GetStats();
+    const ShaderCacheStats before = stats;
+    const uint32_t* calls = GLRecorder_GetTotalStats().CallsPerFunction;
+    uint32_t compileShader = GLRecorder_FindFunction("glCompileShader");
+    uint32_t programBinary = GLRecorder_FindFunction("glProgramBinary");
+
+    // Miss: compiled and stored
+    SELF_TEST_CHECK(result, ShaderCache_LinkProgram(kShaderCacheTestStages, 2) != 0);
+    SELF_TEST_CHECK(result, stats.Misses == before.Misses + 1 && stats.Stored == before.Stored + 1);
+    SELF_TEST_CHECK(result, calls[compileShader] == 2);
+
+    // Hit: loaded without compiling
+    SELF_TEST_CHECK(result, ShaderCache_LinkProgram(kShaderCacheTestStages, 2) != 0);
+    SELF_TEST_CHECK(result, stats.Hits == before.Hits + 1);
+    SELF_TEST_CHECK(result, calls[compileShader] == 2 && calls[programBinary] == 1);
+
+    // Reject: the driver changed its binary format, so the old binary is compiled over and replaced
+    GLRecorder_SetProgramBinaryFormat(GL_RECORDER_PROGRAM_BINARY_FORMAT + 1);
+    SELF_TEST_CHECK(result, ShaderCache_LinkProgram(kShaderCacheTestStages, 2) != 0);
+    SELF_TEST_CHECK(result, stats.Rejected == before.Rejected + 1 && stats.Misses == before.Misses + 2);
+    SELF_TEST_CHECK(result, calls[compileShader] == 4 && calls[programBinary] == 2);
+    SELF_TEST_CHECK(result, ShaderCache_LinkProgram(kShaderCacheTestStages, 2) != 0);
+    SELF_TEST_CHECK(result, stats.Hits == before.Hits + 2);
+    GLRecorder_SetProgramBinaryFormat(GL_RECORDER_PROGRAM_BINARY_FORMAT);
+
+    // A size bigger than the file, and a file cut short: misses that don't get to the driver or count as rejected
+    SELF_TEST_CHECK(result, ShaderCacheTest_Corrupt(path, 0x7FFFFFFF));
+    SELF_TEST_CHECK(result, ShaderCache_LinkProgram(kShaderCacheTestStages, 2) != 0);
+    SELF_TEST_CHECK(result, ShaderCacheTest_Corrupt(path, 0));
+    SELF_TEST_CHECK(result, ShaderCache_LinkProgram(kShaderCacheTestStages, 2) != 0);
+    SELF_TEST_CHECK(result, stats.Misses == before.Misses + 4 && stats.Rejected == before.Rejected + 1);
+    SELF_TEST_CHECK(result, calls[programBinary] == 3);
+
+    // Each miss replaced the file
+    SELF_TEST_CHECK(result, ShaderCache_LinkProgram(kShaderCacheTestStages, 2) != 0);
+    SELF_TEST_CHECK(result, stats.Hits == before.Hits + 3 && stats.Stored == before.Stored + 4);
+
+    remove(path.c_str());
+    rmdir(SHADER_CACHE_TEST_DIRECTORY);
+    ShaderCache_SetDirectory(SHADER_CACHE_DIRECTORY);
+    return result;
+}
@@ -0,0 +1,621 @@
+#if defined(_MSC_VER) && !defined(_CRT_SECURE_NO_WARNINGS)
+#define _CRT_SECURE_NO_WARNINGS
+#endif
+
+#include "soft_renderer.h"
+
+#include "clock.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SOFT_RENDERER_SSE2 1
+#include <emmintrin.h>
+#else
+#define SOFT_RENDERER_SSE2 0
+#endif
+
+SoftRenderer::SoftRenderer()
+{
+    Stats = SoftRendererStats();
+    FontTexture = SoftRendererTexture();
+    FramebufferWidth = 0;
+    FramebufferHeight = 0;
+    FramebufferStride = 0;
+    TilesX = 0;
+    TilesY = 0;
+    ChunkCount = 0;
+    Job = NULL;
+    JobCount = 0;
+    JobGeneration = 0;
+    NextJob = 0;
+    BusyWorkers = 0;
+    Quit = false;
+    UseSSE2 = true;
+}
+
+SoftRenderer::~SoftRenderer()
+{
+    Shutdown();
+}
+
+void SoftRenderer::Init(int threadCount)
+{
+    if (threadCount <= 0)
+    {
+        threadCount = (int)std::thread::hardware_concurrency();
+    }
+
+    Quit = false;
+    for (int i = 1; i < threadCount; i++)
+    {
+        Workers.emplace_back(&SoftRenderer::WorkerMain, this);
+    }
+
+    ImGuiIO& io = ImGui::GetIO();
+    unsigned char* pixels;
+    int width, height;
+    io.Fonts->GetTexDataAsAlpha8(&pixels, &width, &height);
+    FontTexture.Pixels = pixels;
+    FontTexture.Width = width;
+    FontTexture.Height = height;
+    FontTexture.Alpha8 = true;
+    if (!io.Fonts->TexID)
+    {
+        io.Fonts->TexID = &FontTexture;
+    }
+}
+
+void SoftRenderer::Shutdown()
+{
+    {
+        std::lock_guard<std::mutex> lock(JobMutex);
+        Quit = true;
+    }
+    JobStarted.notify_all();
+
+    for (std::thread& worker : Workers)
+    {
+        worker.join();
+    }
+    Workers.clear();
+}
+
+void SoftRenderer::Resize(int width, int height)
+{
+    FramebufferWidth = width;
+    FramebufferHeight = height;
+    FramebufferStride = (width + 3) & ~3;
+    Framebuffer.assign((size_t)FramebufferStride * height, 0);
+
+    TilesX = (width + SOFT_RENDERER_TILE_SIZE - 1) / SOFT_RENDERER_TILE_SIZE;
+    TilesY = (height + SOFT_RENDERER_TILE_SIZE - 1) / SOFT_RENDERER_TILE_SIZE;
+}
+
+void SoftRenderer::Clear(ImU32 color)
+{
+    uint32_t rgba =
+        ((color >> IM_COL32_R_SHIFT) & 0xFF) |
+        (((color >> IM_COL32_G_SHIFT) & 0xFF) << 8) |
+        (((color >> IM_COL32_B_SHIFT) & 0xFF) << 16) |
+        (((color >> IM_COL32_A_SHIFT) & 0xFF) << 24);
+    std::fill(Framebuffer.begin(), Framebuffer.end(), rgba);
+}
+
+void SoftRenderer::RunParallel(int jobCount, const std::function<void(int)>& job)
+{
+    if (Workers.empty())
+    {
+        for (int i = 0; i < jobCount; i++)
+        {
+            job(i);
+        }
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(JobMutex);
+        Job = &job;
+        JobCount = jobCount;
+        NextJob = 0;
+        BusyWorkers = (int)Workers.size();
+        JobGeneration++;
+    }
+    JobStarted.notify_all();
+
+    for (int i = NextJob++; i < jobCount; i = NextJob++)
+    {
+        job(i);
+    }
+
+    std::unique_lock<std::mutex> lock(JobMutex);
+    JobFinished.wait(lock, [this] { return BusyWorkers == 0; });
+}
+
+void SoftRenderer::WorkerMain()
+{
+    uint64_t generation = 0;
+    for (;;)
+    {
+        const std::function<void(int)>* job;
+        int jobCount;
+        {
+            std::unique_lock<std::mutex> lock(JobMutex);
+            JobStarted.wait(lock, [&] { return Quit || JobGeneration != generation; });
+            if (Quit)
+            {
+                return;
+            }
+            generation = JobGeneration;
+            job = Job;
+            jobCount = JobCount;
+        }
+
+        for (int i = NextJob++; i < jobCount; i = NextJob++)
+        {
+            (*job)(i);
+        }
+
+        std::lock_guard<std::mutex> lock(JobMutex);
+        if (--BusyWorkers == 0)
+        {
+            JobFinished.notify_one();
+        }
+    }
+}
+
+// Range of triangles of a command
+struct SoftRendererDraw
+{
+    const ImDrawVert* Vertices;
+    const ImDrawIdx* Indices;
+    uint32_t FirstTriangle;
+    uint32_t TriangleCount;
+    int ClipMinX, ClipMinY, ClipMaxX, ClipMaxY;
+    const SoftRendererTexture* Texture;
+};
+
+static float SoftRenderer_Channel(ImU32 color, int shift)
+{
+    return (float)((color >> shift) & 0xFF);
+}
+
+// Returns false if the triangle covers no pixel center.
+static bool SoftRenderer_SetupTriangle(SoftRendererTriangle* tri, const SoftRendererDraw& draw, const ImDrawVert* v0, const ImDrawVert* v1, const ImDrawVert* v2)
+{
+    float area = (v1->pos.x - v0->pos.x) * (v2->pos.y - v0->pos.y) - (v1->pos.y - v0->pos.y) * (v2->pos.x - v0->pos.x);
+    if (area == 0.0f)
+    {
+        return false;
+    }
+    if (area < 0.0f)
+    {
+        const ImDrawVert* swap = v1;
+        v1 = v2;
+        v2 = swap;
+        area = -area;
+    }
+
+    float minX = fminf(v0->pos.x, fminf(v1->pos.x, v2->pos.x));
+    float minY = fminf(v0->pos.y, fminf(v1->pos.y, v2->pos.y));
+    float maxX = fmaxf(v0->pos.x, fmaxf(v1->pos.x, v2->pos.x));
+    float maxY = fmaxf(v0->pos.y, fmaxf(v1->pos.y, v2->pos.y));
+    tri->MinX = draw.ClipMinX > (int)floorf(minX) ? draw.ClipMinX : (int)floorf(minX);
+    tri->MinY = draw.ClipMinY > (int)floorf(minY) ? draw.ClipMinY : (int)floorf(minY);
+    tri->MaxX = draw.ClipMaxX < (int)ceilf(maxX) ? draw.ClipMaxX : (int)ceilf(maxX);
+    tri->MaxY = draw.ClipMaxY < (int)ceilf(maxY) ? draw.ClipMaxY : (int)ceilf(maxY);
+    if (tri->MinX > tri->MaxX || tri->MinY > tri->MaxY)
+    {
+        return false;
+    }
+
+    // Edge i is opposite vertex i, and evaluates to 'area' at it.
+    const ImDrawVert* v[3] = { v0, v1, v2 };
+    for (int i = 0; i < 3; i++)
+    {
+        const ImVec2& a = v[(i + 1) % 3]->pos;
+        const ImVec2& b = v[(i + 2) % 3]->pos;
+        float ea = a.y - b.y;
+        float eb = b.x - a.x;
+        tri->Edge[i][0] = ea;
+        tri->Edge[i][1] = eb;
+        tri->Edge[i][2] = -(ea * a.x + eb * a.y);
+
+        // Pixels on an edge shared by two triangles belong to exactly one of them
+        tri->TopLeft[i] = (ea > 0.0f || (ea == 0.0f && eb > 0.0f)) ? 0.0f : FLT_MIN;
+    }
+
+    float attribs[3][6];
+    for (int i = 0; i < 3; i++)
+    {
+        attribs[i][0] = v[i]->uv.x;
+        attribs[i][1] = v[i]->uv.y;
+        attribs[i][2] = SoftRenderer_Channel(v[i]->col, IM_COL32_R_SHIFT);
+        attribs[i][3] = SoftRenderer_Channel(v[i]->col, IM_COL32_G_SHIFT);
+        attribs[i][4] = SoftRenderer_Channel(v[i]->col, IM_COL32_B_SHIFT);
+        attribs[i][5] = SoftRenderer_Channel(v[i]->col, IM_COL32_A_SHIFT);
+    }
+
+    // attrib(p) = sum(edge_i(p) * attrib_i) / area
+    float invArea = 1.0f / area;
+    for (int a = 0; a < 6; a++)
+    {
+        for (int c = 0; c < 3; c++)
+        {
+            tri->Attrib[a][c] = (tri->Edge[0][c] * attribs[0][a] + tri->Edge[1][c] * attribs[1][a] + tri->Edge[2][c] * attribs[2][a]) * invArea;
+        }
+    }
+
+    tri->Texture = draw.Texture;
+    return true;
+}
+
+#if SOFT_RENDERER_SSE2
+
+static void SoftRenderer_ShadeRowSSE2(uint32_t* row, const SoftRendererTriangle& tri, int y, int x0, int x1)
+{
+    const __m128 laneOffsets = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+    const __m128 py = _mm_set1_ps(y + 0.5f);
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 max255 = _mm_set1_ps(255.0f);
+    const __m128 inv255 = _mm_set1_ps(1.0f / 255.0f);
+    const __m128i byteMask = _mm_set1_epi32(0xFF);
+
+    // Row constant part of the planes: b * y + c
+    __m128 edgeA[3], edgeRow[3], bias[3];
+    for (int i = 0; i < 3; i++)
+    {
+        edgeA[i] = _mm_set1_ps(tri.Edge[i][0]);
+        edgeRow[i] = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(tri.Edge[i][1]), py), _mm_set1_ps(tri.Edge[i][2]));
+        bias[i] = _mm_set1_ps(tri.TopLeft[i]);
+    }
+    __m128 attribA[6], attribRow[6];
+    for (int i = 0; i < 6; i++)
+    {
+        attribA[i] = _mm_set1_ps(tri.Attrib[i][0]);
+        attribRow[i] = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(tri.Attrib[i][1]), py), _mm_set1_ps(tri.Attrib[i][2]));
+    }
+
+    const __m128i first = _mm_set1_epi32(x0 - 1);
+    const __m128i last = _mm_set1_epi32(x1 + 1);
+
+    for (int x = x0 & ~3; x <= x1; x += 4)
+    {
+        __m128i lanes = _mm_add_epi32(_mm_set1_epi32(x), _mm_setr_epi32(0, 1, 2, 3));
+        __m128 mask = _mm_castsi128_ps(_mm_and_si128(_mm_cmpgt_epi32(lanes, first), _mm_cmplt_epi32(lanes, last)));
+
+        __m128 px = _mm_add_ps(_mm_set1_ps((float)x), laneOffsets);
+        for (int i = 0; i < 3; i++)
+        {
+            __m128 w = _mm_add_ps(_mm_mul_ps(edgeA[i], px), edgeRow[i]);
+            mask = _mm_and_ps(mask, _mm_cmpge_ps(w, bias[i]));
+        }
+
+        if (!_mm_movemask_ps(mask))
+        {
+            continue;
+        }
+
+        __m128 attrib[6];
+        for (int i = 0; i < 6; i++)
+        {
+            attrib[i] = _mm_add_ps(_mm_mul_ps(attribA[i], px), attribRow[i]);
+        }
+
+        __m128 texel[4] = { max255, max255, max255, max255 };
+        if (tri.Texture)
+        {
+            // Nearest texel with clamp to edge. Truncating is flooring once clamped to 0.
+            const SoftRendererTexture* texture = tri.Texture;
+            __m128 width = _mm_set1_ps((float)texture->Width);
+            __m128 tx = _mm_min_ps(_mm_max_ps(_mm_mul_ps(attrib[0], width), zero), _mm_set1_ps(texture->Width - 1.0f));
+            __m128 ty = _mm_min_ps(_mm_max_ps(_mm_mul_ps(attrib[1], _mm_set1_ps((float)texture->Height)), zero), _mm_set1_ps(texture->Height - 1.0f));
+            __m128 index = _mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_cvttps_epi32(ty)), width), _mm_cvtepi32_ps(_mm_cvttps_epi32(tx)));
+
+            // No gather in SSE2, so texels are read a lane at a time.
+            alignas(16) int32_t indices[4];
+            _mm_store_si128((__m128i*)indices, _mm_cvttps_epi32(index));
+            if (texture->Alpha8)
+            {
+                texel[3] = _mm_setr_ps(texture->Pixels[indices[0]], texture->Pixels[indices[1]], texture->Pixels[indices[2]], texture->Pixels[indices[3]]);
+            }
+            else
+            {
+                const uint32_t* pixels = (const uint32_t*)texture->Pixels;
+                __m128i rgba = _mm_setr_epi32(pixels[indices[0]], pixels[indices[1]], pixels[indices[2]], pixels[indices[3]]);
+                for (int c = 0; c < 4; c++)
+                {
+                    texel[c] = _mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(rgba, c * 8), byteMask));
+                }
+            }
+        }
+
+        __m128 src[4];
+        for (int c = 0; c < 4; c++)
+        {
+            src[c] = _mm_mul_ps(_mm_mul_ps(attrib[2 + c], texel[c]), inv255);
+        }
+        __m128 srcAlpha = _mm_mul_ps(src[3], inv255);
+        __m128 dstWeight = _mm_sub_ps(one, srcAlpha);
+
+        __m128i dst = _mm_loadu_si128((const __m128i*)&row[x]);
+        __m128i result = _mm_setzero_si128();
+        for (int c = 0; c < 4; c++)
+        {
+            __m128 dstChannel = _mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(dst, c * 8), byteMask));
+            __m128 blended = _mm_add_ps(_mm_mul_ps(src[c], srcAlpha), _mm_mul_ps(dstChannel, dstWeight));
+            blended = _mm_min_ps(_mm_max_ps(blended, zero), max255);
+            result = _mm_or_si128(result, _mm_slli_epi32(_mm_cvtps_epi32(blended), c * 8));
+        }
+
+        __m128i keep = _mm_castps_si128(mask);
+        result = _mm_or_si128(_mm_and_si128(keep, result), _mm_andnot_si128(keep, dst));
+        _mm_storeu_si128((__m128i*)&row[x], result);
+    }
+}
+
+#endif
+
+// Nearest texel with clamp to edge, as 0-255 RGBA floats
+static void SoftRenderer_Sample(const SoftRendererTexture* texture, float u, float v, float* rgba)
+{
+    if (!texture)
+    {
+        rgba[0] = rgba[1] = rgba[2] = rgba[3] = 255.0f;
+        return;
+    }
+
+    int x = (int)floorf(u * texture->Width);
+    int y = (int)floorf(v * texture->Height);
+    x = x < 0 ? 0 : (x >= texture->Width ? texture->Width - 1 : x);
+    y = y < 0 ? 0 : (y >= texture->Height ? texture->Height - 1 : y);
+
+    if (texture->Alpha8)
+    {
+        rgba[0] = rgba[1] = rgba[2] = 255.0f;
+        rgba[3] = texture->Pixels[y * texture->Width + x];
+    }
+    else
+    {
+        const unsigned char* texel = &texture->Pixels[(y * texture->Width + x) * 4];
+        rgba[0] = texel[0];
+        rgba[1] = texel[1];
+        rgba[2] = texel[2];
+        rgba[3] = texel[3];
+    }
+}
+
+// Evaluates the planes in the same order as the SSE2 path, a * x + (b * y + c), so both round the same way.
+static void SoftRenderer_ShadeRowScalar(uint32_t* row, const SoftRendererTriangle& tri, int y, int x0, int x1)
+{
+    float py = y + 0.5f;
+    for (int x = x0; x <= x1; x++)
+    {
+        float px = x + 0.5f;
+
+        bool inside = true;
+        for (int i = 0; i < 3; i++)
+        {
+            inside = inside && tri.Edge[i][0] * px + (tri.Edge[i][1] * py + tri.Edge[i][2]) >= tri.TopLeft[i];
+        }
+        if (!inside)
+        {
+            continue;
+        }
+
+        float attrib[6];
+        for (int i = 0; i < 6; i++)
+        {
+            attrib[i] = tri.Attrib[i][0] * px + (tri.Attrib[i][1] * py + tri.Attrib[i][2]);
+        }
+
+        float texel[4];
+        SoftRenderer_Sample(tri.Texture, attrib[0], attrib[1], texel);
+
+        float src[4];
+        for (int c = 0; c < 4; c++)
+        {
+            src[c] = attrib[2 + c] * texel[c] * (1.0f / 255.0f);
+        }
+        float srcAlpha = src[3] * (1.0f / 255.0f);
+
+        uint32_t dst = row[x];
+        uint32_t result = 0;
+        for (int c = 0; c < 4; c++)
+        {
+            float blended = src[c] * srcAlpha + (float)((dst >> (c * 8)) & 0xFF) * (1.0f - srcAlpha);
+            blended = blended < 0.0f ? 0.0f : (blended > 255.0f ? 255.0f : blended);
+            result |= (uint32_t)lrintf(blended) << (c * 8);
+        }
+        row[x] = result;
+    }
+}
+
+void SoftRenderer::ShadeTile(int tile)
+{
+    int tileMinX = (tile % TilesX) * SOFT_RENDERER_TILE_SIZE;
+    int tileMinY = (tile / TilesX) * SOFT_RENDERER_TILE_SIZE;
+    int tileMaxX = tileMinX + SOFT_RENDERER_TILE_SIZE - 1;
+    int tileMaxY = tileMinY + SOFT_RENDERER_TILE_SIZE - 1;
+
+    void (*shadeRow)(uint32_t*, const SoftRendererTriangle&, int, int, int) = SoftRenderer_ShadeRowScalar;
+#if SOFT_RENDERER_SSE2
+    if (UseSSE2)
+    {
+        shadeRow = SoftRenderer_ShadeRowSSE2;
+    }
+#endif
+
+    for (int chunk = 0; chunk < ChunkCount; chunk++)
+    {
+        for (uint32_t index : Bins[chunk][tile])
+        {
+            const SoftRendererTriangle& tri = Triangles[index];
+            int minX = tri.MinX > tileMinX ? tri.MinX : tileMinX;
+            int maxX = tri.MaxX < tileMaxX ? tri.MaxX : tileMaxX;
+            int minY = tri.MinY > tileMinY ? tri.MinY : tileMinY;
+            int maxY = tri.MaxY < tileMaxY ? tri.MaxY : tileMaxY;
+            for (int y = minY; y <= maxY; y++)
+            {
+                shadeRow(&Framebuffer[(size_t)y * FramebufferStride], tri, y, minX, maxX);
+            }
+        }
+    }
+}
+
+void SoftRenderer::Render(const ImDrawData* drawData)
+{
+    uint64_t start = GetClock()->NowNs();
+
+    ImTextureID fontTexID = ImGui::GetIO().Fonts->TexID;
+
+    std::vector<SoftRendererDraw> draws;
+    uint32_t triangleCount = 0;
+    for (int n = 0; n < drawData->CmdListsCount; n++)
+    {
+        const ImDrawList* cmd_list = drawData->CmdLists[n];
+        const ImDrawIdx* idx_buffer = cmd_list->IdxBuffer.Data;
+        for (const ImDrawCmd* pcmd = cmd_list->CmdBuffer.begin(); pcmd != cmd_list->CmdBuffer.end(); pcmd++)
+        {
+            if (!pcmd->UserCallback)
+            {
+                // Same pixels as the scissor box of ImGui_Impl_SetScissor, flipped from GL's bottom-left origin.
+                // Rounded like that box rather than the clip rect, so fractional clip rects match too.
+                int scissorX = (int)pcmd->ClipRect.x;
+                int scissorY = (int)(FramebufferHeight - pcmd->ClipRect.w);
+                int scissorWidth = (int)(pcmd->ClipRect.z - pcmd->ClipRect.x);
+                int scissorHeight = (int)(pcmd->ClipRect.w - pcmd->ClipRect.y);
+
+                SoftRendererDraw draw;
+                draw.Vertices = cmd_list->VtxBuffer.Data;
+                draw.Indices = idx_buffer;
+                draw.FirstTriangle = triangleCount;
+                draw.TriangleCount = pcmd->ElemCount / 3;
+                draw.ClipMinX = scissorX;
+                draw.ClipMaxX = scissorX + scissorWidth - 1;
+                draw.ClipMinY = FramebufferHeight - scissorY - scissorHeight;
+                draw.ClipMaxY = FramebufferHeight - 1 - scissorY;
+                draw.ClipMinX = draw.ClipMinX > 0 ? draw.ClipMinX : 0;
+                draw.ClipMinY = draw.ClipMinY > 0 ? draw.ClipMinY : 0;
+                draw.ClipMaxX = draw.ClipMaxX < FramebufferWidth - 1 ? draw.ClipMaxX : FramebufferWidth - 1;
+                draw.ClipMaxY = draw.ClipMaxY < FramebufferHeight - 1 ? draw.ClipMaxY : FramebufferHeight - 1;
+                draw.Texture = (pcmd->TextureId == fontTexID || pcmd->TextureId == &FontTexture) ? &FontTexture : (const SoftRendererTexture*)pcmd->TextureId;
+                draws.push_back(draw);
+                triangleCount += draw.TriangleCount;
+            }
+            idx_buffer += pcmd->ElemCount;
+        }
+    }
+
+    int tileCount = TilesX * TilesY;
+    ChunkCount = (int)((triangleCount + SOFT_RENDERER_CHUNK_SIZE - 1) / SOFT_RENDERER_CHUNK_SIZE);
+    Triangles.resize(triangleCount);
+    if ((int)Bins.size() < ChunkCount)
+    {
+        Bins.resize(ChunkCount);
+    }
+    std::vector<uint64_t> chunkTriangles(ChunkCount);
+    std::vector<uint64_t> chunkBinEntries(ChunkCount);
+
+    std::function<void(int)> bin = [&](int chunk)
+    {
+        std::vector<std::vector<uint32_t>>& bins = Bins[chunk];
+        bins.resize(tileCount);
+        for (std::vector<uint32_t>& tileBin : bins)
+        {
+            tileBin.clear();
+        }
+
+        uint32_t first = (uint32_t)chunk * SOFT_RENDERER_CHUNK_SIZE;
+        uint32_t end = first + SOFT_RENDERER_CHUNK_SIZE < triangleCount ? first + SOFT_RENDERER_CHUNK_SIZE : triangleCount;
+
+        // Last draw that starts at or before the chunk
+        size_t d = 0;
+        while (d + 1 < draws.size() && draws[d + 1].FirstTriangle <= first)
+        {
+            d++;
+        }
+
+        for (uint32_t t = first; t < end; t++)
+        {
+            while (t >= draws[d].FirstTriangle + draws[d].TriangleCount)
+            {
+                d++;
+            }
+
+            const SoftRendererDraw& draw = draws[d];
+            const ImDrawIdx* indices = &draw.Indices[(t - draw.FirstTriangle) * 3];
+            SoftRendererTriangle& tri = Triangles[t];
+            if (!SoftRenderer_SetupTriangle(&tri, draw, &draw.Vertices[indices[0]], &draw.Vertices[indices[1]], &draw.Vertices[indices[2]]))
+            {
+                continue;
+            }
+
+            chunkTriangles[chunk]++;
+            for (int ty = tri.MinY / SOFT_RENDERER_TILE_SIZE; ty <= tri.MaxY / SOFT_RENDERER_TILE_SIZE; ty++)
+            {
+                for (int tx = tri.MinX / SOFT_RENDERER_TILE_SIZE; tx <= tri.MaxX / SOFT_RENDERER_TILE_SIZE; tx++)
+                {
+                    bins[ty * TilesX + tx].push_back(t);
+                    chunkBinEntries[chunk]++;
+                }
+            }
+        }
+    };
+    RunParallel(ChunkCount, bin);
+
+    std::function<void(int)> shade = [this](int tile) { ShadeTile(tile); };
+    RunParallel(tileCount, shade);
+
+    Stats.Triangles = 0;
+    Stats.BinEntries = 0;
+    for (int chunk = 0; chunk < ChunkCount; chunk++)
+    {
+        Stats.Triangles += chunkTriangles[chunk];
+        Stats.BinEntries += chunkBinEntries[chunk];
+    }
+    Stats.RenderNs = GetClock()->NowNs() - start;
+}
+
+bool SoftRenderer::WriteTGA(const char* path) const
+{
+    FILE* f = fopen(path, "wb");
+    if (!f)
+    {
+        return false;
+    }
+
+    // Uncompressed true color, 8 bits of alpha, top-left origin
+    unsigned char header[18] = {};
+    header[2] = 2;
+    header[12] = (unsigned char)(FramebufferWidth & 0xFF);
+    header[13] = (unsigned char)(FramebufferWidth >> 8);
+    header[14] = (unsigned char)(FramebufferHeight & 0xFF);
+    header[15] = (unsigned char)(FramebufferHeight >> 8);
+    header[16] = 32;
+    header[17] = 0x28;
+    fwrite(header, sizeof(header), 1, f);
+
+    std::vector<unsigned char> bgra((size_t)FramebufferWidth * 4);
+    for (int y = 0; y < FramebufferHeight; y++)
+    {
+        const uint32_t* row = &Framebuffer[(size_t)y * FramebufferStride];
+        for (int x = 0; x < FramebufferWidth; x++)
+        {
+            bgra[x * 4 + 0] = (unsigned char)(row[x] >> 16);
+            bgra[x * 4 + 1] = (unsigned char)(row[x] >> 8);
+            bgra[x * 4 + 2] = (unsigned char)(row[x]);
+            bgra[x * 4 + 3] = (unsigned char)(row[x] >> 24);
+        }
+        fwrite(bgra.data(), 1, bgra.size(), f);
+    }
+
+    bool ok = !ferror(f);
+    ok = fclose(f) == 0 && ok;
+    return ok;
+}
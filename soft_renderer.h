@@ -0,0 +1,116 @@
+#pragma once
+
+// CPU renderer for ImDrawData, for rendering the GUI without a GPU (eg. golden-image and performance tests on
+// headless machines) and as a reference to compare the GL output against.
+//
+// Renders like ImGui_Impl_RenderDrawLists: vertex-colored triangles modulated by a nearest-sampled texture, blended
+// with SRC_ALPHA, ONE_MINUS_SRC_ALPHA, and clipped to each command's ClipRect, into an RGBA8 framebuffer.
+//
+// Rendering runs in two parallel passes over a pool of worker threads:
+// - Binning: the triangles are split into chunks, and each chunk's triangles are set up and appended to the bins of the
+//   SOFT_RENDERER_TILE_SIZE tiles they overlap. Each chunk has its own bins, so no locking is needed.
+// - Shading: each tile goes through the bins of every chunk in order, so triangles blend in submission order,
+//   and no two threads ever write the same pixel. Rows are shaded 4 pixels at a time with SSE2 when available.
+//   The scalar path is always built too, and both give the same pixels.
+
+#include "imgui.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#define SOFT_RENDERER_TILE_SIZE 64
+
+// Triangles per binning job
+#define SOFT_RENDERER_CHUNK_SIZE 4096
+
+// Texture of an ImDrawCmd's TextureId, other than the font atlas.
+struct SoftRendererTexture
+{
+    const unsigned char* Pixels;
+    int Width;
+    int Height;
+    bool Alpha8;            // One alpha byte per texel (white color), otherwise RGBA8
+};
+
+struct SoftRendererStats
+{
+    uint64_t Triangles;     // Set up for the last frame, after clipping away the ones outside their clip rect
+    uint64_t BinEntries;    // Triangles times the tiles they overlap
+    uint64_t RenderNs;      // Time of the last Render
+};
+
+// Set up triangle, with plane equations (a * x + b * y + c) for its edges and attributes.
+struct SoftRendererTriangle
+{
+    float Edge[3][3];
+    float TopLeft[3];       // 0 if pixels exactly on the edge are inside, otherwise a tiny bias that excludes them
+    float Attrib[6][3];     // U, V, R, G, B, A
+    int MinX, MinY, MaxX, MaxY;     // Bounds within the clip rect, inclusive
+    const SoftRendererTexture* Texture;
+};
+
+class SoftRenderer
+{
+public:
+    SoftRenderer();
+    ~SoftRenderer();
+
+    // Starts threadCount - 1 workers, since the calling thread works too. 0 uses every core.
+    // Also gets the font atlas from GetTexDataAsAlpha8, and makes it the atlas' TexID if it has none yet.
+    void Init(int threadCount);
+    void Shutdown();
+
+    void Resize(int width, int height);
+    void Clear(ImU32 color);
+
+    // Draws on top of the framebuffer's current contents. Commands with a user callback are skipped.
+    void Render(const ImDrawData* drawData);
+
+    // Rows are Stride() pixels apart, each pixel being 4 bytes in R, G, B, A order.
+    const uint32_t* Pixels() const { return Framebuffer.data(); }
+    int Width() const { return FramebufferWidth; }
+    int Height() const { return FramebufferHeight; }
+    int Stride() const { return FramebufferStride; }
+
+    // Writes an uncompressed 32-bit TGA. Returns false if the file couldn't be written.
+    bool WriteTGA(const char* path) const;
+
+    SoftRendererStats Stats;
+
+    // Shade with SSE2 if the build has it (the default). Turned off to compare the SSE2 path against the scalar one.
+    bool UseSSE2;
+
+private:
+    void RunParallel(int jobCount, const std::function<void(int)>& job);
+    void WorkerMain();
+    void ShadeTile(int tile);
+
+    SoftRendererTexture FontTexture;
+
+    std::vector<uint32_t> Framebuffer;
+    int FramebufferWidth;
+    int FramebufferHeight;
+    int FramebufferStride;      // Width rounded up to 4, so SSE stores never cross into the next row
+    int TilesX;
+    int TilesY;
+
+    std::vector<SoftRendererTriangle> Triangles;
+    std::vector<std::vector<std::vector<uint32_t>>> Bins;   // [chunk][tile] indices into Triangles
+    int ChunkCount;
+
+    std::vector<std::thread> Workers;
+    std::mutex JobMutex;
+    std::condition_variable JobStarted;
+    std::condition_variable JobFinished;
+    const std::function<void(int)>* Job;
+    int JobCount;
+    uint64_t JobGeneration;
+    std::atomic<int> NextJob;
+    int BusyWorkers;
+    bool Quit;
+};
@@ -0,0 +1,303 @@
+#include "self_test.h"
+
+#include "soft_renderer.h"
+
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+// Not a multiple of 4, so rows are padded, and wider than a tile, so triangles straddle tiles
+#define SOFT_RENDERER_TEST_WIDTH 70
+#define SOFT_RENDERER_TEST_HEIGHT 50
+
+// Enough triangles for more than one binning chunk, so the chunks have to blend in order
+#define SOFT_RENDERER_TEST_CONFETTI (SOFT_RENDERER_CHUNK_SIZE + 500)
+
+// FNV-1a of the RGBA8 pixels of the scene of SoftRendererTest_BuildScene, without the font atlas triangle
+#define SOFT_RENDERER_TEST_GOLDEN_HASH 0x98f5b45cb290b388ull
+
+#define SOFT_RENDERER_TEST_BACKGROUND IM_COL32(10, 20, 30, 255)
+
+static const ImVec4 kSoftRendererTestNoClip(-8192.0f, -8192.0f, 8192.0f, 8192.0f);
+
+// Deterministic, so a failure reproduces
+struct SoftRendererTestRandom
+{
+    uint32_t State;
+
+    // Uniform in [0, 1)
+    float Next()
+    {
+        State = State * 1664525u + 1013904223u;
+        return (float)(State >> 8) / (float)(1u << 24);
+    }
+};
+
+static void SoftRendererTest_AddCommand(ImDrawList* list, const ImVec4& clipRect, ImTextureID texture)
+{
+    ImDrawCmd cmd;
+    cmd.ClipRect = clipRect;
+    cmd.TextureId = texture;
+    list->CmdBuffer.push_back(cmd);
+}
+
+// Appends a triangle to the list's last command
+static void SoftRendererTest_AddTriangle(ImDrawList* list, const ImDrawVert& v0, const ImDrawVert& v1, const ImDrawVert& v2)
+{
+    ImDrawIdx first = (ImDrawIdx)list->VtxBuffer.Size;
+    list->VtxBuffer.push_back(v0);
+    list->VtxBuffer.push_back(v1);
+    list->VtxBuffer.push_back(v2);
+    list->IdxBuffer.push_back(first);
+    list->IdxBuffer.push_back((ImDrawIdx)(first + 1));
+    list->IdxBuffer.push_back((ImDrawIdx)(first + 2));
+    list->CmdBuffer.back().ElemCount += 3;
+}
+
+static ImDrawVert SoftRendererTest_Vert(float x, float y, ImU32 col, float u = 0.0f, float v = 0.0f)
+{
+    ImDrawVert vert;
+    vert.pos = ImVec2(x, y);
+    vert.uv = ImVec2(u, v);
+    vert.col = col;
+    return vert;
+}
+
+// Two triangles, split along the diagonal from (x0, y0) to (x1, y1)
+static void SoftRendererTest_AddQuad(ImDrawList* list, float x0, float y0, float x1, float y1, ImU32 col)
+{
+    SoftRendererTest_AddTriangle(list, SoftRendererTest_Vert(x0, y0, col), SoftRendererTest_Vert(x1, y0, col), SoftRendererTest_Vert(x1, y1, col));
+    SoftRendererTest_AddTriangle(list, SoftRendererTest_Vert(x0, y0, col), SoftRendererTest_Vert(x1, y1, col), SoftRendererTest_Vert(x0, y1, col));
+}
+
+static void SoftRendererTest_Render(SoftRenderer& renderer, ImDrawList** lists, int count)
+{
+    ImDrawData drawData;
+    drawData.Valid = true;
+    drawData.CmdLists = lists;
+    drawData.CmdListsCount = count;
+    for (int i = 0; i < count; i++)
+    {
+        drawData.TotalVtxCount += lists[i]->VtxBuffer.Size;
+        drawData.TotalIdxCount += lists[i]->IdxBuffer.Size;
+    }
+
+    renderer.Resize(SOFT_RENDERER_TEST_WIDTH, SOFT_RENDERER_TEST_HEIGHT);
+    renderer.Clear(SOFT_RENDERER_TEST_BACKGROUND);
+    renderer.Render(&drawData);
+}
+
+static uint32_t SoftRendererTest_Pixel(const SoftRenderer& renderer, int x, int y)
+{
+    return renderer.Pixels()[(size_t)y * renderer.Stride() + x];
+}
+
+// Compares the visible pixels, but not the padding at the end of rows
+static bool SoftRendererTest_Equal(const SoftRenderer& a, const SoftRenderer& b)
+{
+    for (int y = 0; y < a.Height(); y++)
+    {
+        if (memcmp(&a.Pixels()[(size_t)y * a.Stride()], &b.Pixels()[(size_t)y * b.Stride()], a.Width() * sizeof(uint32_t)) != 0)
+            return false;
+    }
+    return true;
+}
+
+static uint64_t SoftRendererTest_Hash(const SoftRenderer& renderer)
+{
+    uint64_t hash = 14695981039346656037ull;
+    for (int y = 0; y < renderer.Height(); y++)
+    {
+        const unsigned char* row = (const unsigned char*)&renderer.Pixels()[(size_t)y * renderer.Stride()];
+        for (size_t i = 0; i < renderer.Width() * sizeof(uint32_t); i++)
+            hash = (hash ^ row[i]) * 1099511628211ull;
+    }
+    return hash;
+}
+
+// A bit of everything: translucent quads sharing edges, a textured and vertex-colored rotated quad, a clipped quad,
+// and enough confetti to take two binning chunks. With 'fontTexture', adds a triangle sampling the font atlas.
+static void SoftRendererTest_BuildScene(ImDrawList* list, const SoftRendererTexture* texture, ImTextureID fontTexture)
+{
+    SoftRendererTest_AddCommand(list, kSoftRendererTestNoClip, NULL);
+    SoftRendererTest_AddQuad(list, 4.5f, 4.5f, 20.5f, 20.5f, IM_COL32(255, 255, 255, 128));
+    SoftRendererTest_AddQuad(list, 20.5f, 4.5f, 36.5f, 20.5f, IM_COL32(255, 128, 0, 200));
+
+    SoftRendererTest_AddCommand(list, kSoftRendererTestNoClip, (ImTextureID)texture);
+    SoftRendererTest_AddTriangle(list,
+        SoftRendererTest_Vert(40.2f, 3.7f, IM_COL32(255, 255, 255, 255), 0.0f, 0.0f),
+        SoftRendererTest_Vert(66.9f, 12.1f, IM_COL32(255, 0, 255, 160), 1.0f, 0.0f),
+        SoftRendererTest_Vert(58.4f, 38.8f, IM_COL32(0, 255, 255, 255), 1.0f, 1.0f));
+    SoftRendererTest_AddTriangle(list,
+        SoftRendererTest_Vert(40.2f, 3.7f, IM_COL32(255, 255, 255, 255), 0.0f, 0.0f),
+        SoftRendererTest_Vert(58.4f, 38.8f, IM_COL32(0, 255, 255, 255), 1.0f, 1.0f),
+        SoftRendererTest_Vert(31.6f, 30.3f, IM_COL32(255, 255, 0, 96), 0.0f, 1.0f));
+
+    SoftRendererTest_AddCommand(list, ImVec4(8.0f, 30.0f, 20.0f, 44.0f), NULL);
+    SoftRendererTest_AddQuad(list, 2.0f, 24.0f, 30.0f, 48.0f, IM_COL32(0, 200, 80, 255));
+
+    SoftRendererTest_AddCommand(list, kSoftRendererTestNoClip, NULL);
+    SoftRendererTestRandom random = { 4321 };
+    for (int i = 0; i < SOFT_RENDERER_TEST_CONFETTI; i++)
+    {
+        float x = random.Next() * SOFT_RENDERER_TEST_WIDTH;
+        float y = random.Next() * SOFT_RENDERER_TEST_HEIGHT;
+        ImU32 col = IM_COL32((int)(random.Next() * 255), (int)(random.Next() * 255), (int)(random.Next() * 255), 40);
+        SoftRendererTest_AddTriangle(list,
+            SoftRendererTest_Vert(x, y, col),
+            SoftRendererTest_Vert(x + 1.0f + random.Next() * 3.0f, y + random.Next(), col),
+            SoftRendererTest_Vert(x + random.Next(), y + 1.0f + random.Next() * 3.0f, col));
+    }
+
+    if (fontTexture)
+    {
+        // The atlas is made by stb_truetype, so it's only compared between the SSE2 and scalar paths
+        SoftRendererTest_AddCommand(list, kSoftRendererTestNoClip, fontTexture);
+        SoftRendererTest_AddTriangle(list,
+            SoftRendererTest_Vert(0.0f, 0.0f, IM_COL32(255, 255, 255, 255), 0.0f, 0.0f),
+            SoftRendererTest_Vert(70.0f, 0.0f, IM_COL32(255, 255, 255, 255), 0.5f, 0.0f),
+            SoftRendererTest_Vert(0.0f, 50.0f, IM_COL32(255, 255, 255, 255), 0.0f, 0.5f));
+    }
+}
+
+// Renders hand-built ImDrawData and checks the rasterization rules, clipping, that the SSE2 and scalar paths and
+// any thread count give the same pixels, and that the scene still renders to the same image.
+SelfTestResult SoftRendererTest_RunDrawData()
+{
+    SelfTestResult result = {};
+
+    ImGuiIO& io = ImGui::GetIO();
+    ImTextureID previousFontTexID = io.Fonts->TexID;
+
+    SoftRenderer renderer;
+    renderer.Init(1);
+    ImTextureID fontTexID = io.Fonts->TexID;
+
+    // Pixels exactly on an edge shared by two triangles, along the diagonal of a quad and between two quads, are drawn
+    // once: the union of the quads is covered without gaps or double blending, on pixel centers up to the top-left rule.
+    ImDrawList quads;
+    SoftRendererTest_AddCommand(&quads, kSoftRendererTestNoClip, NULL);
+    SoftRendererTest_AddQuad(&quads, 4.5f, 4.5f, 20.5f, 20.5f, IM_COL32(255, 255, 255, 128));
+    SoftRendererTest_AddQuad(&quads, 20.5f, 4.5f, 36.5f, 20.5f, IM_COL32(255, 255, 255, 128));
+    ImDrawList* quadLists[] = { &quads };
+
+    for (int sse2 = 0; sse2 < 2; sse2++)
+    {
+        renderer.UseSSE2 = sse2 != 0;
+        SoftRendererTest_Render(renderer, quadLists, 1);
+
+        uint32_t background = SoftRendererTest_Pixel(renderer, 0, 0);
+        uint32_t once = SoftRendererTest_Pixel(renderer, 10, 10);
+        int wrong = 0;
+        for (int y = 0; y < SOFT_RENDERER_TEST_HEIGHT; y++)
+        {
+            for (int x = 0; x < SOFT_RENDERER_TEST_WIDTH; x++)
+            {
+                // Left and top edges are in, right and bottom edges are out
+                bool inside = x >= 4 && x < 36 && y >= 4 && y < 20;
+                if (SoftRendererTest_Pixel(renderer, x, y) != (inside ? once : background))
+                    wrong++;
+            }
+        }
+        SELF_TEST_CHECK(result, once != background);
+        SELF_TEST_CHECK(result, wrong == 0);
+        SELF_TEST_CHECK(result, renderer.Stats.Triangles == 4);
+    }
+
+    // A hexagon covers the same pixels however it's split into triangles
+    ImDrawList centerFan, vertexFan;
+    SoftRendererTest_AddCommand(&centerFan, kSoftRendererTestNoClip, NULL);
+    SoftRendererTest_AddCommand(&vertexFan, kSoftRendererTestNoClip, NULL);
+    const ImVec2 hexagon[6] = {
+        ImVec2(50.3f, 18.2f), ImVec2(61.7f, 24.5f), ImVec2(61.2f, 37.0f),
+        ImVec2(50.5f, 43.1f), ImVec2(39.4f, 36.6f), ImVec2(39.9f, 24.9f),
+    };
+    const ImU32 hexagonColor = IM_COL32(200, 100, 50, 100);
+    for (int i = 0; i < 6; i++)
+    {
+        SoftRendererTest_AddTriangle(&centerFan, SoftRendererTest_Vert(50.6f, 30.7f, hexagonColor),
+            SoftRendererTest_Vert(hexagon[i].x, hexagon[i].y, hexagonColor),
+            SoftRendererTest_Vert(hexagon[(i + 1) % 6].x, hexagon[(i + 1) % 6].y, hexagonColor));
+    }
+    for (int i = 1; i < 5; i++)
+    {
+        SoftRendererTest_AddTriangle(&vertexFan, SoftRendererTest_Vert(hexagon[0].x, hexagon[0].y, hexagonColor),
+            SoftRendererTest_Vert(hexagon[i].x, hexagon[i].y, hexagonColor),
+            SoftRendererTest_Vert(hexagon[i + 1].x, hexagon[i + 1].y, hexagonColor));
+    }
+    SoftRenderer other;
+    other.Init(1);
+    ImDrawList* centerFanLists[] = { &centerFan };
+    ImDrawList* vertexFanLists[] = { &vertexFan };
+    renderer.UseSSE2 = true;
+    SoftRendererTest_Render(renderer, centerFanLists, 1);
+    SoftRendererTest_Render(other, vertexFanLists, 1);
+    SELF_TEST_CHECK(result, SoftRendererTest_Equal(renderer, other));
+
+    // A command draws the pixels of the scissor box ImGui_Impl_SetScissor gives GL for its ClipRect. GL keeps the
+    // pixels whose window coordinates, from the bottom left, are within [x, x + width) and [y, y + height).
+    // The clip rect is fractional, so the box is rounded differently than the clip rect would be on its own.
+    const ImVec4 clipRect(10.25f, 25.5f, 30.0f, 40.75f);
+    int scissorX = (int)clipRect.x;
+    int scissorY = (int)(SOFT_RENDERER_TEST_HEIGHT - clipRect.w);
+    int scissorWidth = (int)(clipRect.z - clipRect.x);
+    int scissorHeight = (int)(clipRect.w - clipRect.y);
+
+    ImDrawList clipped;
+    SoftRendererTest_AddCommand(&clipped, clipRect, NULL);
+    SoftRendererTest_AddQuad(&clipped, -10.0f, -10.0f, 80.0f, 60.0f, IM_COL32(255, 0, 0, 255));
+    ImDrawList* clippedLists[] = { &clipped };
+    SoftRendererTest_Render(renderer, clippedLists, 1);
+
+    int clipWrong = 0;
+    for (int y = 0; y < SOFT_RENDERER_TEST_HEIGHT; y++)
+    {
+        for (int x = 0; x < SOFT_RENDERER_TEST_WIDTH; x++)
+        {
+            int windowY = SOFT_RENDERER_TEST_HEIGHT - 1 - y;
+            bool inside = x >= scissorX && x < scissorX + scissorWidth && windowY >= scissorY && windowY < scissorY + scissorHeight;
+            if ((SoftRendererTest_Pixel(renderer, x, y) == 0xFF0000FFu) != inside)
+                clipWrong++;
+        }
+    }
+    SELF_TEST_CHECK(result, clipWrong == 0);
+
+    // The SSE2 and scalar paths, and one or more threads, give the same pixels
+    uint32_t texels[8 * 8];
+    for (int i = 0; i < 8 * 8; i++)
+        texels[i] = (i * 37u & 0xFF) | ((255u - i * 4u) << 8) | ((i * 11u & 0xFF) << 16) | ((i % 3 == 0 ? 255u : 128u) << 24);
+    SoftRendererTexture texture = { (const unsigned char*)texels, 8, 8, false };
+
+    ImDrawList scene;
+    SoftRendererTest_BuildScene(&scene, &texture, fontTexID);
+    ImDrawList* sceneLists[] = { &scene };
+
+    renderer.UseSSE2 = true;
+    SoftRendererTest_Render(renderer, sceneLists, 1);
+    other.UseSSE2 = false;
+    SoftRendererTest_Render(other, sceneLists, 1);
+    SELF_TEST_CHECK(result, SoftRendererTest_Equal(renderer, other));
+
+    SoftRenderer parallel;
+    parallel.Init(4);
+    SoftRendererTest_Render(parallel, sceneLists, 1);
+    SELF_TEST_CHECK(result, SoftRendererTest_Equal(renderer, parallel));
+
+    // And the same image as when the golden hash was taken
+    ImDrawList goldenScene;
+    SoftRendererTest_BuildScene(&goldenScene, &texture, NULL);
+    ImDrawList* goldenLists[] = { &goldenScene };
+    SoftRendererTest_Render(renderer, goldenLists, 1);
+    uint64_t hash = SoftRendererTest_Hash(renderer);
+    if (!SELF_TEST_CHECK(result, hash == SOFT_RENDERER_TEST_GOLDEN_HASH))
+        fprintf(stderr, "Soft renderer scene hash: 0x%016llxull\n", (unsigned long long)hash);
+
+    parallel.Shutdown();
+    other.Shutdown();
+    renderer.Shutdown();
+
+    // Init made the renderer's font texture the atlas' TexID, which is gone with the renderer
+    io.Fonts->TexID = previousFontTexID;
+
+    return result;
+}
@@ -0,0 +1,110 @@
+#pragma once
+
+// Bounded lock-free queue between exactly one producer thread and one consumer thread.
+//
+// Head and Tail are free-running counters (they wrap around at 2^32, which is fine since N is a power of two).
+// Each side only writes its own counter, and keeps a cached copy of the other side's counter so that it only
+// touches the other side's cache line when the cached copy says the queue is full (producer) or empty (consumer).
+//
+// The consumer reads in batches: Available() snapshots what the producer has published, At() peeks at those items,
+// and Consume() hands the slots back to the producer. So draining a batch costs one acquire and one release.
+//
+// The counters and items are aligned to cache lines, so give queues static storage: new doesn't align them before C++17.
+
+#include <atomic>
+#include <cstdint>
+
+#define SPSC_QUEUE_CACHE_LINE_SIZE 64
+
+template<class T, uint32_t N>
+class SpscQueue
+{
+    static_assert((N & (N - 1)) == 0, "SpscQueue size must be a power of two");
+
+public:
+    static const uint32_t Size = N;
+
+    SpscQueue()
+    {
+        Tail.store(0, std::memory_order_relaxed);
+        CachedHead = 0;
+        Head.store(0, std::memory_order_relaxed);
+        CachedTail = 0;
+    }
+
+    // Producer only. Returns false (and drops the item) if the queue is full.
+    bool TryPush(const T& item)
+    {
+        uint32_t tail = Tail.load(std::memory_order_relaxed);
+        if (tail - CachedHead == N)
+        {
+            CachedHead = Head.load(std::memory_order_acquire);
+            if (tail - CachedHead == N)
+            {
+                return false;
+            }
+        }
+
+        Items[tail & (N - 1)] = item;
+        Tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer only. Number of items that can be read with At(), as of this call.
+    uint32_t Available()
+    {
+        uint32_t head = Head.load(std::memory_order_relaxed);
+        if (CachedTail == head)
+        {
+            CachedTail = Tail.load(std::memory_order_acquire);
+        }
+        return CachedTail - head;
+    }
+
+    // Consumer only. Like Available(), but always reloads the producer's position, so it also counts the items
+    // published since an earlier call that left items unconsumed (eg. when peeking without consuming).
+    uint32_t AvailableLatest()
+    {
+        CachedTail = Tail.load(std::memory_order_acquire);
+        return CachedTail - Head.load(std::memory_order_relaxed);
+    }
+
+    // Consumer only. The i-th item from the front, for i < Available().
+    const T& At(uint32_t i) const
+    {
+        return Items[(Head.load(std::memory_order_relaxed) + i) & (N - 1)];
+    }
+
+    // Consumer only. Removes the first 'count' items (count <= Available()).
+    void Consume(uint32_t count)
+    {
+        Head.store(Head.load(std::memory_order_relaxed) + count, std::memory_order_release);
+    }
+
+    // Consumer only. Copies up to 'maxCount' items to 'items' and removes them. Returns how many were copied.
+    uint32_t PopBatch(T* items, uint32_t maxCount)
+    {
+        uint32_t count = Available();
+        if (count > maxCount)
+        {
+            count = maxCount;
+        }
+        for (uint32_t i = 0; i < count; i++)
+        {
+            items[i] = At(i);
+        }
+        Consume(count);
+        return count;
+    }
+
+private:
+    // Producer's cache line
+    alignas(SPSC_QUEUE_CACHE_LINE_SIZE) std::atomic<uint32_t> Tail;
+    uint32_t CachedHead;
+
+    // Consumer's cache line
+    alignas(SPSC_QUEUE_CACHE_LINE_SIZE) std::atomic<uint32_t> Head;
+    uint32_t CachedTail;
+
+    alignas(SPSC_QUEUE_CACHE_LINE_SIZE) T Items[N];
+};
@@ -0,0 +1,118 @@
+#include "spsc_queue_benchmark.h"
+
+#include "spsc_queue.h"
+#include "clock.h"
+
+#include <deque>
+#include <mutex>
+#include <thread>
+
+// Same size as ImGui_Impl_Event on 64-bit Windows
+struct SpscQueueBenchmarkItem
+{
+    uint64_t Sequence;
+    uint32_t Msg;
+    uint64_t wParam;
+    uint64_t lParam;
+};
+
+#define SPSC_QUEUE_BENCHMARK_SIZE 4096
+#define SPSC_QUEUE_BENCHMARK_BATCH 256
+
+static SpscQueue<SpscQueueBenchmarkItem, SPSC_QUEUE_BENCHMARK_SIZE> g_SpscQueueBenchmarkQueue;
+
+static SpscQueueBenchmarkItem SpscQueueBenchmark_Make(uint64_t sequence)
+{
+    SpscQueueBenchmarkItem item = { sequence, (uint32_t)sequence, sequence * 3, ~sequence };
+    return item;
+}
+
+static bool SpscQueueBenchmark_IsExpected(const SpscQueueBenchmarkItem& item, uint64_t sequence)
+{
+    return item.Sequence == sequence && item.Msg == (uint32_t)sequence && item.wParam == sequence * 3 && item.lParam == ~sequence;
+}
+
+// What a queue between the window and render threads would be without the lock-free one
+struct SpscQueueBenchmarkMutexQueue
+{
+    std::mutex Mutex;
+    std::deque<SpscQueueBenchmarkItem> Items;
+
+    bool TryPush(const SpscQueueBenchmarkItem& item)
+    {
+        std::lock_guard<std::mutex> lock(Mutex);
+        if (Items.size() == SPSC_QUEUE_BENCHMARK_SIZE)
+            return false;
+        Items.push_back(item);
+        return true;
+    }
+
+    uint32_t PopBatch(SpscQueueBenchmarkItem* items, uint32_t maxCount)
+    {
+        std::lock_guard<std::mutex> lock(Mutex);
+        uint32_t count = 0;
+        while (count < maxCount && !Items.empty())
+        {
+            items[count++] = Items.front();
+            Items.pop_front();
+        }
+        return count;
+    }
+};
+
+template<class Queue>
+static uint64_t SpscQueueBenchmark_Time(Queue& queue, uint64_t items, SpscQueueBenchmarkResult& result)
+{
+    uint64_t start = GetClock()->NowNs();
+
+    uint64_t fullSpins = 0;
+    std::thread producer([&] {
+        for (uint64_t i = 0; i < items; i++)
+        {
+            while (!queue.TryPush(SpscQueueBenchmark_Make(i)))
+            {
+                fullSpins++;
+                std::this_thread::yield();
+            }
+        }
+    });
+
+    SpscQueueBenchmarkItem batch[SPSC_QUEUE_BENCHMARK_BATCH];
+    uint64_t next = 0;
+    while (next < items)
+    {
+        uint32_t count = queue.PopBatch(batch, SPSC_QUEUE_BENCHMARK_BATCH);
+        if (count == 0)
+        {
+            std::this_thread::yield();
+            continue;
+        }
+
+        result.Batches++;
+        for (uint32_t i = 0; i < count; i++)
+        {
+            if (!SpscQueueBenchmark_IsExpected(batch[i], next))
+                result.Mismatches++;
+            next++;
+        }
+    }
+
+    producer.join();
+    result.QueueFullSpins += fullSpins;
+    return GetClock()->NowNs() - start;
+}
+
+SpscQueueBenchmarkResult SpscQueueBenchmark_Run(uint64_t items)
+{
+    SpscQueueBenchmarkResult result = {};
+    result.Items = items;
+
+    SpscQueueBenchmarkMutexQueue mutexQueue;
+    SpscQueueBenchmarkResult mutexResult = {};
+    result.MutexNs = SpscQueueBenchmark_Time(mutexQueue, items, mutexResult);
+    result.Mismatches += mutexResult.Mismatches;
+
+    result.QueueNs = SpscQueueBenchmark_Time(g_SpscQueueBenchmarkQueue, items, result);
+
+    return result;
+}
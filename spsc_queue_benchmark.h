@@ -0,0 +1,21 @@
+#pragma once
+
+// Throughput benchmark of SpscQueue with items the size of ImGui_Impl's events, against a std::deque behind a mutex.
+//
+// A producer thread pushes as fast as it can (spinning while the queue is full) and the consumer drains in batches,
+// like ImGui_Impl_NewFrame does. Both queues hold as many items as ImGui_Impl's. Items are checked to arrive
+// whole and in order.
+
+#include <cstdint>
+
+struct SpscQueueBenchmarkResult
+{
+    uint64_t Items;
+    uint64_t QueueNs;           // From the first push to the last pop
+    uint64_t MutexNs;
+    uint64_t QueueFullSpins;    // Failed pushes of the producer
+    uint64_t Batches;           // Non-empty batches of the consumer
+    uint32_t Mismatches;        // Items missing, out of order or torn, should always be 0
+};
+
+SpscQueueBenchmarkResult SpscQueueBenchmark_Run(uint64_t items);
@@ -0,0 +1,120 @@
+#include "self_test.h"
+
+#include "spsc_queue.h"
+
+#include <thread>
+
+// Like the events of ImGui_Impl, with every field derived from the sequence number so a torn item fails the check.
+struct SpscQueueTestItem
+{
+    uint64_t Sequence;
+    uint32_t Msg;
+    uint64_t wParam;
+    uint64_t lParam;
+};
+
+#define SPSC_QUEUE_TEST_SIZE 256
+#define SPSC_QUEUE_TEST_ITEMS 2000000
+
+typedef SpscQueue<SpscQueueTestItem, SPSC_QUEUE_TEST_SIZE> SpscQueueTestQueue;
+
+static SpscQueueTestQueue g_SpscQueueTestQueue;
+static SpscQueueTestQueue g_SpscQueueTestFullQueue;
+
+static SpscQueueTestItem SpscQueueTest_Make(uint64_t sequence)
+{
+    SpscQueueTestItem item = { sequence, (uint32_t)sequence * 3, sequence * 0x9E3779B97F4A7C15ull, ~sequence };
+    return item;
+}
+
+static bool SpscQueueTest_IsWhole(const SpscQueueTestItem& item)
+{
+    SpscQueueTestItem expected = SpscQueueTest_Make(item.Sequence);
+    return item.Msg == expected.Msg && item.wParam == expected.wParam && item.lParam == expected.lParam;
+}
+
+// A producer pushes as fast as it can into a small queue, retrying when it's full, while the consumer alternates
+// between PopBatch and peeking with At. Every item has to come out once, whole, and in order.
+SelfTestResult SpscQueueTest_RunStress()
+{
+    SelfTestResult result = {};
+
+    // Full and empty, on one thread
+    SpscQueueTestQueue& full = g_SpscQueueTestFullQueue;
+    uint32_t pushed = 0;
+    while (full.TryPush(SpscQueueTest_Make(pushed)))
+        pushed++;
+    SELF_TEST_CHECK(result, pushed == SPSC_QUEUE_TEST_SIZE);
+    SELF_TEST_CHECK(result, full.Available() == SPSC_QUEUE_TEST_SIZE);
+    full.Consume(1);
+    SELF_TEST_CHECK(result, full.TryPush(SpscQueueTest_Make(pushed)));
+    SELF_TEST_CHECK(result, !full.TryPush(SpscQueueTest_Make(pushed + 1)));
+    SELF_TEST_CHECK(result, full.At(0).Sequence == 1);
+    SELF_TEST_CHECK(result, full.AvailableLatest() == SPSC_QUEUE_TEST_SIZE);
+    full.Consume(SPSC_QUEUE_TEST_SIZE);
+    SELF_TEST_CHECK(result, full.Available() == 0);
+
+    SpscQueueTestQueue& queue = g_SpscQueueTestQueue;
+    std::thread producer([&queue] {
+        for (uint64_t i = 0; i < SPSC_QUEUE_TEST_ITEMS; i++)
+        {
+            while (!queue.TryPush(SpscQueueTest_Make(i)))
+            {
+                std::this_thread::yield();
+            }
+        }
+    });
+
+    uint64_t next = 0;
+    uint32_t outOfOrder = 0;
+    uint32_t torn = 0;
+    uint32_t batches = 0;
+    SpscQueueTestItem items[64];
+    while (next < SPSC_QUEUE_TEST_ITEMS && outOfOrder == 0)
+    {
+        uint32_t count;
+        if (batches++ & 1)
+        {
+            count = queue.PopBatch(items, 64);
+            for (uint32_t i = 0; i < count; i++)
+            {
+                outOfOrder += items[i].Sequence != next++;
+                torn += !SpscQueueTest_IsWhole(items[i]);
+            }
+        }
+        else
+        {
+            count = queue.Available();
+            for (uint32_t i = 0; i < count; i++)
+            {
+                outOfOrder += queue.At(i).Sequence != next++;
+                torn += !SpscQueueTest_IsWhole(queue.At(i));
+            }
+            queue.Consume(count);
+        }
+
+        if (count == 0)
+        {
+            std::this_thread::yield();
+        }
+    }
+
+    // The loop stops at the first out of order item, so the producer may still be waiting for room.
+    while (next < SPSC_QUEUE_TEST_ITEMS)
+    {
+        uint32_t count = queue.Available();
+        queue.Consume(count);
+        next += count;
+        if (count == 0)
+        {
+            std::this_thread::yield();
+        }
+    }
+    producer.join();
+
+    SELF_TEST_CHECK(result, outOfOrder == 0);
+    SELF_TEST_CHECK(result, torn == 0);
+    SELF_TEST_CHECK(result, queue.AvailableLatest() == 0);
+
+    return result;
+}
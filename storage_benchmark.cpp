@@ -0,0 +1,173 @@
+#include "storage_benchmark.h"
+
+#include "imgui.h"
+#include "imgui_internal.h"
+#include "clock.h"
+
+#include <algorithm>
+#include <vector>
+
+static volatile int g_StorageBenchmarkSink;
+
+// ImGuiStorage without IMGUI_STORAGE_OPEN_ADDRESSING, as the reference
+struct StorageBenchmarkSorted
+{
+    struct Pair
+    {
+        ImGuiID Key;
+        int Value;
+        bool operator<(ImGuiID key) const { return Key < key; }
+    };
+    std::vector<Pair> Pairs;
+
+    int GetInt(ImGuiID key, int defaultValue) const
+    {
+        std::vector<Pair>::const_iterator it = std::lower_bound(Pairs.begin(), Pairs.end(), key);
+        return (it == Pairs.end() || it->Key != key) ? defaultValue : it->Value;
+    }
+
+    void SetInt(ImGuiID key, int value)
+    {
+        std::vector<Pair>::iterator it = std::lower_bound(Pairs.begin(), Pairs.end(), key);
+        if (it == Pairs.end() || it->Key != key)
+        {
+            Pair pair = { key, value };
+            Pairs.insert(it, pair);
+            return;
+        }
+        it->Value = value;
+    }
+
+    void Remove(ImGuiID key)
+    {
+        std::vector<Pair>::iterator it = std::lower_bound(Pairs.begin(), Pairs.end(), key);
+        if (it != Pairs.end() && it->Key == key)
+        {
+            Pairs.erase(it);
+        }
+    }
+};
+
+template<class Storage>
+static void StorageBenchmark_TimeOps(Storage& storage, const std::vector<ImGuiID>& keys,
+    uint64_t* insertNs, uint64_t* lookupNs, uint64_t* churnNs)
+{
+    const int keyCount = (int)keys.size();
+
+    uint64_t start = GetClock()->NowNs();
+    for (int i = 0; i < keyCount; i++)
+    {
+        storage.SetInt(keys[i], i);
+    }
+    *insertNs = GetClock()->NowNs() - start;
+
+    int sum = 0;
+    start = GetClock()->NowNs();
+    for (int i = 0; i < keyCount; i++)
+    {
+        sum += storage.GetInt(keys[i], -1);
+    }
+    *lookupNs = GetClock()->NowNs() - start;
+    g_StorageBenchmarkSink = sum;
+
+    start = GetClock()->NowNs();
+    for (int i = 0; i < keyCount; i += 2)
+    {
+        storage.Remove(keys[i]);
+    }
+    for (int i = 0; i < keyCount; i += 4)
+    {
+        storage.SetInt(keys[i], -i);
+    }
+    *churnNs = GetClock()->NowNs() - start;
+}
+
+static void StorageBenchmark_Frame(int nodeCount, int frame)
+{
+    ImGui::NewFrame();
+    ImGui::SetNextWindowPos(ImVec2(0, 0), ImGuiSetCond_FirstUseEver);
+    ImGui::SetNextWindowSize(ImVec2(400, 1000), ImGuiSetCond_FirstUseEver);
+    ImGui::Begin("Tree");
+    for (int i = 0; i < nodeCount; i++)
+    {
+        // The first frame gives every node a state, later ones toggle an eighth of them
+        if (frame == 0 || (i + frame) % 8 == 0)
+        {
+            ImGui::SetNextTreeNodeOpen(((i + frame) & 8) != 0, ImGuiSetCond_Always);
+        }
+
+        ImGui::PushID(i);
+        if (i % 16 == 0)
+        {
+            ImGui::CollapsingHeader("Section");
+        }
+        else if (ImGui::TreeNode("Node"))
+        {
+            ImGui::TreePop();
+        }
+        ImGui::PopID();
+    }
+    ImGui::End();
+    ImGui::Render();
+}
+
+StorageBenchmarkResult StorageBenchmark_Run(int keyCount, int frames)
+{
+    StorageBenchmarkResult result = {};
+    result.Keys = keyCount;
+
+    // IDs like PushID(int) gives
+    std::vector<ImGuiID> keys(keyCount);
+    for (int i = 0; i < keyCount; i++)
+    {
+        keys[i] = ImHash(&i, sizeof(i), 0);
+    }
+
+    StorageBenchmarkSorted sorted;
+    StorageBenchmark_TimeOps(sorted, keys, &result.SortedInsertNs, &result.SortedLookupNs, &result.SortedChurnNs);
+    ImGuiStorage storage;
+    StorageBenchmark_TimeOps(storage, keys, &result.InsertNs, &result.LookupNs, &result.ChurnNs);
+
+    for (int i = 0; i < keyCount; i++)
+    {
+        if (storage.GetInt(keys[i], -1) != sorted.GetInt(keys[i], -1))
+        {
+            result.Mismatches++;
+        }
+    }
+    if (storage.Data.Size != (int)sorted.Pairs.size())
+    {
+        result.Mismatches++;
+    }
+
+    ImGuiContext* appContext = ImGui::GetCurrentContext();
+    ImFontAtlas* fonts = ImGui::GetIO().Fonts;
+
+    ImGuiContext* context = ImGui::CreateContext();
+    ImGui::SetCurrentContext(context);
+    ImGuiIO& io = ImGui::GetIO();
+    io.Fonts = fonts;
+    io.IniFilename = NULL;
+    io.DisplaySize = ImVec2(1920, 1080);
+    io.DeltaTime = 1.0f / 60.0f;
+
+    uint64_t start = GetClock()->NowNs();
+    StorageBenchmark_Frame(keyCount, 0);
+    result.FirstFrameNs = GetClock()->NowNs() - start;
+
+    start = GetClock()->NowNs();
+    for (int frame = 1; frame <= frames; frame++)
+    {
+        StorageBenchmark_Frame(keyCount, frame);
+    }
+    result.FrameNs = GetClock()->NowNs() - start;
+    result.Frames = frames;
+
+    // The atlas belongs to the application, Shutdown would clear it
+    io.Fonts = NULL;
+    ImGui::Shutdown();
+    ImGui::DestroyContext(context);
+    ImGui::SetCurrentContext(appContext);
+
+    return result;
+}
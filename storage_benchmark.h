@@ -0,0 +1,29 @@
+#pragma once
+
+// Benchmark of ImGuiStorage with as many keys as a large tree view has node states.
+//
+// - Raw operations: inserting the keys (in hash order, like tree nodes opened for the first time), looking them up,
+//   and removing and re-inserting half of them, against the sorted array ImGuiStorage uses without
+//   IMGUI_STORAGE_OPEN_ADDRESSING. Both are checked to hold the same values afterwards.
+// - Frames: a window of tree nodes and collapsing headers in a private ImGui context, where the first frame creates
+//   every node's open state and the following frames each toggle an eighth of them.
+
+#include <cstdint>
+
+struct StorageBenchmarkResult
+{
+    int      Keys;
+    uint64_t SortedInsertNs;
+    uint64_t InsertNs;
+    uint64_t SortedLookupNs;    // Lookups of every key
+    uint64_t LookupNs;
+    uint64_t SortedChurnNs;     // Removing and re-inserting half of the keys
+    uint64_t ChurnNs;
+    uint32_t Mismatches;        // Keys whose values differ between the two, should always be 0
+
+    uint64_t FirstFrameNs;
+    uint64_t Frames;            // Frames toggling nodes, after the first
+    uint64_t FrameNs;
+};
+
+StorageBenchmarkResult StorageBenchmark_Run(int keyCount, int frames);
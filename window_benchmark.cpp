@@ -0,0 +1,109 @@
+#include "window_benchmark.h"
+
+#include "imgui.h"
+#include "imgui_internal.h"
+#include "clock.h"
+
+// FindWindowByName as it was before the ID index
+static ImGuiWindow* WindowBenchmark_FindLinear(const char* name)
+{
+    ImGuiContext& g = *GImGui;
+    ImGuiID id = ImHash(name, 0);
+    for (int i = 0; i < g.Windows.Size; i++)
+        if (g.Windows[i]->ID == id)
+            return g.Windows[i];
+    return NULL;
+}
+
+static void WindowBenchmark_Frame(int windowCount, int childrenPerWindow)
+{
+    ImGui::NewFrame();
+    for (int i = 0; i < windowCount; i++)
+    {
+        char name[32];
+        ImFormatString(name, IM_ARRAYSIZE(name), "Panel %d", i);
+        ImGui::SetNextWindowPos(ImVec2((float)(i % 32) * 30.0f, (float)(i / 32) * 30.0f), ImGuiSetCond_FirstUseEver);
+        ImGui::SetNextWindowSize(ImVec2(300, 200), ImGuiSetCond_FirstUseEver);
+        ImGui::Begin(name);
+        for (int j = 0; j < childrenPerWindow; j++)
+        {
+            ImGui::PushID(j);
+            ImGui::BeginChild("Child", ImVec2(0, 40), true);
+            ImGui::Text("Child %d of panel %d", j, i);
+            ImGui::EndChild();
+            ImGui::PopID();
+        }
+        ImGui::End();
+    }
+    ImGui::Render();
+}
+
+WindowBenchmarkResult WindowBenchmark_Run(int windowCount, int childrenPerWindow, int frames)
+{
+    WindowBenchmarkResult result = {};
+
+    ImGuiContext* appContext = ImGui::GetCurrentContext();
+    ImFontAtlas* fonts = ImGui::GetIO().Fonts;
+
+    ImGuiContext* context = ImGui::CreateContext();
+    ImGui::SetCurrentContext(context);
+    ImGuiIO& io = ImGui::GetIO();
+    io.Fonts = fonts;
+    io.IniFilename = NULL;
+    io.DisplaySize = ImVec2(1920, 1080);
+    io.DeltaTime = 1.0f / 60.0f;
+
+    // The first frame creates the windows
+    WindowBenchmark_Frame(windowCount, childrenPerWindow);
+
+    uint64_t start = GetClock()->NowNs();
+    for (int frame = 0; frame < frames; frame++)
+    {
+        WindowBenchmark_Frame(windowCount, childrenPerWindow);
+    }
+    result.FrameNs = GetClock()->NowNs() - start;
+    result.Frames = frames;
+
+    ImGuiContext& g = *GImGui;
+    result.Windows = g.Windows.Size;
+
+    for (int i = 0; i < g.Windows.Size; i++)
+    {
+        if (ImGui::FindWindowByName(g.Windows[i]->Name) != WindowBenchmark_FindLinear(g.Windows[i]->Name))
+        {
+            result.Mismatches++;
+        }
+    }
+
+    // As many lookups as the frames did
+    ImGuiWindow* found = NULL;
+    start = GetClock()->NowNs();
+    for (int frame = 0; frame < frames; frame++)
+    {
+        for (int i = 0; i < g.Windows.Size; i++)
+        {
+            found = ImGui::FindWindowByName(g.Windows[i]->Name);
+        }
+    }
+    result.LookupNs = GetClock()->NowNs() - start;
+
+    start = GetClock()->NowNs();
+    for (int frame = 0; frame < frames; frame++)
+    {
+        for (int i = 0; i < g.Windows.Size; i++)
+        {
+            found = WindowBenchmark_FindLinear(g.Windows[i]->Name);
+        }
+    }
+    result.LinearLookupNs = GetClock()->NowNs() - start;
+    result.Lookups = (uint64_t)frames * g.Windows.Size;
+    IM_ASSERT(found != NULL);
+
+    // The atlas belongs to the application, Shutdown would clear it
+    io.Fonts = NULL;
+    ImGui::Shutdown();
+    ImGui::DestroyContext(context);
+    ImGui::SetCurrentContext(appContext);
+
+    return result;
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+// Benchmark of ImGui frames with many windows and child windows, in a private ImGui context so the application's
+// windows and settings are left alone.
+//
+// Begin() looks up every window by name every frame, so it also times FindWindowByName over the names of all the
+// windows against the linear scan of g.Windows that it used to be, and checks that both find the same windows.
+
+#include <cstdint>
+
+struct WindowBenchmarkResult
+{
+    int      Windows;           // Including child windows
+    uint64_t Frames;
+    uint64_t FrameNs;           // NewFrame to Render, for all frames
+    uint64_t Lookups;           // Per implementation
+    uint64_t LookupNs;
+    uint64_t LinearLookupNs;
+    uint32_t Mismatches;        // Names for which the two lookups disagree, should always be 0
+};
+
+WindowBenchmarkResult WindowBenchmark_Run(int windowCount, int childrenPerWindow, int frames);